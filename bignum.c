@@ -39,6 +39,7 @@
 #include <string.h>
 
 #include "bignum.h"
+#include "hogweed-internal.h"
 
 /* Two's complement negation means that -x = ~x + 1, ~x = -(x+1),
  * and we use that x = ~~x = ~(-x-1).
@@ -219,3 +220,17 @@ nettle_mpz_init_set_str_256_s(mpz_t x,
   mpz_init(x);
   nettle_mpz_set_str_256_s(x, length, s);
 }
+
+void
+_nettle_run_tasks (void *executor_ctx, nettle_executor_func *executor,
+		   size_t count, nettle_task_func *task, void *arg)
+{
+  if (executor)
+    executor (executor_ctx, count, task, arg);
+  else
+    {
+      size_t i;
+      for (i = 0; i < count; i++)
+	task (arg, i);
+    }
+}
@@ -127,6 +127,27 @@ nettle_random_prime(mpz_t p, unsigned bits, int top_bits_set,
 		    void *ctx, nettle_random_func *random,
 		    void *progress_ctx, nettle_progress_func *progress);
 
+/* Support for running independent computations concurrently, without
+   nettle depending on any particular threading library. The executor
+   must call task(arg, i) exactly once for each i = 0, ..., count - 1,
+   possibly concurrently in different threads, and return only when
+   all calls have completed. A NULL executor means that the tasks are
+   run sequentially by the calling thread. */
+typedef void nettle_task_func(void *arg, size_t i);
+typedef void nettle_executor_func(void *executor_ctx, size_t count,
+				  nettle_task_func *task, void *arg);
+
+/* Like nettle_random_prime, but tests up to WIDTH sieved candidates
+   at a time, as concurrent executor tasks. The random function is
+   called only by the calling thread. The result depends on WIDTH, but
+   not on the executor. */
+void
+nettle_random_prime_parallel(mpz_t p, unsigned bits, int top_bits_set,
+			     void *ctx, nettle_random_func *random,
+			     void *progress_ctx, nettle_progress_func *progress,
+			     void *executor_ctx, nettle_executor_func *executor,
+			     unsigned width);
+
   
 /* sexp parsing */
 struct sexp_iterator;
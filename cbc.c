@@ -131,6 +131,54 @@ cbc_decrypt(const void *ctx, nettle_cipher_func *f,
     }
 }
 
+void
+cbc_encrypt_streams(const void *ctx, nettle_cipher_func *f,
+		    size_t block_size, size_t streams,
+		    uint8_t * const *ivs, size_t length,
+		    uint8_t * const *dst, const uint8_t * const *src)
+{
+  /* The next block of each of a group of streams is collected into
+     buffer, so that all of them are encrypted with a single call. */
+  TMP_DECL(buffer, uint8_t, CBC_BUFFER_LIMIT);
+  size_t group;
+
+  assert(!(length % block_size));
+  assert(block_size <= CBC_BUFFER_LIMIT);
+
+  if (!length || !streams)
+    return;
+
+  group = CBC_BUFFER_LIMIT / block_size;
+  if (group > streams)
+    group = streams;
+
+  TMP_ALLOC(buffer, group * block_size);
+
+  for (; streams > 0; streams -= group, ivs += group, dst += group, src += group)
+    {
+      size_t offset;
+      size_t i;
+
+      if (group > streams)
+	group = streams;
+
+      for (offset = 0; offset < length; offset += block_size)
+	{
+	  for (i = 0; i < group; i++)
+	    memxor3(buffer + i * block_size,
+		    offset ? dst[i] + offset - block_size : ivs[i],
+		    src[i] + offset, block_size);
+
+	  f(ctx, group * block_size, buffer, buffer);
+
+	  for (i = 0; i < group; i++)
+	    memcpy(dst[i] + offset, buffer + i * block_size, block_size);
+	}
+      for (i = 0; i < group; i++)
+	memcpy(ivs[i], dst[i] + length - block_size, block_size);
+    }
+}
+
 #if 0
 #include "twofish.h"
 #include "aes.h"
@@ -43,6 +43,7 @@ extern "C" {
 /* Name mangling */
 #define cbc_encrypt nettle_cbc_encrypt
 #define cbc_decrypt nettle_cbc_decrypt
+#define cbc_encrypt_streams nettle_cbc_encrypt_streams
 
 void
 cbc_encrypt(const void *ctx, nettle_cipher_func *f,
@@ -56,6 +57,16 @@ cbc_decrypt(const void *ctx, nettle_cipher_func *f,
 	    size_t length, uint8_t *dst,
 	    const uint8_t *src);
 
+/* Encrypts length bytes of each of several independent streams, with
+   separate ivs, dst and src for each. Blocks from different streams
+   are passed to the cipher function together, for ciphers that can
+   process several blocks in parallel. */
+void
+cbc_encrypt_streams(const void *ctx, nettle_cipher_func *f,
+		    size_t block_size, size_t streams,
+		    uint8_t * const *ivs, size_t length,
+		    uint8_t * const *dst, const uint8_t * const *src);
+
 #define CBC_CTX(type, size) \
 { type ctx; uint8_t iv[size]; }
 
@@ -44,6 +44,7 @@
 #include "ccm.h"
 #include "ctr.h"
 
+#include "block-internal.h"
 #include "memops.h"
 #include "nettle-internal.h"
 #include "macros.h"
@@ -225,10 +226,23 @@ ccm_digest(struct ccm_ctx *ctx, const void *cipher, nettle_cipher_func *f,
 	   size_t length, uint8_t *digest)
 {
   int i = CCM_BLOCK_SIZE - CCM_FLAG_GET_L(ctx->ctr.b[CCM_OFFSET_FLAGS]);
+  union nettle_block16 B[2];
   assert(length <= CCM_BLOCK_SIZE);
   while (i < CCM_BLOCK_SIZE)  ctx->ctr.b[i++] = 0;
-  ccm_pad(ctx, cipher, f);
-  ctr_crypt(cipher, f, CCM_BLOCK_SIZE, ctx->ctr.b, length, digest, ctx->tag.b);
+
+  /* The final CBC-MAC block, if any, and the key stream block for the
+     tag are independent, and encrypted together. */
+  B[0] = ctx->tag;
+  B[1] = ctx->ctr;
+  if (ctx->blength)
+    f(cipher, 2*CCM_BLOCK_SIZE, B[0].b, B[0].b);
+  else
+    f(cipher, CCM_BLOCK_SIZE, B[1].b, B[1].b);
+  ctx->tag = B[0];
+  ctx->blength = 0;
+  INCREMENT(CCM_BLOCK_SIZE, ctx->ctr.b);
+
+  memxor3(digest, B[0].b, B[1].b, length);
 }
 
 void
@@ -54,34 +54,66 @@
 
 #define CHACHA_ROUNDS 20
 
+#if HAVE_NATIVE_chacha_8core
+# if !HAVE_NATIVE_chacha_4core
+#  error _chacha_8core requires _chacha_4core
+# endif
+/* For fat builds, when the 8-way function is not usable. */
+void
+_nettle_chacha_8core_c(uint32_t *dst, const uint32_t *src, unsigned rounds);
+
+void
+_nettle_chacha_8core_c(uint32_t *dst, const uint32_t *src, unsigned rounds)
+{
+  uint32_t s[_CHACHA_STATE_LENGTH];
+
+  _chacha_4core (dst, src, rounds);
+  memcpy (s, src, sizeof(s));
+  s[12] += 4;
+  s[13] += (s[12] < 4);
+  _chacha_4core (dst + 4*_CHACHA_STATE_LENGTH, s, rounds);
+}
+# define CHACHA_MAX_BLOCKS 8
+#elif HAVE_NATIVE_chacha_4core
+# define CHACHA_MAX_BLOCKS 4
+#else
+# define CHACHA_MAX_BLOCKS 1
+#endif
+
+/* Produces key stream for up to n blocks, and advances the counter
+   by the number of blocks actually used. */
+#define CHACHA_BLOCKS(ctx, core, n, length, c, m, x) do {	\
+    size_t __size = (length) < (n) * CHACHA_BLOCK_SIZE		\
+      ? (length) : (n) * CHACHA_BLOCK_SIZE;			\
+    uint32_t __incr = (__size + CHACHA_BLOCK_SIZE - 1)		\
+      / CHACHA_BLOCK_SIZE;					\
+    core ((x), (ctx)->state, CHACHA_ROUNDS);			\
+    (ctx)->state[12] += __incr;					\
+    (ctx)->state[13] += ((ctx)->state[12] < __incr);		\
+    memxor3 ((c), (m), (x), __size);				\
+    (length) -= __size;						\
+    (c) += __size;						\
+    (m) += __size;						\
+  } while (0)
+
 void
 chacha_crypt(struct chacha_ctx *ctx,
 	      size_t length,
 	      uint8_t *c,
 	      const uint8_t *m)
 {
-  if (!length)
-    return;
-  
-  for (;;)
-    {
-      uint32_t x[_CHACHA_STATE_LENGTH];
-
-      _chacha_core (x, ctx->state, CHACHA_ROUNDS);
-
-      ctx->state[13] += (++ctx->state[12] == 0);
-
-      /* stopping at 2^70 length per nonce is user's responsibility */
-      
-      if (length <= CHACHA_BLOCK_SIZE)
-	{
-	  memxor3 (c, m, x, length);
-	  return;
-	}
-      memxor3 (c, m, x, CHACHA_BLOCK_SIZE);
-
-      length -= CHACHA_BLOCK_SIZE;
-      c += CHACHA_BLOCK_SIZE;
-      m += CHACHA_BLOCK_SIZE;
-  }
+  uint32_t x[CHACHA_MAX_BLOCKS * _CHACHA_STATE_LENGTH];
+
+  /* stopping at 2^70 length per nonce is user's responsibility */
+
+#if HAVE_NATIVE_chacha_8core
+  while (length > 4*CHACHA_BLOCK_SIZE)
+    CHACHA_BLOCKS (ctx, _chacha_8core, 8, length, c, m, x);
+#endif
+#if HAVE_NATIVE_chacha_4core
+  while (length > 2*CHACHA_BLOCK_SIZE)
+    CHACHA_BLOCKS (ctx, _chacha_4core, 4, length, c, m, x);
+#endif
+  while (length > 0)
+    CHACHA_BLOCKS (ctx, _chacha_core, 1, length, c, m, x);
 }
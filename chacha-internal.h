@@ -39,8 +39,19 @@
 #include "nettle-types.h"
 
 #define _chacha_core _nettle_chacha_core
+#define _chacha_4core _nettle_chacha_4core
+#define _chacha_8core _nettle_chacha_8core
 
 void
 _chacha_core(uint32_t *dst, const uint32_t *src, unsigned rounds);
 
+/* Generate 4 or 8 consecutive blocks of key stream, where block i
+   uses src[12], src[13] plus i as the 64-bit block counter. The
+   state at src is not updated. */
+void
+_chacha_4core(uint32_t *dst, const uint32_t *src, unsigned rounds);
+
+void
+_chacha_8core(uint32_t *dst, const uint32_t *src, unsigned rounds);
+
 #endif /* NETTLE_CHACHA_INTERNAL_H_INCLUDED */
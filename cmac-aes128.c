@@ -58,3 +58,13 @@ cmac_aes128_digest(struct cmac_aes128_ctx *ctx,
 {
   CMAC128_DIGEST(ctx, aes128_encrypt, length, digest);
 }
+
+void
+cmac_aes128_digest_messages(const struct cmac_aes128_ctx *ctx,
+			    size_t count, const size_t *msg_lengths,
+			    const uint8_t * const *msgs,
+			    size_t length, uint8_t * const *digests)
+{
+  CMAC128_DIGEST_MESSAGES(ctx, aes128_encrypt, count, msg_lengths, msgs,
+			 length, digests);
+}
@@ -58,3 +58,13 @@ cmac_aes256_digest(struct cmac_aes256_ctx *ctx,
 {
   CMAC128_DIGEST(ctx, aes256_encrypt, length, digest);
 }
+
+void
+cmac_aes256_digest_messages(const struct cmac_aes256_ctx *ctx,
+			    size_t count, const size_t *msg_lengths,
+			    const uint8_t * const *msgs,
+			    size_t length, uint8_t * const *digests)
+{
+  CMAC128_DIGEST_MESSAGES(ctx, aes256_encrypt, count, msg_lengths, msgs,
+			 length, digests);
+}
@@ -59,3 +59,12 @@ cmac_des3_digest (struct cmac_des3_ctx *ctx,
   CMAC64_DIGEST (ctx, des3_encrypt, length, digest);
 }
 
+void
+cmac_des3_digest_messages(const struct cmac_des3_ctx *ctx,
+			  size_t count, const size_t *msg_lengths,
+			  const uint8_t * const *msgs,
+			  size_t length, uint8_t * const *digests)
+{
+  CMAC64_DIGEST_MESSAGES(ctx, des3_encrypt, count, msg_lengths, msgs,
+			 length, digests);
+}
@@ -47,3 +47,13 @@ cmac_kuznyechik_digest(struct cmac_kuznyechik_ctx *ctx,
 {
   CMAC128_DIGEST(ctx, kuznyechik_encrypt, length, digest);
 }
+
+void
+cmac_kuznyechik_digest_messages(const struct cmac_kuznyechik_ctx *ctx,
+				size_t count, const size_t *msg_lengths,
+				const uint8_t * const *msgs,
+				size_t length, uint8_t * const *digests)
+{
+  CMAC128_DIGEST_MESSAGES(ctx, kuznyechik_encrypt, count, msg_lengths, msgs,
+			 length, digests);
+}
@@ -50,3 +50,13 @@ cmac_magma_digest(struct cmac_magma_ctx *ctx,
 {
   CMAC64_DIGEST(ctx, magma_encrypt, length, digest);
 }
+
+void
+cmac_magma_digest_messages(const struct cmac_magma_ctx *ctx,
+			   size_t count, const size_t *msg_lengths,
+			   const uint8_t * const *msgs,
+			   size_t length, uint8_t * const *digests)
+{
+  CMAC64_DIGEST_MESSAGES(ctx, magma_encrypt, count, msg_lengths, msgs,
+			 length, digests);
+}
@@ -151,3 +151,92 @@ cmac128_digest(struct cmac128_ctx *ctx, const struct cmac128_key *key,
   /* reset state for re-use */
   cmac128_init(ctx);
 }
+
+void
+cmac128_digest_message(const struct cmac128_key *key,
+		      const void *cipher, nettle_cipher_func *encrypt,
+		      size_t msg_len, const uint8_t *msg,
+		      unsigned length, uint8_t *digest)
+{
+  struct cmac128_ctx ctx;
+
+  cmac128_init(&ctx);
+  cmac128_update(&ctx, cipher, encrypt, msg_len, msg);
+  cmac128_digest(&ctx, key, cipher, encrypt, length, digest);
+}
+
+/* Maximum number of messages processed together */
+#define CMAC128_MAX_MESSAGES 16
+
+void
+cmac128_digest_messages(const struct cmac128_key *key,
+		       const void *cipher, nettle_cipher_func *encrypt,
+		       size_t count, const size_t *msg_lengths,
+		       const uint8_t * const *msgs,
+		       unsigned length, uint8_t * const *digests)
+{
+  union nettle_block16 X[CMAC128_MAX_MESSAGES];
+  union nettle_block16 Y[CMAC128_MAX_MESSAGES];
+  size_t blocks[CMAC128_MAX_MESSAGES];
+  unsigned active[CMAC128_MAX_MESSAGES];
+
+  assert(length <= 16);
+
+  while (count > 0)
+    {
+      unsigned n = MIN(count, CMAC128_MAX_MESSAGES);
+      unsigned i;
+      size_t j;
+
+      /* All blocks but the last of each message. Step j encrypts
+	 block j of all messages that have one, with a single call. */
+      for (i = 0; i < n; i++)
+	{
+	  memset(&X[i], 0, sizeof(X[i]));
+	  blocks[i] = msg_lengths[i] > 0 ? (msg_lengths[i] - 1) / 16 : 0;
+	}
+      for (j = 0; ; j++)
+	{
+	  unsigned k;
+	  for (i = k = 0; i < n; i++)
+	    if (j < blocks[i])
+	      {
+		block16_xor_bytes(&Y[k], &X[i], msgs[i] + j * 16);
+		active[k++] = i;
+	      }
+	  if (!k)
+	    break;
+
+	  encrypt(cipher, k * 16, Y[0].b, Y[0].b);
+	  for (i = 0; i < k; i++)
+	    X[active[i]] = Y[i];
+	}
+
+      /* The final blocks, see cmac128_digest */
+      for (i = 0; i < n; i++)
+	{
+	  size_t left = msg_lengths[i] - blocks[i] * 16;
+	  const uint8_t *last = msgs[i] + blocks[i] * 16;
+
+	  if (left < 16)
+	    {
+	      memset(Y[i].b, 0, 16);
+	      memcpy(Y[i].b, last, left);
+	      Y[i].b[left] = 0x80;
+	      block16_xor(&Y[i], &key->K2);
+	    }
+	  else
+	    block16_xor_bytes(&Y[i], &key->K1, last);
+
+	  block16_xor(&Y[i], &X[i]);
+	}
+      encrypt(cipher, n * 16, Y[0].b, Y[0].b);
+      for (i = 0; i < n; i++)
+	memcpy(digests[i], Y[i].b, length);
+
+      count -= n;
+      msg_lengths += n;
+      msgs += n;
+      digests += n;
+    }
+}
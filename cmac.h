@@ -53,26 +53,35 @@ extern "C" {
 #define cmac128_init nettle_cmac128_init
 #define cmac128_update nettle_cmac128_update
 #define cmac128_digest nettle_cmac128_digest
+#define cmac128_digest_message nettle_cmac128_digest_message
+#define cmac128_digest_messages nettle_cmac128_digest_messages
 #define cmac_aes128_set_key nettle_cmac_aes128_set_key
 #define cmac_aes128_update nettle_cmac_aes128_update
 #define cmac_aes128_digest nettle_cmac_aes128_digest
+#define cmac_aes128_digest_messages nettle_cmac_aes128_digest_messages
 #define cmac_aes256_set_key nettle_cmac_aes256_set_key
 #define cmac_aes256_update nettle_cmac_aes256_update
 #define cmac_aes256_digest nettle_cmac_aes256_digest
+#define cmac_aes256_digest_messages nettle_cmac_aes256_digest_messages
 #define cmac_kuznyechik_set_key nettle_cmac_kuznyechik_set_key
 #define cmac_kuznyechik_update nettle_cmac_kuznyechik_update
 #define cmac_kuznyechik_digest nettle_cmac_kuznyechik_digest
+#define cmac_kuznyechik_digest_messages nettle_cmac_kuznyechik_digest_messages
 
 #define cmac64_set_key nettle_cmac64_set_key
 #define cmac64_init nettle_cmac64_init
 #define cmac64_update nettle_cmac64_update
 #define cmac64_digest nettle_cmac64_digest
+#define cmac64_digest_message nettle_cmac64_digest_message
+#define cmac64_digest_messages nettle_cmac64_digest_messages
 #define cmac_des3_set_key nettle_cmac_des3_set_key
 #define cmac_des3_update nettle_cmac_des3_update
 #define cmac_des3_digest nettle_cmac_des3_digest
+#define cmac_des3_digest_messages nettle_cmac_des3_digest_messages
 #define cmac_magma_set_key nettle_cmac_magma_set_key
 #define cmac_magma_update nettle_cmac_magma_update
 #define cmac_magma_digest nettle_cmac_magma_digest
+#define cmac_magma_digest_messages nettle_cmac_magma_digest_messages
 
 struct cmac128_key
 {
@@ -122,6 +131,23 @@ cmac128_digest(struct cmac128_ctx *ctx, const struct cmac128_key *key,
 	       const void *cipher, nettle_cipher_func *encrypt,
 	       unsigned length, uint8_t *digest);
 
+/* One-shot MAC of a complete message. */
+void
+cmac128_digest_message(const struct cmac128_key *key,
+		      const void *cipher, nettle_cipher_func *encrypt,
+		      size_t msg_len, const uint8_t *msg,
+		      unsigned length, uint8_t *digest);
+
+/* Computes the MACs of count independent messages, all with the same
+   key. Blocks from different messages are passed to the cipher
+   function together. */
+void
+cmac128_digest_messages(const struct cmac128_key *key,
+		       const void *cipher, nettle_cipher_func *encrypt,
+		       size_t count, const size_t *msg_lengths,
+		       const uint8_t * const *msgs,
+		       unsigned length, uint8_t * const *digests);
+
 
 #define CMAC128_CTX(type) \
   { struct cmac128_key key; struct cmac128_ctx ctx; type cipher; }
@@ -152,6 +178,15 @@ cmac128_digest(struct cmac128_ctx *ctx, const struct cmac128_key *key,
 		      (nettle_cipher_func *) (encrypt),		\
 		      (length), (digest)))
 
+#define CMAC128_DIGEST_MESSAGES(self, encrypt, count, msg_lengths,	\
+			       msgs, length, digests)		\
+  (0 ? (encrypt)(&(self)->cipher, ~(size_t) 0,			\
+		 (uint8_t *) 0, (const uint8_t *) 0)		\
+     : cmac128_digest_messages(&(self)->key, &(self)->cipher,	\
+			      (nettle_cipher_func *) (encrypt),	\
+			      (count), (msg_lengths), (msgs),	\
+			      (length), (digests)))
+
 void
 cmac64_set_key(struct cmac64_key *key, const void *cipher,
 		nettle_cipher_func *encrypt);
@@ -169,6 +204,23 @@ cmac64_digest(struct cmac64_ctx *ctx, const struct cmac64_key *key,
 	       const void *cipher, nettle_cipher_func *encrypt,
 	       unsigned length, uint8_t *digest);
 
+/* One-shot MAC of a complete message. */
+void
+cmac64_digest_message(const struct cmac64_key *key,
+		      const void *cipher, nettle_cipher_func *encrypt,
+		      size_t msg_len, const uint8_t *msg,
+		      unsigned length, uint8_t *digest);
+
+/* Computes the MACs of count independent messages, all with the same
+   key. Blocks from different messages are passed to the cipher
+   function together. */
+void
+cmac64_digest_messages(const struct cmac64_key *key,
+		       const void *cipher, nettle_cipher_func *encrypt,
+		       size_t count, const size_t *msg_lengths,
+		       const uint8_t * const *msgs,
+		       unsigned length, uint8_t * const *digests);
+
 
 #define CMAC64_CTX(type) \
   { struct cmac64_key key; struct cmac64_ctx ctx; type cipher; }
@@ -199,6 +251,15 @@ cmac64_digest(struct cmac64_ctx *ctx, const struct cmac64_key *key,
 		      (nettle_cipher_func *) (encrypt),		\
 		      (length), (digest)))
 
+#define CMAC64_DIGEST_MESSAGES(self, encrypt, count, msg_lengths,	\
+			       msgs, length, digests)		\
+  (0 ? (encrypt)(&(self)->cipher, ~(size_t) 0,			\
+		 (uint8_t *) 0, (const uint8_t *) 0)		\
+     : cmac64_digest_messages(&(self)->key, &(self)->cipher,	\
+			      (nettle_cipher_func *) (encrypt),	\
+			      (count), (msg_lengths), (msgs),	\
+			      (length), (digests)))
+
 struct cmac_aes128_ctx CMAC128_CTX(struct aes128_ctx);
 
 void
@@ -212,6 +273,12 @@ void
 cmac_aes128_digest(struct cmac_aes128_ctx *ctx,
 		   size_t length, uint8_t *digest);
 
+void
+cmac_aes128_digest_messages(const struct cmac_aes128_ctx *ctx,
+			    size_t count, const size_t *msg_lengths,
+			    const uint8_t * const *msgs,
+			    size_t length, uint8_t * const *digests);
+
 struct cmac_aes256_ctx CMAC128_CTX(struct aes256_ctx);
 
 void
@@ -225,6 +292,12 @@ void
 cmac_aes256_digest(struct cmac_aes256_ctx *ctx,
 		   size_t length, uint8_t *digest);
 
+void
+cmac_aes256_digest_messages(const struct cmac_aes256_ctx *ctx,
+			    size_t count, const size_t *msg_lengths,
+			    const uint8_t * const *msgs,
+			    size_t length, uint8_t * const *digests);
+
 struct cmac_des3_ctx CMAC64_CTX(struct des3_ctx);
 
 void
@@ -238,6 +311,12 @@ void
 cmac_des3_digest(struct cmac_des3_ctx *ctx,
 		 size_t length, uint8_t *digest);
 
+void
+cmac_des3_digest_messages(const struct cmac_des3_ctx *ctx,
+			  size_t count, const size_t *msg_lengths,
+			  const uint8_t * const *msgs,
+			  size_t length, uint8_t * const *digests);
+
 struct cmac_magma_ctx CMAC64_CTX(struct magma_ctx);
 
 void
@@ -251,6 +330,12 @@ void
 cmac_magma_digest(struct cmac_magma_ctx *ctx,
 		  size_t length, uint8_t *digest);
 
+void
+cmac_magma_digest_messages(const struct cmac_magma_ctx *ctx,
+			   size_t count, const size_t *msg_lengths,
+			   const uint8_t * const *msgs,
+			   size_t length, uint8_t * const *digests);
+
 struct cmac_kuznyechik_ctx CMAC128_CTX(struct kuznyechik_ctx);
 
 void
@@ -264,6 +349,12 @@ void
 cmac_kuznyechik_digest(struct cmac_kuznyechik_ctx *ctx,
 		       size_t length, uint8_t *digest);
 
+void
+cmac_kuznyechik_digest_messages(const struct cmac_kuznyechik_ctx *ctx,
+				size_t count, const size_t *msg_lengths,
+				const uint8_t * const *msgs,
+				size_t length, uint8_t * const *digests);
+
 #ifdef __cplusplus
 }
 #endif
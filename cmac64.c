@@ -152,3 +152,92 @@ cmac64_digest(struct cmac64_ctx *ctx, const struct cmac64_key *key,
   memset(&ctx->X, 0, sizeof(ctx->X));
   ctx->index = 0;
 }
+
+void
+cmac64_digest_message(const struct cmac64_key *key,
+		      const void *cipher, nettle_cipher_func *encrypt,
+		      size_t msg_len, const uint8_t *msg,
+		      unsigned length, uint8_t *digest)
+{
+  struct cmac64_ctx ctx;
+
+  cmac64_init(&ctx);
+  cmac64_update(&ctx, cipher, encrypt, msg_len, msg);
+  cmac64_digest(&ctx, key, cipher, encrypt, length, digest);
+}
+
+/* Maximum number of messages processed together */
+#define CMAC64_MAX_MESSAGES 16
+
+void
+cmac64_digest_messages(const struct cmac64_key *key,
+		       const void *cipher, nettle_cipher_func *encrypt,
+		       size_t count, const size_t *msg_lengths,
+		       const uint8_t * const *msgs,
+		       unsigned length, uint8_t * const *digests)
+{
+  union nettle_block8 X[CMAC64_MAX_MESSAGES];
+  union nettle_block8 Y[CMAC64_MAX_MESSAGES];
+  size_t blocks[CMAC64_MAX_MESSAGES];
+  unsigned active[CMAC64_MAX_MESSAGES];
+
+  assert(length <= 8);
+
+  while (count > 0)
+    {
+      unsigned n = MIN(count, CMAC64_MAX_MESSAGES);
+      unsigned i;
+      size_t j;
+
+      /* All blocks but the last of each message. Step j encrypts
+	 block j of all messages that have one, with a single call. */
+      for (i = 0; i < n; i++)
+	{
+	  memset(&X[i], 0, sizeof(X[i]));
+	  blocks[i] = msg_lengths[i] > 0 ? (msg_lengths[i] - 1) / 8 : 0;
+	}
+      for (j = 0; ; j++)
+	{
+	  unsigned k;
+	  for (i = k = 0; i < n; i++)
+	    if (j < blocks[i])
+	      {
+		block8_xor_bytes(&Y[k], &X[i], msgs[i] + j * 8);
+		active[k++] = i;
+	      }
+	  if (!k)
+	    break;
+
+	  encrypt(cipher, k * 8, Y[0].b, Y[0].b);
+	  for (i = 0; i < k; i++)
+	    X[active[i]] = Y[i];
+	}
+
+      /* The final blocks, see cmac64_digest */
+      for (i = 0; i < n; i++)
+	{
+	  size_t left = msg_lengths[i] - blocks[i] * 8;
+	  const uint8_t *last = msgs[i] + blocks[i] * 8;
+
+	  if (left < 8)
+	    {
+	      memset(Y[i].b, 0, 8);
+	      memcpy(Y[i].b, last, left);
+	      Y[i].b[left] = 0x80;
+	      block8_xor(&Y[i], &key->K2);
+	    }
+	  else
+	    block8_xor_bytes(&Y[i], &key->K1, last);
+
+	  block8_xor(&Y[i], &X[i]);
+	}
+      encrypt(cipher, n * 8, Y[0].b, Y[0].b);
+      for (i = 0; i < n; i++)
+	memcpy(digests[i], Y[i].b, length);
+
+      count -= n;
+      msg_lengths += n;
+      msgs += n;
+      digests += n;
+    }
+}
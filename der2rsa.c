@@ -139,3 +139,108 @@ rsa_keypair_from_der(struct rsa_public_key *pub,
   else
     return rsa_public_key_from_der_iterator(pub, limit, &i);    
 }
+
+/* Reads the additional primes of a version 1 key. */
+static int
+rsa_other_primes_from_der_iterator(struct rsa_multi_private_key *priv,
+				   unsigned limit,
+				   struct asn1_der_iterator *i)
+{
+  /* OtherPrimeInfos ::= SEQUENCE SIZE(1..MAX) OF OtherPrimeInfo
+
+     OtherPrimeInfo ::= SEQUENCE {
+         prime             INTEGER,  -- ri
+	 exponent          INTEGER,  -- di
+	 coefficient       INTEGER   -- ti
+    }
+  */
+
+  struct asn1_der_iterator j;
+  enum asn1_iterator_result res;
+
+  if (!(asn1_der_iterator_next(i) == ASN1_ITERATOR_CONSTRUCTED
+	&& i->type == ASN1_SEQUENCE))
+    return 0;
+
+  for (res = asn1_der_decode_constructed(i, &j);
+       res == ASN1_ITERATOR_CONSTRUCTED;
+       res = asn1_der_iterator_next(&j))
+    {
+      struct asn1_der_iterator k;
+      struct rsa_prime_info *info;
+
+      if (priv->count == RSA_MAX_PRIMES - 2 || j.type != ASN1_SEQUENCE)
+	return 0;
+
+      info = &priv->other[priv->count++];
+
+      if (!(asn1_der_decode_constructed(&j, &k) == ASN1_ITERATOR_PRIMITIVE
+	    && k.type == ASN1_INTEGER
+	    && asn1_der_get_bignum(&k, info->r, limit)
+	    && mpz_sgn(info->r) > 0
+	    && GET(&k, info->d, limit)
+	    && GET(&k, info->t, limit)
+	    && asn1_der_iterator_next(&k) == ASN1_ITERATOR_END))
+	return 0;
+    }
+
+  return (res == ASN1_ITERATOR_END && priv->count > 0);
+}
+
+int
+rsa_multi_private_key_from_der_iterator(struct rsa_public_key *pub,
+					struct rsa_multi_private_key *priv,
+					unsigned limit,
+					struct asn1_der_iterator *i)
+{
+  /* Same as RSAPrivateKey above, with version 1 if and only if
+     otherPrimeInfos is present. */
+
+  uint32_t version;
+
+  if (i->type != ASN1_SEQUENCE)
+    return 0;
+
+  priv->count = 0;
+
+  if (asn1_der_decode_constructed_last(i) == ASN1_ITERATOR_PRIMITIVE
+      && i->type == ASN1_INTEGER
+      && asn1_der_get_uint32(i, &version)
+      && version <= 1
+      && GET(i, pub->n, limit)
+      && GET(i, pub->e, limit)
+      && rsa_public_key_prepare(pub)
+      && GET(i, priv->d, limit)
+      && GET(i, priv->p, limit)
+      && GET(i, priv->q, limit)
+      && GET(i, priv->a, limit)
+      && GET(i, priv->b, limit)
+      && GET(i, priv->c, limit)
+      && (version == 0
+	  || rsa_other_primes_from_der_iterator(priv, limit, i))
+      && asn1_der_iterator_next(i) == ASN1_ITERATOR_END)
+    return (rsa_multi_private_key_prepare(priv)
+	    && priv->size == pub->size);
+
+  return 0;
+}
+
+int
+rsa_multi_keypair_from_der(struct rsa_public_key *pub,
+			   struct rsa_multi_private_key *priv,
+			   unsigned limit,
+			   size_t length, const uint8_t *data)
+{
+  struct asn1_der_iterator i;
+  enum asn1_iterator_result res;
+
+  res = asn1_der_iterator_first(&i, length, data);
+
+  if (res != ASN1_ITERATOR_CONSTRUCTED)
+    return 0;
+
+  if (priv)
+    return rsa_multi_private_key_from_der_iterator(pub, priv, limit, &i);
+  else
+    return rsa_public_key_from_der_iterator(pub, limit, &i);
+}
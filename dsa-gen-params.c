@@ -37,10 +37,13 @@
 
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "dsa.h"
 
 #include "bignum.h"
+#include "macros.h"
+#include "sha2.h"
 #include "nettle-internal.h"
 #include "hogweed-internal.h"
 
@@ -48,27 +51,32 @@
 /* Valid sizes, according to FIPS 186-3 are (1024, 160), (2048, 224),
    (2048, 256), (3072, 256). */
 int
-dsa_generate_params(struct dsa_params *params,
-		    void *random_ctx, nettle_random_func *random,
-		    void *progress_ctx, nettle_progress_func *progress,
-		    unsigned p_bits, unsigned q_bits)
+dsa_generate_params_parallel(struct dsa_params *params,
+			     void *random_ctx, nettle_random_func *random,
+			     void *progress_ctx, nettle_progress_func *progress,
+			     void *executor_ctx, nettle_executor_func *executor,
+			     unsigned width,
+			     unsigned p_bits, unsigned q_bits)
 {
   mpz_t r;
   unsigned p0_bits;
   unsigned a;
 
-  if (q_bits < 30 || p_bits < q_bits + 30)
+  if (q_bits < 30 || p_bits < q_bits + 30 || width == 0)
     return 0;
 
   mpz_init (r);
 
-  nettle_random_prime (params->q, q_bits, 0, random_ctx, random,
-		       progress_ctx, progress);
+  nettle_random_prime_parallel (params->q, q_bits, 0, random_ctx, random,
+				progress_ctx, progress,
+				executor_ctx, executor, width);
 
   if (q_bits >= (p_bits + 2)/3)
     _nettle_generate_pocklington_prime (params->p, r, p_bits, 0,
 					random_ctx, random,
-					params->q, NULL, params->q);
+					params->q, NULL, params->q,
+					progress_ctx, progress,
+					executor_ctx, executor, width);
   else
     {
       mpz_t p0, p0q;
@@ -77,9 +85,10 @@ dsa_generate_params(struct dsa_params *params,
 
       p0_bits = (p_bits + 3)/2;
   
-      nettle_random_prime (p0, p0_bits, 0,
-			   random_ctx, random,
-			   progress_ctx, progress);
+      nettle_random_prime_parallel (p0, p0_bits, 0,
+				    random_ctx, random,
+				    progress_ctx, progress,
+				    executor_ctx, executor, width);
 
       if (progress)
 	progress (progress_ctx, 'q');
@@ -89,7 +98,9 @@ dsa_generate_params(struct dsa_params *params,
 
       _nettle_generate_pocklington_prime (params->p, r, p_bits, 0,
 					  random_ctx, random,
-					  p0, params->q, p0q);
+					  p0, params->q, p0q,
+					  progress_ctx, progress,
+					  executor_ctx, executor, width);
 
       mpz_mul (r, r, p0);
 
@@ -114,3 +125,74 @@ dsa_generate_params(struct dsa_params *params,
 
   return 1;
 }
+
+int
+dsa_generate_params(struct dsa_params *params,
+		    void *random_ctx, nettle_random_func *random,
+		    void *progress_ctx, nettle_progress_func *progress,
+		    unsigned p_bits, unsigned q_bits)
+{
+  return dsa_generate_params_parallel (params, random_ctx, random,
+				       progress_ctx, progress,
+				       NULL, NULL, 1, p_bits, q_bits);
+}
+
+/* Deterministic generator, producing the blocks SHA256 (seed || i),
+   for i = 0, 1, ..., with i as a 32-bit big-endian counter. */
+struct dsa_seed_ctx
+{
+  struct sha256_ctx seeded;
+  uint32_t counter;
+  unsigned index;
+  uint8_t block[SHA256_DIGEST_SIZE];
+};
+
+static void
+dsa_seed_random (void *p, size_t length, uint8_t *dst)
+{
+  struct dsa_seed_ctx *ctx = (struct dsa_seed_ctx *) p;
+
+  while (length > 0)
+    {
+      size_t n;
+      if (ctx->index == SHA256_DIGEST_SIZE)
+	{
+	  struct sha256_ctx hash = ctx->seeded;
+	  uint8_t counter[4];
+
+	  WRITE_UINT32 (counter, ctx->counter);
+	  ctx->counter++;
+	  sha256_update (&hash, sizeof (counter), counter);
+	  sha256_digest (&hash, sizeof (ctx->block), ctx->block);
+	  ctx->index = 0;
+	}
+      n = SHA256_DIGEST_SIZE - ctx->index;
+      if (n > length)
+	n = length;
+      memcpy (dst, ctx->block + ctx->index, n);
+      ctx->index += n;
+      dst += n;
+      length -= n;
+    }
+}
+
+int
+dsa_generate_params_seed(struct dsa_params *params,
+			 size_t seed_length, const uint8_t *seed,
+			 void *progress_ctx, nettle_progress_func *progress,
+			 void *executor_ctx, nettle_executor_func *executor,
+			 unsigned width,
+			 unsigned p_bits, unsigned q_bits)
+{
+  struct dsa_seed_ctx ctx;
+
+  sha256_init (&ctx.seeded);
+  sha256_update (&ctx.seeded, seed_length, seed);
+  ctx.counter = 0;
+  ctx.index = SHA256_DIGEST_SIZE;
+
+  return dsa_generate_params_parallel (params, &ctx, dsa_seed_random,
+				       progress_ctx, progress,
+				       executor_ctx, executor, width,
+				       p_bits, q_bits);
+}
@@ -49,6 +49,8 @@ extern "C" {
 #define dsa_sign nettle_dsa_sign
 #define dsa_verify nettle_dsa_verify
 #define dsa_generate_params nettle_dsa_generate_params
+#define dsa_generate_params_parallel nettle_dsa_generate_params_parallel
+#define dsa_generate_params_seed nettle_dsa_generate_params_seed
 #define dsa_generate_keypair nettle_dsa_generate_keypair
 #define dsa_signature_from_sexp nettle_dsa_signature_from_sexp
 #define dsa_keypair_to_sexp nettle_dsa_keypair_to_sexp
@@ -125,6 +127,34 @@ dsa_generate_params(struct dsa_params *params,
 		    void *progress_ctx, nettle_progress_func *progress,
 		    unsigned p_bits, unsigned q_bits);
 
+/* Like dsa_generate_params, but tests up to WIDTH candidates at a
+   time as concurrent executor tasks, see
+   nettle_random_prime_parallel. The random function is called only by
+   the calling thread, and the result depends on WIDTH but not on the
+   executor. While searching for p, the progress function is called
+   with '.' for each tested candidate, which can be used to monitor the
+   search rate. */
+int
+dsa_generate_params_parallel(struct dsa_params *params,
+			     void *random_ctx, nettle_random_func *random,
+			     void *progress_ctx, nettle_progress_func *progress,
+			     void *executor_ctx, nettle_executor_func *executor,
+			     unsigned width,
+			     unsigned p_bits, unsigned q_bits);
+
+/* Deterministic variant, with the randomness derived from the seed
+   using SHA256. The same seed, sizes and width always give the same
+   parameters, so they can be regenerated, or the generation restarted,
+   from the seed alone. The seed must be secret and have enough
+   entropy if the parameters are to be unpredictable. */
+int
+dsa_generate_params_seed(struct dsa_params *params,
+			 size_t seed_length, const uint8_t *seed,
+			 void *progress_ctx, nettle_progress_func *progress,
+			 void *executor_ctx, nettle_executor_func *executor,
+			 unsigned width,
+			 unsigned p_bits, unsigned q_bits);
+
 void
 dsa_generate_keypair (const struct dsa_params *params,
 		      mpz_t pub, mpz_t key,
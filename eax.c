@@ -42,6 +42,7 @@
 
 #include "block-internal.h"
 #include "ctr.h"
+#include "memops.h"
 #include "memxor.h"
 
 static void
@@ -137,11 +138,80 @@ eax_digest (struct eax_ctx *eax, const struct eax_key *key,
 	    const void *cipher, nettle_cipher_func *f,
 	    size_t length, uint8_t *digest)
 {
+  union nettle_block16 B[2];
+
   assert (length > 0);
   assert (length <= EAX_BLOCK_SIZE);
-  omac_final (&eax->omac_data, key, cipher, f);
-  omac_final (&eax->omac_message, key, cipher, f);
+
+  /* Both final OMAC blocks, with a single cipher call */
+  block16_xor3 (&B[0], &eax->omac_data, &key->pad_block);
+  block16_xor3 (&B[1], &eax->omac_message, &key->pad_block);
+  f (cipher, 2*EAX_BLOCK_SIZE, B[0].b, B[0].b);
+  eax->omac_data = B[0];
+  eax->omac_message = B[1];
 
   block16_xor (&eax->omac_nonce, &eax->omac_data);
   memxor3 (digest, eax->omac_nonce.b, eax->omac_message.b, length);
 }
+
+/* Runs the OMAC of the nonce and of the associated data in lockstep,
+   since they are independent. */
+static void
+eax_set_nonce_update (struct eax_ctx *eax, const struct eax_key *key,
+		      const void *cipher, nettle_cipher_func *f,
+		      size_t nonce_length, const uint8_t *nonce,
+		      size_t data_length, const uint8_t *data)
+{
+  union nettle_block16 B[2];
+
+  omac_init (&B[0], 0);
+  omac_init (&B[1], 1);
+
+  for (; nonce_length >= EAX_BLOCK_SIZE && data_length >= EAX_BLOCK_SIZE;
+       nonce_length -= EAX_BLOCK_SIZE, nonce += EAX_BLOCK_SIZE,
+	 data_length -= EAX_BLOCK_SIZE, data += EAX_BLOCK_SIZE)
+    {
+      f (cipher, 2*EAX_BLOCK_SIZE, B[0].b, B[0].b);
+      memxor (B[0].b, nonce, EAX_BLOCK_SIZE);
+      memxor (B[1].b, data, EAX_BLOCK_SIZE);
+    }
+  omac_update (&B[0], key, cipher, f, nonce_length, nonce);
+  omac_final (&B[0], key, cipher, f);
+  eax->omac_nonce = B[0];
+  eax->ctr = B[0];
+
+  eax->omac_data = B[1];
+  omac_update (&eax->omac_data, key, cipher, f, data_length, data);
+  omac_init (&eax->omac_message, 2);
+}
+
+void
+eax_encrypt_message (const struct eax_key *key,
+		     const void *cipher, nettle_cipher_func *f,
+		     size_t nlength, const uint8_t *nonce,
+		     size_t alength, const uint8_t *adata,
+		     size_t tlength,
+		     size_t clength, uint8_t *dst, const uint8_t *src)
+{
+  struct eax_ctx eax;
+  assert (clength >= tlength);
+  eax_set_nonce_update (&eax, key, cipher, f, nlength, nonce, alength, adata);
+  eax_encrypt (&eax, key, cipher, f, clength - tlength, dst, src);
+  eax_digest (&eax, key, cipher, f, tlength, dst + clength - tlength);
+}
+
+int
+eax_decrypt_message (const struct eax_key *key,
+		     const void *cipher, nettle_cipher_func *f,
+		     size_t nlength, const uint8_t *nonce,
+		     size_t alength, const uint8_t *adata,
+		     size_t tlength,
+		     size_t mlength, uint8_t *dst, const uint8_t *src)
+{
+  struct eax_ctx eax;
+  uint8_t tag[EAX_DIGEST_SIZE];
+  eax_set_nonce_update (&eax, key, cipher, f, nlength, nonce, alength, adata);
+  eax_decrypt (&eax, key, cipher, f, mlength, dst, src);
+  eax_digest (&eax, key, cipher, f, tlength, tag);
+  return memeql_sec (tag, src + mlength, tlength);
+}
@@ -129,6 +129,7 @@ const struct ecc_curve _nettle_secp_192r1 =
     ecc_192_modp,
     ecc_192_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -148,6 +149,7 @@ const struct ecc_curve _nettle_secp_192r1 =
     ecc_mod,
     ecc_mod,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   
@@ -81,6 +81,7 @@ const struct ecc_curve _nettle_secp_224r1 =
     ecc_224_modp,
     USE_REDC ? ecc_224_redc : ecc_224_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -100,6 +101,7 @@ const struct ecc_curve _nettle_secp_224r1 =
     ecc_mod,
     ecc_mod,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   
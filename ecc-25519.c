@@ -177,7 +177,8 @@ ecc_mod_pow_252m3 (const struct ecc_modulo *m,
 #undef a7
 }
 
-/* Needs 5*ECC_LIMB_SIZE scratch space. */
+/* Needs 5*ECC_LIMB_SIZE scratch space, which is also sufficient for
+   ecc_mod_inv_vartime. */
 #define ECC_25519_INV_ITCH (5*ECC_LIMB_SIZE)
 
 static void ecc_25519_inv (const struct ecc_modulo *p,
@@ -309,6 +310,7 @@ const struct ecc_curve _nettle_curve25519 =
     ecc_25519_modp,
     ecc_25519_modp,
     ecc_25519_inv,
+    ecc_mod_inv_vartime,
     ecc_25519_sqrt,
   },
   {
@@ -328,6 +330,7 @@ const struct ecc_curve _nettle_curve25519 =
     ecc_25519_modq,
     ecc_25519_modq,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
 
@@ -258,6 +258,7 @@ const struct ecc_curve _nettle_secp_256r1 =
     ecc_256_modp,
     USE_REDC ? ecc_256_redc : ecc_256_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -277,6 +278,7 @@ const struct ecc_curve _nettle_secp_256r1 =
     ecc_256_modq,
     ecc_256_modq,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
 
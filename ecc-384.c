@@ -166,6 +166,7 @@ const struct ecc_curve _nettle_secp_384r1 =
     ecc_384_modp,
     ecc_384_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -185,6 +186,7 @@ const struct ecc_curve _nettle_secp_384r1 =
     ecc_mod,
     ecc_mod,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
 
@@ -94,6 +94,7 @@ const struct ecc_curve _nettle_secp_521r1 =
     ecc_521_modp,
     ecc_521_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -113,6 +114,7 @@ const struct ecc_curve _nettle_secp_521r1 =
     ecc_mod,
     ecc_mod,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   
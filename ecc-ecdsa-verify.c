@@ -57,7 +57,8 @@ ecc_ecdsa_verify_itch (const struct ecc_curve *ecc)
   return 5*ecc->p.size + ecc->mul_itch;
 }
 
-/* FIXME: Use faster primitives, not requiring side-channel silence. */
+/* FIXME: Use faster primitives for the scalar multiplications, not
+   requiring side-channel silence. */
 int
 ecc_ecdsa_verify (const struct ecc_curve *ecc,
 		  const mp_limb_t *pp, /* Public key */
@@ -98,7 +99,7 @@ ecc_ecdsa_verify (const struct ecc_curve *ecc,
      division, I think), and write an ecc_add_ppp. */
 
   /* Compute sinv */
-  ecc->q.invert (&ecc->q, sinv, sp, sinv + 2*ecc->p.size);
+  ecc->q.invert_vartime (&ecc->q, sinv, sp, sinv + 2*ecc->p.size);
 
   /* u1 = h / s, P1 = u1 * G */
   ecc_hash (&ecc->q, hp, length, digest);
@@ -135,7 +136,7 @@ ecc_ecdsa_verify (const struct ecc_curve *ecc,
       ecc->add_hhh (ecc, P1, P1, P2, P1 + 3*ecc->p.size);
     }
   /* x coordinate only, modulo q */
-  ecc->h_to_a (ecc, 2, P2, P1, P1 + 3*ecc->p.size);
+  ecc->h_to_a (ecc, 2 | ECC_H_TO_A_VARTIME, P2, P1, P1 + 3*ecc->p.size);
 
   return (mpn_cmp (rp, P2, ecc->p.size) == 0);
 #undef P2
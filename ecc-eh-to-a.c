@@ -54,10 +54,19 @@ ecc_eh_to_a (const struct ecc_curve *ecc,
 #define yp (p + ecc->p.size)
 #define zp (p + 2*ecc->p.size)
 
+  ecc_mod_inv_func *invert;
   mp_limb_t cy;
 
+  if (op & ECC_H_TO_A_VARTIME)
+    {
+      invert = ecc->p.invert_vartime;
+      op &= ~ECC_H_TO_A_VARTIME;
+    }
+  else
+    invert = ecc->p.invert;
+
   /* Needs 2*size + scratch for the invert call. */
-  ecc->p.invert (&ecc->p, izp, zp, tp + ecc->p.size);
+  invert (&ecc->p, izp, zp, tp + ecc->p.size);
 
   ecc_modp_mul (ecc, tp, xp, izp);
   cy = mpn_sub_n (r, tp, ecc->p.m, ecc->p.size);
@@ -94,6 +94,7 @@ const struct ecc_curve _nettle_gost_256cpb =
     ecc_256_modp,
     USE_REDC ? ecc_256_redc : ecc_256_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -113,6 +114,7 @@ const struct ecc_curve _nettle_gost_256cpb =
     ecc_256_modq,
     ecc_256_modq,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
 
@@ -88,6 +88,7 @@ const struct ecc_curve _nettle_gost_256cpc =
     ecc_256_modp,
     USE_REDC ? ecc_256_redc : ecc_256_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -107,6 +108,7 @@ const struct ecc_curve _nettle_gost_256cpc =
     ecc_256_modq,
     ecc_256_modq,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
 
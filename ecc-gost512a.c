@@ -76,6 +76,7 @@ const struct ecc_curve _nettle_gost_512a =
     ecc_512_modp,
     USE_REDC ? ecc_512_redc : ecc_512_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -95,6 +96,7 @@ const struct ecc_curve _nettle_gost_512a =
     ecc_512_modq,
     ecc_512_modq,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
 
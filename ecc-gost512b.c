@@ -88,6 +88,7 @@ const struct ecc_curve _nettle_gost_512b =
     ecc_512_modp,
     USE_REDC ? ecc_512_redc : ecc_512_modp,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
   {
@@ -107,6 +108,7 @@ const struct ecc_curve _nettle_gost_512b =
     ecc_512_modq,
     ecc_512_modq,
     ecc_mod_inv,
+    ecc_mod_inv_vartime,
     NULL,
   },
 
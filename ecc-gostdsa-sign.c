@@ -52,34 +52,37 @@ ecc_gostdsa_sign_itch (const struct ecc_curve *ecc)
   return ECC_GOSTDSA_SIGN_ITCH (ecc->p.size);
 }
 
-/* NOTE: Caller should check if r or s is zero. */
+/* Computes r from the nonce k. Uses the same scratch space as
+   ecc_gostdsa_sign. */
 void
-ecc_gostdsa_sign (const struct ecc_curve *ecc,
-		const mp_limb_t *zp,
-		const mp_limb_t *kp,
-		size_t length, const uint8_t *digest,
-		mp_limb_t *rp, mp_limb_t *sp,
-		mp_limb_t *scratch)
+ecc_gostdsa_sign_offline (const struct ecc_curve *ecc,
+			  const mp_limb_t *kp,
+			  mp_limb_t *rp,
+			  mp_limb_t *scratch)
 {
 #define P	    scratch
-#define hp	    (scratch + 4*ecc->p.size)
-#define tp	    (scratch + 2*ecc->p.size)
-#define t2p	    scratch
-  /* Procedure, according to GOST 34.10. q denotes the group
-     order.
-
-     1. k <-- uniformly random, 0 < k < q
-
-     2. C <-- (c_x, c_y) = k g
-
-     3. r <-- c_x mod q
-
-     4. s <-- (r*z + k*h) mod q.
-  */
-
+  /* C <-- (c_x, c_y) = k g, and r <-- c_x mod q */
   ecc->mul_g (ecc, P, kp, P + 3*ecc->p.size);
   /* x coordinate only, modulo q */
   ecc->h_to_a (ecc, 2, rp, P, P + 3*ecc->p.size);
+#undef P
+}
+
+/* Computes s, given the nonce k and the corresponding r computed by
+   ecc_gostdsa_sign_offline. Uses the same scratch space as
+   ecc_gostdsa_sign. */
+void
+ecc_gostdsa_sign_online (const struct ecc_curve *ecc,
+			 const mp_limb_t *zp,
+			 const mp_limb_t *kp, const mp_limb_t *rp,
+			 size_t length, const uint8_t *digest,
+			 mp_limb_t *sp,
+			 mp_limb_t *scratch)
+{
+#define hp	    (scratch + 4*ecc->p.size)
+#define tp	    (scratch + 2*ecc->p.size)
+#define t2p	    scratch
+  /* s <-- (r*z + k*h) mod q. */
 
   /* Process hash digest */
   gost_hash (&ecc->q, hp, length, digest);
@@ -96,8 +99,32 @@ ecc_gostdsa_sign (const struct ecc_curve *ecc,
   *scratch = mpn_sub_n (tp, sp, ecc->q.m, ecc->p.size);
   cnd_copy (*scratch == 0, sp, tp, ecc->p.size);
 
-#undef P
 #undef hp
 #undef tp
 #undef t2p
 }
+
+/* NOTE: Caller should check if r or s is zero. */
+void
+ecc_gostdsa_sign (const struct ecc_curve *ecc,
+		const mp_limb_t *zp,
+		const mp_limb_t *kp,
+		size_t length, const uint8_t *digest,
+		mp_limb_t *rp, mp_limb_t *sp,
+		mp_limb_t *scratch)
+{
+  /* Procedure, according to GOST 34.10. q denotes the group
+     order.
+
+     1. k <-- uniformly random, 0 < k < q
+
+     2. C <-- (c_x, c_y) = k g
+
+     3. r <-- c_x mod q
+
+     4. s <-- (r*z + k*h) mod q.
+  */
+
+  ecc_gostdsa_sign_offline (ecc, kp, rp, scratch);
+  ecc_gostdsa_sign_online (ecc, zp, kp, rp, length, digest, sp, scratch);
+}
@@ -58,7 +58,8 @@ ecc_gostdsa_verify_itch (const struct ecc_curve *ecc)
   return 5*ecc->p.size + ecc->mul_itch;
 }
 
-/* FIXME: Use faster primitives, not requiring side-channel silence. */
+/* FIXME: Use faster primitives for the scalar multiplications, not
+   requiring side-channel silence. */
 int
 ecc_gostdsa_verify (const struct ecc_curve *ecc,
 		  const mp_limb_t *pp, /* Public key */
@@ -101,7 +102,7 @@ ecc_gostdsa_verify (const struct ecc_curve *ecc,
     mpn_add_1 (hp, hp, ecc->p.size, 1);
 
   /* Compute v */
-  ecc->q.invert (&ecc->q, vp, hp, vp + 2*ecc->p.size);
+  ecc->q.invert_vartime (&ecc->q, vp, hp, vp + 2*ecc->p.size);
 
   /* z1 = s / h, P1 = z1 * G */
   ecc_modq_mul (ecc, z1, sp, vp);
@@ -120,7 +121,7 @@ ecc_gostdsa_verify (const struct ecc_curve *ecc,
   ecc->add_hhh (ecc, P1, P1, P2, P1 + 3*ecc->p.size);
 
   /* x coordinate only, modulo q */
-  ecc->h_to_a (ecc, 2, P2, P1, P1 + 3*ecc->p.size);
+  ecc->h_to_a (ecc, 2 | ECC_H_TO_A_VARTIME, P2, P1, P1 + 3*ecc->p.size);
 
   return (mpn_cmp (rp, P2, ecc->p.size) == 0);
 #undef P2
@@ -52,6 +52,7 @@
 #define ecc_mod_random _nettle_ecc_mod_random
 #define ecc_mod _nettle_ecc_mod
 #define ecc_mod_inv _nettle_ecc_mod_inv
+#define ecc_mod_inv_vartime _nettle_ecc_mod_inv_vartime
 #define ecc_hash _nettle_ecc_hash
 #define gost_hash _nettle_gost_hash
 #define ecc_a_to_j _nettle_ecc_a_to_j
@@ -162,6 +163,9 @@ struct ecc_modulo
   ecc_mod_func *mod;
   ecc_mod_func *reduce;
   ecc_mod_inv_func *invert;
+  /* Faster, but with running time depending on the input. Only for
+     public data. Uses the same scratch space as invert. */
+  ecc_mod_inv_func *invert_vartime;
   ecc_mod_sqrt_func *sqrt;
 };
 
@@ -223,6 +227,7 @@ ecc_mod_func ecc_pp1_redc;
 ecc_mod_func ecc_pm1_redc;
 
 ecc_mod_inv_func ecc_mod_inv;
+ecc_mod_inv_func ecc_mod_inv_vartime;
 
 void
 ecc_mod_add (const struct ecc_modulo *m, mp_limb_t *rp,
@@ -292,11 +297,17 @@ void
 ecc_a_to_j (const struct ecc_curve *ecc,
 	    mp_limb_t *r, const mp_limb_t *p);
 
+/* Flag for the op argument to ecc->h_to_a, ecc_j_to_a and
+   ecc_eh_to_a. The input point is public, so the conversion may use
+   the faster variable-time inversion. */
+#define ECC_H_TO_A_VARTIME 4
+
 /* Converts a point P in jacobian coordinates into a point R in affine
    coordinates. If op == 1, produce x coordinate only. If op == 2,
-   produce the x coordinate only, and also reduce it modulo q. FIXME:
-   For the public interface, have separate functions for the three
-   cases, and use this flag argument only for the internal ecc->h_to_a
+   produce the x coordinate only, and also reduce it modulo q. The
+   ECC_H_TO_A_VARTIME flag may be or:ed with any of these. FIXME: For
+   the public interface, have separate functions for the three cases,
+   and use this flag argument only for the internal ecc->h_to_a
    function. */
 void
 ecc_j_to_a (const struct ecc_curve *ecc,
@@ -402,8 +413,8 @@ curve25519_eh_to_x (mp_limb_t *xp, const mp_limb_t *p,
 		    mp_limb_t *scratch);
 
 /* Current scratch needs: */
-#define ECC_MOD_INV_ITCH(size) (2*(size))
-#define ECC_J_TO_A_ITCH(size) (5*(size))
+#define ECC_MOD_INV_ITCH(size) (4*(size) + 4)
+#define ECC_J_TO_A_ITCH(size) (3*(size) + ECC_MOD_INV_ITCH (size))
 #define ECC_EH_TO_A_ITCH(size, inv) (2*(size)+(inv))
 #define ECC_DUP_JJ_ITCH(size) (5*(size))
 #define ECC_DUP_EH_ITCH(size) (5*(size))
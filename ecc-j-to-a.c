@@ -51,8 +51,17 @@ ecc_j_to_a (const struct ecc_curve *ecc,
 #define izBp (scratch + 3*ecc->p.size)
 #define tp    scratch
 
+  ecc_mod_inv_func *invert;
   mp_limb_t cy;
 
+  if (op & ECC_H_TO_A_VARTIME)
+    {
+      invert = ecc->p.invert_vartime;
+      op &= ~ECC_H_TO_A_VARTIME;
+    }
+  else
+    invert = ecc->p.invert;
+
   if (ecc->use_redc)
     {
       /* Set v = (r_z / B^2)^-1,
@@ -67,7 +76,7 @@ ecc_j_to_a (const struct ecc_curve *ecc,
       mpn_zero (up + ecc->p.size, ecc->p.size);
       ecc->p.reduce (&ecc->p, up);
 
-      ecc->p.invert (&ecc->p, izp, up, up + ecc->p.size);
+      invert (&ecc->p, izp, up, up + ecc->p.size);
 
       /* Divide this common factor by B */
       mpn_copyi (izBp, izp, ecc->p.size);
@@ -81,7 +90,7 @@ ecc_j_to_a (const struct ecc_curve *ecc,
       /* Set s = p_z^{-1}, r_x = p_x s^2, r_y = p_y s^3 */
 
       mpn_copyi (up, p+2*ecc->p.size, ecc->p.size); /* p_z */
-      ecc->p.invert (&ecc->p, izp, up, up + ecc->p.size);
+      invert (&ecc->p, izp, up, up + ecc->p.size);
 
       ecc_modp_sqr (ecc, iz2p, izp);
     }
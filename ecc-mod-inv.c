@@ -54,107 +54,330 @@ cnd_neg (int cnd, mp_limb_t *rp, const mp_limb_t *ap, mp_size_t n)
     }
 }
 
+/* The inversion functions below use the "divstep" iteration of
+   Bernstein and Yang, "Fast constant-time gcd computation and modular
+   inversion" (https://eprint.iacr.org/2019/266). With delta = 1
+   initially and f odd,
+
+     divstep (delta, f, g)
+       = (1 - delta, g, (g - f)/2)        if delta > 0 and g odd
+       = (1 + delta, f, (g + (g mod 2) f)/2)  otherwise
+
+   The steps are done in batches of DIVSTEP_BATCH, using only the low
+   limb of f and g, and recording the combined effect as a matrix of
+   single-limb signed entries,
+
+     2^DIVSTEP_BATCH (f', g') = (u, v; q, r) (f, g)
+
+   which is then applied to the full numbers. Each row of the matrix
+   satisfies |u| + |v| <= 2^DIVSTEP_BATCH, so the entries fit in a
+   signed limb. */
+
+#define DIVSTEP_BATCH (GMP_NUMB_BITS - 2)
+
+/* Number of divsteps needed to get g = 0, for any odd f and any g with
+   f^2 + 4 g^2 <= 5 * 2^{2d}, according to Theorem 11.2 of the paper.
+   Valid for d >= 46, which holds for all our moduli. */
+#define DIVSTEP_COUNT(d) ((49*(d) + 57) / 17)
+
+#define TOP_BIT(x) ((x) >> (GMP_NUMB_BITS - 1))
+
+/* Do DIVSTEP_BATCH divsteps on the low limbs of f and g, and return
+   the transition matrix in t[0,...,3] = (u, v, q, r). Runs in time
+   independent of the input values. */
+static mp_limb_t
+divsteps (mp_limb_t delta, mp_limb_t f, mp_limb_t g, mp_limb_t *t)
+{
+  mp_limb_t u = 1, v = 0, q = 0, r = 1;
+  unsigned i;
+
+  for (i = 0; i < DIVSTEP_BATCH; i++)
+    {
+      mp_limb_t odd = -(g & 1);
+      /* All ones if delta > 0 and g is odd. */
+      mp_limb_t swap = odd & -TOP_BIT (-delta);
+      mp_limb_t x;
+
+      /* Conditionally replace (delta, f, g) by (-delta, g, -f), and
+	 the matrix rows correspondingly. */
+      delta = (delta ^ swap) - swap;
+      x = (f ^ g) & swap; f ^= x; g ^= x; g = (g ^ swap) - swap;
+      x = (u ^ q) & swap; u ^= x; q ^= x; q = (q ^ swap) - swap;
+      x = (v ^ r) & swap; v ^= x; r ^= x; r = (r ^ swap) - swap;
+
+      /* Now g + (g mod 2) f is even. */
+      g += f & odd;
+      q += u & odd;
+      r += v & odd;
+
+      g >>= 1;
+      u <<= 1;
+      v <<= 1;
+      delta++;
+    }
+  t[0] = u; t[1] = v; t[2] = q; t[3] = r;
+  return delta;
+}
+
+/* Same result as divsteps, but with running time depending on the
+   input. */
+static mp_limb_t
+divsteps_vartime (mp_limb_t delta, mp_limb_t f, mp_limb_t g, mp_limb_t *t)
+{
+  mp_limb_t u = 1, v = 0, q = 0, r = 1;
+  unsigned i = DIVSTEP_BATCH;
+
+  for (;;)
+    {
+      mp_limb_t x;
+      for (; i > 0 && !(g & 1); i--)
+	{
+	  g >>= 1;
+	  u <<= 1;
+	  v <<= 1;
+	  delta++;
+	}
+      if (i == 0)
+	break;
+
+      /* g is odd */
+      if (!TOP_BIT (delta) && delta > 0)
+	{
+	  delta = -delta;
+	  x = f; f = g; g = -x;
+	  x = u; u = q; q = -x;
+	  x = v; v = r; r = -x;
+	}
+      /* Leaves g even, the halving is done above. */
+      g += f;
+      q += u;
+      r += v;
+    }
+  t[0] = u; t[1] = v; t[2] = q; t[3] = r;
+  return delta;
+}
+
+/* Computes rp = u a + v b (mod B^n), where a, b, u and v are all
+   signed, two's complement. */
+static void
+signed_addmul (mp_limb_t *rp, mp_size_t n,
+	       const mp_limb_t *ap, mp_limb_t u,
+	       const mp_limb_t *bp, mp_limb_t v)
+{
+  /* For negative u, multiplying by the unsigned limb adds an extra
+     a B, which we subtract. */
+  mpn_mul_1 (rp, ap, n, u);
+  cnd_sub_n (TOP_BIT (u), rp + 1, ap, n - 1);
+  mpn_addmul_1 (rp, bp, n, v);
+  cnd_sub_n (TOP_BIT (v), rp + 1, bp, n - 1);
+}
+
+/* Arithmetic right shift by DIVSTEP_BATCH bits, of a two's
+   complement number which is known to be divisible by
+   2^DIVSTEP_BATCH. */
+static void
+signed_rshift (mp_limb_t *rp, mp_size_t n)
+{
+  mp_limb_t sign = -TOP_BIT (rp[n-1]);
+  mpn_rshift (rp, rp, n, DIVSTEP_BATCH);
+  rp[n-1] |= sign << (GMP_NUMB_BITS - DIVSTEP_BATCH);
+}
+
+/* Computes t = (u d + v e) / 2^DIVSTEP_BATCH (mod m), where d, e are
+   m->size limbs in the range 0 <= d, e < m, and minv = m^{-1} (mod
+   B). Needs m->size + 1 limbs at tp. The result, in the low m->size
+   limbs, is fully reduced, 0 <= t < m. */
+static void
+update_de (const struct ecc_modulo *m, mp_limb_t *tp,
+	   const mp_limb_t *dp, mp_limb_t u,
+	   const mp_limb_t *ep, mp_limb_t v,
+	   mp_limb_t minv)
+{
+  mp_size_t n = m->size;
+  mp_limb_t c, cy;
+
+  tp[n] = mpn_mul_1 (tp, dp, n, u);
+  cnd_sub_n (TOP_BIT (u), tp + 1, dp, n);
+  tp[n] += mpn_addmul_1 (tp, ep, n, v);
+  cnd_sub_n (TOP_BIT (v), tp + 1, ep, n);
+
+  /* Now |t| < 2^DIVSTEP_BATCH m. Add c m, 0 <= c < 2^DIVSTEP_BATCH
+     to make it divisible by 2^DIVSTEP_BATCH. */
+  c = (-tp[0] * minv) & (GMP_NUMB_MASK >> (GMP_NUMB_BITS - DIVSTEP_BATCH));
+  tp[n] += mpn_addmul_1 (tp, m->m, n, c);
+  signed_rshift (tp, n + 1);
+
+  /* Now -m < t < 2m, fold into the range 0 <= t < m. */
+  tp[n] += cnd_add_n (TOP_BIT (tp[n]), tp, m->m, n);
+  cy = mpn_sub_n (tp, tp, m->m, n);
+  cnd_add_n (cy > tp[n], tp, m->m, n);
+}
+
+/* Inverse of the odd limb m0, modulo B. */
+static mp_limb_t
+limb_inverse (mp_limb_t m0)
+{
+  /* Correct to 3 bits, and each Newton step doubles the number of
+     correct bits. */
+  mp_limb_t inv = m0;
+  unsigned bits;
+  for (bits = 3; bits < GMP_NUMB_BITS; bits *= 2)
+    inv *= 2 - m0 * inv;
+  return inv;
+}
+
+/* One batch of the main iteration, common to the constant-time and
+   the variable-time inversion. Updates f and g, of size + 1 limbs,
+   and d and e, of size limbs. Needs 2*(size + 1) limbs of scratch. */
+static void
+divstep_update (const struct ecc_modulo *m, const mp_limb_t *t,
+		mp_limb_t *fp, mp_limb_t *gp, mp_limb_t *dp, mp_limb_t *ep,
+		mp_limb_t minv, mp_limb_t *scratch)
+{
+  mp_size_t n = m->size;
+#define t0 scratch
+#define t1 (scratch + n + 1)
+
+  signed_addmul (t0, n + 1, fp, t[0], gp, t[1]);
+  signed_addmul (t1, n + 1, fp, t[2], gp, t[3]);
+  signed_rshift (t0, n + 1);
+  signed_rshift (t1, n + 1);
+  mpn_copyi (fp, t0, n + 1);
+  mpn_copyi (gp, t1, n + 1);
+
+  update_de (m, t0, dp, t[0], ep, t[1], minv);
+  update_de (m, t1, dp, t[2], ep, t[3], minv);
+  mpn_copyi (dp, t0, n);
+  mpn_copyi (ep, t1, n);
+#undef t0
+#undef t1
+}
+
+/* Final step: if f = 1, the inverse is d, and if f = -1, it's -d.
+   Otherwise, a wasn't invertible, and we return zero. Clobbers f. */
+static void
+divstep_finish (const struct ecc_modulo *m, mp_limb_t *vp,
+		mp_limb_t *fp, mp_limb_t *tp)
+{
+  mp_size_t n = m->size;
+  mp_limb_t neg, w, mask;
+  mp_size_t i;
+
+  neg = TOP_BIT (fp[n]);
+  cnd_neg (neg, fp, fp, n + 1);
+
+  mpn_sub_n (tp, m->m, vp, n);
+  cnd_copy (neg, vp, tp, n);
+
+  for (i = 1, w = fp[0] ^ 1; i <= n; i++)
+    w |= fp[i];
+
+  /* All ones if w == 0. */
+  mask = TOP_BIT (w | -w) - 1;
+  for (i = 0; i < n; i++)
+    vp[i] &= mask;
+}
+
 /* Compute a^{-1} mod m, with running time depending only on the size.
    Returns zero if a == 0 (mod m), to be consistent with a^{phi(m)-1}.
-   Also needs (m+1)/2, and m must be odd.
+   Also works for input a >= m, as long as it fits in m->size limbs,
+   and m must be odd.
 
-   Needs 2n limbs available at rp, and 2n additional scratch limbs.
-*/
-
-/* FIXME: Could use mpn_sec_invert (in GMP-6), but with a bit more
-   scratch need since it doesn't precompute (m+1)/2. */
+   Needs 2n limbs available at rp, and 4n + 4 additional scratch
+   limbs. */
 void
 ecc_mod_inv (const struct ecc_modulo *m,
-	     mp_limb_t *vp, const mp_limb_t *in_ap,
+	     mp_limb_t *vp, const mp_limb_t *ap,
 	     mp_limb_t *scratch)
 {
-#define ap scratch
-#define bp (scratch + n)
-#define up (vp + n)
-
   mp_size_t n = m->size;
-  /* Avoid the mp_bitcnt_t type for compatibility with older GMP
-     versions. */  
+  mp_limb_t t[4];
+  mp_limb_t minv;
+  mp_limb_t delta;
   unsigned i;
 
+#define dp vp
+#define ep (vp + n)
+#define fp scratch
+#define gp (scratch + n + 1)
+#define tp (scratch + 2*(n + 1))
+
   /* Maintain
 
-       a = u * orig_a (mod m)
-       b = v * orig_a (mod m)
+       f = d * orig_a (mod m)
+       g = e * orig_a (mod m)
 
-     and b odd at all times. Initially,
+     Initially,
 
-       a = a_orig, u = 1
-       b = m,      v = 0
-     */
+       f = m,      d = 0
+       g = orig_a, e = 1
 
-  assert (ap != vp);
+     When g = 0, f = +/- gcd (orig_a, m).
+  */
+  mpn_copyi (gp, ap, n);
+  gp[n] = 0;
+  mpn_copyi (fp, m->m, n);
+  fp[n] = 0;
+  mpn_zero (dp, n);
+  ep[0] = 1;
+  mpn_zero (ep + 1, n - 1);
 
-  up[0] = 1;
-  mpn_zero (up+1, n - 1);
-  mpn_copyi (bp, m->m, n);
-  mpn_zero (vp, n);
-  mpn_copyi (ap, in_ap, n);
+  minv = limb_inverse (m->m[0]);
 
-  for (i = m->bit_size + GMP_NUMB_BITS * n; i-- > 0; )
+  for (i = 0, delta = 1; i < DIVSTEP_COUNT (n * GMP_NUMB_BITS);
+       i += DIVSTEP_BATCH)
     {
-      mp_limb_t odd, swap, cy;
-      
-      /* Always maintain b odd. The logic of the iteration is as
-	 follows. For a, b:
-
-	   odd = a & 1
-	   a -= odd * b
-	   if (underflow from a-b)
-	     {
-	       b += a, assigns old a
-	       a = B^n-a
-	     }
-	   
-	   a /= 2
-
-	 For u, v:
-
-	   if (underflow from a - b)
-	     swap u, v
-	   u -= odd * v
-	   if (underflow from u - v)
-	     u += m
-
-	   u /= 2
-	   if (a one bit was shifted out)
-	     u += (m+1)/2
-
-	 As long as a > 0, the quantity
-
-	   (bitsize of a) + (bitsize of b)
-
-	 is reduced by at least one bit per iteration, hence after
-         (bit_size of orig_a) + (bit_size of m) - 1 iterations we
-         surely have a = 0. Then b = gcd(orig_a, m) and if b = 1 then
-         also v = orig_a^{-1} (mod m)
-      */
-
-      assert (bp[0] & 1);
-      odd = ap[0] & 1;
-
-      swap = cnd_sub_n (odd, ap, bp, n);
-      cnd_add_n (swap, bp, ap, n);
-      cnd_neg (swap, ap, ap, n);
-
-      cnd_swap (swap, up, vp, n);
-      cy = cnd_sub_n (odd, up, vp, n);
-      cy -= cnd_add_n (cy, up, m->m, n);
-      assert (cy == 0);
-
-      cy = mpn_rshift (ap, ap, n, 1);
-      assert (cy == 0);
-      cy = mpn_rshift (up, up, n, 1);
-      cy = cnd_add_n (cy, up, m->mp1h, n);
-      assert (cy == 0);
+      delta = divsteps (delta, fp[0], gp[0], t);
+      divstep_update (m, t, fp, gp, dp, ep, minv, tp);
     }
-  assert ( (ap[0] | ap[n-1]) == 0);
-#undef ap
-#undef bp
-#undef up
+  assert (mpn_zero_p (gp, n + 1));
+
+  divstep_finish (m, vp, fp, tp);
+#undef dp
+#undef ep
+#undef fp
+#undef gp
+#undef tp
+}
+
+/* Like ecc_mod_inv, but with running time depending on the input, and
+   hence only suitable for public values. Same scratch requirements. */
+void
+ecc_mod_inv_vartime (const struct ecc_modulo *m,
+		     mp_limb_t *vp, const mp_limb_t *ap,
+		     mp_limb_t *scratch)
+{
+  mp_size_t n = m->size;
+  mp_limb_t t[4];
+  mp_limb_t minv;
+  mp_limb_t delta;
+
+#define dp vp
+#define ep (vp + n)
+#define fp scratch
+#define gp (scratch + n + 1)
+#define tp (scratch + 2*(n + 1))
+
+  mpn_copyi (gp, ap, n);
+  gp[n] = 0;
+  mpn_copyi (fp, m->m, n);
+  fp[n] = 0;
+  mpn_zero (dp, n);
+  ep[0] = 1;
+  mpn_zero (ep + 1, n - 1);
+
+  minv = limb_inverse (m->m[0]);
+
+  for (delta = 1; !mpn_zero_p (gp, n + 1); )
+    {
+      delta = divsteps_vartime (delta, fp[0], gp[0], t);
+      divstep_update (m, t, fp, gp, dp, ep, minv, tp);
+    }
+
+  divstep_finish (m, vp, fp, tp);
+#undef dp
+#undef ep
+#undef fp
+#undef gp
+#undef tp
 }
@@ -0,0 +1,343 @@
+/* ecc-mul-multi.c
+
+   Multi-scalar multiplication, using Pippenger's bucket method.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "ecc.h"
+#include "ecc-internal.h"
+
+/* Computes R = sum_i N_i P_i. Each scalar is written in signed base
+   2^c digits, d in (-2^{c-1}, 2^{c-1}]. Then, for each digit
+   position, starting with the most significant one, each point
+   +/-P_i is added into bucket |d_i|, and the buckets are combined
+   into sum_j j B_j using two running sums. Between digit positions,
+   the result is multiplied by 2^c.
+
+   With b-bit scalars, this needs roughly (b+1)/c (N + 2^c) point
+   additions, and b point doublings, and the window size c is chosen
+   to minimize the number of additions for the given N.
+
+   This function is *not* side-channel silent. Both running time and
+   memory access pattern depend on the scalars, so it must be used
+   only when the scalars are public, e.g., for signature
+   verification. */
+
+#define ECC_MUL_MULTI_MAX_WBITS 14
+
+static unsigned
+ecc_mul_multi_wbits (const struct ecc_curve *ecc, size_t count)
+{
+  /* One extra bit, for the carry out of the top digit. */
+  unsigned bits = ecc->q.bit_size + 1;
+  unsigned best_c;
+  size_t best_cost;
+  unsigned c;
+
+  for (c = best_c = 1, best_cost = (size_t) -1;
+       c <= ECC_MUL_MULTI_MAX_WBITS; c++)
+    {
+      size_t cost = (bits + c - 1) / c * (count + ((size_t) 1 << c));
+      if (cost < best_cost)
+	{
+	  best_c = c;
+	  best_cost = cost;
+	}
+    }
+  return best_c;
+}
+
+/* Scratch layout for ecc_mul_multi, where n = ecc->p.size and
+   nb = 2^{c-1} is the number of buckets:
+
+     points	count * 2n	Copies of P_i, converted by ecc_a_to_j
+     digits	count * windows	Recoded scalars
+     flags	nb		Non-zero flags for the buckets
+     buckets	nb * 3n
+     s, t	6n		Running sums
+     tp		3n		Temporary point
+     scratch_out 8n		Scratch for point operations
+*/
+#define ECC_MUL_MULTI_POINT_ITCH(size) (8*(size))
+
+mp_size_t
+ecc_mul_multi_itch (const struct ecc_curve *ecc, size_t count)
+{
+  mp_size_t size = ecc->p.size;
+  unsigned c = ecc_mul_multi_wbits (ecc, count);
+  unsigned windows = (ecc->q.bit_size + c) / c;
+
+  return count * (2*size + windows) + ((mp_size_t) 1 << (c-1)) * (3*size + 1)
+    + 9*size + ECC_MUL_MULTI_POINT_ITCH (size);
+}
+
+static int
+ecc_mul_multi_edwards_p (const struct ecc_curve *ecc)
+{
+  return ecc->add_hhh == ecc_add_ehh;
+}
+
+/* Checks if X == 0 (mod p). Needs 2*size limbs of scratch. */
+static int
+zero_p (const struct ecc_modulo *m, const mp_limb_t *xp,
+	mp_limb_t *scratch)
+{
+  mpn_copyi (scratch, xp, m->size);
+  mpn_zero (scratch + m->size, m->size);
+  m->mod (m, scratch);
+
+  while (mpn_cmp (scratch, m->m, m->size) >= 0)
+    mpn_sub_n (scratch, scratch, m->m, m->size);
+
+  return mpn_zero_p (scratch, m->size);
+}
+
+/* Extracts c bits, starting at bit position POS. */
+static unsigned
+get_bits (const mp_limb_t *np, mp_size_t size, unsigned pos, unsigned c)
+{
+  mp_size_t i = pos / GMP_NUMB_BITS;
+  unsigned shift = pos % GMP_NUMB_BITS;
+  mp_limb_t bits;
+
+  if (i >= size)
+    return 0;
+
+  bits = np[i] >> shift;
+  if (shift + c > GMP_NUMB_BITS && i + 1 < size)
+    bits |= np[i+1] << (GMP_NUMB_BITS - shift);
+
+  return bits & (((mp_limb_t) 1 << c) - 1);
+}
+
+/* Adds Q (non-zero) to the non-zero point R, in place. Q must not
+   overlap R. Returns zero if the sum is zero. */
+static int
+add_hhh (const struct ecc_curve *ecc,
+	 mp_limb_t *r, const mp_limb_t *q,
+	 mp_limb_t *scratch)
+{
+  mp_size_t size = ecc->p.size;
+
+  if (ecc_mul_multi_edwards_p (ecc))
+    {
+      /* Complete addition formulas, and zero is an ordinary point. */
+      ecc_add_ehh (ecc, r, q, r, scratch);
+      return 1;
+    }
+
+  ecc_add_jjj (ecc, r, r, q, scratch);
+  if (!zero_p (&ecc->p, r + 2*size, scratch))
+    return 1;
+
+  /* The x coordinate of the result is zero if and only if the
+     inputs were equal. */
+  if (!zero_p (&ecc->p, r, scratch))
+    return 0;
+
+  ecc_dup_jj (ecc, r, q, scratch);
+  return 1;
+}
+
+/* Like add_hhh, but with Q = (x, y, 1), as produced by
+   ecc_a_to_j. */
+static int
+add_hha (const struct ecc_curve *ecc,
+	 mp_limb_t *r, const mp_limb_t *q,
+	 mp_limb_t *scratch)
+{
+  mp_size_t size = ecc->p.size;
+
+  if (ecc_mul_multi_edwards_p (ecc))
+    {
+      ecc_add_eh (ecc, r, r, q, scratch);
+      return 1;
+    }
+
+  ecc_add_jja (ecc, r, r, q, scratch);
+  if (!zero_p (&ecc->p, r + 2*size, scratch))
+    return 1;
+
+  if (!zero_p (&ecc->p, r, scratch))
+    return 0;
+
+  ecc_dup_jj (ecc, r, q, scratch);
+  return 1;
+}
+
+/* Adds Q to the accumulator R, where the flag *RP says if R is
+   non-zero. */
+static void
+add_acc (const struct ecc_curve *ecc,
+	 mp_limb_t *r, mp_limb_t *rp, const mp_limb_t *q,
+	 mp_limb_t *scratch)
+{
+  if (*rp)
+    *rp = add_hhh (ecc, r, q, scratch);
+  else
+    {
+      mpn_copyi (r, q, 3*ecc->p.size);
+      *rp = 1;
+    }
+}
+
+void
+ecc_mul_multi (const struct ecc_curve *ecc,
+	       mp_limb_t *r,
+	       size_t count, const mp_limb_t *np, const mp_limb_t *p,
+	       mp_limb_t *scratch)
+{
+  mp_size_t size = ecc->p.size;
+  unsigned c = ecc_mul_multi_wbits (ecc, count);
+  unsigned windows = (ecc->q.bit_size + c) / c;
+  unsigned half = 1U << (c-1);
+  int edwards = ecc_mul_multi_edwards_p (ecc);
+  mp_limb_t r_nonzero;
+  size_t i;
+  unsigned j;
+
+#define points scratch
+#define digits (scratch + count*2*size)
+#define flags (digits + count*windows)
+#define BUCKET(k) (flags + half + (k) * 3*size)
+#define sp BUCKET(half)
+#define tp (sp + 3*size)
+#define qp (tp + 3*size)
+#define scratch_out (qp + 3*size)
+
+  for (i = 0; i < count; i++)
+    {
+      unsigned carry;
+
+      /* Converts to the internal representation, e.g., redc form. */
+      ecc_a_to_j (ecc, qp, p + 2*i*size);
+      mpn_copyi (points + 2*i*size, qp, 2*size);
+
+      /* Recode, storing each digit as 2|d| + sign. */
+      for (j = 0, carry = 0; j < windows; j++)
+	{
+	  unsigned d = get_bits (np + i*size, size, j*c, c) + carry;
+	  if (d > half)
+	    {
+	      digits[i*windows + j] = (((1U << c) - d) << 1) | 1;
+	      carry = 1;
+	    }
+	  else
+	    {
+	      digits[i*windows + j] = d << 1;
+	      carry = 0;
+	    }
+	}
+      assert (carry == 0);
+    }
+
+  r_nonzero = 0;
+
+  for (j = windows; j-- > 0; )
+    {
+      mp_limb_t s_nonzero, t_nonzero;
+      unsigned k;
+
+      if (r_nonzero)
+	for (k = 0; k < c; k++)
+	  {
+	    if (edwards)
+	      ecc_dup_eh (ecc, r, r, scratch_out);
+	    else
+	      ecc_dup_jj (ecc, r, r, scratch_out);
+	  }
+
+      mpn_zero (flags, half);
+
+      for (i = 0; i < count; i++)
+	{
+	  mp_limb_t d = digits[i*windows + j];
+	  mp_limb_t *bucket;
+
+	  if (d < 2)
+	    continue;
+
+	  /* Negation is (x, -y) on Weierstrass curves, and (-x, y) on
+	     Edwards curves. */
+	  mpn_copyi (qp, points + 2*i*size, 2*size);
+	  if (d & 1)
+	    {
+	      mp_limb_t *cp = edwards ? qp : qp + size;
+	      ecc_mod_sub (&ecc->p, cp, ecc->p.m, cp);
+	    }
+	  mpn_copyi (qp + 2*size, ecc->unit, size);
+
+	  d = (d >> 1) - 1;
+	  bucket = BUCKET(d);
+	  if (flags[d])
+	    flags[d] = add_hha (ecc, bucket, qp, scratch_out);
+	  else
+	    {
+	      mpn_copyi (bucket, qp, 3*size);
+	      flags[d] = 1;
+	    }
+	}
+
+      /* sum_k (k+1) B_k = sum_k S_k, where S_k = sum_{l >= k} B_l. */
+      for (k = half, s_nonzero = t_nonzero = 0; k-- > 0; )
+	{
+	  if (flags[k])
+	    add_acc (ecc, sp, &s_nonzero, BUCKET(k), scratch_out);
+	  if (s_nonzero)
+	    add_acc (ecc, tp, &t_nonzero, sp, scratch_out);
+	}
+      if (t_nonzero)
+	add_acc (ecc, r, &r_nonzero, tp, scratch_out);
+    }
+
+  if (!r_nonzero)
+    {
+      /* The zero point is (0, 1, 1) on Edwards curves, and has Z = 0
+	 in Jacobian coordinates. */
+      mpn_zero (r, 3*size);
+      if (edwards)
+	{
+	  mpn_copyi (r + size, ecc->unit, size);
+	  mpn_copyi (r + 2*size, ecc->unit, size);
+	}
+    }
+#undef points
+#undef digits
+#undef flags
+#undef BUCKET
+#undef sp
+#undef tp
+#undef qp
+#undef scratch_out
+}
@@ -0,0 +1,77 @@
+/* ecc-point-mul-multi.c
+
+   Multi-scalar multiplication, high-level interface.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "ecc.h"
+#include "ecc-internal.h"
+
+void
+ecc_point_mul_multi (struct ecc_point *r,
+		     size_t count, const struct ecc_scalar *n,
+		     const struct ecc_point *p)
+{
+  const struct ecc_curve *ecc = r->ecc;
+  mp_size_t size = ecc->p.size;
+  mp_size_t itch;
+  mp_limb_t *np;
+  mp_limb_t *pp;
+  mp_limb_t *rp;
+  mp_limb_t *scratch;
+  size_t i;
+
+  itch = ecc_mul_multi_itch (ecc, count);
+  if (itch < ecc->h_to_a_itch)
+    itch = ecc->h_to_a_itch;
+  itch += (3*count + 3) * size;
+
+  np = gmp_alloc_limbs (itch);
+  pp = np + count*size;
+  rp = pp + 2*count*size;
+  scratch = rp + 3*size;
+
+  for (i = 0; i < count; i++)
+    {
+      assert (n[i].ecc == ecc);
+      assert (p[i].ecc == ecc);
+      mpn_copyi (np + i*size, n[i].p, size);
+      mpn_copyi (pp + 2*i*size, p[i].p, 2*size);
+    }
+
+  ecc_mul_multi (ecc, rp, count, np, pp, scratch);
+  ecc->h_to_a (ecc, ECC_H_TO_A_VARTIME, r->p, rp, scratch);
+
+  gmp_free_limbs (np, itch);
+}
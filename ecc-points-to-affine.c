@@ -0,0 +1,178 @@
+/* ecc-points-to-affine.c
+
+   Conversion of many points to affine coordinates, sharing a single
+   inversion.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "ecc.h"
+#include "ecc-internal.h"
+
+/* Uses Montgomery's trick: With prefix products c_i = z_0 ... z_i,
+   a single inversion of c_{N-1} gives all the z_i^{-1}, using
+   3(N-1) multiplications.
+
+   Scratch layout, with n = ecc->p.size:
+
+     izp	N * n	Prefix products, then inverses
+     up		2n	Inversion input, and products
+     vp		2n	Inversion output, then the running inverse
+     scratch_out	max (p.invert_itch, 6n)
+*/
+mp_size_t
+ecc_points_to_affine_batch_itch (const struct ecc_curve *ecc, size_t count)
+{
+  mp_size_t size = ecc->p.size;
+  mp_size_t out = ecc->p.invert_itch;
+  if (out < 6*size)
+    out = 6*size;
+
+  return count * size + 4*size + out;
+}
+
+/* Conversion of a single point, given izp = z^{-1}, in the same
+   representation as the coordinates. Follows ecc_j_to_a and
+   ecc_eh_to_a. Needs 6*size scratch. */
+static void
+h_to_a_iz (const struct ecc_curve *ecc,
+	   mp_limb_t *r, const mp_limb_t *p, const mp_limb_t *izp,
+	   mp_limb_t *scratch)
+{
+  mp_size_t size = ecc->p.size;
+  mp_limb_t cy;
+
+#define iz2p scratch
+#define iz3p (scratch + 2*size)
+#define izBp (scratch + 2*size)
+#define tp (scratch + 4*size)
+
+  if (ecc->h_to_a == ecc_eh_to_a)
+    {
+      /* r_x = p_x / p_z, r_y = p_y / p_z. */
+      ecc_modp_mul (ecc, tp, p, izp);
+      cy = mpn_sub_n (r, tp, ecc->p.m, size);
+      cnd_copy (cy, r, tp, size);
+
+      ecc_modp_mul (ecc, tp, p + size, izp);
+      cy = mpn_sub_n (r + size, tp, ecc->p.m, size);
+      cnd_copy (cy, r + size, tp, size);
+      return;
+    }
+
+  if (ecc->use_redc)
+    {
+      /* Here izp = B / p_z, and iz2 = izp * (izp/B) / B = p_z^{-2},
+	 without any factor B. */
+      mpn_copyi (izBp, izp, size);
+      mpn_zero (izBp + size, size);
+      ecc->p.reduce (&ecc->p, izBp);
+
+      ecc_modp_mul (ecc, iz2p, izp, izBp);
+    }
+  else
+    ecc_modp_sqr (ecc, iz2p, izp);
+
+  /* r_x = p_x / p_z^2 */
+  ecc_modp_mul (ecc, tp, iz2p, p);
+  cy = mpn_sub_n (r, tp, ecc->p.m, size);
+  cnd_copy (cy, r, tp, size);
+
+  /* r_y = p_y / p_z^3 */
+  ecc_modp_mul (ecc, iz3p, iz2p, izp);
+  ecc_modp_mul (ecc, tp, iz3p, p + size);
+  cy = mpn_sub_n (r + size, tp, ecc->p.m, size);
+  cnd_copy (cy, r + size, tp, size);
+
+#undef iz2p
+#undef iz3p
+#undef izBp
+#undef tp
+}
+
+void
+ecc_points_to_affine_batch (const struct ecc_curve *ecc,
+			    size_t count, mp_limb_t *r, const mp_limb_t *p,
+			    mp_limb_t *scratch)
+{
+  mp_size_t size = ecc->p.size;
+  size_t i;
+
+#define izp scratch
+#define up (scratch + count*size)
+#define vp (up + 2*size)
+#define scratch_out (vp + 2*size)
+#define Z(i) (p + (3*(i) + 2)*size)
+
+  if (count == 0)
+    return;
+
+  mpn_copyi (izp, Z(0), size);
+  for (i = 1; i < count; i++)
+    {
+      ecc_modp_mul (ecc, up, izp + (i-1)*size, Z(i));
+      mpn_copyi (izp + i*size, up, size);
+    }
+
+  mpn_copyi (up, izp + (count-1)*size, size);
+  if (ecc->use_redc)
+    {
+      /* Divide by B^2, so that the inverse gets a factor B, as for
+	 the individual z_i. */
+      mpn_zero (up + size, size);
+      ecc->p.reduce (&ecc->p, up);
+      mpn_zero (up + size, size);
+      ecc->p.reduce (&ecc->p, up);
+    }
+  ecc->p.invert (&ecc->p, vp, up, scratch_out);
+
+  for (i = count; --i > 0; )
+    {
+      /* z_i^{-1} = c_{i-1} c_i^{-1}, and c_{i-1}^{-1} = z_i c_i^{-1} */
+      ecc_modp_mul (ecc, up, vp, izp + (i-1)*size);
+      mpn_copyi (izp + i*size, up, size);
+      ecc_modp_mul (ecc, up, vp, Z(i));
+      mpn_copyi (vp, up, size);
+    }
+  mpn_copyi (izp, vp, size);
+
+  for (i = 0; i < count; i++)
+    h_to_a_iz (ecc, r + 2*i*size, p + 3*i*size, izp + i*size,
+	       scratch_out);
+
+#undef izp
+#undef up
+#undef vp
+#undef scratch_out
+#undef Z
+}
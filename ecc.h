@@ -48,6 +48,7 @@ extern "C" {
 #define ecc_point_get nettle_ecc_point_get
 #define ecc_point_mul nettle_ecc_point_mul
 #define ecc_point_mul_g nettle_ecc_point_mul_g
+#define ecc_point_mul_multi nettle_ecc_point_mul_multi
 #define ecc_scalar_init nettle_ecc_scalar_init
 #define ecc_scalar_clear nettle_ecc_scalar_clear
 #define ecc_scalar_set nettle_ecc_scalar_set
@@ -58,6 +59,10 @@ extern "C" {
 #define ecc_size nettle_ecc_size
 #define ecc_size_a nettle_ecc_size_a
 #define ecc_size_j nettle_ecc_size_j
+#define ecc_mul_multi_itch nettle_ecc_mul_multi_itch
+#define ecc_mul_multi nettle_ecc_mul_multi
+#define ecc_points_to_affine_batch_itch nettle_ecc_points_to_affine_batch_itch
+#define ecc_points_to_affine_batch nettle_ecc_points_to_affine_batch
 
 struct ecc_curve;
 
@@ -116,6 +121,17 @@ ecc_point_mul (struct ecc_point *r, const struct ecc_scalar *n,
 void
 ecc_point_mul_g (struct ecc_point *r, const struct ecc_scalar *n);
 
+/* Computes r = n_0 p_0 + n_1 p_1 + ... + n_{count-1} p_{count-1},
+   much faster than separate calls to ecc_point_mul. The running time
+   depends on the scalars, so use only with public data, e.g., for
+   batch signature verification. If the sum is zero, r is set to the
+   affine representation of the zero point, (0, 0) on Weierstrass
+   curves. */
+void
+ecc_point_mul_multi (struct ecc_point *r,
+		     size_t count, const struct ecc_scalar *n,
+		     const struct ecc_point *p);
+
 
 /* Low-level interface */
   
@@ -149,6 +165,35 @@ ecc_size_a (const struct ecc_curve *ecc);
 mp_size_t
 ecc_size_j (const struct ecc_curve *ecc);
 
+/* Computes R = N_0 P_0 + ... + N_{count-1} P_{count-1}, with the
+   same variable-time algorithm as ecc_point_mul_multi. NP holds the
+   scalars, ecc_size() limbs each, all less than the group order. P
+   holds the points, in affine coordinates, ecc_size_a() limbs each.
+   The output R is in the curve's internal representation, ecc_size_j()
+   limbs, and may be the zero point. The scratch need grows with the
+   number of points. */
+mp_size_t
+ecc_mul_multi_itch (const struct ecc_curve *ecc, size_t count);
+
+void
+ecc_mul_multi (const struct ecc_curve *ecc,
+	       mp_limb_t *r,
+	       size_t count, const mp_limb_t *np, const mp_limb_t *p,
+	       mp_limb_t *scratch);
+
+/* Converts COUNT points from the internal representation,
+   ecc_size_j() limbs each, to affine coordinates, ecc_size_a() limbs
+   each. Much faster than converting one point at a time, since it
+   needs only a single modular inversion. All points must be
+   non-zero. */
+mp_size_t
+ecc_points_to_affine_batch_itch (const struct ecc_curve *ecc, size_t count);
+
+void
+ecc_points_to_affine_batch (const struct ecc_curve *ecc,
+			    size_t count, mp_limb_t *r, const mp_limb_t *p,
+			    mp_limb_t *scratch);
+
 /* FIXME: Define a generic ecc_dup, ecc_add, for any type of curve. Do
    they need to handle infinity points? */
 
@@ -59,3 +59,48 @@ ecdsa_generate_keypair (struct ecc_point *pub,
   ecc->mul_g (ecc, p, key->p, p + 3*ecc->p.size);
   ecc->h_to_a (ecc, 0, pub->p, p, p + 3*ecc->p.size);
 }
+
+void
+ecdsa_generate_keypairs (size_t count,
+			 struct ecc_point *pub,
+			 struct ecc_scalar *key,
+			 void *random_ctx, nettle_random_func *random)
+{
+  const struct ecc_curve *ecc;
+  mp_size_t size;
+  mp_size_t itch;
+  mp_limb_t *p;
+  mp_limb_t *rp;
+  mp_limb_t *scratch;
+  size_t i;
+
+  if (count == 0)
+    return;
+
+  ecc = pub->ecc;
+  size = ecc->p.size;
+
+  itch = ecc_points_to_affine_batch_itch (ecc, count);
+  if (itch < ecc->mul_g_itch)
+    itch = ecc->mul_g_itch;
+  itch += 5*count*size;
+
+  p = gmp_alloc_limbs (itch);
+  rp = p + 3*count*size;
+  scratch = rp + 2*count*size;
+
+  for (i = 0; i < count; i++)
+    {
+      assert (pub[i].ecc == ecc);
+      assert (key[i].ecc == ecc);
+
+      ecc_mod_random (&ecc->q, key[i].p, random_ctx, random, scratch);
+      ecc->mul_g (ecc, p + 3*i*size, key[i].p, scratch);
+    }
+  ecc_points_to_affine_batch (ecc, count, rp, p, scratch);
+
+  for (i = 0; i < count; i++)
+    mpn_copyi (pub[i].p, rp + 2*i*size, 2*size);
+
+  gmp_free_limbs (p, itch);
+}
@@ -45,6 +45,7 @@ extern "C" {
 #define ecdsa_sign nettle_ecdsa_sign
 #define ecdsa_verify nettle_ecdsa_verify
 #define ecdsa_generate_keypair nettle_ecdsa_generate_keypair
+#define ecdsa_generate_keypairs nettle_ecdsa_generate_keypairs
 #define ecc_ecdsa_sign nettle_ecc_ecdsa_sign
 #define ecc_ecdsa_sign_itch nettle_ecc_ecdsa_sign_itch
 #define ecc_ecdsa_verify nettle_ecc_ecdsa_verify
@@ -71,6 +72,15 @@ ecdsa_generate_keypair (struct ecc_point *pub,
 			struct ecc_scalar *key,
 			void *random_ctx, nettle_random_func *random);
 
+/* Generates COUNT keypairs, all on the same curve. Faster than
+   repeated calls to ecdsa_generate_keypair, since the conversions to
+   affine coordinates share a single inversion. */
+void
+ecdsa_generate_keypairs (size_t count,
+			 struct ecc_point *pub,
+			 struct ecc_scalar *key,
+			 void *random_ctx, nettle_random_func *random);
+
 /* Low-level ECDSA functions. */
 mp_size_t
 ecc_ecdsa_sign_itch (const struct ecc_curve *ecc);
@@ -165,6 +165,13 @@ bench_modinv (void *p)
   ctx->ecc->p.invert (&ctx->ecc->p, ctx->rp, ctx->ap, ctx->tp);
 }
 
+static void
+bench_modinv_vartime (void *p)
+{
+  struct ecc_ctx *ctx = (struct ecc_ctx *) p;
+  ctx->ecc->p.invert_vartime (&ctx->ecc->p, ctx->rp, ctx->ap, ctx->tp);
+}
+
 #if !NETTLE_USE_MINI_GMP
 static void
 bench_modinv_gcd (void *p)
@@ -253,7 +260,7 @@ static void
 bench_curve (const struct ecc_curve *ecc)
 {
   struct ecc_ctx ctx;  
-  double modp, reduce, modq, modinv, modinv_gcd, modinv_powm,
+  double modp, reduce, modq, modinv, modinv_vartime, modinv_gcd, modinv_powm,
     dup_jj, add_jja, add_hhh,
     mul_g, mul_a;
 
@@ -292,6 +299,7 @@ bench_curve (const struct ecc_curve *ecc)
   modq = time_function (bench_modq, &ctx);
 
   modinv = time_function (bench_modinv, &ctx);
+  modinv_vartime = time_function (bench_modinv_vartime, &ctx);
 #if !NETTLE_USE_MINI_GMP
   modinv_gcd = time_function (bench_modinv_gcd, &ctx);
 #else
@@ -322,13 +330,151 @@ bench_curve (const struct ecc_curve *ecc)
   free (ctx.bp);
   free (ctx.tp);
 
-  printf ("%4d %6.4f %6.4f %6.4f %6.2f %6.3f %6.2f %6.3f %6.3f %6.3f %6.1f %6.1f\n",
+  printf ("%4d %6.4f %6.4f %6.4f %6.2f %6.2f %6.3f %6.2f %6.3f %6.3f %6.3f %6.1f %6.1f\n",
 	  ecc->p.bit_size, 1e6 * modp, 1e6 * reduce, 1e6 * modq,
-	  1e6 * modinv, 1e6 * modinv_gcd, 1e6 * modinv_powm,
+	  1e6 * modinv, 1e6 * modinv_vartime, 1e6 * modinv_gcd, 1e6 * modinv_powm,
 	  1e6 * dup_jj, 1e6 * add_jja, 1e6 * add_hhh,
 	  1e6 * mul_g, 1e6 * mul_a);
 }
 
+#define numberof(x)  (sizeof (x) / sizeof ((x)[0]))
+
+struct multi_ctx {
+  const struct ecc_curve *ecc;
+  size_t count;
+  mp_limb_t *np;
+  mp_limb_t *p;
+  mp_limb_t *rp;
+  mp_limb_t *tp;
+};
+
+static void
+bench_mul_a_1 (void *p)
+{
+  struct multi_ctx *ctx = (struct multi_ctx *) p;
+  ctx->ecc->mul (ctx->ecc, ctx->rp, ctx->np, ctx->p, ctx->tp);
+}
+
+static void
+bench_mul_multi (void *p)
+{
+  struct multi_ctx *ctx = (struct multi_ctx *) p;
+  ecc_mul_multi (ctx->ecc, ctx->rp, ctx->count, ctx->np, ctx->p, ctx->tp);
+}
+
+/* Compares ecc_mul_multi to the same number of separate ecc->mul
+   calls. Times are per point. */
+static void
+bench_multi (const struct ecc_curve *ecc)
+{
+  static const size_t counts[] = { 1, 10, 100, 1000 };
+  size_t max_count = counts[numberof (counts) - 1];
+  mp_size_t size = ecc->p.size;
+  struct multi_ctx ctx;
+  mp_limb_t mask;
+  mp_size_t itch;
+  double mul_a;
+  size_t i;
+
+  ctx.ecc = ecc;
+  ctx.np = xalloc_limbs (max_count * size);
+  ctx.p = xalloc_limbs (max_count * 2*size);
+  ctx.rp = xalloc_limbs (3*size);
+  itch = ecc_mul_multi_itch (ecc, max_count);
+  if (itch < ecc->mul_itch)
+    itch = ecc->mul_itch;
+  if (itch < ecc->mul_g_itch)
+    itch = ecc->mul_g_itch;
+  if (itch < ecc->h_to_a_itch)
+    itch = ecc->h_to_a_itch;
+  ctx.tp = xalloc_limbs (itch);
+
+  mask = (~(mp_limb_t) 0) >> (size * GMP_NUMB_BITS - ecc->q.bit_size + 1);
+  mpn_random (ctx.np, max_count * size);
+  for (i = 0; i < max_count; i++)
+    ctx.np[(i+1)*size - 1] &= mask;
+
+  /* Valid points, needed for the variable-time algorithm. */
+  for (i = 0; i < max_count; i++)
+    {
+      ecc->mul_g (ecc, ctx.rp, ctx.np + i*size, ctx.tp);
+      ecc->h_to_a (ecc, 0, ctx.p + 2*i*size, ctx.rp, ctx.tp);
+    }
+
+  mul_a = time_function (bench_mul_a_1, &ctx);
+
+  for (i = 0; i < numberof (counts); i++)
+    {
+      double multi;
+      ctx.count = counts[i];
+      multi = time_function (bench_mul_multi, &ctx) / ctx.count;
+      printf ("%4d %5u %8.2f %8.2f %6.2f\n",
+	      ecc->p.bit_size, (unsigned) ctx.count,
+	      1e6 * mul_a, 1e6 * multi, mul_a / multi);
+    }
+
+  free (ctx.np);
+  free (ctx.p);
+  free (ctx.rp);
+  free (ctx.tp);
+}
+
+struct to_affine_ctx {
+  const struct ecc_curve *ecc;
+  size_t count;
+  mp_limb_t *p;
+  mp_limb_t *rp;
+  mp_limb_t *tp;
+};
+
+static void
+bench_h_to_a (void *p)
+{
+  struct to_affine_ctx *ctx = (struct to_affine_ctx *) p;
+  ctx->ecc->h_to_a (ctx->ecc, 0, ctx->rp, ctx->p, ctx->tp);
+}
+
+static void
+bench_to_affine_batch (void *p)
+{
+  struct to_affine_ctx *ctx = (struct to_affine_ctx *) p;
+  ecc_points_to_affine_batch (ctx->ecc, ctx->count, ctx->rp, ctx->p, ctx->tp);
+}
+
+/* Compares ecc_points_to_affine_batch to converting one point at a
+   time. Times are per point. */
+static void
+bench_to_affine (const struct ecc_curve *ecc)
+{
+  mp_size_t size = ecc->p.size;
+  struct to_affine_ctx ctx;
+  mp_size_t itch;
+  double h_to_a, batch;
+
+  ctx.ecc = ecc;
+  ctx.count = 100;
+  ctx.p = xalloc_limbs (3*ctx.count*size);
+  ctx.rp = xalloc_limbs (2*ctx.count*size);
+  itch = ecc_points_to_affine_batch_itch (ecc, ctx.count);
+  if (itch < ecc->h_to_a_itch)
+    itch = ecc->h_to_a_itch;
+  ctx.tp = xalloc_limbs (itch);
+
+  /* Any non-zero z will do. */
+  mpn_random (ctx.p, 3*ctx.count*size);
+
+  h_to_a = time_function (bench_h_to_a, &ctx);
+  batch = time_function (bench_to_affine_batch, &ctx) / ctx.count;
+
+  printf ("%4d %5u %8.3f %8.3f %6.2f\n",
+	  ecc->p.bit_size, (unsigned) ctx.count,
+	  1e6 * h_to_a, 1e6 * batch, h_to_a / batch);
+
+  free (ctx.p);
+  free (ctx.rp);
+  free (ctx.tp);
+}
+
 const struct ecc_curve * const curves[] = {
   &_nettle_secp_192r1,
   &_nettle_secp_224r1,
@@ -343,20 +489,28 @@ const struct ecc_curve * const curves[] = {
   &_nettle_gost_512b,
 };
 
-#define numberof(x)  (sizeof (x) / sizeof ((x)[0]))
-
 int
 main (int argc UNUSED, char **argv UNUSED)
 {
   unsigned i;
 
   time_init();
-  printf ("%4s %6s %6s %6s %6s %6s %6s %6s %6s %6s %6s %6s (us)\n",
-	  "size", "modp", "reduce", "modq", "modinv", "mi_gcd", "mi_pow",
+  printf ("%4s %6s %6s %6s %6s %6s %6s %6s %6s %6s %6s %6s %6s (us)\n",
+	  "size", "modp", "reduce", "modq", "modinv", "mi_var", "mi_gcd", "mi_pow",
 	  "dup_jj", "ad_jja", "ad_hhh",
 	  "mul_g", "mul_a");
   for (i = 0; i < numberof (curves); i++)
     bench_curve (curves[i]);
 
+  printf ("\n%4s %5s %8s %8s %6s (us per point)\n",
+	  "size", "count", "mul_a", "multi", "ratio");
+  for (i = 0; i < numberof (curves); i++)
+    bench_multi (curves[i]);
+
+  printf ("\n%4s %5s %8s %8s %6s (us per point)\n",
+	  "size", "count", "h_to_a", "batch", "ratio");
+  for (i = 0; i < numberof (curves); i++)
+    bench_to_affine (curves[i]);
+
   return EXIT_SUCCESS;
 }
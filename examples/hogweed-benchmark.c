@@ -44,6 +44,7 @@
 #include <time.h>
 
 #include "timing.h"
+#include "getopt.h"
 
 #include "dsa.h"
 #include "rsa.h"
@@ -54,7 +55,9 @@
 #include "knuth-lfib.h"
 
 #include "../ecdsa.h"
+#include "../gostdsa.h"
 #include "../ecc-internal.h"
+#include "../rsa-internal.h"
 #include "../gmp-glue.h"
 
 #if WITH_OPENSSL
@@ -139,33 +142,204 @@ time_function(void (*f)(void *arg), void *arg)
   return elapsed / ncalls;
 }
 
+/* Per-call timing statistics, all in seconds. The percentiles are
+   computed only with --latency. */
+struct bench_stats
+{
+  double mean;
+  double p50;
+  double p99;
+  double p999;
+};
+
+enum bench_format { FORMAT_TEXT, FORMAT_CSV, FORMAT_JSON };
+
+static enum bench_format format = FORMAT_TEXT;
+static int latency = 0;
+static int json_first = 1;
+
+/* Number of individually timed calls for --latency. At least enough
+   for a meaningful p999, and more for fast operations, so that the
+   total sampling time is close to LATENCY_INTERVAL. */
+#define LATENCY_INTERVAL 0.2
+#define LATENCY_MIN_SAMPLES 1000
+#define LATENCY_MAX_SAMPLES 100000
+
+static int
+compare_double (const void *ap, const void *bp)
+{
+  double a = *(const double *) ap;
+  double b = *(const double *) bp;
+  return (a > b) - (a < b);
+}
+
+/* Nearest-rank percentile, with p in per mille. */
+static double
+percentile (const double *samples, unsigned count, unsigned p)
+{
+  unsigned long rank = ((unsigned long) p * count + 999) / 1000;
+  return samples[rank > 0 ? rank - 1 : 0];
+}
+
+static void
+bench_function (void (*f)(void *arg), void *arg, struct bench_stats *stats)
+{
+  double *samples;
+  double n;
+  unsigned count;
+  unsigned i;
+
+  stats->mean = time_function (f, arg);
+  stats->p50 = stats->p99 = stats->p999 = 0.0;
+
+  if (!latency)
+    return;
+
+  n = LATENCY_INTERVAL / stats->mean;
+  if (n < LATENCY_MIN_SAMPLES)
+    count = LATENCY_MIN_SAMPLES;
+  else if (n > LATENCY_MAX_SAMPLES)
+    count = LATENCY_MAX_SAMPLES;
+  else
+    count = n;
+
+  samples = xalloc (count * sizeof(*samples));
+  for (i = 0; i < count; i++)
+    {
+      time_start();
+      f(arg);
+      samples[i] = time_end();
+    }
+  qsort (samples, count, sizeof(*samples), compare_double);
+
+  stats->p50 = percentile (samples, count, 500);
+  stats->p99 = percentile (samples, count, 990);
+  stats->p999 = percentile (samples, count, 999);
+
+  free (samples);
+}
+
+/* With pairs non-zero, the default text output has a single line for
+   each pair of operations, see report_pair. */
+static void
+report_header (int pairs)
+{
+  switch (format)
+    {
+    case FORMAT_TEXT:
+      if (latency)
+	printf ("%16s %4s %8s %9s %9s %9s %9s\n",
+		"name", "size", "op", "ops/ms", "p50/us", "p99/us", "p999/us");
+      else if (pairs)
+	printf ("%16s %4s %9s %9s\n",
+		"name", "size", "sign/ms", "verify/ms");
+      else
+	printf ("%16s %4s %8s %9s\n", "name", "size", "op", "ops/ms");
+      break;
+    case FORMAT_CSV:
+      printf ("name,size,op,ops_per_ms,p50_us,p99_us,p999_us\n");
+      break;
+    case FORMAT_JSON:
+      printf ("[");
+      break;
+    }
+}
+
+static void
+report_footer (void)
+{
+  if (format == FORMAT_JSON)
+    printf ("\n]\n");
+}
+
+static void
+report_op (const char *name, unsigned size, const char *op,
+	   const struct bench_stats *stats)
+{
+  switch (format)
+    {
+    case FORMAT_TEXT:
+      printf ("%16s %4d %8s %9.4f", name, size, op, 1e-3/stats->mean);
+      if (latency)
+	printf (" %9.2f %9.2f %9.2f",
+		1e6*stats->p50, 1e6*stats->p99, 1e6*stats->p999);
+      printf ("\n");
+      break;
+    case FORMAT_CSV:
+      printf ("%s,%d,%s,%.4f", name, size, op, 1e-3/stats->mean);
+      if (latency)
+	printf (",%.3f,%.3f,%.3f\n",
+		1e6*stats->p50, 1e6*stats->p99, 1e6*stats->p999);
+      else
+	printf (",,,\n");
+      break;
+    case FORMAT_JSON:
+      printf ("%s\n  {\"name\": \"%s\", \"size\": %d, \"op\": \"%s\", "
+	      "\"ops_per_ms\": %.4f, ",
+	      json_first ? "" : ",", name, size, op, 1e-3/stats->mean);
+      if (latency)
+	printf ("\"p50_us\": %.3f, \"p99_us\": %.3f, \"p999_us\": %.3f}",
+		1e6*stats->p50, 1e6*stats->p99, 1e6*stats->p999);
+      else
+	printf ("\"p50_us\": null, \"p99_us\": null, \"p999_us\": null}");
+      json_first = 0;
+      break;
+    }
+}
+
+/* Reports two operations benchmarked together, e.g., sign and verify,
+   on one text line. A NULL stats1 reports only the second operation. */
+static void
+report_pair (const char *name, unsigned size,
+	     const char *op1, const struct bench_stats *stats1,
+	     const char *op2, const struct bench_stats *stats2)
+{
+  if (format == FORMAT_TEXT && !latency)
+    {
+      if (stats1)
+	printf("%16s %4d %9.4f %9.4f\n",
+	       name, size, 1e-3/stats1->mean, 1e-3/stats2->mean);
+      else
+	printf("%16s %4d %9s %9.4f\n",
+	       name, size, "-", 1e-3/stats2->mean);
+    }
+  else
+    {
+      if (stats1)
+	report_op (name, size, op1, stats1);
+      report_op (name, size, op2, stats2);
+    }
+}
+
 static void 
 bench_alg (const struct alg *alg)
 {
-  double sign;
-  double verify;
+  struct bench_stats sign;
+  struct bench_stats verify;
   void *ctx;
 
   ctx = alg->init(alg->size);
   if (ctx == NULL)
     {
-      printf("%16s %4d N/A\n", alg->name, alg->size);
+      if (format == FORMAT_TEXT)
+	printf("%16s %4d N/A\n", alg->name, alg->size);
       return;
     }
 
-  sign = time_function (alg->sign, ctx);
-  verify = time_function (alg->verify, ctx);
+  bench_function (alg->sign, ctx, &sign);
+  bench_function (alg->verify, ctx, &verify);
 
   alg->clear (ctx);
 
-  printf("%16s %4d %9.4f %9.4f\n",
-	 alg->name, alg->size, 1e-3/sign, 1e-3/verify);
+  report_pair (alg->name, alg->size, "sign", &sign, "verify", &verify);
 }
 
 struct rsa_ctx
 {
   struct rsa_public_key pub;
   struct rsa_private_key key;
+  struct rsa_private_precomp pre;
+  struct rsa_blinding blinding;
   struct knuth_lfib_ctx lfib;
   uint8_t *digest;
   mpz_t s;
@@ -224,6 +398,7 @@ bench_rsa_init (unsigned size)
 
   rsa_public_key_init (&ctx->pub);
   rsa_private_key_init (&ctx->key);
+  rsa_blinding_init (&ctx->blinding);
   mpz_init (ctx->s);
   knuth_lfib_init (&ctx->lfib, 1);
 
@@ -238,7 +413,8 @@ bench_rsa_init (unsigned size)
   if (! (res
 	 && sexp_iterator_check_type (&i, "private-key")
 	 && sexp_iterator_check_type (&i, "rsa-pkcs1-sha1")
-	 && rsa_keypair_from_sexp_alist (&ctx->pub, &ctx->key, 0, &i)))
+	 && rsa_keypair_from_sexp_alist (&ctx->pub, &ctx->key, 0, &i)
+	 && rsa_private_precomp_init (&ctx->pre, &ctx->pub, &ctx->key)))
     die ("Internal error.\n");
 
   ctx->digest = hash_string (&nettle_sha256, "foo");
@@ -272,6 +448,20 @@ bench_rsa_sign_tr (void *p)
   mpz_clear (s);
 }
 
+static void
+bench_rsa_sign_tr_blinding (void *p)
+{
+  struct rsa_ctx *ctx = p;
+
+  mpz_t s;
+  mpz_init (s);
+  rsa_sha256_sign_digest_tr_blinding (&ctx->pub, &ctx->key, &ctx->pre,
+				      &ctx->blinding, &ctx->lfib,
+				      (nettle_random_func *)knuth_lfib_random,
+				      ctx->digest, s);
+  mpz_clear (s);
+}
+
 static void
 bench_rsa_verify (void *p)
 {
@@ -280,6 +470,15 @@ bench_rsa_verify (void *p)
     die ("Internal error, rsa_sha256_verify_digest failed.\n");
 }
 
+static void
+bench_rsa_verify_precomp (void *p)
+{
+  struct rsa_ctx *ctx = p;
+  if (! rsa_sha256_verify_digest_precomp (&ctx->pub, &ctx->pre.pub,
+					  ctx->digest, ctx->s))
+    die ("Internal error, rsa_sha256_verify_digest_precomp failed.\n");
+}
+
 static void
 bench_rsa_clear (void *p)
 {
@@ -287,12 +486,199 @@ bench_rsa_clear (void *p)
 
   rsa_public_key_clear (&ctx->pub);
   rsa_private_key_clear (&ctx->key);
+  rsa_private_precomp_clear (&ctx->pre);
+  rsa_blinding_clear (&ctx->blinding);
   mpz_clear (ctx->s);
   
   free (ctx->digest);
   free (ctx);
 }
 
+/* Batch verification, reported per signature. */
+#define RSA_BATCH_SIZE 16
+#define RSA_PSS_SALT_SIZE 32
+
+struct rsa_verify_batch_ctx
+{
+  struct rsa_ctx *rsa;
+  uint8_t *digests;
+  uint8_t *pkcs1;
+  uint8_t *pss;
+};
+
+static void
+bench_rsa_verify_batch_pkcs1 (void *p)
+{
+  struct rsa_verify_batch_ctx *ctx = p;
+  if (! rsa_sha256_verify_digest_batch (&ctx->rsa->pub, &ctx->rsa->pre.pub,
+					RSA_BATCH_SIZE, ctx->digests,
+					ctx->pkcs1, NULL))
+    die ("Internal error, rsa_sha256_verify_digest_batch failed.\n");
+}
+
+static void
+bench_rsa_verify_batch_pss (void *p)
+{
+  struct rsa_verify_batch_ctx *ctx = p;
+  if (! rsa_pss_sha256_verify_digest_batch (&ctx->rsa->pub, &ctx->rsa->pre.pub,
+					    RSA_PSS_SALT_SIZE,
+					    RSA_BATCH_SIZE, ctx->digests,
+					    ctx->pss, NULL))
+    die ("Internal error, rsa_pss_sha256_verify_digest_batch failed.\n");
+}
+
+static void
+scale_stats (struct bench_stats *stats, unsigned n)
+{
+  stats->mean /= n;
+  stats->p50 /= n;
+  stats->p99 /= n;
+  stats->p999 /= n;
+}
+
+static void
+bench_rsa_verify_batch (unsigned size, const char *filter)
+{
+  static const char name[] = "rsa-verify-batch";
+  struct rsa_verify_batch_ctx ctx;
+  struct bench_stats pkcs1;
+  struct bench_stats pss;
+  uint8_t salt[RSA_PSS_SALT_SIZE];
+  unsigned i;
+
+  if (filter && !strstr (name, filter))
+    return;
+
+  ctx.rsa = bench_rsa_init (size);
+  ctx.digests = xalloc (RSA_BATCH_SIZE * SHA256_DIGEST_SIZE);
+  ctx.pkcs1 = xalloc (RSA_BATCH_SIZE * ctx.rsa->pub.size);
+  ctx.pss = xalloc (RSA_BATCH_SIZE * ctx.rsa->pub.size);
+
+  knuth_lfib_random (&ctx.rsa->lfib, RSA_BATCH_SIZE * SHA256_DIGEST_SIZE,
+		     ctx.digests);
+
+  for (i = 0; i < RSA_BATCH_SIZE; i++)
+    {
+      const uint8_t *digest = ctx.digests + i * SHA256_DIGEST_SIZE;
+      knuth_lfib_random (&ctx.rsa->lfib, sizeof(salt), salt);
+
+      if (! (rsa_sha256_sign_digest (&ctx.rsa->key, digest, ctx.rsa->s)))
+	die ("Internal error, rsa_sha256_sign_digest failed.\n");
+      nettle_mpz_get_str_256 (ctx.rsa->pub.size,
+			      ctx.pkcs1 + i * ctx.rsa->pub.size, ctx.rsa->s);
+
+      if (! (rsa_pss_sha256_sign_digest_tr (&ctx.rsa->pub, &ctx.rsa->key,
+					    &ctx.rsa->lfib,
+					    (nettle_random_func *) knuth_lfib_random,
+					    sizeof(salt), salt, digest,
+					    ctx.rsa->s)))
+	die ("Internal error, rsa_pss_sha256_sign_digest_tr failed.\n");
+      nettle_mpz_get_str_256 (ctx.rsa->pub.size,
+			      ctx.pss + i * ctx.rsa->pub.size, ctx.rsa->s);
+    }
+
+  bench_function (bench_rsa_verify_batch_pkcs1, &ctx, &pkcs1);
+  bench_function (bench_rsa_verify_batch_pss, &ctx, &pss);
+  scale_stats (&pkcs1, RSA_BATCH_SIZE);
+  scale_stats (&pss, RSA_BATCH_SIZE);
+
+  report_pair (name, size, "pkcs1", &pkcs1, "pss", &pss);
+
+  free (ctx.digests);
+  free (ctx.pkcs1);
+  free (ctx.pss);
+  bench_rsa_clear (ctx.rsa);
+}
+
+/* Batch signing and decryption with a single worker, reported per
+   operation. */
+#define RSA_DECRYPT_LENGTH 32
+
+struct rsa_sign_batch_ctx
+{
+  struct rsa_ctx *rsa;
+  struct rsa_worker worker;
+  uint8_t *digests;
+  mpz_t s[RSA_BATCH_SIZE];
+  uint8_t *ciphertexts;
+  uint8_t *messages;
+};
+
+static void
+bench_rsa_sign_batch_sign (void *p)
+{
+  struct rsa_sign_batch_ctx *ctx = p;
+  if (! rsa_sha256_sign_digest_tr_batch (&ctx->rsa->pub, &ctx->rsa->key,
+					 &ctx->rsa->pre, 1, &ctx->worker,
+					 NULL, NULL, RSA_BATCH_SIZE,
+					 ctx->digests, ctx->s))
+    die ("Internal error, rsa_sha256_sign_digest_tr_batch failed.\n");
+}
+
+static void
+bench_rsa_sign_batch_decrypt (void *p)
+{
+  struct rsa_sign_batch_ctx *ctx = p;
+  if (! rsa_sec_decrypt_batch (&ctx->rsa->pub, &ctx->rsa->key,
+			       &ctx->rsa->pre, 1, &ctx->worker,
+			       NULL, NULL, RSA_BATCH_SIZE, RSA_DECRYPT_LENGTH,
+			       ctx->messages, ctx->ciphertexts, NULL))
+    die ("Internal error, rsa_sec_decrypt_batch failed.\n");
+}
+
+static void
+bench_rsa_sign_batch (unsigned size, const char *filter)
+{
+  static const char name[] = "rsa-sign-batch";
+  struct rsa_sign_batch_ctx ctx;
+  struct bench_stats sign;
+  struct bench_stats decrypt;
+  unsigned i;
+
+  if (filter && !strstr (name, filter))
+    return;
+
+  ctx.rsa = bench_rsa_init (size);
+  rsa_worker_init (&ctx.worker, &ctx.rsa->pub, &ctx.rsa->key, &ctx.rsa->pre,
+		   &ctx.rsa->lfib, (nettle_random_func *) knuth_lfib_random);
+  ctx.digests = xalloc (RSA_BATCH_SIZE * SHA256_DIGEST_SIZE);
+  ctx.ciphertexts = xalloc (RSA_BATCH_SIZE * ctx.rsa->pub.size);
+  ctx.messages = xalloc (RSA_BATCH_SIZE * RSA_DECRYPT_LENGTH);
+
+  knuth_lfib_random (&ctx.rsa->lfib, RSA_BATCH_SIZE * SHA256_DIGEST_SIZE,
+		     ctx.digests);
+  knuth_lfib_random (&ctx.rsa->lfib, RSA_BATCH_SIZE * RSA_DECRYPT_LENGTH,
+		     ctx.messages);
+
+  for (i = 0; i < RSA_BATCH_SIZE; i++)
+    {
+      mpz_init (ctx.s[i]);
+      if (! rsa_encrypt (&ctx.rsa->pub,
+			 &ctx.rsa->lfib, (nettle_random_func *) knuth_lfib_random,
+			 RSA_DECRYPT_LENGTH,
+			 ctx.messages + i * RSA_DECRYPT_LENGTH, ctx.rsa->s))
+	die ("Internal error, rsa_encrypt failed.\n");
+      nettle_mpz_get_str_256 (ctx.rsa->pub.size,
+			      ctx.ciphertexts + i * ctx.rsa->pub.size,
+			      ctx.rsa->s);
+    }
+
+  bench_function (bench_rsa_sign_batch_sign, &ctx, &sign);
+  bench_function (bench_rsa_sign_batch_decrypt, &ctx, &decrypt);
+  scale_stats (&sign, RSA_BATCH_SIZE);
+  scale_stats (&decrypt, RSA_BATCH_SIZE);
+
+  report_pair (name, size, "sign", &sign, "decrypt", &decrypt);
+
+  for (i = 0; i < RSA_BATCH_SIZE; i++)
+    mpz_clear (ctx.s[i]);
+  free (ctx.digests);
+  free (ctx.ciphertexts);
+  free (ctx.messages);
+  rsa_worker_clear (&ctx.worker);
+  bench_rsa_clear (ctx.rsa);
+}
+
 struct dsa_ctx
 {
   struct dsa_params params;
@@ -523,6 +909,150 @@ bench_ecdsa_clear (void *p)
   free (ctx);
 }
 
+struct gostdsa_ctx
+{
+  struct ecc_point pub;
+  struct ecc_scalar key;
+  struct knuth_lfib_ctx rctx;
+  unsigned digest_size;
+  uint8_t *digest;
+  struct dsa_signature s;
+  /* For the online signing benchmark, a precomputed nonce and the
+     corresponding r. */
+  mp_limb_t *kr;
+  mp_limb_t *scratch;
+};
+
+static void *
+gostdsa_init_curve (const struct ecc_curve *ecc,
+		    const struct nettle_hash *hash)
+{
+  struct gostdsa_ctx *ctx;
+  mp_size_t n;
+
+  ctx = xalloc (sizeof(*ctx));
+
+  dsa_signature_init (&ctx->s);
+  knuth_lfib_init (&ctx->rctx, 17);
+
+  ctx->digest = hash_string (hash, "abc");
+  ctx->digest_size = hash->digest_size;
+
+  ecc_point_init (&ctx->pub, ecc);
+  ecc_scalar_init (&ctx->key, ecc);
+
+  gostdsa_generate_keypair (&ctx->pub, &ctx->key,
+			    &ctx->rctx, (nettle_random_func *) knuth_lfib_random);
+
+  gostdsa_sign (&ctx->key,
+		&ctx->rctx, (nettle_random_func *) knuth_lfib_random,
+		ctx->digest_size, ctx->digest,
+		&ctx->s);
+
+  n = ecc->p.size;
+  ctx->kr = xalloc (2*n * sizeof(mp_limb_t));
+  ctx->scratch = xalloc (ecc_gostdsa_sign_itch (ecc) * sizeof(mp_limb_t));
+  do
+    ecc_mod_random (&ecc->q, ctx->kr,
+		    &ctx->rctx, (nettle_random_func *) knuth_lfib_random,
+		    ctx->scratch);
+  while (mpn_zero_p (ctx->kr, n));
+  ecc_gostdsa_sign_offline (ecc, ctx->kr, ctx->kr + n, ctx->scratch);
+
+  return ctx;
+}
+
+static void *
+bench_gostdsa_cpa_init (unsigned size UNUSED)
+{
+  return gostdsa_init_curve (&_nettle_gost_256cpa, &nettle_streebog256);
+}
+
+static void *
+bench_gostdsa_cpb_init (unsigned size UNUSED)
+{
+  return gostdsa_init_curve (&_nettle_gost_256cpb, &nettle_streebog256);
+}
+
+static void *
+bench_gostdsa_cpc_init (unsigned size UNUSED)
+{
+  return gostdsa_init_curve (&_nettle_gost_256cpc, &nettle_streebog256);
+}
+
+static void *
+bench_gostdsa_a_init (unsigned size UNUSED)
+{
+  return gostdsa_init_curve (&_nettle_gost_512a, &nettle_streebog512);
+}
+
+static void *
+bench_gostdsa_b_init (unsigned size UNUSED)
+{
+  return gostdsa_init_curve (&_nettle_gost_512b, &nettle_streebog512);
+}
+
+static void
+bench_gostdsa_sign (void *p)
+{
+  struct gostdsa_ctx *ctx = p;
+  struct dsa_signature s;
+
+  dsa_signature_init (&s);
+  gostdsa_sign (&ctx->key,
+		&ctx->rctx, (nettle_random_func *) knuth_lfib_random,
+		ctx->digest_size, ctx->digest,
+		&s);
+  dsa_signature_clear (&s);
+}
+
+/* Only the part done by gostdsa_sign_online, reusing the same
+   precomputed nonce every time. */
+static void
+bench_gostdsa_sign_online (void *p)
+{
+  struct gostdsa_ctx *ctx = p;
+  const struct ecc_curve *ecc = ctx->key.ecc;
+  mp_size_t n = ecc->p.size;
+  struct dsa_signature s;
+  mp_limb_t *rp, *sp;
+
+  dsa_signature_init (&s);
+  rp = mpz_limbs_write (s.r, n);
+  sp = mpz_limbs_write (s.s, n);
+  mpn_copyi (rp, ctx->kr + n, n);
+  ecc_gostdsa_sign_online (ecc, ctx->key.p, ctx->kr, rp,
+			   ctx->digest_size, ctx->digest, sp, ctx->scratch);
+  mpz_limbs_finish (s.r, n);
+  mpz_limbs_finish (s.s, n);
+  dsa_signature_clear (&s);
+}
+
+static void
+bench_gostdsa_verify (void *p)
+{
+  struct gostdsa_ctx *ctx = p;
+  if (! gostdsa_verify (&ctx->pub,
+			ctx->digest_size, ctx->digest,
+			&ctx->s))
+    die ("Internal error, gostdsa_verify failed.\n");
+}
+
+static void
+bench_gostdsa_clear (void *p)
+{
+  struct gostdsa_ctx *ctx = p;
+
+  ecc_point_clear (&ctx->pub);
+  ecc_scalar_clear (&ctx->key);
+  dsa_signature_clear (&ctx->s);
+  free (ctx->digest);
+  free (ctx->kr);
+  free (ctx->scratch);
+
+  free (ctx);
+}
+
 #if WITH_OPENSSL
 struct openssl_rsa_ctx
 {
@@ -709,8 +1239,8 @@ bench_curve25519_mul (void *p)
 static void
 bench_curve25519 (void)
 {
-  double mul_g;
-  double mul;
+  struct bench_stats mul_g;
+  struct bench_stats mul;
   struct knuth_lfib_ctx lfib;
   struct curve25519_ctx ctx;
   knuth_lfib_init (&lfib, 2);
@@ -718,18 +1248,126 @@ bench_curve25519 (void)
   knuth_lfib_random (&lfib, sizeof(ctx.s), ctx.s);
   curve25519_mul_g (ctx.x, ctx.s);
 
-  mul_g = time_function (bench_curve25519_mul_g, &ctx);
-  mul = time_function (bench_curve25519_mul, &ctx);
+  bench_function (bench_curve25519_mul_g, &ctx, &mul_g);
+  bench_function (bench_curve25519_mul, &ctx, &mul);
 
-  printf("%16s %4d %9.4f %9.4f\n",
-	 "curve25519", 255, 1e-3/mul_g, 1e-3/mul);
+  report_pair ("curve25519", 255, "mul_g", &mul_g, "mul", &mul);
 }
 
+struct gostdsa_vko_ctx
+{
+  struct knuth_lfib_ctx rctx;
+  struct ecc_point pub;
+  struct ecc_scalar key;
+  /* Peer public key */
+  struct ecc_point peer;
+  const struct nettle_hash *hash;
+  void *hash_ctx;
+  uint8_t ukm[8];
+};
+
+static void
+bench_gostdsa_keygen (void *p)
+{
+  struct gostdsa_vko_ctx *ctx = p;
+  gostdsa_generate_keypair (&ctx->pub, &ctx->key,
+			    &ctx->rctx, (nettle_random_func *) knuth_lfib_random);
+}
+
+/* Key agreement as in RFC 7836, i.e., VKO followed by hashing with
+   streebog256 or streebog512. */
+static void
+bench_gostdsa_vko (void *p)
+{
+  struct gostdsa_vko_ctx *ctx = p;
+  uint8_t out[128];
+  int length;
+
+  length = gostdsa_vko (&ctx->key, &ctx->peer,
+			sizeof(ctx->ukm), ctx->ukm, sizeof(out), out);
+  if (!length)
+    die ("Internal error, gostdsa_vko failed.\n");
+
+  ctx->hash->init (ctx->hash_ctx);
+  ctx->hash->update (ctx->hash_ctx, length, out);
+  ctx->hash->digest (ctx->hash_ctx, ctx->hash->digest_size, out);
+}
+
+static void
+bench_gostdsa_kex (const char *name, unsigned size,
+		   const struct ecc_curve *ecc, const char *filter)
+{
+  static const struct nettle_hash * const hashes[2] =
+    { &nettle_streebog256, &nettle_streebog512 };
+  static const char * const kex_names[2] = { "vko256", "vko512" };
+  struct gostdsa_vko_ctx ctx;
+  struct ecc_scalar peer_key;
+  struct bench_stats keygen;
+  struct bench_stats vko;
+  int have_keygen;
+  unsigned i;
+
+  knuth_lfib_init (&ctx.rctx, 17);
+  knuth_lfib_random (&ctx.rctx, sizeof(ctx.ukm), ctx.ukm);
+
+  ecc_point_init (&ctx.pub, ecc);
+  ecc_scalar_init (&ctx.key, ecc);
+  ecc_point_init (&ctx.peer, ecc);
+  ecc_scalar_init (&peer_key, ecc);
+
+  gostdsa_generate_keypair (&ctx.peer, &peer_key,
+			    &ctx.rctx, (nettle_random_func *) knuth_lfib_random);
+
+  /* Key generation doesn't depend on the hash, so it is benchmarked
+     and reported only for the first row that isn't filtered out. */
+  for (i = 0, have_keygen = 0; i < 2; i++)
+    {
+      char row[30];
+      snprintf (row, sizeof(row), "gost-%s-%s", kex_names[i], name);
+      if (filter && !strstr (row, filter))
+	continue;
+
+      ctx.hash = hashes[i];
+      ctx.hash_ctx = xalloc (ctx.hash->context_size);
+
+      /* Also sets up ctx.key, used by vko. */
+      if (!have_keygen)
+	bench_function (bench_gostdsa_keygen, &ctx, &keygen);
+
+      bench_function (bench_gostdsa_vko, &ctx, &vko);
+      report_pair (row, size, "keygen", have_keygen ? NULL : &keygen,
+		   "vko", &vko);
+      have_keygen = 1;
+
+      free (ctx.hash_ctx);
+    }
+
+  ecc_point_clear (&ctx.pub);
+  ecc_scalar_clear (&ctx.key);
+  ecc_point_clear (&ctx.peer);
+  ecc_scalar_clear (&peer_key);
+}
+
+static const struct
+{
+  const char *name;
+  unsigned size;
+  const struct ecc_curve *ecc;
+} gost_curves[] = {
+  { "cpa", 256, &_nettle_gost_256cpa },
+  { "cpb", 256, &_nettle_gost_256cpb },
+  { "cpc", 256, &_nettle_gost_256cpc },
+  { "a",   512, &_nettle_gost_512a },
+  { "b",   512, &_nettle_gost_512b },
+};
+
 struct alg alg_list[] = {
   { "rsa",   1024, bench_rsa_init,   bench_rsa_sign,   bench_rsa_verify,   bench_rsa_clear },
   { "rsa",   2048, bench_rsa_init,   bench_rsa_sign,   bench_rsa_verify,   bench_rsa_clear },
   { "rsa-tr",   1024, bench_rsa_init,   bench_rsa_sign_tr,   bench_rsa_verify,   bench_rsa_clear },
   { "rsa-tr",   2048, bench_rsa_init,   bench_rsa_sign_tr,   bench_rsa_verify,   bench_rsa_clear },
+  { "rsa-blinding", 1024, bench_rsa_init, bench_rsa_sign_tr_blinding, bench_rsa_verify_precomp, bench_rsa_clear },
+  { "rsa-blinding", 2048, bench_rsa_init, bench_rsa_sign_tr_blinding, bench_rsa_verify_precomp, bench_rsa_clear },
 #if WITH_OPENSSL
   { "rsa (openssl)",  1024, bench_openssl_rsa_init, bench_openssl_rsa_sign, bench_openssl_rsa_verify, bench_openssl_rsa_clear },
   { "rsa (openssl)",  2048, bench_openssl_rsa_init, bench_openssl_rsa_sign, bench_openssl_rsa_verify, bench_openssl_rsa_clear },
@@ -745,6 +1383,13 @@ struct alg alg_list[] = {
   { "ecdsa",  256, bench_ecdsa_init, bench_ecdsa_sign, bench_ecdsa_verify, bench_ecdsa_clear },
   { "ecdsa",  384, bench_ecdsa_init, bench_ecdsa_sign, bench_ecdsa_verify, bench_ecdsa_clear },
   { "ecdsa",  521, bench_ecdsa_init, bench_ecdsa_sign, bench_ecdsa_verify, bench_ecdsa_clear },
+  { "gostdsa-cpa",  256, bench_gostdsa_cpa_init, bench_gostdsa_sign, bench_gostdsa_verify, bench_gostdsa_clear },
+  { "gostdsa-cpb",  256, bench_gostdsa_cpb_init, bench_gostdsa_sign, bench_gostdsa_verify, bench_gostdsa_clear },
+  { "gostdsa-cpc",  256, bench_gostdsa_cpc_init, bench_gostdsa_sign, bench_gostdsa_verify, bench_gostdsa_clear },
+  { "gostdsa-a",  512, bench_gostdsa_a_init, bench_gostdsa_sign, bench_gostdsa_verify, bench_gostdsa_clear },
+  { "gostdsa-b",  512, bench_gostdsa_b_init, bench_gostdsa_sign, bench_gostdsa_verify, bench_gostdsa_clear },
+  { "gostdsa-online",  256, bench_gostdsa_cpa_init, bench_gostdsa_sign_online, bench_gostdsa_verify, bench_gostdsa_clear },
+  { "gostdsa-online",  512, bench_gostdsa_a_init, bench_gostdsa_sign_online, bench_gostdsa_verify, bench_gostdsa_clear },
 #if WITH_OPENSSL
   { "ecdsa (openssl)",  192, bench_openssl_ecdsa_init, bench_openssl_ecdsa_sign, bench_openssl_ecdsa_verify, bench_openssl_ecdsa_clear },
   { "ecdsa (openssl)",  224, bench_openssl_ecdsa_init, bench_openssl_ecdsa_sign, bench_openssl_ecdsa_verify, bench_openssl_ecdsa_clear },
@@ -756,25 +1401,343 @@ struct alg alg_list[] = {
 
 #define numberof(x)  (sizeof (x) / sizeof ((x)[0]))
 
+/* Key and parameter generation is slow, and its running time varies a
+   lot with the number of candidates tested, so it is benchmarked only
+   with --keygen, timing each of a fixed number of calls. */
+#define KEYGEN_DEFAULT_COUNT 20
+
+struct keygen_ctx
+{
+  struct knuth_lfib_ctx lfib;
+  unsigned size;
+  struct rsa_public_key pub;
+  struct rsa_private_key key;
+  struct dsa_params params;
+};
+
+static void
+bench_rsa_keygen (void *p)
+{
+  struct keygen_ctx *ctx = p;
+  if (!rsa_generate_keypair (&ctx->pub, &ctx->key,
+			     &ctx->lfib, (nettle_random_func *) knuth_lfib_random,
+			     NULL, NULL, ctx->size, 0))
+    die ("Internal error, rsa_generate_keypair failed.\n");
+}
+
+static void
+bench_dsa_params (void *p)
+{
+  struct keygen_ctx *ctx = p;
+  if (!dsa_generate_params (&ctx->params,
+			    &ctx->lfib, (nettle_random_func *) knuth_lfib_random,
+			    NULL, NULL, ctx->size, ctx->size < 2048 ? 160 : 224))
+    die ("Internal error, dsa_generate_params failed.\n");
+}
+
+static const struct
+{
+  const char *name;
+  unsigned size;
+  void (*f)(void *);
+} keygen_list[] = {
+  { "rsa-keygen", 1024, bench_rsa_keygen },
+  { "rsa-keygen", 2048, bench_rsa_keygen },
+  { "rsa-keygen", 3072, bench_rsa_keygen },
+  { "rsa-keygen", 4096, bench_rsa_keygen },
+  { "dsa-params", 1024, bench_dsa_params },
+  { "dsa-params", 2048, bench_dsa_params },
+};
+
+static void
+bench_keygen (unsigned count, const char *filter)
+{
+  struct keygen_ctx ctx;
+  double *samples;
+  unsigned i, j;
+
+  knuth_lfib_init (&ctx.lfib, 3);
+  rsa_public_key_init (&ctx.pub);
+  rsa_private_key_init (&ctx.key);
+  dsa_params_init (&ctx.params);
+  mpz_set_ui (ctx.pub.e, 65537);
+
+  samples = xalloc (count * sizeof(*samples));
+
+  for (i = 0; i < numberof(keygen_list); i++)
+    {
+      struct bench_stats stats;
+      double sum;
+
+      if (filter && !strstr (keygen_list[i].name, filter))
+	continue;
+
+      ctx.size = keygen_list[i].size;
+      for (j = 0, sum = 0.0; j < count; j++)
+	{
+	  time_start();
+	  keygen_list[i].f (&ctx);
+	  samples[j] = time_end();
+	  sum += samples[j];
+	}
+      qsort (samples, count, sizeof(*samples), compare_double);
+
+      stats.mean = sum / count;
+      stats.p50 = percentile (samples, count, 500);
+      stats.p99 = percentile (samples, count, 990);
+      stats.p999 = percentile (samples, count, 999);
+
+      report_op (keygen_list[i].name, keygen_list[i].size, "keygen", &stats);
+    }
+
+  free (samples);
+  rsa_public_key_clear (&ctx.pub);
+  rsa_private_key_clear (&ctx.key);
+  dsa_params_clear (&ctx.params);
+}
+
+/* For --sweep, the cost of the two exponentiations of an RSA
+   signature using the CRT, one mod p and one mod q, with each window
+   size. The cost depends only on the sizes, so random moduli and
+   exponents of half the key size are used, which avoids slow key
+   generation for the larger sizes. */
+struct sweep_ctx
+{
+  struct rsa_mont m;
+  unsigned w;
+  mp_limb_t *mp;
+  mp_limb_t *r2;
+  mp_limb_t *ap;
+  mp_limb_t *ep;
+  mp_limb_t *rp;
+  mp_limb_t *scratch;
+};
+
+static void
+bench_sweep_powm (void *p)
+{
+  struct sweep_ctx *ctx = p;
+  mp_bitcnt_t ebits = (mp_bitcnt_t) ctx->m.size * GMP_NUMB_BITS;
+
+  _rsa_mont_powm (&ctx->m, ctx->w, ctx->rp, ctx->ap,
+		  ctx->ep, ebits, ctx->scratch);
+  _rsa_mont_powm (&ctx->m, ctx->w, ctx->rp, ctx->ap,
+		  ctx->ep, ebits, ctx->scratch);
+}
+
+#if !NETTLE_USE_MINI_GMP
+/* For comparison, gmp's mpn_sec_powm, used by the private key
+   operations in gmp builds. */
+static void
+bench_sweep_gmp (void *p)
+{
+  struct sweep_ctx *ctx = p;
+  mp_size_t n = ctx->m.size;
+
+  mpn_sec_powm (ctx->rp, ctx->ap, n, ctx->ep, n * GMP_NUMB_BITS,
+		ctx->mp, n, ctx->scratch);
+  mpn_sec_powm (ctx->rp, ctx->ap, n, ctx->ep, n * GMP_NUMB_BITS,
+		ctx->mp, n, ctx->scratch);
+}
+#endif
+
+static const unsigned sweep_sizes[] = { 1024, 2048, 3072, 4096, 8192 };
+
+static void
+bench_sweep (const char *filter)
+{
+  struct knuth_lfib_ctx lfib;
+  unsigned i;
+
+  knuth_lfib_init (&lfib, 11);
+
+  for (i = 0; i < numberof(sweep_sizes); i++)
+    {
+      struct sweep_ctx ctx;
+      struct bench_stats stats;
+      unsigned size = sweep_sizes[i];
+      mp_size_t n = size / 2 / GMP_NUMB_BITS;
+      mp_size_t itch;
+      unsigned best;
+      unsigned w;
+
+      itch = _rsa_mont_powm_itch (n, RSA_POWM_MAX_WINDOW);
+#if !NETTLE_USE_MINI_GMP
+      if (itch < mpn_sec_powm_itch (n, n * GMP_NUMB_BITS, n))
+	itch = mpn_sec_powm_itch (n, n * GMP_NUMB_BITS, n);
+#endif
+      ctx.mp = xalloc (5 * n * sizeof(mp_limb_t));
+      ctx.r2 = ctx.mp + n;
+      ctx.ap = ctx.r2 + n;
+      ctx.ep = ctx.ap + n;
+      ctx.rp = ctx.ep + n;
+      ctx.scratch = xalloc (itch * sizeof(mp_limb_t));
+
+      knuth_lfib_random (&lfib, n * sizeof(mp_limb_t), (uint8_t *) ctx.mp);
+      knuth_lfib_random (&lfib, n * sizeof(mp_limb_t), (uint8_t *) ctx.ap);
+      knuth_lfib_random (&lfib, n * sizeof(mp_limb_t), (uint8_t *) ctx.ep);
+      ctx.mp[0] |= 1;
+      ctx.mp[n-1] |= (mp_limb_t) 1 << (GMP_NUMB_BITS - 1);
+      ctx.ap[n-1] >>= 1;
+
+      _rsa_mont_r2 (ctx.r2, ctx.mp, n, ctx.scratch);
+      ctx.m.size = n;
+      ctx.m.m = ctx.mp;
+      ctx.m.minv = _rsa_mont_minv (ctx.mp[0]);
+      ctx.m.r2 = ctx.r2;
+
+      best = _rsa_mont_powm_window ((mp_bitcnt_t) n * GMP_NUMB_BITS, n);
+      for (w = 1; w <= RSA_POWM_MAX_WINDOW; w++)
+	{
+	  char name[20];
+	  snprintf (name, sizeof(name), "rsa-window-%u", w);
+	  if (filter && !strstr (name, filter))
+	    continue;
+
+	  ctx.w = w;
+	  bench_function (bench_sweep_powm, &ctx, &stats);
+	  report_op (name, size, w == best ? "sign*" : "sign", &stats);
+	}
+#if !NETTLE_USE_MINI_GMP
+      if (!filter || strstr ("rsa-window-gmp", filter))
+	{
+	  bench_function (bench_sweep_gmp, &ctx, &stats);
+	  report_op ("rsa-window-gmp", size, "sign", &stats);
+	}
+#endif
+      free (ctx.mp);
+      free (ctx.scratch);
+    }
+}
+
+static void
+usage (void)
+{
+  printf("Usage: hogweed-benchmark [OPTIONS] [ALGORITHM]\n\n"
+	 "Options:\n"
+	 "  --latency         Time each call individually, and report the\n"
+	 "                    p50, p99 and p999 latencies, in microseconds.\n"
+	 "                    Note that timer overhead dominates for the\n"
+	 "                    fastest operations.\n"
+	 "  --format=FORMAT   Output format: text (default), csv or json.\n"
+	 "  --keygen[=COUNT]  Benchmark key and parameter generation instead,\n"
+	 "                    timing COUNT calls of each (default %d).\n"
+	 "  --sweep           Benchmark the exponentiations of RSA signing,\n"
+	 "                    for key sizes 1024 to 8192, with each window\n"
+	 "                    size. The default choice is marked with *.\n"
+	 "  --help            Display this help.\n\n"
+	 "Only algorithms with a name containing ALGORITHM are benchmarked.\n",
+	 KEYGEN_DEFAULT_COUNT);
+}
+
 int
 main (int argc, char **argv)
 {
   const char *filter = NULL;
+  unsigned keygen = 0;
+  int sweep = 0;
   unsigned i;
+  int c;
 
-  if (argc > 1)
-    filter = argv[1];
+  enum { OPT_HELP = 300, OPT_LATENCY, OPT_FORMAT, OPT_KEYGEN, OPT_SWEEP };
+  static const struct option options[] =
+    {
+      /* Name, args, flag, val */
+      { "help", no_argument, NULL, OPT_HELP },
+      { "latency", no_argument, NULL, OPT_LATENCY },
+      { "format", required_argument, NULL, OPT_FORMAT },
+      { "keygen", optional_argument, NULL, OPT_KEYGEN },
+      { "sweep", no_argument, NULL, OPT_SWEEP },
+      { NULL, 0, NULL, 0 }
+    };
+
+  while ( (c = getopt_long(argc, argv, "", options, NULL)) != -1)
+    switch (c)
+      {
+      case OPT_HELP:
+	usage();
+	return EXIT_SUCCESS;
+
+      case OPT_LATENCY:
+	latency = 1;
+	break;
+
+      case OPT_FORMAT:
+	if (!strcmp (optarg, "text"))
+	  format = FORMAT_TEXT;
+	else if (!strcmp (optarg, "csv"))
+	  format = FORMAT_CSV;
+	else if (!strcmp (optarg, "json"))
+	  format = FORMAT_JSON;
+	else
+	  die ("Unknown output format `%s'.\n", optarg);
+	break;
+
+      case OPT_KEYGEN:
+	if (optarg)
+	  {
+	    char *end;
+	    keygen = strtoul (optarg, &end, 10);
+	    if (*optarg == '\0' || *end != '\0' || keygen == 0)
+	      die ("Invalid count `%s'.\n", optarg);
+	  }
+	else
+	  keygen = KEYGEN_DEFAULT_COUNT;
+	break;
+
+      case OPT_SWEEP:
+	sweep = 1;
+	break;
+
+      case '?':
+	return EXIT_FAILURE;
+
+      default:
+	abort();
+      }
+
+  if (optind < argc)
+    filter = argv[optind];
 
   time_init();
-  printf ("%16s %4s %9s %9s\n",
-	  "name", "size", "sign/ms", "verify/ms");
+
+  if (keygen)
+    {
+      /* Always report percentiles, since they are computed anyway. */
+      latency = 1;
+      report_header (0);
+      bench_keygen (keygen, filter);
+      report_footer ();
+      return EXIT_SUCCESS;
+    }
+
+  if (sweep)
+    {
+      report_header (0);
+      bench_sweep (filter);
+      report_footer ();
+      return EXIT_SUCCESS;
+    }
+
+  report_header (1);
 
   for (i = 0; i < numberof(alg_list); i++)
     if (!filter || strstr (alg_list[i].name, filter))
       bench_alg (&alg_list[i]);
 
+  bench_rsa_verify_batch (1024, filter);
+  bench_rsa_verify_batch (2048, filter);
+  bench_rsa_sign_batch (1024, filter);
+  bench_rsa_sign_batch (2048, filter);
+
+  for (i = 0; i < numberof(gost_curves); i++)
+    bench_gostdsa_kex (gost_curves[i].name, gost_curves[i].size,
+		       gost_curves[i].ecc, filter);
+
   if (!filter || strstr("curve25519", filter))
     bench_curve25519();
 
+  report_footer ();
+
   return EXIT_SUCCESS;
 }
@@ -442,14 +442,60 @@ time_umac(void)
 	  time_function(bench_hash, &info));
 }
 
+/* Independent short messages, as for per-packet MACs. */
+#define BENCH_CMAC_MSG_SIZE 64
+#define BENCH_CMAC_MSGS (BENCH_BLOCK / BENCH_CMAC_MSG_SIZE)
+
+typedef void
+bench_cmac_messages_func(const void *ctx, size_t count,
+			 const size_t *msg_lengths,
+			 const uint8_t * const *msgs,
+			 size_t length, uint8_t * const *digests);
+
+struct bench_cmac_messages_info
+{
+  void *ctx;
+  bench_cmac_messages_func *digest_messages;
+  const size_t *lengths;
+  const uint8_t * const *msgs;
+  uint8_t * const *digests;
+};
+
+static void
+bench_cmac_messages(void *arg)
+{
+  struct bench_cmac_messages_info *info = arg;
+  info->digest_messages(info->ctx, BENCH_CMAC_MSGS, info->lengths,
+			info->msgs, CMAC64_DIGEST_SIZE, info->digests);
+}
+
 static void
 time_cmac(void)
 {
   static uint8_t data[BENCH_BLOCK];
+  static uint8_t digest[BENCH_CMAC_MSGS][CMAC64_DIGEST_SIZE];
+  size_t lengths[BENCH_CMAC_MSGS];
+  const uint8_t *msgs[BENCH_CMAC_MSGS];
+  uint8_t *digests[BENCH_CMAC_MSGS];
   struct bench_hash_info info;
+  struct bench_cmac_messages_info minfo;
   struct cmac_aes128_ctx ctx;
+  struct cmac_kuznyechik_ctx kuznyechik_ctx;
+  struct cmac_magma_ctx magma_ctx;
+  unsigned i;
 
-  uint8_t key[16];
+  uint8_t key[32];
+
+  memset(key, 0, sizeof(key));
+  for (i = 0; i < BENCH_CMAC_MSGS; i++)
+    {
+      lengths[i] = BENCH_CMAC_MSG_SIZE;
+      msgs[i] = data + i * BENCH_CMAC_MSG_SIZE;
+      digests[i] = digest[i];
+    }
+  minfo.lengths = lengths;
+  minfo.msgs = msgs;
+  minfo.digests = digests;
 
   cmac_aes128_set_key (&ctx, key);
   info.ctx = &ctx;
@@ -458,6 +504,38 @@ time_cmac(void)
 
   display("cmac-aes128", "update", AES_BLOCK_SIZE,
 	  time_function(bench_hash, &info));
+
+  minfo.ctx = &ctx;
+  minfo.digest_messages
+    = (bench_cmac_messages_func *) cmac_aes128_digest_messages;
+  display("cmac-aes128", "64-byte msgs", AES_BLOCK_SIZE,
+	  time_function(bench_cmac_messages, &minfo));
+
+  cmac_kuznyechik_set_key (&kuznyechik_ctx, key);
+  info.ctx = &kuznyechik_ctx;
+  info.update = (nettle_hash_update_func *) cmac_kuznyechik_update;
+
+  display("cmac-kuznyechik", "update", KUZNYECHIK_BLOCK_SIZE,
+	  time_function(bench_hash, &info));
+
+  minfo.ctx = &kuznyechik_ctx;
+  minfo.digest_messages
+    = (bench_cmac_messages_func *) cmac_kuznyechik_digest_messages;
+  display("cmac-kuznyechik", "64-byte msgs", KUZNYECHIK_BLOCK_SIZE,
+	  time_function(bench_cmac_messages, &minfo));
+
+  cmac_magma_set_key (&magma_ctx, key);
+  info.ctx = &magma_ctx;
+  info.update = (nettle_hash_update_func *) cmac_magma_update;
+
+  display("cmac-magma", "update", MAGMA_BLOCK_SIZE,
+	  time_function(bench_hash, &info));
+
+  minfo.ctx = &magma_ctx;
+  minfo.digest_messages
+    = (bench_cmac_messages_func *) cmac_magma_digest_messages;
+  display("cmac-magma", "64-byte msgs", MAGMA_BLOCK_SIZE,
+	  time_function(bench_cmac_messages, &minfo));
 }
 
 static void
@@ -166,6 +166,19 @@ typedef void salsa20_core_func (uint32_t *dst, const uint32_t *src, unsigned rou
 typedef void sha1_compress_func(uint32_t *state, const uint8_t *input);
 typedef void sha256_compress_func(uint32_t *state, const uint8_t *input, const uint32_t *k);
 
+typedef void mont52_mul_func (uint64_t *rp, const uint64_t *ap,
+			      const uint64_t *bp, const uint64_t *mp,
+			      const uint64_t *minv, size_t size);
+
+struct gcm_key;
+typedef void gcm_init_key_func (struct gcm_key *key,
+				const union nettle_block16 *h);
+typedef void gcm_hash_func (const struct gcm_key *key, union nettle_block16 *x,
+			    size_t length, const uint8_t *data);
+typedef size_t gcm_aes_crypt_func (struct gcm_key *key, unsigned rounds,
+				   size_t length, uint8_t *dst,
+				   const uint8_t *src);
+
 struct sha3_state;
 typedef void sha3_permute_func (struct sha3_state *state);
 
@@ -176,3 +189,7 @@ typedef void umac_nh_n_func (uint64_t *out, unsigned n, const uint32_t *key,
 			     unsigned length, const uint8_t *msg);
 
 typedef void chacha_core_func(uint32_t *dst, const uint32_t *src, unsigned rounds);
+
+struct poly1305_ctx;
+typedef const uint8_t *poly1305_blocks_func (struct poly1305_ctx *ctx,
+					     size_t blocks, const uint8_t *m);
@@ -43,16 +43,24 @@
 #include "nettle-types.h"
 
 #include "aes-internal.h"
+#include "chacha-internal.h"
+#include "gcm-internal.h"
 #include "memxor.h"
+#include "mont52-internal.h"
+#include "poly1305.h"
 #include "fat-setup.h"
 
 void _nettle_cpuid (uint32_t input, uint32_t regs[4]);
+uint32_t _nettle_xgetbv (uint32_t index);
 
 struct x86_features
 {
   enum x86_vendor { X86_OTHER, X86_INTEL, X86_AMD } vendor;
   int have_aesni;
+  int have_pclmul;
   int have_sha_ni;
+  int have_avx2;
+  int have_avx512_ifma;
 };
 
 #define SKIP(s, slen, literal, llen)				\
@@ -67,7 +75,10 @@ get_x86_features (struct x86_features *features)
   const char *s;
   features->vendor = X86_OTHER;
   features->have_aesni = 0;
+  features->have_pclmul = 0;
   features->have_sha_ni = 0;
+  features->have_avx2 = 0;
+  features->have_avx512_ifma = 0;
 
   s = secure_getenv (ENV_OVERRIDE);
   if (s)
@@ -86,8 +97,14 @@ get_x86_features (struct x86_features *features)
 	  }
 	else if (MATCH (s, length, "aesni", 5))
 	  features->have_aesni = 1;
+	else if (MATCH (s, length, "pclmul", 6))
+	  features->have_pclmul = 1;
 	else if (MATCH (s, length, "sha_ni", 6))
 	  features->have_sha_ni = 1;
+	else if (MATCH (s, length, "avx2", 4))
+	  features->have_avx2 = 1;
+	else if (MATCH (s, length, "avx512_ifma", 11))
+	  features->have_avx512_ifma = 1;
 	if (!sep)
 	  break;
 	s = sep + 1;
@@ -95,6 +112,7 @@ get_x86_features (struct x86_features *features)
   else
     {
       uint32_t cpuid_data[4];
+      uint32_t xcr0;
       _nettle_cpuid (0, cpuid_data);
       if (memcmp (cpuid_data + 1, "Genu" "ntel" "ineI", 12) == 0)
 	features->vendor = X86_INTEL;
@@ -104,8 +122,21 @@ get_x86_features (struct x86_features *features)
       _nettle_cpuid (1, cpuid_data);
       if (cpuid_data[2] & 0x02000000)
        features->have_aesni = 1;
+      if (cpuid_data[2] & 0x00000002)
+       features->have_pclmul = 1;
+
+      /* The avx2 and avx512 instructions are usable only if the OS
+	 saves the ymm and zmm state, i.e, OSXSAVE is set and XCR0 has
+	 the sse and avx bits, and the opmask and zmm bits, set. */
+      xcr0 = (cpuid_data[2] & 0x08000000) ? _nettle_xgetbv (0) : 0;
 
       _nettle_cpuid (7, cpuid_data);
+      if ((xcr0 & 6) == 6 && (cpuid_data[1] & 0x00000020))
+	features->have_avx2 = 1;
+      if ((xcr0 & 0xe6) == 0xe6
+	  && (cpuid_data[1] & 0x00210000) == 0x00210000)
+	features->have_avx512_ifma = 1;
+
       if (cpuid_data[1] & 0x20000000)
        features->have_sha_ni = 1;
     }
@@ -119,6 +150,22 @@ DECLARE_FAT_FUNC(_nettle_aes_decrypt, aes_crypt_internal_func)
 DECLARE_FAT_FUNC_VAR(aes_decrypt, aes_crypt_internal_func, x86_64)
 DECLARE_FAT_FUNC_VAR(aes_decrypt, aes_crypt_internal_func, aesni)
 
+DECLARE_FAT_FUNC(_nettle_gcm_init_key, gcm_init_key_func)
+DECLARE_FAT_FUNC_VAR(gcm_init_key, gcm_init_key_func, c)
+DECLARE_FAT_FUNC_VAR(gcm_init_key, gcm_init_key_func, pclmul)
+
+DECLARE_FAT_FUNC(_nettle_gcm_hash, gcm_hash_func)
+DECLARE_FAT_FUNC_VAR(gcm_hash, gcm_hash_func, c)
+DECLARE_FAT_FUNC_VAR(gcm_hash, gcm_hash_func, pclmul)
+
+DECLARE_FAT_FUNC(_nettle_gcm_aes_encrypt, gcm_aes_crypt_func)
+DECLARE_FAT_FUNC_VAR(gcm_aes_encrypt, gcm_aes_crypt_func, c)
+DECLARE_FAT_FUNC_VAR(gcm_aes_encrypt, gcm_aes_crypt_func, aesni_pclmul)
+
+DECLARE_FAT_FUNC(_nettle_gcm_aes_decrypt, gcm_aes_crypt_func)
+DECLARE_FAT_FUNC_VAR(gcm_aes_decrypt, gcm_aes_crypt_func, c)
+DECLARE_FAT_FUNC_VAR(gcm_aes_decrypt, gcm_aes_crypt_func, aesni_pclmul)
+
 DECLARE_FAT_FUNC(nettle_memxor, memxor_func)
 DECLARE_FAT_FUNC_VAR(memxor, memxor_func, x86_64)
 DECLARE_FAT_FUNC_VAR(memxor, memxor_func, sse2)
@@ -131,6 +178,26 @@ DECLARE_FAT_FUNC(_nettle_sha256_compress, sha256_compress_func)
 DECLARE_FAT_FUNC_VAR(sha256_compress, sha256_compress_func, x86_64)
 DECLARE_FAT_FUNC_VAR(sha256_compress, sha256_compress_func, sha_ni)
 
+DECLARE_FAT_FUNC(_nettle_chacha_8core, chacha_core_func)
+DECLARE_FAT_FUNC_VAR(chacha_8core, chacha_core_func, c)
+DECLARE_FAT_FUNC_VAR(chacha_8core, chacha_core_func, avx2)
+
+DECLARE_FAT_FUNC(_nettle_poly1305_blocks, poly1305_blocks_func)
+DECLARE_FAT_FUNC_VAR(poly1305_blocks, poly1305_blocks_func, x86_64)
+DECLARE_FAT_FUNC_VAR(poly1305_blocks, poly1305_blocks_func, avx2)
+
+DECLARE_FAT_FUNC(_nettle_umac_nh, umac_nh_func)
+DECLARE_FAT_FUNC_VAR(umac_nh, umac_nh_func, x86_64)
+DECLARE_FAT_FUNC_VAR(umac_nh, umac_nh_func, avx2)
+
+DECLARE_FAT_FUNC(_nettle_umac_nh_n, umac_nh_n_func)
+DECLARE_FAT_FUNC_VAR(umac_nh_n, umac_nh_n_func, x86_64)
+DECLARE_FAT_FUNC_VAR(umac_nh_n, umac_nh_n_func, avx2)
+
+DECLARE_FAT_FUNC(_nettle_mont52_mul, mont52_mul_func)
+DECLARE_FAT_FUNC_VAR(mont52_mul, mont52_mul_func, c)
+DECLARE_FAT_FUNC_VAR(mont52_mul, mont52_mul_func, ifma)
+
 /* This function should usually be called only once, at startup. But
    it is idempotent, and on x86, pointer updates are atomic, so
    there's no danger if it is called simultaneously from multiple
@@ -151,10 +218,13 @@ fat_init (void)
     {
       const char * const vendor_names[3] =
 	{ "other", "intel", "amd" };
-      fprintf (stderr, "libnettle: cpu features: vendor:%s%s%s\n",
+      fprintf (stderr, "libnettle: cpu features: vendor:%s%s%s%s%s%s\n",
 	       vendor_names[features.vendor],
 	       features.have_aesni ? ",aesni" : "",
-	       features.have_sha_ni ? ",sha_ni" : "");
+	       features.have_pclmul ? ",pclmul" : "",
+	       features.have_sha_ni ? ",sha_ni" : "",
+	       features.have_avx2 ? ",avx2" : "",
+	       features.have_avx512_ifma ? ",avx512_ifma" : "");
     }
   if (features.have_aesni)
     {
@@ -171,6 +241,35 @@ fat_init (void)
       _nettle_aes_decrypt_vec = _nettle_aes_decrypt_x86_64;
     }
 
+  if (features.have_pclmul)
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: using pclmulqdq instructions.\n");
+      _nettle_gcm_init_key_vec = _nettle_gcm_init_key_pclmul;
+      _nettle_gcm_hash_vec = _nettle_gcm_hash_pclmul;
+    }
+  else
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: not using pclmulqdq instructions.\n");
+      _nettle_gcm_init_key_vec = _nettle_gcm_init_key_c;
+      _nettle_gcm_hash_vec = _nettle_gcm_hash_c;
+    }
+  if (features.have_aesni && features.have_pclmul)
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: using stitched aes-gcm.\n");
+      _nettle_gcm_aes_encrypt_vec = _nettle_gcm_aes_encrypt_aesni_pclmul;
+      _nettle_gcm_aes_decrypt_vec = _nettle_gcm_aes_decrypt_aesni_pclmul;
+    }
+  else
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: not using stitched aes-gcm.\n");
+      _nettle_gcm_aes_encrypt_vec = _nettle_gcm_aes_encrypt_c;
+      _nettle_gcm_aes_decrypt_vec = _nettle_gcm_aes_decrypt_c;
+    }
+
   if (features.have_sha_ni)
     {
       if (verbose)
@@ -185,6 +284,36 @@ fat_init (void)
       nettle_sha1_compress_vec = _nettle_sha1_compress_x86_64;
       _nettle_sha256_compress_vec = _nettle_sha256_compress_x86_64;
     }
+  if (features.have_avx2)
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: using avx2 instructions.\n");
+      _nettle_chacha_8core_vec = _nettle_chacha_8core_avx2;
+      _nettle_poly1305_blocks_vec = _nettle_poly1305_blocks_avx2;
+      _nettle_umac_nh_vec = _nettle_umac_nh_avx2;
+      _nettle_umac_nh_n_vec = _nettle_umac_nh_n_avx2;
+    }
+  else
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: not using avx2 instructions.\n");
+      _nettle_chacha_8core_vec = _nettle_chacha_8core_c;
+      _nettle_poly1305_blocks_vec = _nettle_poly1305_blocks_x86_64;
+      _nettle_umac_nh_vec = _nettle_umac_nh_x86_64;
+      _nettle_umac_nh_n_vec = _nettle_umac_nh_n_x86_64;
+    }
+  if (features.have_avx512_ifma)
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: using avx512 ifma instructions.\n");
+      _nettle_mont52_mul_vec = _nettle_mont52_mul_ifma;
+    }
+  else
+    {
+      if (verbose)
+	fprintf (stderr, "libnettle: not using avx512 ifma instructions.\n");
+      _nettle_mont52_mul_vec = _nettle_mont52_mul_c;
+    }
   if (features.vendor == X86_INTEL)
     {
       if (verbose)
@@ -213,6 +342,25 @@ DEFINE_FAT_FUNC(_nettle_aes_decrypt, void,
 		 const uint8_t *src),
 		(rounds, keys, T, length, dst, src))
 
+DEFINE_FAT_FUNC(_nettle_gcm_init_key, void,
+		(struct gcm_key *key, const union nettle_block16 *h),
+		(key, h))
+
+DEFINE_FAT_FUNC(_nettle_gcm_hash, void,
+		(const struct gcm_key *key, union nettle_block16 *x,
+		 size_t length, const uint8_t *data),
+		(key, x, length, data))
+
+DEFINE_FAT_FUNC(_nettle_gcm_aes_encrypt, size_t,
+		(struct gcm_key *key, unsigned rounds,
+		 size_t length, uint8_t *dst, const uint8_t *src),
+		(key, rounds, length, dst, src))
+
+DEFINE_FAT_FUNC(_nettle_gcm_aes_decrypt, size_t,
+		(struct gcm_key *key, unsigned rounds,
+		 size_t length, uint8_t *dst, const uint8_t *src),
+		(key, rounds, length, dst, src))
+
 DEFINE_FAT_FUNC(nettle_memxor, void *,
 		(void *dst, const void *src, size_t n),
 		(dst, src, n))
@@ -224,3 +372,33 @@ DEFINE_FAT_FUNC(nettle_sha1_compress, void,
 DEFINE_FAT_FUNC(_nettle_sha256_compress, void,
 		(uint32_t *state, const uint8_t *input, const uint32_t *k),
 		(state, input, k))
+
+DEFINE_FAT_FUNC(_nettle_chacha_8core, void,
+		(uint32_t *dst, const uint32_t *src, unsigned rounds),
+		(dst, src, rounds))
+
+DEFINE_FAT_FUNC(_nettle_poly1305_blocks, const uint8_t *,
+		(struct poly1305_ctx *ctx, size_t blocks, const uint8_t *m),
+		(ctx, blocks, m))
+
+DEFINE_FAT_FUNC(_nettle_umac_nh, uint64_t,
+		(const uint32_t *key, unsigned length, const uint8_t *msg),
+		(key, length, msg))
+
+DEFINE_FAT_FUNC(_nettle_umac_nh_n, void,
+		(uint64_t *out, unsigned n, const uint32_t *key,
+		 unsigned length, const uint8_t *msg),
+		(out, n, key, length, msg))
+
+DEFINE_FAT_FUNC(_nettle_mont52_mul, void,
+		(uint64_t *rp, const uint64_t *ap, const uint64_t *bp,
+		 const uint64_t *mp, const uint64_t *minv, size_t size),
+		(rp, ap, bp, mp, minv, size))
+
+int
+_nettle_mont52_native (void)
+{
+  if (_nettle_mont52_mul_vec == _nettle_mont52_mul_init)
+    fat_init ();
+  return _nettle_mont52_mul_vec != _nettle_mont52_mul_c;
+}
@@ -38,6 +38,7 @@
 #include <assert.h>
 
 #include "gcm.h"
+#include "gcm-internal.h"
 
 void
 gcm_aes192_set_key(struct gcm_aes192_ctx *ctx, const uint8_t *key)
@@ -63,14 +64,20 @@ void
 gcm_aes192_encrypt(struct gcm_aes192_ctx *ctx,
 		size_t length, uint8_t *dst, const uint8_t *src)
 {
-  GCM_ENCRYPT(ctx, aes192_encrypt, length, dst, src);
+  size_t done = _gcm_aes_encrypt (&ctx->key, _AES192_ROUNDS,
+				 length, dst, src);
+  ctx->gcm.data_size += done;
+  GCM_ENCRYPT(ctx, aes192_encrypt, length - done, dst + done, src + done);
 }
 
 void
 gcm_aes192_decrypt(struct gcm_aes192_ctx *ctx,
 		   size_t length, uint8_t *dst, const uint8_t *src)
 {
-  GCM_DECRYPT(ctx, aes192_encrypt, length, dst, src);
+  size_t done = _gcm_aes_decrypt (&ctx->key, _AES192_ROUNDS,
+				 length, dst, src);
+  ctx->gcm.data_size += done;
+  GCM_DECRYPT(ctx, aes192_encrypt, length - done, dst + done, src + done);
 }
 
 void
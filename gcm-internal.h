@@ -0,0 +1,75 @@
+/* gcm-internal.h
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef NETTLE_GCM_INTERNAL_H_INCLUDED
+#define NETTLE_GCM_INTERNAL_H_INCLUDED
+
+#include "gcm.h"
+
+/* Name mangling */
+#define _gcm_init_key _nettle_gcm_init_key
+#define _gcm_hash _nettle_gcm_hash
+
+/* Sets up the key for _gcm_hash, from the hash subkey h = E_K(0).
+   The layout of the key->h array is private to the implementation;
+   the pclmul implementation stores only H^1, ..., H^8, in the first
+   eight elements. */
+void
+_gcm_init_key (struct gcm_key *key, const union nettle_block16 *h);
+
+/* Updates x <- (x + data) H for each block of data, with a final
+   partial block padded with zeros. */
+void
+_gcm_hash (const struct gcm_key *key, union nettle_block16 *x,
+	   size_t length, const uint8_t *data);
+
+/* Stitched AES-CTR and GHASH, for the largest prefix of the data that
+   is a multiple of 8 blocks. The key must be the first element of a
+   struct gcm_aes128_ctx, gcm_aes192_ctx or gcm_aes256_ctx, and the
+   ctr and x of the following struct gcm_ctx are updated, but not
+   data_size. Returns the number of bytes processed. */
+#if HAVE_NATIVE_gcm_aes_encrypt || HAVE_NATIVE_fat_gcm_aes_encrypt
+#define _gcm_aes_encrypt _nettle_gcm_aes_encrypt
+size_t
+_gcm_aes_encrypt (struct gcm_key *key, unsigned rounds,
+		  size_t length, uint8_t *dst, const uint8_t *src);
+#else
+#define _gcm_aes_encrypt(key, rounds, length, dst, src) 0
+#endif
+
+#if HAVE_NATIVE_gcm_aes_decrypt || HAVE_NATIVE_fat_gcm_aes_decrypt
+#define _gcm_aes_decrypt _nettle_gcm_aes_decrypt
+size_t
+_gcm_aes_decrypt (struct gcm_key *key, unsigned rounds,
+		  size_t length, uint8_t *dst, const uint8_t *src);
+#else
+#define _gcm_aes_decrypt(key, rounds, length, dst, src) 0
+#endif
+
+#endif /* NETTLE_GCM_INTERNAL_H_INCLUDED */
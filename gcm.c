@@ -54,6 +54,56 @@
 #include "macros.h"
 #include "ctr-internal.h"
 #include "block-internal.h"
+#include "gcm-internal.h"
+
+#if (HAVE_NATIVE_gcm_hash || HAVE_NATIVE_fat_gcm_hash) \
+  && (1 << GCM_TABLE_BITS) < 8
+# error The native gcm_hash needs room for 8 blocks in struct gcm_key.
+#endif
+
+#if HAVE_NATIVE_fat_gcm_hash
+/* For fat builds */
+# define gcm_init_key_c _nettle_gcm_init_key_c
+# define gcm_hash_c _nettle_gcm_hash_c
+void
+gcm_init_key_c (struct gcm_key *key, const union nettle_block16 *h);
+void
+gcm_hash_c (const struct gcm_key *key, union nettle_block16 *x,
+	    size_t length, const uint8_t *data);
+#elif !HAVE_NATIVE_gcm_hash
+# define gcm_init_key_c _gcm_init_key
+# define gcm_hash_c _gcm_hash
+#endif
+
+#if HAVE_NATIVE_fat_gcm_aes_encrypt
+/* For fat builds, when the cpu lacks either aes or pclmul
+   instructions. */
+size_t
+_nettle_gcm_aes_encrypt_c (struct gcm_key *key, unsigned rounds,
+			   size_t length, uint8_t *dst, const uint8_t *src);
+size_t
+_nettle_gcm_aes_encrypt_c (struct gcm_key *key UNUSED, unsigned rounds UNUSED,
+			   size_t length UNUSED, uint8_t *dst UNUSED,
+			   const uint8_t *src UNUSED)
+{
+  return 0;
+}
+#endif
+
+#if HAVE_NATIVE_fat_gcm_aes_decrypt
+size_t
+_nettle_gcm_aes_decrypt_c (struct gcm_key *key, unsigned rounds,
+			   size_t length, uint8_t *dst, const uint8_t *src);
+size_t
+_nettle_gcm_aes_decrypt_c (struct gcm_key *key UNUSED, unsigned rounds UNUSED,
+			   size_t length UNUSED, uint8_t *dst UNUSED,
+			   const uint8_t *src UNUSED)
+{
+  return 0;
+}
+#endif
+
+#if !HAVE_NATIVE_gcm_hash
 
 #if GCM_TABLE_BITS == 0
 /* Sets x <- x * y mod r, using the plain bitwise algorithm from the
@@ -142,7 +192,6 @@ gcm_gf_mul (union nettle_block16 *x, const union nettle_block16 *table)
 # elif GCM_TABLE_BITS == 8
 #  if HAVE_NATIVE_gcm_hash8
 
-#define gcm_hash _nettle_gcm_hash8
 void
 _nettle_gcm_hash8 (const struct gcm_key *key, union nettle_block16 *x,
 		   size_t length, const uint8_t *data);
@@ -225,26 +274,16 @@ gcm_gf_mul (union nettle_block16 *x, const union nettle_block16 *table)
 
 #endif /* GCM_TABLE_BITS */
 
-/* Increment the rightmost 32 bits. */
-#define INC32(block) INCREMENT(4, (block.b) + GCM_BLOCK_SIZE - 4)
-
-/* Initialization of GCM.
- * @ctx: The context of GCM
- * @cipher: The context of the underlying block cipher
- * @f: The underlying cipher encryption function
- */
 void
-gcm_set_key(struct gcm_key *key,
-	    const void *cipher, nettle_cipher_func *f)
+gcm_init_key_c (struct gcm_key *key, const union nettle_block16 *h)
 {
   /* Middle element if GCM_TABLE_BITS > 0, otherwise the first
      element */
   unsigned i = (1<<GCM_TABLE_BITS)/2;
 
-  /* H */  
   memset(key->h[0].b, 0, GCM_BLOCK_SIZE);
-  f (cipher, GCM_BLOCK_SIZE, key->h[i].b, key->h[0].b);
-  
+  key->h[i] = *h;
+
 #if GCM_TABLE_BITS
   /* Algorithm 3 from the gcm paper. First do powers of two, then do
      the rest by adding. */
@@ -259,11 +298,13 @@ gcm_set_key(struct gcm_key *key,
 #endif
 }
 
-#ifndef gcm_hash
-static void
-gcm_hash(const struct gcm_key *key, union nettle_block16 *x,
-	 size_t length, const uint8_t *data)
+void
+gcm_hash_c(const struct gcm_key *key, union nettle_block16 *x,
+	   size_t length, const uint8_t *data)
 {
+#if GCM_TABLE_BITS == 8 && HAVE_NATIVE_gcm_hash8
+  _nettle_gcm_hash8 (key, x, length, data);
+#else
   for (; length >= GCM_BLOCK_SIZE;
        length -= GCM_BLOCK_SIZE, data += GCM_BLOCK_SIZE)
     {
@@ -275,8 +316,29 @@ gcm_hash(const struct gcm_key *key, union nettle_block16 *x,
       memxor (x->b, data, length);
       gcm_gf_mul (x, key->h);
     }
+#endif
+}
+#endif /* !HAVE_NATIVE_gcm_hash */
+
+/* Increment the rightmost 32 bits. */
+#define INC32(block) INCREMENT(4, (block.b) + GCM_BLOCK_SIZE - 4)
+
+/* Initialization of GCM.
+ * @ctx: The context of GCM
+ * @cipher: The context of the underlying block cipher
+ * @f: The underlying cipher encryption function
+ */
+void
+gcm_set_key(struct gcm_key *key,
+	    const void *cipher, nettle_cipher_func *f)
+{
+  union nettle_block16 h;
+
+  /* H */
+  memset(h.b, 0, GCM_BLOCK_SIZE);
+  f (cipher, GCM_BLOCK_SIZE, h.b, h.b);
+  _gcm_init_key (key, &h);
 }
-#endif /* !gcm_hash */
 
 static void
 gcm_hash_sizes(const struct gcm_key *key, union nettle_block16 *x,
@@ -290,7 +352,7 @@ gcm_hash_sizes(const struct gcm_key *key, union nettle_block16 *x,
   WRITE_UINT64 (buffer, auth_size);
   WRITE_UINT64 (buffer + 8, data_size);
 
-  gcm_hash(key, x, GCM_BLOCK_SIZE, buffer);
+  _gcm_hash(key, x, GCM_BLOCK_SIZE, buffer);
 }
 
 /* NOTE: The key is needed only if length != GCM_IV_SIZE */
@@ -309,7 +371,7 @@ gcm_set_iv(struct gcm_ctx *ctx, const struct gcm_key *key,
   else
     {
       memset(ctx->iv.b, 0, GCM_BLOCK_SIZE);
-      gcm_hash(key, &ctx->iv, length, iv);
+      _gcm_hash(key, &ctx->iv, length, iv);
       gcm_hash_sizes(key, &ctx->iv, 0, length);
     }
 
@@ -328,7 +390,7 @@ gcm_update(struct gcm_ctx *ctx, const struct gcm_key *key,
   assert(ctx->auth_size % GCM_BLOCK_SIZE == 0);
   assert(ctx->data_size == 0);
 
-  gcm_hash(key, &ctx->x, length, data);
+  _gcm_hash(key, &ctx->x, length, data);
 
   ctx->auth_size += length;
 }
@@ -358,7 +420,7 @@ gcm_encrypt (struct gcm_ctx *ctx, const struct gcm_key *key,
   assert(ctx->data_size % GCM_BLOCK_SIZE == 0);
 
   _ctr_crypt16(cipher, f, gcm_fill, ctx->ctr.b, length, dst, src);
-  gcm_hash(key, &ctx->x, length, dst);
+  _gcm_hash(key, &ctx->x, length, dst);
 
   ctx->data_size += length;
 }
@@ -370,7 +432,7 @@ gcm_decrypt(struct gcm_ctx *ctx, const struct gcm_key *key,
 {
   assert(ctx->data_size % GCM_BLOCK_SIZE == 0);
 
-  gcm_hash(key, &ctx->x, length, src);
+  _gcm_hash(key, &ctx->x, length, src);
   _ctr_crypt16(cipher, f, gcm_fill, ctx->ctr.b, length, dst, src);
 
   ctx->data_size += length;
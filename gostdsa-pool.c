@@ -0,0 +1,171 @@
+/* gostdsa-pool.c
+
+   Offline/online GOST DSA signing, using a pool of precomputed nonces.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "gostdsa.h"
+#include "ecc-internal.h"
+#include "nettle-internal.h"
+
+void
+gostdsa_nonce_pool_init (struct gostdsa_nonce_pool *pool,
+			 const struct ecc_curve *ecc, size_t size)
+{
+  assert (size > 0);
+  pool->ecc = ecc;
+  pool->size = size;
+  pool->count = 0;
+  pool->entries = gmp_alloc_limbs (2 * ecc->p.size * size);
+}
+
+void
+gostdsa_nonce_pool_clear (struct gostdsa_nonce_pool *pool)
+{
+  mp_size_t n = 2 * pool->ecc->p.size * pool->size;
+
+  mpn_zero (pool->entries, n);
+  gmp_free_limbs (pool->entries, n);
+}
+
+size_t
+gostdsa_nonce_pool_fill (struct gostdsa_nonce_pool *pool,
+			 void *random_ctx, nettle_random_func *random,
+			 size_t n)
+{
+  const struct ecc_curve *ecc = pool->ecc;
+  mp_size_t size = ecc->p.size;
+  mp_size_t itch = ECC_GOSTDSA_SIGN_ITCH (size);
+  mp_limb_t *scratch;
+  size_t i;
+
+  if (n > pool->size - pool->count)
+    n = pool->size - pool->count;
+  if (!n)
+    return 0;
+
+  scratch = gmp_alloc_limbs (itch);
+
+  for (i = 0; i < n; i++, pool->count++)
+    {
+      mp_limb_t *kp = pool->entries + 2*size*pool->count;
+      mp_limb_t *rp = kp + size;
+
+      /* Like in gostdsa_sign, timing reveals the number of attempts,
+	 but not the finally used k. */
+      do
+	{
+	  do
+	    ecc_mod_random (&ecc->q, kp, random_ctx, random, scratch);
+	  while (mpn_zero_p (kp, size));
+
+	  ecc_gostdsa_sign_offline (ecc, kp, rp, scratch);
+	}
+      while (mpn_zero_p (rp, size));
+    }
+
+  /* Don't leave k g around in the scratch area. */
+  mpn_zero (scratch, itch);
+  gmp_free_limbs (scratch, itch);
+
+  return n;
+}
+
+size_t
+gostdsa_nonce_pool_move (struct gostdsa_nonce_pool *dst,
+			 struct gostdsa_nonce_pool *src)
+{
+  mp_size_t entry_size = 2 * src->ecc->p.size;
+  size_t n;
+
+  assert (dst->ecc == src->ecc);
+
+  n = dst->size - dst->count;
+  if (n > src->count)
+    n = src->count;
+  if (!n)
+    return 0;
+
+  src->count -= n;
+  mpn_copyi (dst->entries + entry_size * dst->count,
+	     src->entries + entry_size * src->count, entry_size * n);
+  mpn_zero (src->entries + entry_size * src->count, entry_size * n);
+  dst->count += n;
+
+  return n;
+}
+
+int
+gostdsa_sign_online (const struct ecc_scalar *key,
+		     struct gostdsa_nonce_pool *pool,
+		     size_t digest_length,
+		     const uint8_t *digest,
+		     struct dsa_signature *signature)
+{
+  TMP_DECL(scratch, mp_limb_t, ECC_GOSTDSA_SIGN_ITCH (ECC_MAX_SIZE));
+  const struct ecc_curve *ecc = key->ecc;
+  mp_size_t size = ecc->p.size;
+
+  assert (pool->ecc == ecc);
+
+  TMP_ALLOC (scratch, ECC_GOSTDSA_SIGN_ITCH (size));
+
+  /* The pool contains only entries with non-zero r, but s can still
+     be zero, and then we need to use another entry. */
+  do
+    {
+      mp_limb_t *kp;
+      mp_limb_t *rp;
+      mp_limb_t *sp;
+
+      if (!pool->count)
+	return 0;
+
+      kp = pool->entries + 2*size*(--pool->count);
+
+      rp = mpz_limbs_write (signature->r, size);
+      sp = mpz_limbs_write (signature->s, size);
+      mpn_copyi (rp, kp + size, size);
+
+      ecc_gostdsa_sign_online (ecc, key->p, kp, rp,
+			       digest_length, digest, sp, scratch);
+      mpz_limbs_finish (signature->r, size);
+      mpz_limbs_finish (signature->s, size);
+
+      mpn_zero (kp, 2*size);
+    }
+  while (mpz_sgn (signature->s) == 0);
+
+  return 1;
+}
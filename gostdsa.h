@@ -47,13 +47,21 @@ extern "C" {
 #define gostdsa_sign nettle_gostdsa_sign
 #define gostdsa_verify nettle_gostdsa_verify
 #define gostdsa_vko nettle_gostdsa_vko
+#define gostdsa_nonce_pool_init nettle_gostdsa_nonce_pool_init
+#define gostdsa_nonce_pool_clear nettle_gostdsa_nonce_pool_clear
+#define gostdsa_nonce_pool_fill nettle_gostdsa_nonce_pool_fill
+#define gostdsa_nonce_pool_move nettle_gostdsa_nonce_pool_move
+#define gostdsa_sign_online nettle_gostdsa_sign_online
 #define ecc_gostdsa_sign nettle_ecc_gostdsa_sign
 #define ecc_gostdsa_sign_itch nettle_ecc_gostdsa_sign_itch
+#define ecc_gostdsa_sign_offline nettle_ecc_gostdsa_sign_offline
+#define ecc_gostdsa_sign_online nettle_ecc_gostdsa_sign_online
 #define ecc_gostdsa_verify nettle_ecc_gostdsa_verify
 #define ecc_gostdsa_verify_itch nettle_ecc_gostdsa_verify_itch
 
 /* Just use ECDSA function for key generation */
 #define gostdsa_generate_keypair ecdsa_generate_keypair
+#define gostdsa_generate_keypairs ecdsa_generate_keypairs
 
 /* High level GOST DSA functions.
  *
@@ -77,6 +85,57 @@ gostdsa_vko(const struct ecc_scalar *key,
 	    size_t ukm_length, const uint8_t *ukm,
 	    size_t out_length, uint8_t *out);
 
+/* Offline/online signing. The expensive part of signing, computing
+   r from a random nonce k, doesn't depend on the message, and can be
+   done in advance. A pool holds such precomputed (k, r) pairs, and
+   gostdsa_sign_online consumes one pair per signature. Used pairs
+   are overwritten with zeros.
+
+   Like the rest of Nettle, the pool does no locking of its own. To
+   refill a pool in use by other threads, fill a separate pool without
+   holding any lock, and then transfer the entries using
+   gostdsa_nonce_pool_move, which is cheap, with the lock held. */
+struct gostdsa_nonce_pool
+{
+  const struct ecc_curve *ecc;
+  /* Capacity, and current number of unused entries. */
+  size_t size;
+  size_t count;
+  /* Each entry is k followed by r, 2*ecc_size limbs. Allocated using
+     the same allocation function as GMP. */
+  mp_limb_t *entries;
+};
+
+void
+gostdsa_nonce_pool_init (struct gostdsa_nonce_pool *pool,
+			 const struct ecc_curve *ecc, size_t size);
+
+/* Also clears all unused entries. */
+void
+gostdsa_nonce_pool_clear (struct gostdsa_nonce_pool *pool);
+
+/* Adds at most n new entries, returns the number of entries added,
+   which is smaller than n only if the pool gets full. */
+size_t
+gostdsa_nonce_pool_fill (struct gostdsa_nonce_pool *pool,
+			 void *random_ctx, nettle_random_func *random,
+			 size_t n);
+
+/* Moves as many entries as fit from src to dst, and returns the
+   number of entries moved. The pools must use the same curve. */
+size_t
+gostdsa_nonce_pool_move (struct gostdsa_nonce_pool *dst,
+			 struct gostdsa_nonce_pool *src);
+
+/* Returns zero, without producing any signature, if the pool is
+   empty. */
+int
+gostdsa_sign_online (const struct ecc_scalar *key,
+		     struct gostdsa_nonce_pool *pool,
+		     size_t digest_length,
+		     const uint8_t *digest,
+		     struct dsa_signature *signature);
+
 /* Low-level GOSTDSA functions. */
 mp_size_t
 ecc_gostdsa_sign_itch (const struct ecc_curve *ecc);
@@ -91,6 +150,23 @@ ecc_gostdsa_sign (const struct ecc_curve *ecc,
 		mp_limb_t *rp, mp_limb_t *sp,
 		mp_limb_t *scratch);
 
+/* The two halves of ecc_gostdsa_sign, using the same scratch space.
+   The offline part computes r from k, the online part computes s
+   from k, r and the message digest. */
+void
+ecc_gostdsa_sign_offline (const struct ecc_curve *ecc,
+			  const mp_limb_t *kp,
+			  mp_limb_t *rp,
+			  mp_limb_t *scratch);
+
+void
+ecc_gostdsa_sign_online (const struct ecc_curve *ecc,
+			 const mp_limb_t *zp,
+			 const mp_limb_t *kp, const mp_limb_t *rp,
+			 size_t length, const uint8_t *digest,
+			 mp_limb_t *sp,
+			 mp_limb_t *scratch);
+
 mp_size_t
 ecc_gostdsa_verify_itch (const struct ecc_curve *ecc);
 
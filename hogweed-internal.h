@@ -40,7 +40,18 @@ _nettle_generate_pocklington_prime (mpz_t p, mpz_t r,
 				    void *ctx, nettle_random_func *random,
 				    const mpz_t p0,
 				    const mpz_t q,
-				    const mpz_t p0q);
+				    const mpz_t p0q,
+				    void *progress_ctx,
+				    nettle_progress_func *progress,
+				    void *executor_ctx,
+				    nettle_executor_func *executor,
+				    unsigned width);
+
+/* Runs the tasks using the executor, or sequentially if it is
+   NULL. */
+void
+_nettle_run_tasks (void *executor_ctx, nettle_executor_func *executor,
+		   size_t count, nettle_task_func *task, void *arg);
 
 #define _pkcs1_signature_prefix _nettle_pkcs1_signature_prefix
 
@@ -51,4 +62,12 @@ _pkcs1_signature_prefix(unsigned key_size,
 			const uint8_t *id,
 			unsigned digest_size);
 
+#define _pkcs1_rsa_sha256_prefix _nettle_pkcs1_rsa_sha256_prefix
+
+/* Writes the padding and DigestInfo prefix of a PKCS#1 SHA256
+   signature, and returns where the digest goes, or NULL if key_size
+   is too small. */
+uint8_t *
+_pkcs1_rsa_sha256_prefix(size_t key_size, uint8_t *buffer);
+
 #endif /* NETTLE_HOGWEED_INTERNAL_H_INCLUDED */
@@ -0,0 +1,65 @@
+/* mont52-internal.h
+
+   Multi-buffer Montgomery multiplication, in radix 2^52.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#ifndef NETTLE_MONT52_INTERNAL_H_INCLUDED
+#define NETTLE_MONT52_INTERNAL_H_INCLUDED
+
+#include "nettle-types.h"
+
+/* Numbers are processed MONT52_LANES at a time, each lane with its
+   own modulus. A vector of size digits is stored interleaved, with
+   digit j of lane l at index j * MONT52_LANES + l, each digit less
+   than 2^52. */
+#define MONT52_LANES 8
+#define MONT52_DIGIT_BITS 52
+#define MONT52_DIGIT_MASK ((((uint64_t) 1) << MONT52_DIGIT_BITS) - 1)
+
+/* Largest supported size, in digits, enough for 2048-bit moduli. */
+#define MONT52_MAX_SIZE 40
+
+#define _mont52_mul _nettle_mont52_mul
+#define _mont52_native _nettle_mont52_native
+
+/* Almost Montgomery multiplication, r = a b / 2^(52 size) mod m, for
+   each lane, with minv holding -1/m mod 2^52 for each lane. Requires
+   4 m < 2^(52 size), and a, b < 2 m. The output is less than 2 m,
+   and must not overlap any input. Side-channel silent, and size must
+   be at least 2 and at most MONT52_MAX_SIZE. */
+void
+_mont52_mul (uint64_t *rp, const uint64_t *ap, const uint64_t *bp,
+	     const uint64_t *mp, const uint64_t *minv, size_t size);
+
+/* Non-zero if _mont52_mul uses vector instructions, and hence is
+   faster than doing the same work with the mpn functions. */
+int
+_mont52_native (void);
+
+#endif /* NETTLE_MONT52_INTERNAL_H_INCLUDED */
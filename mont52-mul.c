@@ -0,0 +1,133 @@
+/* mont52-mul.c
+
+   Multi-buffer Montgomery multiplication, in radix 2^52.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "mont52-internal.h"
+
+/* For fat builds */
+#if HAVE_NATIVE_mont52_mul
+void
+_nettle_mont52_mul_c (uint64_t *rp, const uint64_t *ap, const uint64_t *bp,
+		      const uint64_t *mp, const uint64_t *minv, size_t size);
+#define _nettle_mont52_mul _nettle_mont52_mul_c
+#else
+int
+_mont52_native (void)
+{
+  return 0;
+}
+#endif
+
+/* Sets *hi and *lo to the high and low 52 bits of a b, for a, b <
+   2^52, in the same way as the vpmadd52huq and vpmadd52luq
+   instructions. */
+#define MUL52(hi, lo, a, b) do {					\
+    uint64_t __a0 = (a) & 0x3ffffff, __a1 = (a) >> 26;			\
+    uint64_t __b0 = (b) & 0x3ffffff, __b1 = (b) >> 26;			\
+    uint64_t __m = __a0 * __b1 + __a1 * __b0;				\
+    uint64_t __s = __a0 * __b0 + ((__m & 0x3ffffff) << 26);		\
+    (lo) = __s & MONT52_DIGIT_MASK;					\
+    (hi) = __a1 * __b1 + (__m >> 26) + (__s >> MONT52_DIGIT_BITS);	\
+  } while (0)
+
+/* Same algorithm as the vector implementations: digits of the
+   accumulator are allowed to exceed 2^52, and carries are propagated
+   only at the end. With at most 4 additions per digit per iteration,
+   there's no overflow for sizes below 2^10, well above
+   MONT52_MAX_SIZE. */
+void
+_mont52_mul (uint64_t *rp, const uint64_t *ap, const uint64_t *bp,
+	     const uint64_t *mp, const uint64_t *minv, size_t size)
+{
+  unsigned l;
+
+  assert (size >= 2);
+  assert (size <= MONT52_MAX_SIZE);
+
+  for (l = 0; l < MONT52_LANES; l++)
+    {
+      uint64_t *tp = rp + l;
+      size_t i, j;
+      uint64_t c;
+
+#define A(j) ap[(j) * MONT52_LANES + l]
+#define M(j) mp[(j) * MONT52_LANES + l]
+#define T(j) tp[(j) * MONT52_LANES]
+      for (j = 0; j < size; j++)
+	T(j) = 0;
+
+      for (i = 0; i < size; i++)
+	{
+	  uint64_t b = bp[i * MONT52_LANES + l];
+	  uint64_t hi, lo, q, t;
+
+	  MUL52 (hi, lo, A(0), b);
+	  t = T(0) + lo;
+	  MUL52 (hi, q, t & MONT52_DIGIT_MASK, minv[l]);
+	  MUL52 (hi, lo, M(0), q);
+	  c = (t + lo) >> MONT52_DIGIT_BITS;
+
+	  for (j = 1; j < size; j++)
+	    {
+	      t = T(j) + c;
+	      c = 0;
+	      MUL52 (hi, lo, A(j), b);
+	      t += lo;
+	      MUL52 (hi, lo, M(j), q);
+	      t += lo;
+	      MUL52 (hi, lo, A(j-1), b);
+	      t += hi;
+	      MUL52 (hi, lo, M(j-1), q);
+	      T(j-1) = t + hi;
+	    }
+	  MUL52 (hi, lo, A(size-1), b);
+	  t = hi;
+	  MUL52 (hi, lo, M(size-1), q);
+	  T(size-1) = t + hi;
+	}
+
+      for (j = 0, c = 0; j < size; j++)
+	{
+	  uint64_t t = T(j) + c;
+	  c = t >> MONT52_DIGIT_BITS;
+	  T(j) = t & MONT52_DIGIT_MASK;
+	}
+      assert (c == 0);
+#undef A
+#undef M
+#undef T
+    }
+}
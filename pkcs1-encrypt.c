@@ -40,18 +40,18 @@
 #include <string.h>
 
 #include "pkcs1.h"
+#include "pkcs1-internal.h"
 
 #include "bignum.h"
 #include "gmp-glue.h"
 
 int
-pkcs1_encrypt (size_t key_size,
-	       /* For padding */
-	       void *random_ctx, nettle_random_func *random,
-	       size_t length, const uint8_t *message,
-	       mpz_t m)
+_pkcs1_encrypt_octets (size_t key_size,
+		       /* For padding */
+		       void *random_ctx, nettle_random_func *random,
+		       size_t length, const uint8_t *message,
+		       uint8_t *em)
 {
-  TMP_GMP_DECL(em, uint8_t);
   size_t padding;
   size_t i;
 
@@ -71,7 +71,6 @@ pkcs1_encrypt (size_t key_size,
   padding = key_size - length - 3;
   assert(padding >= 8);
   
-  TMP_GMP_ALLOC(em, key_size - 1);
   em[0] = 2;
 
   random(random_ctx, padding, em + 1);
@@ -84,8 +83,26 @@ pkcs1_encrypt (size_t key_size,
   em[padding+1] = 0;
   memcpy(em + padding + 2, message, length);
 
-  nettle_mpz_set_str_256_u(m, key_size - 1, em);
+  return 1;
+}
+
+int
+pkcs1_encrypt (size_t key_size,
+	       /* For padding */
+	       void *random_ctx, nettle_random_func *random,
+	       size_t length, const uint8_t *message,
+	       mpz_t m)
+{
+  TMP_GMP_DECL(em, uint8_t);
+  int res;
+
+  TMP_GMP_ALLOC(em, key_size - 1);
+
+  res = _pkcs1_encrypt_octets (key_size, random_ctx, random,
+			       length, message, em);
+  if (res)
+    nettle_mpz_set_str_256_u(m, key_size - 1, em);
 
   TMP_GMP_FREE(em);
-  return 1;
+  return res;
 }
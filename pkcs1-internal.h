@@ -37,6 +37,10 @@
 
 #define _pkcs1_sec_decrypt _nettle_pkcs1_sec_decrypt
 #define _pkcs1_sec_decrypt_variable _nettle_pkcs1_sec_decrypt_variable
+#define _pkcs1_encrypt_octets _nettle_pkcs1_encrypt_octets
+#define _pss_verify_mgf1_octets _nettle_pss_verify_mgf1_octets
+
+struct nettle_hash;
 
 /* additional resistance to memory access side-channel attacks.
  * Note: message buffer is returned unchanged on error */
@@ -50,4 +54,21 @@ _pkcs1_sec_decrypt_variable(size_t *length, uint8_t *message,
                             size_t padded_message_length,
                             const volatile uint8_t *padded_message);
 
+/* Writes the key_size - 1 least significant octets of the encoding,
+   02 pad 00 message, to em. */
+int
+_pkcs1_encrypt_octets (size_t key_size,
+		       void *random_ctx, nettle_random_func *random,
+		       size_t length, const uint8_t *message,
+		       uint8_t *em);
+
+/* Like pss_verify_mgf1, for the encoded message given as key_size =
+   (bits + 7) / 8 octets. Uses key_size octets at db as scratch. */
+int
+_pss_verify_mgf1_octets(const uint8_t *em, size_t bits,
+			const struct nettle_hash *hash,
+			size_t salt_length,
+			const uint8_t *digest,
+			uint8_t *db);
+
 #endif /* NETTLE_PKCS1_INTERNAL_H_INCLUDED */
@@ -68,6 +68,15 @@ sha256_prefix[] =
       /* Here comes the raw hash value */
 };
 
+uint8_t *
+_pkcs1_rsa_sha256_prefix(size_t key_size, uint8_t *buffer)
+{
+  return _pkcs1_signature_prefix(key_size, buffer,
+				 sizeof(sha256_prefix),
+				 sha256_prefix,
+				 SHA256_DIGEST_SIZE);
+}
+
 int
 pkcs1_rsa_sha256_encode(mpz_t m, size_t key_size, struct sha256_ctx *hash)
 {
@@ -76,10 +85,7 @@ pkcs1_rsa_sha256_encode(mpz_t m, size_t key_size, struct sha256_ctx *hash)
 
   TMP_GMP_ALLOC(em, key_size);
 
-  p = _pkcs1_signature_prefix(key_size, em,
-			      sizeof(sha256_prefix),
-			      sha256_prefix,
-			      SHA256_DIGEST_SIZE);
+  p = _pkcs1_rsa_sha256_prefix(key_size, em);
   if (p)
     {
       sha256_digest(hash, SHA256_DIGEST_SIZE, p);
@@ -102,10 +108,7 @@ pkcs1_rsa_sha256_encode_digest(mpz_t m, size_t key_size, const uint8_t *digest)
 
   TMP_GMP_ALLOC(em, key_size);
 
-  p = _pkcs1_signature_prefix(key_size, em,
-			      sizeof(sha256_prefix),
-			      sha256_prefix,
-			      SHA256_DIGEST_SIZE);
+  p = _pkcs1_rsa_sha256_prefix(key_size, em);
   if (p)
     {
       memcpy(p, digest, SHA256_DIGEST_SIZE);
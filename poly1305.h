@@ -45,6 +45,8 @@ extern "C" {
 #define poly1305_set_key nettle_poly1305_set_key
 #define poly1305_digest nettle_poly1305_digest
 #define _poly1305_block _nettle_poly1305_block
+#define _poly1305_blocks _nettle_poly1305_blocks
+#define _poly1305_update _nettle_poly1305_update
 
 #define poly1305_aes_set_key nettle_poly1305_aes_set_key
 #define poly1305_aes_set_nonce nettle_poly1305_aes_set_nonce
@@ -83,6 +85,17 @@ void poly1305_digest (struct poly1305_ctx *ctx, union nettle_block16 *s);
 /* Internal function. Process one block. */
 void _poly1305_block (struct poly1305_ctx *ctx, const uint8_t *m,
 		      unsigned high);
+/* Internal function. Process a number of complete blocks, all with
+   the high bit set. Returns a pointer to the end of the processed
+   data. */
+const uint8_t *
+_poly1305_blocks (struct poly1305_ctx *ctx, size_t blocks,
+		  const uint8_t *m);
+/* Internal function. Processes data, using buffer to hold a partial
+   block of index bytes. Returns the new index. */
+unsigned
+_poly1305_update (struct poly1305_ctx *ctx, uint8_t *buffer,
+		  unsigned index, size_t length, const uint8_t *m);
 
 /* poly1305-aes */
 
@@ -35,7 +35,6 @@
 # include "config.h"
 #endif
 
-#include <assert.h>
 #include <string.h>
 
 #include "pss.h"
@@ -46,6 +45,7 @@
 
 #include "memxor.h"
 #include "nettle-internal.h"
+#include "pkcs1-internal.h"
 
 /* Masks to clear the leftmost N bits.  */
 static const uint8_t pss_masks[8] = {
@@ -120,51 +120,40 @@ pss_encode_mgf1(mpz_t m, size_t bits,
  * Returns 1 if the encoded message is consistent, 0 if it is
  * inconsistent.  */
 int
-pss_verify_mgf1(const mpz_t m, size_t bits,
-		const struct nettle_hash *hash,
-		size_t salt_length,
-		const uint8_t *digest)
+_pss_verify_mgf1_octets(const uint8_t *em, size_t bits,
+			const struct nettle_hash *hash,
+			size_t salt_length,
+			const uint8_t *digest,
+			uint8_t *db)
 {
-  TMP_GMP_DECL(em, uint8_t);
   TMP_DECL(h2, uint8_t, NETTLE_MAX_HASH_DIGEST_SIZE);
   TMP_DECL_ALIGN(state, NETTLE_MAX_HASH_CONTEXT_SIZE);
-  uint8_t *h, *db, *salt;
+  const uint8_t *h, *salt;
   size_t key_size = (bits + 7) / 8;
   size_t j;
-  int ret = 0;
-
-  /* Allocate twice the key size to store the intermediate data DB
-   * following the EM value.  */
-  TMP_GMP_ALLOC(em, key_size * 2);
 
   TMP_ALLOC(h2, hash->digest_size);
   TMP_ALLOC_ALIGN(state, hash->context_size);
 
   if (key_size < hash->digest_size + salt_length + 2)
-    goto cleanup;
+    return 0;
 
-  if (mpz_sizeinbase(m, 2) > bits)
-    goto cleanup;
-
-  nettle_mpz_get_str_256(key_size, em, m);
+  /* The leftmost 8 * emLen - emBits bits of the leftmost octet of EM
+   * must all equal to zero. */
+  if ((*em & ~pss_masks[(8 * key_size - bits)]) != 0)
+    return 0;
 
   /* Check the trailer field.  */
   if (em[key_size - 1] != 0xbc)
-    goto cleanup;
+    return 0;
 
   /* Extract H.  */
   h = em + (key_size - hash->digest_size - 1);
 
-  /* The leftmost 8 * emLen - emBits bits of the leftmost octet of EM
-   * must all equal to zero. Always true here, thanks to the above
-   * check on the bit size of m. */
-  assert((*em & ~pss_masks[(8 * key_size - bits)]) == 0);
-
   /* Compute dbMask.  */
   hash->init(state);
   hash->update(state, hash->digest_size, h);
 
-  db = em + key_size;
   pss_mgf1(state, hash, key_size - hash->digest_size - 1, db);
 
   /* Compute DB.  */
@@ -173,11 +162,11 @@ pss_verify_mgf1(const mpz_t m, size_t bits,
   *db &= pss_masks[(8 * key_size - bits)];
   for (j = 0; j < key_size - salt_length - hash->digest_size - 2; j++)
     if (db[j] != 0)
-      goto cleanup;
+      return 0;
 
   /* Check the octet right after PS is 0x1.  */
   if (db[j] != 0x1)
-    goto cleanup;
+    return 0;
   salt = db + j + 1;
 
   /* Compute H'.  */
@@ -188,11 +177,30 @@ pss_verify_mgf1(const mpz_t m, size_t bits,
   hash->digest(state, hash->digest_size, h2);
 
   /* Check if H' = H.  */
-  if (memcmp(h2, h, hash->digest_size) != 0)
-    goto cleanup;
+  return memcmp(h2, h, hash->digest_size) == 0;
+}
+
+int
+pss_verify_mgf1(const mpz_t m, size_t bits,
+		const struct nettle_hash *hash,
+		size_t salt_length,
+		const uint8_t *digest)
+{
+  TMP_GMP_DECL(em, uint8_t);
+  size_t key_size = (bits + 7) / 8;
+  int ret;
+
+  if (mpz_sizeinbase(m, 2) > bits)
+    return 0;
+
+  /* Allocate twice the key size to store the intermediate data DB
+   * following the EM value.  */
+  TMP_GMP_ALLOC(em, key_size * 2);
+
+  nettle_mpz_get_str_256(key_size, em, m);
+  ret = _pss_verify_mgf1_octets(em, bits, hash, salt_length, digest,
+				em + key_size);
 
-  ret = 1;
- cleanup:
   TMP_GMP_FREE(em);
   return ret;
 }
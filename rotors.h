@@ -0,0 +1,82 @@
+/* automagically made - do not fuss with this */
+
+ 34, 13,  5, 46, 47, 18, 32, 41, 11, 53, 33, 20,
+ 14, 36, 30, 24, 49,  2, 15, 37, 42, 50,  0, 21,
+ 38, 48,  6, 26, 39,  4, 52, 25, 12, 27, 31, 40,
+  1, 17, 28, 29, 23, 51, 35,  7,  3, 22,  9, 43,
+
+ 41, 20, 12, 53, 54, 25, 39, 48, 18, 31, 40, 27,
+ 21, 43, 37,  0,  1,  9, 22, 44, 49,  2,  7, 28,
+ 45, 55, 13, 33, 46, 11,  6, 32, 19, 34, 38, 47,
+  8, 24, 35, 36, 30,  3, 42, 14, 10, 29, 16, 50,
+
+ 55, 34, 26, 38, 11, 39, 53,  5, 32, 45, 54, 41,
+ 35,  2, 51, 14, 15, 23, 36,  3,  8, 16, 21, 42,
+  6, 12, 27, 47, 31, 25, 20, 46, 33, 48, 52,  4,
+ 22,  7, 49, 50, 44, 17,  1, 28, 24, 43, 30,  9,
+
+ 12, 48, 40, 52, 25, 53, 38, 19, 46,  6, 11, 55,
+ 49, 16, 10, 28, 29, 37, 50, 17, 22, 30, 35,  1,
+ 20, 26, 41,  4, 45, 39, 34, 31, 47,  5, 13, 18,
+ 36, 21,  8,  9,  3,  0, 15, 42,  7,  2, 44, 23,
+
+ 26,  5, 54, 13, 39, 38, 52, 33, 31, 20, 25, 12,
+  8, 30, 24, 42, 43, 51,  9,  0, 36, 44, 49, 15,
+ 34, 40, 55, 18,  6, 53, 48, 45,  4, 19, 27, 32,
+ 50, 35, 22, 23, 17, 14, 29,  1, 21, 16,  3, 37,
+
+ 40, 19, 11, 27, 53, 52, 13, 47, 45, 34, 39, 26,
+ 22, 44,  7,  1,  2, 10, 23, 14, 50,  3,  8, 29,
+ 48, 54, 12, 32, 20, 38,  5,  6, 18, 33, 41, 46,
+  9, 49, 36, 37,  0, 28, 43, 15, 35, 30, 17, 51,
+
+ 54, 33, 25, 41, 38, 13, 27,  4,  6, 48, 53, 40,
+ 36,  3, 21, 15, 16, 24, 37, 28,  9, 17, 22, 43,
+  5, 11, 26, 46, 34, 52, 19, 20, 32, 47, 55, 31,
+ 23,  8, 50, 51, 14, 42,  2, 29, 49, 44,  0, 10,
+
+ 11, 47, 39, 55, 52, 27, 41, 18, 20,  5, 38, 54,
+ 50, 17, 35, 29, 30,  7, 51, 42, 23,  0, 36,  2,
+ 19, 25, 40, 31, 48, 13, 33, 34, 46,  4, 12, 45,
+ 37, 22,  9, 10, 28,  1, 16, 43,  8,  3, 14, 24,
+
+ 18, 54, 46,  5,  6, 34, 48, 25, 27, 12, 45,  4,
+  2, 24, 42, 36, 37, 14,  3, 49, 30,  7, 43,  9,
+ 26, 32, 47, 38, 55, 20, 40, 41, 53, 11, 19, 52,
+ 44, 29, 16, 17, 35,  8, 23, 50, 15, 10, 21,  0,
+
+ 32, 11, 31, 19, 20, 48,  5, 39, 41, 26,  6, 18,
+ 16,  7,  1, 50, 51, 28, 17,  8, 44, 21,  2, 23,
+ 40, 46,  4, 52, 12, 34, 54, 55, 38, 25, 33, 13,
+  3, 43, 30,  0, 49, 22, 37,  9, 29, 24, 35, 14,
+
+ 46, 25, 45, 33, 34,  5, 19, 53, 55, 40, 20, 32,
+ 30, 21, 15,  9, 10, 42,  0, 22,  3, 35, 16, 37,
+ 54, 31, 18, 13, 26, 48, 11, 12, 52, 39, 47, 27,
+ 17,  2, 44, 14,  8, 36, 51, 23, 43,  7, 49, 28,
+
+ 31, 39,  6, 47, 48, 19, 33, 38, 12, 54, 34, 46,
+ 44, 35, 29, 23, 24,  1, 14, 36, 17, 49, 30, 51,
+ 11, 45, 32, 27, 40,  5, 25, 26, 13, 53,  4, 41,
+  0, 16,  3, 28, 22, 50, 10, 37,  2, 21,  8, 42,
+
+ 45, 53, 20,  4,  5, 33, 47, 52, 26, 11, 48, 31,
+  3, 49, 43, 37,  7, 15, 28, 50,  0,  8, 44, 10,
+ 25,  6, 46, 41, 54, 19, 39, 40, 27, 38, 18, 55,
+ 14, 30, 17, 42, 36,  9, 24, 51, 16, 35, 22,  1,
+
+  6, 38, 34, 18, 19, 47,  4, 13, 40, 25,  5, 45,
+ 17,  8,  2, 51, 21, 29, 42,  9, 14, 22,  3, 24,
+ 39, 20, 31, 55, 11, 33, 53, 54, 41, 52, 32, 12,
+ 28, 44,  0,  1, 50, 23,  7, 10, 30, 49, 36, 15,
+
+ 20, 52, 48, 32, 33,  4, 18, 27, 54, 39, 19,  6,
+  0, 22, 16, 10, 35, 43,  1, 23, 28, 36, 17,  7,
+ 53, 34, 45, 12, 25, 47, 38, 11, 55, 13, 46, 26,
+ 42,  3, 14, 15,  9, 37, 21, 24, 44,  8, 50, 29,
+
+ 27,  6, 55, 39, 40, 11, 25, 34,  4, 46, 26, 13,
+  7, 29, 23, 17, 42, 50,  8, 30, 35, 43, 24, 14,
+ 31, 41, 52, 19, 32, 54, 45, 18,  5, 20, 53, 33,
+ 49, 10, 21, 22, 16, 44, 28,  0, 51, 15,  2, 36,
+
@@ -0,0 +1,406 @@
+/* rsa-batch.c
+
+   Batch RSA private key operations, distributed over a set of workers.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "rsa.h"
+#include "rsa-internal.h"
+#include "pkcs1-internal.h"
+#include "hogweed-internal.h"
+#include "gmp-glue.h"
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+struct rsa_batch_ctx;
+
+/* Sets mp, of key size limbs, to input i. */
+typedef void rsa_batch_input_func (const struct rsa_batch_ctx *ctx,
+				   size_t i, mp_limb_t *mp);
+/* Stores the root xp of input i, which is zero if ok is 0, and
+   returns 1 on success. Gets key size limbs of scratch. */
+typedef int rsa_batch_output_func (const struct rsa_batch_ctx *ctx,
+				   size_t i, const mp_limb_t *xp, int ok,
+				   mp_limb_t *scratch);
+
+struct rsa_batch_ctx
+{
+  const struct rsa_public_key *pub;
+  const struct rsa_private_key *key;
+  const struct rsa_private_precomp *pre;
+  const struct rsa_mb_key *mb;
+  size_t workers;
+  struct rsa_worker *worker;
+  size_t count;
+  rsa_batch_input_func *input;
+  rsa_batch_output_func *output;
+  /* For rsa_compute_root_tr_batch */
+  mpz_t *x;
+  /* For rsa_sec_decrypt_batch */
+  const uint8_t *ciphertexts;
+  size_t length;
+  uint8_t *messages;
+  int *valid;
+  int *ok;
+};
+
+#if NETTLE_USE_MINI_GMP
+/* Only room for input and output, since mini-gmp uses the mpz
+   interface. */
+void
+rsa_worker_init (struct rsa_worker *worker,
+		 const struct rsa_public_key *pub,
+		 const struct rsa_private_key *key,
+		 const struct rsa_private_precomp *pre,
+		 void *random_ctx, nettle_random_func *random)
+{
+  assert (pre->pub.size == (mp_size_t) mpz_size (pub->n));
+  assert (pre->pub.size
+	  == (mp_size_t) NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size));
+
+  rsa_blinding_init (&worker->blinding);
+  worker->random_ctx = random_ctx;
+  worker->random = random;
+  worker->size = 2 * pre->pub.size;
+  worker->scratch = gmp_alloc_limbs (worker->size);
+}
+
+static int
+rsa_worker_run (const struct rsa_batch_ctx *ctx, struct rsa_worker *worker,
+		size_t start, size_t end)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (ctx->key->size);
+  mp_limb_t *mp = worker->scratch;
+  mp_limb_t *xp = worker->scratch + nn;
+  int ok = 1;
+
+  for (; start < end; start++)
+    {
+      mpz_t m, x;
+      int res;
+
+      ctx->input (ctx, start, mp);
+      mpz_init (x);
+      res = rsa_compute_root_tr_blinding (ctx->pub, ctx->key, ctx->pre,
+					  &worker->blinding,
+					  worker->random_ctx, worker->random,
+					  x, mpz_roinit_n (m, mp, nn));
+      if (res)
+	mpz_limbs_copy (xp, x, nn);
+      else
+	mpn_zero (xp, nn);
+      mpz_clear (x);
+
+      ok &= ctx->output (ctx, start, xp, res, mp);
+    }
+  return ok;
+}
+#else
+/* The multi-buffer path is used only if the vectorized Montgomery
+   multiplication is available, since the generic C implementation is
+   much slower than gmp. */
+static int
+rsa_batch_use_mb (const struct rsa_private_key *key)
+{
+  return _mont52_native () && _rsa_mb_sec_compute_root_itch (key) > 0;
+}
+
+static mp_size_t
+rsa_worker_itch (const struct rsa_public_key *pub,
+		 const struct rsa_private_key *key,
+		 const struct rsa_private_precomp *pre)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size);
+  mp_size_t itch = 2*nn + _rsa_sec_compute_root_tr_precomp_itch (pub, key,
+								  pre);
+  if (rsa_batch_use_mb (key))
+    {
+      mp_size_t i2 = MAX (_rsa_sec_blind_precomp_itch (pub, pre),
+			  _rsa_sec_unblind_precomp_itch (pub, pre));
+      i2 = MAX (i2, _rsa_mb_sec_compute_root_itch (key));
+      itch = MAX (itch, 4 * RSA_MB_COUNT * nn + i2);
+    }
+  return itch;
+}
+
+void
+rsa_worker_init (struct rsa_worker *worker,
+		 const struct rsa_public_key *pub,
+		 const struct rsa_private_key *key,
+		 const struct rsa_private_precomp *pre,
+		 void *random_ctx, nettle_random_func *random)
+{
+  rsa_blinding_init (&worker->blinding);
+  worker->random_ctx = random_ctx;
+  worker->random = random;
+  worker->size = rsa_worker_itch (pub, key, pre);
+  worker->scratch = gmp_alloc_limbs (worker->size);
+}
+
+/* Handles count <= RSA_MB_COUNT elements, with a single multi-buffer
+   exponentiation. */
+static int
+rsa_worker_run_mb (const struct rsa_batch_ctx *ctx, struct rsa_worker *worker,
+		   size_t start, size_t count)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (ctx->key->size);
+  mp_limb_t *mp = worker->scratch;
+  mp_limb_t *cp = mp + RSA_MB_COUNT * nn;
+  mp_limb_t *vf = cp + RSA_MB_COUNT * nn;
+  mp_limb_t *xp = vf + RSA_MB_COUNT * nn;
+  mp_limb_t *scratch = xp + RSA_MB_COUNT * nn;
+  size_t i;
+  int ok;
+
+  for (i = 0; i < count; i++)
+    {
+      ctx->input (ctx, start + i, mp + i*nn);
+      _rsa_sec_blind_precomp (ctx->pub, ctx->pre, &worker->blinding,
+			      worker->random_ctx, worker->random,
+			      cp + i*nn, vf + i*nn, mp + i*nn, nn, scratch);
+    }
+
+  _rsa_mb_sec_compute_root (ctx->mb, ctx->key, ctx->pre,
+			    count, xp, cp, scratch);
+
+  for (i = 0, ok = 1; i < count; i++)
+    {
+      int res = _rsa_sec_unblind_precomp (ctx->pub, ctx->pre, xp + i*nn,
+					  cp + i*nn, vf + i*nn, scratch);
+      ok &= ctx->output (ctx, start + i, xp + i*nn, res, mp + i*nn);
+    }
+  return ok;
+}
+
+/* Uses only the worker's preallocated scratch, and the blinding
+   state, which is allocated on first use. Groups of at least two
+   elements use the multi-buffer path, if enabled. */
+static int
+rsa_worker_run (const struct rsa_batch_ctx *ctx, struct rsa_worker *worker,
+		size_t start, size_t end)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (ctx->key->size);
+  mp_limb_t *mp = worker->scratch;
+  mp_limb_t *xp = worker->scratch + nn;
+  int ok = 1;
+
+  assert (worker->size == rsa_worker_itch (ctx->pub, ctx->key, ctx->pre));
+
+  if (ctx->mb)
+    for (; end - start >= 2; )
+      {
+	size_t count = end - start;
+	if (count > RSA_MB_COUNT)
+	  count = RSA_MB_COUNT;
+
+	ok &= rsa_worker_run_mb (ctx, worker, start, count);
+	start += count;
+      }
+
+  for (; start < end; start++)
+    {
+      int res;
+
+      ctx->input (ctx, start, mp);
+      res = _rsa_sec_compute_root_tr_precomp (ctx->pub, ctx->key, ctx->pre,
+					      &worker->blinding, NULL, NULL,
+					      worker->random_ctx, worker->random,
+					      xp, mp, nn, worker->scratch + 2*nn);
+      ok &= ctx->output (ctx, start, xp, res, mp);
+    }
+  return ok;
+}
+#endif
+
+void
+rsa_worker_clear (struct rsa_worker *worker)
+{
+  rsa_blinding_clear (&worker->blinding);
+  if (worker->scratch)
+    gmp_free_limbs (worker->scratch, worker->size);
+  worker->size = 0;
+  worker->scratch = NULL;
+}
+
+/* Worker i processes a contiguous range of the elements. */
+static void
+rsa_batch_task (void *arg, size_t i)
+{
+  const struct rsa_batch_ctx *ctx = (const struct rsa_batch_ctx *) arg;
+  size_t start = i * ctx->count / ctx->workers;
+  size_t end = (i + 1) * ctx->count / ctx->workers;
+
+  ctx->ok[i] = rsa_worker_run (ctx, ctx->worker + i, start, end);
+}
+
+static int
+rsa_batch_run (struct rsa_batch_ctx *ctx,
+	       void *executor_ctx, rsa_executor_func *executor)
+{
+  size_t i;
+  int res;
+  TMP_GMP_DECL (ok, int);
+
+  assert (ctx->workers > 0);
+
+  if (ctx->workers > ctx->count)
+    ctx->workers = ctx->count;
+  if (ctx->workers == 0)
+    return 1;
+
+  TMP_GMP_ALLOC (ok, ctx->workers);
+  ctx->ok = ok;
+  ctx->mb = NULL;
+
+#if !NETTLE_USE_MINI_GMP
+  /* Invalid keys are left to the single element path, which rejects
+     them. */
+  if (rsa_batch_use_mb (ctx->key) && ctx->count >= 2
+      && mpz_odd_p (ctx->pub->n)
+      && mpz_odd_p (ctx->key->p) && mpz_odd_p (ctx->key->q))
+    {
+      TMP_GMP_DECL (mb, struct rsa_mb_key);
+
+      TMP_GMP_ALLOC (mb, 1);
+      _rsa_mb_key_init (mb, ctx->key);
+      ctx->mb = mb;
+
+      _nettle_run_tasks (executor_ctx, executor, ctx->workers,
+			 rsa_batch_task, ctx);
+
+      TMP_GMP_FREE (mb);
+    }
+  else
+#endif
+    _nettle_run_tasks (executor_ctx, executor, ctx->workers,
+		       rsa_batch_task, ctx);
+
+  for (i = 0, res = 1; i < ctx->workers; i++)
+    res &= ok[i];
+
+  TMP_GMP_FREE (ok);
+  return res;
+}
+
+static void
+rsa_root_input (const struct rsa_batch_ctx *ctx, size_t i, mp_limb_t *mp)
+{
+  mpz_limbs_copy (mp, ctx->x[i],
+		  NETTLE_OCTET_SIZE_TO_LIMB_SIZE (ctx->key->size));
+}
+
+static int
+rsa_root_output (const struct rsa_batch_ctx *ctx, size_t i,
+		 const mp_limb_t *xp, int ok, mp_limb_t *scratch)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (ctx->key->size);
+  (void) scratch;
+
+  mpn_copyi (mpz_limbs_write (ctx->x[i], nn), xp, nn);
+  mpz_limbs_finish (ctx->x[i], nn);
+  return ok;
+}
+
+int
+rsa_compute_root_tr_batch (const struct rsa_public_key *pub,
+			   const struct rsa_private_key *key,
+			   const struct rsa_private_precomp *pre,
+			   size_t workers, struct rsa_worker *worker,
+			   void *executor_ctx, rsa_executor_func *executor,
+			   size_t count, mpz_t *x)
+{
+  struct rsa_batch_ctx ctx;
+
+  ctx.pub = pub;
+  ctx.key = key;
+  ctx.pre = pre;
+  ctx.workers = workers;
+  ctx.worker = worker;
+  ctx.count = count;
+  ctx.input = rsa_root_input;
+  ctx.output = rsa_root_output;
+  ctx.x = x;
+
+  return rsa_batch_run (&ctx, executor_ctx, executor);
+}
+
+static void
+rsa_decrypt_input (const struct rsa_batch_ctx *ctx, size_t i, mp_limb_t *mp)
+{
+  mpn_set_base256 (mp, NETTLE_OCTET_SIZE_TO_LIMB_SIZE (ctx->key->size),
+		   ctx->ciphertexts + i * ctx->key->size, ctx->key->size);
+}
+
+static int
+rsa_decrypt_output (const struct rsa_batch_ctx *ctx, size_t i,
+		    const mp_limb_t *xp, int ok, mp_limb_t *scratch)
+{
+  uint8_t *em = (uint8_t *) scratch;
+
+  mpn_get_base256 (em, ctx->key->size, xp,
+		   NETTLE_OCTET_SIZE_TO_LIMB_SIZE (ctx->key->size));
+
+  ok &= _pkcs1_sec_decrypt (ctx->length, ctx->messages + i * ctx->length,
+			    ctx->key->size, em);
+  if (ctx->valid)
+    ctx->valid[i] = ok;
+  return ok;
+}
+
+int
+rsa_sec_decrypt_batch (const struct rsa_public_key *pub,
+		       const struct rsa_private_key *key,
+		       const struct rsa_private_precomp *pre,
+		       size_t workers, struct rsa_worker *worker,
+		       void *executor_ctx, rsa_executor_func *executor,
+		       size_t count, size_t length, uint8_t *messages,
+		       const uint8_t *ciphertexts, int *valid)
+{
+  struct rsa_batch_ctx ctx;
+
+  ctx.pub = pub;
+  ctx.key = key;
+  ctx.pre = pre;
+  ctx.workers = workers;
+  ctx.worker = worker;
+  ctx.count = count;
+  ctx.input = rsa_decrypt_input;
+  ctx.output = rsa_decrypt_output;
+  ctx.ciphertexts = ciphertexts;
+  ctx.length = length;
+  ctx.messages = messages;
+  ctx.valid = valid;
+
+  return rsa_batch_run (&ctx, executor_ctx, executor);
+}
@@ -0,0 +1,54 @@
+/* rsa-blinding.c
+
+   Amortised blinding state for RSA private key operations.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "rsa.h"
+#include "gmp-glue.h"
+
+void
+rsa_blinding_init (struct rsa_blinding *blinding)
+{
+  blinding->size = 0;
+  blinding->count = 0;
+  blinding->vi = blinding->vf = blinding->n = NULL;
+}
+
+void
+rsa_blinding_clear (struct rsa_blinding *blinding)
+{
+  if (blinding->vi)
+    gmp_free_limbs (blinding->vi, 3*blinding->size);
+
+  rsa_blinding_init (blinding);
+}
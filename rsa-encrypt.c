@@ -38,7 +38,9 @@
 #include "rsa.h"
 #include "rsa-internal.h"
 
+#include "gmp-glue.h"
 #include "pkcs1.h"
+#include "pkcs1-internal.h"
 
 int
 rsa_encrypt(const struct rsa_public_key *key,
@@ -56,3 +58,42 @@ rsa_encrypt(const struct rsa_public_key *key,
   else
     return 0;
 }
+
+/* The message is less than n, since the most significant octet of
+   the encoding is zero. */
+int
+rsa_encrypt_scratch(const struct rsa_public_key *key,
+		    const struct rsa_public_precomp *pre,
+		    /* For padding */
+		    void *random_ctx, nettle_random_func *random,
+		    size_t length, const uint8_t *cleartext,
+		    uint8_t *ciphertext,
+		    mp_limb_t *scratch)
+{
+  struct rsa_mont mont;
+  uint8_t *em = (uint8_t *) scratch;
+  mp_size_t nn;
+
+  if (!_pkcs1_encrypt_octets (key->size, random_ctx, random,
+			      length, cleartext, em + 1))
+    return 0;
+  em[0] = 0;
+
+  _rsa_mont_public (&mont, key, pre);
+  nn = mont.size;
+
+#define xp (scratch + _RSA_OCTETS_ITCH (key->size))
+#define yp (xp + nn)
+#define scratch_out (yp + nn)
+
+  mpn_set_base256 (xp, nn, em, key->size);
+  _rsa_mont_to (&mont, yp, xp, nn, scratch_out);
+  _rsa_mont_powm_e (&mont, pre, xp, yp, scratch_out);
+  _rsa_mont_from (&mont, xp, xp, scratch_out);
+  mpn_get_base256 (ciphertext, key->size, xp, nn);
+
+  return 1;
+#undef xp
+#undef yp
+#undef scratch_out
+}
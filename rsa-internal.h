@@ -35,15 +35,54 @@
 #define NETTLE_RSA_INTERNAL_H_INCLUDED
 
 #include "rsa.h"
+#include "mont52-internal.h"
 
 #define _rsa_verify _nettle_rsa_verify
 #define _rsa_verify_recover _nettle_rsa_verify_recover
+#define _rsa_verify_recover_octets_itch _nettle_rsa_verify_recover_octets_itch
+#define _rsa_verify_recover_octets _nettle_rsa_verify_recover_octets
+#define _rsa_verify_octets _nettle_rsa_verify_octets
 #define _rsa_check_size _nettle_rsa_check_size
 #define _rsa_blind _nettle_rsa_blind
 #define _rsa_unblind _nettle_rsa_unblind
 #define _rsa_sec_compute_root_itch _nettle_rsa_sec_compute_root_itch
 #define _rsa_sec_compute_root _nettle_rsa_sec_compute_root
 #define _rsa_sec_compute_root_tr _nettle_rsa_sec_compute_root_tr
+#define _rsa_verify_precomp _nettle_rsa_verify_precomp
+#define _rsa_sec_compute_root_precomp_itch _nettle_rsa_sec_compute_root_precomp_itch
+#define _rsa_sec_compute_root_precomp _nettle_rsa_sec_compute_root_precomp
+#define _rsa_sec_compute_root_tr_precomp_itch _nettle_rsa_sec_compute_root_tr_precomp_itch
+#define _rsa_sec_compute_root_tr_precomp _nettle_rsa_sec_compute_root_tr_precomp
+#define _rsa_compute_root_precomp _nettle_rsa_compute_root_precomp
+#define _rsa_sec_crt_precomp_itch _nettle_rsa_sec_crt_precomp_itch
+#define _rsa_sec_crt_precomp _nettle_rsa_sec_crt_precomp
+#define _rsa_sec_blind_precomp_itch _nettle_rsa_sec_blind_precomp_itch
+#define _rsa_sec_blind_precomp _nettle_rsa_sec_blind_precomp
+#define _rsa_sec_unblind_precomp_itch _nettle_rsa_sec_unblind_precomp_itch
+#define _rsa_sec_unblind_precomp _nettle_rsa_sec_unblind_precomp
+#define _rsa_mb_key_init _nettle_rsa_mb_key_init
+#define _rsa_mb_sec_compute_root_itch _nettle_rsa_mb_sec_compute_root_itch
+#define _rsa_mb_sec_compute_root _nettle_rsa_mb_sec_compute_root
+#define _rsa_multi_sec_compute_root_itch _nettle_rsa_multi_sec_compute_root_itch
+#define _rsa_multi_sec_compute_root _nettle_rsa_multi_sec_compute_root
+#define _rsa_multi_sec_compute_root_tr _nettle_rsa_multi_sec_compute_root_tr
+#define _rsa_mont_minv _nettle_rsa_mont_minv
+#define _rsa_mont_r2 _nettle_rsa_mont_r2
+#define _rsa_mont_public _nettle_rsa_mont_public
+#define _rsa_mont_itch _nettle_rsa_mont_itch
+#define _rsa_mont_mul _nettle_rsa_mont_mul
+#define _rsa_mont_mul_public _nettle_rsa_mont_mul_public
+#define _rsa_mont_sqr _nettle_rsa_mont_sqr
+#define _rsa_mont_redc _nettle_rsa_mont_redc
+#define _rsa_mont_to_itch _nettle_rsa_mont_to_itch
+#define _rsa_mont_to _nettle_rsa_mont_to
+#define _rsa_mont_from _nettle_rsa_mont_from
+#define _rsa_mont_powm_window _nettle_rsa_mont_powm_window
+#define _rsa_mont_powm_itch _nettle_rsa_mont_powm_itch
+#define _rsa_mont_powm _nettle_rsa_mont_powm
+#define _rsa_mont_powm_e_itch _nettle_rsa_mont_powm_e_itch
+#define _rsa_mont_powm_e _nettle_rsa_mont_powm_e
+#define _rsa_mont_powm_e_public _nettle_rsa_mont_powm_e_public
 
 /* Internal functions. */
 int
@@ -51,11 +90,41 @@ _rsa_verify(const struct rsa_public_key *key,
 	    const mpz_t m,
 	    const mpz_t s);
 
+int
+_rsa_verify_precomp(const struct rsa_public_key *key,
+		    const struct rsa_public_precomp *pre,
+		    const mpz_t m,
+		    const mpz_t s);
+
 int
 _rsa_verify_recover(const struct rsa_public_key *key,
 		    mpz_t m,
 		    const mpz_t s);
 
+/* Computes m = s^e mod n, size limbs, for a signature s of key->size
+   octets, big-endian, using the precomputed parameters. Returns 0 if
+   s is zero or not less than n. */
+mp_size_t
+_rsa_verify_recover_octets_itch(const struct rsa_public_key *key,
+				const struct rsa_public_precomp *pre);
+int
+_rsa_verify_recover_octets(const struct rsa_public_key *key,
+			   const struct rsa_public_precomp *pre,
+			   mp_limb_t *mp, const uint8_t *s,
+			   mp_limb_t *scratch);
+
+/* The rsa_public_itch scratch area starts with room for 2 key->size
+   octets, used for encoded messages. */
+#define _RSA_OCTETS_ITCH(size) NETTLE_OCTET_SIZE_TO_LIMB_SIZE (2*(size))
+
+/* Checks the signature s, key->size octets, against the expected
+   encoding, which the caller stores as the first key->size octets of
+   the rsa_public_itch scratch area. */
+int
+_rsa_verify_octets(const struct rsa_public_key *key,
+		   const struct rsa_public_precomp *pre,
+		   const uint8_t *s, mp_limb_t *scratch);
+
 size_t
 _rsa_check_size(mpz_t n);
 
@@ -85,4 +154,234 @@ _rsa_sec_compute_root_tr(const struct rsa_public_key *pub,
 			 void *random_ctx, nettle_random_func *random,
 			 mp_limb_t *x, const mp_limb_t *m, size_t mn);
 
+/* Variants using precomputed Montgomery parameters. */
+mp_size_t
+_rsa_sec_compute_root_precomp_itch(const struct rsa_private_key *key);
+void
+_rsa_sec_compute_root_precomp(const struct rsa_private_key *key,
+			      const struct rsa_private_precomp *pre,
+			      void *executor_ctx, rsa_executor_func *executor,
+			      mp_limb_t *rp, const mp_limb_t *mp,
+			      mp_limb_t *scratch);
+
+mp_size_t
+_rsa_sec_compute_root_tr_precomp_itch(const struct rsa_public_key *pub,
+				      const struct rsa_private_key *key,
+				      const struct rsa_private_precomp *pre);
+int
+_rsa_sec_compute_root_tr_precomp(const struct rsa_public_key *pub,
+				 const struct rsa_private_key *key,
+				 const struct rsa_private_precomp *pre,
+				 struct rsa_blinding *blinding,
+				 void *executor_ctx, rsa_executor_func *executor,
+				 void *random_ctx, nettle_random_func *random,
+				 mp_limb_t *x, const mp_limb_t *m, size_t mn,
+				 mp_limb_t *scratch);
+
+/* For mini-gmp builds, where the functions above are unavailable.
+   Like rsa_compute_root, but using R^2 mod p and mod q from pre. */
+void
+_rsa_compute_root_precomp(const struct rsa_private_key *key,
+			  const struct rsa_private_precomp *pre,
+			  mpz_t x, const mpz_t m);
+
+/* The CRT step of _rsa_sec_compute_root_precomp. Sets r from r_mod_p
+   and r_mod_q, the roots mod p and mod q, and clobbers r_mod_p. */
+mp_size_t
+_rsa_sec_crt_precomp_itch(const struct rsa_private_key *key);
+void
+_rsa_sec_crt_precomp(const struct rsa_private_key *key,
+		     const struct rsa_private_precomp *pre,
+		     mp_limb_t *rp, mp_limb_t *r_mod_p, const mp_limb_t *r_mod_q,
+		     mp_limb_t *scratch);
+
+/* The steps of _rsa_sec_compute_root_tr_precomp before and after the
+   root computation. _rsa_sec_blind_precomp sets c = m r^e mod n, and
+   vf = 1/r in Montgomery representation, taking the blinding pair
+   from blinding if non-NULL. _rsa_sec_unblind_precomp checks that x^e
+   = c, and sets x = x/r mod n. Returns 1 on success, on failure x is
+   set to zero. */
+mp_size_t
+_rsa_sec_blind_precomp_itch(const struct rsa_public_key *pub,
+			    const struct rsa_private_precomp *pre);
+void
+_rsa_sec_blind_precomp(const struct rsa_public_key *pub,
+		       const struct rsa_private_precomp *pre,
+		       struct rsa_blinding *blinding,
+		       void *random_ctx, nettle_random_func *random,
+		       mp_limb_t *c, mp_limb_t *vf,
+		       const mp_limb_t *m, size_t mn,
+		       mp_limb_t *scratch);
+
+mp_size_t
+_rsa_sec_unblind_precomp_itch(const struct rsa_public_key *pub,
+			      const struct rsa_private_precomp *pre);
+int
+_rsa_sec_unblind_precomp(const struct rsa_public_key *pub,
+			 const struct rsa_private_precomp *pre,
+			 mp_limb_t *x, const mp_limb_t *c, const mp_limb_t *vf,
+			 mp_limb_t *scratch);
+
+/* Multi-buffer root computation, using _mont52_mul, for RSA_MB_COUNT
+   messages at a time, with the exponentiations mod p and mod q in
+   separate lanes. Uses a fixed window exponentiation, with window size
+   RSA_MB_WINDOW. */
+#define RSA_MB_COUNT (MONT52_LANES / 2)
+#define RSA_MB_WINDOW 5
+#define RSA_MB_EXP_LIMBS \
+  ((MONT52_MAX_SIZE * MONT52_DIGIT_BITS + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS)
+
+/* Per-key constants, with p in the even lanes and q in the odd
+   lanes. */
+struct rsa_mb_key
+{
+  /* Number of digits, and number of exponent bits. */
+  size_t size;
+  unsigned bits;
+  uint64_t minv[MONT52_LANES];
+  uint64_t m[MONT52_MAX_SIZE * MONT52_LANES];
+  /* 2^(2 MONT52_DIGIT_BITS size) mod m */
+  uint64_t r2[MONT52_MAX_SIZE * MONT52_LANES];
+  /* The exponents a and b, zero padded. */
+  mp_limb_t e[2][RSA_MB_EXP_LIMBS];
+};
+
+/* Returns zero if the key size is not supported, which is also the
+   case when limbs are not 64 bits. */
+mp_size_t
+_rsa_mb_sec_compute_root_itch(const struct rsa_private_key *key);
+
+void
+_rsa_mb_key_init(struct rsa_mb_key *mb, const struct rsa_private_key *key);
+
+/* Computes the roots of count <= RSA_MB_COUNT inputs, each of the
+   limb size of n, stored consecutively at mp, like
+   _rsa_sec_compute_root_precomp. The outputs, stored in the same way
+   at rp, must not overlap the inputs. */
+void
+_rsa_mb_sec_compute_root(const struct rsa_mb_key *mb,
+			 const struct rsa_private_key *key,
+			 const struct rsa_private_precomp *pre,
+			 size_t count, mp_limb_t *rp, const mp_limb_t *mp,
+			 mp_limb_t *scratch);
+
+/* Multi-prime variants, with Garner's recombination. */
+mp_size_t
+_rsa_multi_sec_compute_root_itch(const struct rsa_multi_private_key *key);
+void
+_rsa_multi_sec_compute_root(const struct rsa_multi_private_key *key,
+			    mp_limb_t *rp, const mp_limb_t *mp,
+			    mp_limb_t *scratch);
+
+int
+_rsa_multi_sec_compute_root_tr(const struct rsa_public_key *pub,
+			       const struct rsa_multi_private_key *key,
+			       void *random_ctx, nettle_random_func *random,
+			       mp_limb_t *x, const mp_limb_t *m, size_t mn);
+
+/* Montgomery arithmetic modulo an odd m, with R = 2^(size
+   GMP_NUMB_BITS). All functions are side-channel silent, except that
+   _rsa_mont_powm_e depends on the (public) exponent. */
+struct rsa_mont
+{
+  mp_size_t size;
+  const mp_limb_t *m;
+  /* -1/m mod 2^GMP_NUMB_BITS */
+  mp_limb_t minv;
+  /* R^2 mod m */
+  const mp_limb_t *r2;
+};
+
+mp_limb_t
+_rsa_mont_minv (mp_limb_t m0);
+
+/* Sets rp to R^2 mod m, for an odd m. Needs _rsa_mont_itch (mn)
+   limbs of scratch. */
+void
+_rsa_mont_r2 (mp_limb_t *rp, const mp_limb_t *mp, mp_size_t mn,
+	      mp_limb_t *scratch);
+
+void
+_rsa_mont_public (struct rsa_mont *m,
+		  const struct rsa_public_key *key,
+		  const struct rsa_public_precomp *pre);
+
+/* Scratch needed by _rsa_mont_mul and _rsa_mont_sqr. */
+mp_size_t
+_rsa_mont_itch (mp_size_t n);
+
+/* Sets r = a b / R mod m. Inputs must be < R, with a b < m R. Output
+   is canonically reduced, and may overlap the inputs. */
+void
+_rsa_mont_mul (const struct rsa_mont *m, mp_limb_t *rp,
+	       const mp_limb_t *ap, const mp_limb_t *bp,
+	       mp_limb_t *scratch);
+void
+_rsa_mont_sqr (const struct rsa_mont *m, mp_limb_t *rp,
+	       const mp_limb_t *ap, mp_limb_t *scratch);
+
+/* Like _rsa_mont_mul, but faster, with timing depending on the
+   inputs. For public values only. */
+void
+_rsa_mont_mul_public (const struct rsa_mont *m, mp_limb_t *rp,
+		      const mp_limb_t *ap, const mp_limb_t *bp,
+		      mp_limb_t *scratch);
+
+/* Sets r = t / R mod m, for t < m R of 2 size limbs. Clobbers t. */
+void
+_rsa_mont_redc (const struct rsa_mont *m, mp_limb_t *rp, mp_limb_t *tp);
+
+/* Converts a of an limbs, of any size, to Montgomery representation,
+   r = a R mod m. */
+mp_size_t
+_rsa_mont_to_itch (mp_size_t n);
+void
+_rsa_mont_to (const struct rsa_mont *m, mp_limb_t *rp,
+	      const mp_limb_t *ap, mp_size_t an, mp_limb_t *scratch);
+
+/* Converts back, r = a / R mod m. Uses _rsa_mont_itch scratch. */
+void
+_rsa_mont_from (const struct rsa_mont *m, mp_limb_t *rp,
+		const mp_limb_t *ap, mp_limb_t *scratch);
+
+#define RSA_POWM_MAX_WINDOW 7
+
+/* Window size for _rsa_mont_powm, minimizing the estimated cost for
+   an exponent of ebits bits and a modulus of n limbs. */
+unsigned
+_rsa_mont_powm_window (mp_bitcnt_t ebits, mp_size_t n);
+
+/* Sets r = a^e, for a secret exponent e of ebits bits, using a fixed
+   window exponentiation with window size w, and sec_tabselect for the
+   table lookups. Both input and output in Montgomery representation.
+   Side-channel silent, with timing depending only on the sizes and w.
+   The output may overlap the input. */
+mp_size_t
+_rsa_mont_powm_itch (mp_size_t n, unsigned w);
+void
+_rsa_mont_powm (const struct rsa_mont *m, unsigned w,
+		mp_limb_t *rp, const mp_limb_t *ap,
+		const mp_limb_t *ep, mp_bitcnt_t ebits,
+		mp_limb_t *scratch);
+
+/* Sets r = a^e, using the recoded public exponent. Both input and
+   output in Montgomery representation. Timing depends on e only. */
+mp_size_t
+_rsa_mont_powm_e_itch (const struct rsa_mont *m,
+		       const struct rsa_public_precomp *pre);
+void
+_rsa_mont_powm_e (const struct rsa_mont *m,
+		  const struct rsa_public_precomp *pre,
+		  mp_limb_t *rp, const mp_limb_t *ap,
+		  mp_limb_t *scratch);
+
+/* Like _rsa_mont_powm_e, with the same scratch requirements, but for
+   public a only, e.g., a signature to be verified. Faster, but timing
+   depends on a. */
+void
+_rsa_mont_powm_e_public (const struct rsa_mont *m,
+			 const struct rsa_public_precomp *pre,
+			 mp_limb_t *rp, const mp_limb_t *ap,
+			 mp_limb_t *scratch);
+
 #endif /* NETTLE_RSA_INTERNAL_H_INCLUDED */
@@ -52,12 +52,14 @@
 
 
 int
-rsa_generate_keypair(struct rsa_public_key *pub,
-		     struct rsa_private_key *key,
-		     void *random_ctx, nettle_random_func *random,
-		     void *progress_ctx, nettle_progress_func *progress,
-		     unsigned n_size,
-		     unsigned e_size)
+rsa_generate_keypair_parallel(struct rsa_public_key *pub,
+			      struct rsa_private_key *key,
+			      void *random_ctx, nettle_random_func *random,
+			      void *progress_ctx, nettle_progress_func *progress,
+			      void *executor_ctx, rsa_executor_func *executor,
+			      unsigned width,
+			      unsigned n_size,
+			      unsigned e_size)
 {
   mpz_t p1;
   mpz_t q1;
@@ -98,9 +100,10 @@ rsa_generate_keypair(struct rsa_public_key *pub,
       /* Generate p, such that gcd(p-1, e) = 1 */
       for (;;)
 	{
-	  nettle_random_prime(key->p, (n_size+1)/2, 1,
-			      random_ctx, random,
-			      progress_ctx, progress);
+	  nettle_random_prime_parallel(key->p, (n_size+1)/2, 1,
+				       random_ctx, random,
+				       progress_ctx, progress,
+				       executor_ctx, executor, width);
 
 	  mpz_sub_ui(p1, key->p, 1);
       
@@ -122,9 +125,10 @@ rsa_generate_keypair(struct rsa_public_key *pub,
       /* Generate q, such that gcd(q-1, e) = 1 */
       for (;;)
 	{
-	  nettle_random_prime(key->q, n_size/2, 1,
-			      random_ctx, random,
-			      progress_ctx, progress);
+	  nettle_random_prime_parallel(key->q, n_size/2, 1,
+				       random_ctx, random,
+				       progress_ctx, progress,
+				       executor_ctx, executor, width);
 
 	  mpz_sub_ui(q1, key->q, 1);
       
@@ -207,3 +211,16 @@ rsa_generate_keypair(struct rsa_public_key *pub,
 
   return 1;
 }
+
+int
+rsa_generate_keypair(struct rsa_public_key *pub,
+		     struct rsa_private_key *key,
+		     void *random_ctx, nettle_random_func *random,
+		     void *progress_ctx, nettle_progress_func *progress,
+		     unsigned n_size,
+		     unsigned e_size)
+{
+  return rsa_generate_keypair_parallel (pub, key, random_ctx, random,
+					progress_ctx, progress,
+					NULL, NULL, 1, n_size, e_size);
+}
@@ -0,0 +1,442 @@
+/* rsa-mont.c
+
+   Montgomery arithmetic for RSA, using per-key precomputed parameters.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "rsa.h"
+#include "rsa-internal.h"
+#include "ecc-internal.h"
+#include "gmp-glue.h"
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* The products must not have any data dependent timing. mini-gmp's
+   schoolbook multiplication has none, while gmp's mpn_mul_n may use
+   algorithms with sign-dependent branches. */
+#if NETTLE_USE_MINI_GMP
+#define MUL_ITCH(n) (2*(n))
+#define sec_mul_n(rp, ap, bp, n, scratch) mpn_mul_n ((rp), (ap), (bp), (n))
+
+/* mini-gmp's mpn_sqr is a plain multiplication. Computing each of the
+   off-diagonal products only once makes squaring, which dominates the
+   exponentiations, close to twice as fast. Uses 2n limbs of scratch
+   for the diagonal terms. */
+static void
+sec_sqr (mp_limb_t *rp, const mp_limb_t *ap, mp_size_t n, mp_limb_t *tp)
+{
+  mp_size_t i;
+
+  mpn_zero (rp, 2*n);
+  for (i = 0; i + 1 < n; i++)
+    rp[n + i] = mpn_addmul_1 (rp + 2*i + 1, ap + i + 1, n - i - 1, ap[i]);
+
+  /* The sum of the off-diagonal products is less than B^(2n) / 2. */
+  mpn_lshift (rp, rp, 2*n, 1);
+
+  for (i = 0; i < n; i++)
+    tp[2*i + 1] = mpn_mul_1 (tp + 2*i, ap + i, 1, ap[i]);
+  mpn_add_n (rp, rp, tp, 2*n);
+}
+#else
+#define MUL_ITCH(n) MAX (mpn_sec_mul_itch ((n), (n)), mpn_sec_sqr_itch (n))
+#define sec_mul_n(rp, ap, bp, n, scratch) \
+  mpn_sec_mul ((rp), (ap), (n), (bp), (n), (scratch))
+#define sec_sqr(rp, ap, n, scratch) mpn_sec_sqr ((rp), (ap), (n), (scratch))
+#endif
+
+mp_limb_t
+_rsa_mont_minv (mp_limb_t m0)
+{
+  mp_limb_t inv;
+  unsigned i;
+
+  assert (m0 & 1);
+  /* Correct to 3 bits, and each Newton iteration doubles the number
+     of correct bits. */
+  for (i = 3, inv = m0; i < GMP_NUMB_BITS; i *= 2)
+    inv *= 2 - m0 * inv;
+
+  return -inv;
+}
+
+/* Sets r = 2 r mod m, for r < m */
+static void
+mont_dbl (mp_limb_t *rp, const mp_limb_t *mp, mp_size_t n,
+	  mp_limb_t *tp)
+{
+  mp_limb_t cy, borrow;
+  cy = mpn_lshift (rp, rp, n, 1);
+  borrow = mpn_sub_n (tp, rp, mp, n);
+  cnd_copy (cy | (borrow ^ 1), rp, tp, n);
+}
+
+/* Sets r = a + b mod m, for a, b < m */
+static void
+mont_add (const struct rsa_mont *m, mp_limb_t *rp,
+	  const mp_limb_t *ap, const mp_limb_t *bp, mp_limb_t *tp)
+{
+  mp_limb_t cy, borrow;
+  cy = mpn_add_n (rp, ap, bp, m->size);
+  borrow = mpn_sub_n (tp, rp, m->m, m->size);
+  cnd_copy (cy | (borrow ^ 1), rp, tp, m->size);
+}
+
+/* Starts from 2^((mn - 1) GMP_NUMB_BITS) < m, and gets R mod m, the
+   representation of 1, by GMP_NUMB_BITS doublings. Then 2^k R mod m,
+   the representation of 2^k, is computed for k = mn GMP_NUMB_BITS
+   by left-to-right binary exponentiation, with a Montgomery squaring
+   for each bit and a doubling for each one bit. Only the size
+   affects control flow. */
+void
+_rsa_mont_r2 (mp_limb_t *rp, const mp_limb_t *mp, mp_size_t mn,
+	      mp_limb_t *scratch)
+{
+  struct rsa_mont m;
+  mp_bitcnt_t k = (mp_bitcnt_t) mn * GMP_NUMB_BITS;
+  unsigned i;
+
+  assert (mn > 0);
+  assert (mp[mn-1] > 0);
+  assert (mp[0] & 1);
+
+  m.size = mn;
+  m.m = mp;
+  m.minv = _rsa_mont_minv (mp[0]);
+  m.r2 = NULL;
+
+  mpn_zero (rp, mn);
+  rp[mn-1] = 1;
+
+  for (i = 0; i < GMP_NUMB_BITS; i++)
+    mont_dbl (rp, mp, mn, scratch);
+
+  for (i = GMP_NUMB_BITS; i-- > 0; )
+    if (k >> i)
+      {
+	_rsa_mont_sqr (&m, rp, rp, scratch);
+	if ((k >> i) & 1)
+	  mont_dbl (rp, mp, mn, scratch);
+      }
+}
+
+void
+_rsa_mont_public (struct rsa_mont *m,
+		  const struct rsa_public_key *key,
+		  const struct rsa_public_precomp *pre)
+{
+  assert (mpz_size (key->n) == (size_t) pre->size);
+
+  m->size = pre->size;
+  m->m = mpz_limbs_read (key->n);
+  m->minv = pre->ninv;
+  m->r2 = pre->r2;
+}
+
+mp_size_t
+_rsa_mont_itch (mp_size_t n)
+{
+  return 2*n + MUL_ITCH (n);
+}
+
+void
+_rsa_mont_redc (const struct rsa_mont *m, mp_limb_t *rp, mp_limb_t *tp)
+{
+  mp_size_t n = m->size;
+  mp_size_t i;
+  mp_limb_t cy, borrow;
+
+  for (i = 0; i < n; i++)
+    tp[i] = mpn_addmul_1 (tp + i, m->m, n, tp[i] * m->minv);
+
+  /* Result is < 2m, and at most one subtraction is needed. */
+  cy = mpn_add_n (rp, tp + n, tp, n);
+  borrow = mpn_sub_n (tp, rp, m->m, n);
+  cnd_copy (cy | (borrow ^ 1), rp, tp, n);
+}
+
+void
+_rsa_mont_mul (const struct rsa_mont *m, mp_limb_t *rp,
+	       const mp_limb_t *ap, const mp_limb_t *bp,
+	       mp_limb_t *scratch)
+{
+  sec_mul_n (scratch, ap, bp, m->size, scratch + 2*m->size);
+  _rsa_mont_redc (m, rp, scratch);
+}
+
+void
+_rsa_mont_sqr (const struct rsa_mont *m, mp_limb_t *rp,
+	       const mp_limb_t *ap, mp_limb_t *scratch)
+{
+  sec_sqr (scratch, ap, m->size, scratch + 2*m->size);
+  _rsa_mont_redc (m, rp, scratch);
+}
+
+mp_size_t
+_rsa_mont_to_itch (mp_size_t n)
+{
+  return 2*n + _rsa_mont_itch (n);
+}
+
+/* Processes one chunk of size limbs at a time, most significant
+   first. With a = a_1 R + a_0, we get a R = (a_1 R) R + a_0 R, where
+   both terms are computed by a Montgomery multiplication by R^2. */
+void
+_rsa_mont_to (const struct rsa_mont *m, mp_limb_t *rp,
+	      const mp_limb_t *ap, mp_size_t an, mp_limb_t *scratch)
+{
+  mp_size_t n = m->size;
+  mp_size_t k;
+#define tp scratch
+#define up (scratch + n)
+#define scratch_out (scratch + 2*n)
+
+  assert (an > 0);
+  k = (an - 1) / n;
+
+  mpn_copyi (tp, ap + k*n, an - k*n);
+  mpn_zero (tp + an - k*n, (k+1)*n - an);
+  _rsa_mont_mul (m, rp, tp, m->r2, scratch_out);
+
+  while (k-- > 0)
+    {
+      _rsa_mont_mul (m, rp, rp, m->r2, scratch_out);
+      _rsa_mont_mul (m, up, ap + k*n, m->r2, scratch_out);
+      mont_add (m, rp, rp, up, tp);
+    }
+#undef tp
+#undef up
+#undef scratch_out
+}
+
+void
+_rsa_mont_from (const struct rsa_mont *m, mp_limb_t *rp,
+		const mp_limb_t *ap, mp_limb_t *scratch)
+{
+  mpn_copyi (scratch, ap, m->size);
+  mpn_zero (scratch + m->size, m->size);
+  _rsa_mont_redc (m, rp, scratch);
+}
+
+/* Estimated cost of a fixed window exponentiation, in units of limb
+   products. Each Montgomery multiplication or squaring costs about 2
+   n^2, and the table lookup for each digit reads all of the 2^w n
+   table limbs, with a masked addition per limb, counted as an eighth
+   of a limb product. Checked with hogweed-benchmark --sweep. */
+static unsigned long
+powm_cost (mp_bitcnt_t ebits, mp_size_t n, unsigned w)
+{
+  unsigned long digits = (ebits + w - 1) / w;
+  unsigned long mul = 2 * (unsigned long) n * n;
+
+  return (ebits + (1UL << w) - 2 + digits) * mul
+    + digits * (((unsigned long) n << w) / 8);
+}
+
+unsigned
+_rsa_mont_powm_window (mp_bitcnt_t ebits, mp_size_t n)
+{
+  unsigned best_w = 1;
+  unsigned long best_cost = powm_cost (ebits, n, 1);
+  unsigned w;
+
+  for (w = 2; w <= RSA_POWM_MAX_WINDOW; w++)
+    {
+      unsigned long cost = powm_cost (ebits, n, w);
+      if (cost < best_cost)
+	{
+	  best_cost = cost;
+	  best_w = w;
+	}
+    }
+  return best_w;
+}
+
+mp_size_t
+_rsa_mont_powm_itch (mp_size_t n, unsigned w)
+{
+  return (((mp_size_t) 1 << w) + 1) * n + _rsa_mont_itch (n);
+}
+
+/* Digit of w bits, starting at bit position pos. Only the bit
+   positions, not the exponent, affect control flow and memory
+   accesses. */
+static unsigned
+powm_digit (const mp_limb_t *ep, mp_size_t en, mp_bitcnt_t pos, unsigned w)
+{
+  mp_size_t i = pos / GMP_NUMB_BITS;
+  unsigned shift = pos % GMP_NUMB_BITS;
+  mp_limb_t d = ep[i] >> shift;
+
+  if (shift + w > GMP_NUMB_BITS && i + 1 < en)
+    d |= ep[i+1] << (GMP_NUMB_BITS - shift);
+
+  return d & ((1U << w) - 1);
+}
+
+/* Table holds a^0, a^1, ..., a^(2^w - 1), and every digit, including
+   zero digits, gives a full table scan and a multiplication. */
+void
+_rsa_mont_powm (const struct rsa_mont *m, unsigned w,
+		mp_limb_t *rp, const mp_limb_t *ap,
+		const mp_limb_t *ep, mp_bitcnt_t ebits,
+		mp_limb_t *scratch)
+{
+  mp_size_t n = m->size;
+  mp_size_t en = (ebits + GMP_NUMB_BITS - 1) / GMP_NUMB_BITS;
+  unsigned tn = 1U << w;
+  mp_limb_t *table = scratch;
+  mp_limb_t *tp = scratch + tn * n;
+  mp_limb_t *scratch_out = tp + n;
+  mp_bitcnt_t pos;
+  unsigned j;
+
+  assert (w >= 1 && w <= RSA_POWM_MAX_WINDOW);
+  assert (ebits > 0);
+
+#define TABLE(d) (table + (d) * n)
+  /* R mod m, the representation of 1. */
+  _rsa_mont_from (m, TABLE(0), m->r2, scratch_out);
+  mpn_copyi (TABLE(1), ap, n);
+  for (j = 2; j < tn; j++)
+    _rsa_mont_mul (m, TABLE(j), TABLE(j-1), ap, scratch_out);
+#undef TABLE
+
+  pos = ((ebits - 1) / w) * w;
+  sec_tabselect (rp, n, table, tn, powm_digit (ep, en, pos, w));
+
+  while (pos > 0)
+    {
+      pos -= w;
+      for (j = 0; j < w; j++)
+	_rsa_mont_sqr (m, rp, rp, scratch_out);
+      sec_tabselect (tp, n, table, tn, powm_digit (ep, en, pos, w));
+      _rsa_mont_mul (m, rp, rp, tp, scratch_out);
+    }
+}
+
+mp_size_t
+_rsa_mont_powm_e_itch (const struct rsa_mont *m,
+		       const struct rsa_public_precomp *pre)
+{
+  return (((mp_size_t) 1 << pre->ewindow) - 1) * m->size
+    + _rsa_mont_itch (m->size);
+}
+
+void
+_rsa_mont_mul_public (const struct rsa_mont *m, mp_limb_t *rp,
+		      const mp_limb_t *ap, const mp_limb_t *bp,
+		      mp_limb_t *scratch)
+{
+  mpn_mul_n (scratch, ap, bp, m->size);
+  _rsa_mont_redc (m, rp, scratch);
+}
+
+/* Like _rsa_mont_sqr, but with the faster, not side-channel silent,
+   squaring. */
+static void
+mont_sqr_public (const struct rsa_mont *m, mp_limb_t *rp,
+		 const mp_limb_t *ap, mp_limb_t *scratch)
+{
+  mpn_sqr (scratch, ap, m->size);
+  _rsa_mont_redc (m, rp, scratch);
+}
+
+/* Table holds a^1, a^2, ..., a^(2^w - 1). Zero digits are skipped,
+   which leaks nothing but the public exponent. */
+static void
+mont_powm_e (const struct rsa_mont *m,
+	     const struct rsa_public_precomp *pre,
+	     mp_limb_t *rp, const mp_limb_t *ap,
+	     mp_limb_t *scratch, int public_input)
+{
+  mp_size_t n = m->size;
+  unsigned w = pre->ewindow;
+  unsigned tn = (1U << w) - 1;
+  mp_limb_t *table = scratch;
+  mp_limb_t *scratch_out = scratch + tn * n;
+  unsigned i, j;
+
+#define TABLE(d) (table + ((d) - 1) * n)
+#define MUL(r, a, b) do {					\
+    if (public_input)						\
+      _rsa_mont_mul_public (m, (r), (a), (b), scratch_out);	\
+    else							\
+      _rsa_mont_mul (m, (r), (a), (b), scratch_out);		\
+  } while (0)
+#define SQR(r, a) do {						\
+    if (public_input)						\
+      mont_sqr_public (m, (r), (a), scratch_out);		\
+    else							\
+      _rsa_mont_sqr (m, (r), (a), scratch_out);			\
+  } while (0)
+
+  mpn_copyi (TABLE(1), ap, n);
+  for (j = 2; j <= tn; j++)
+    MUL (TABLE(j), TABLE(j-1), ap);
+
+  assert (pre->edigits > 0);
+  assert (pre->ep[0] > 0);
+
+  mpn_copyi (rp, TABLE(pre->ep[0]), n);
+  for (i = 1; i < pre->edigits; i++)
+    {
+      unsigned d = pre->ep[i];
+      for (j = 0; j < w; j++)
+	SQR (rp, rp);
+      if (d > 0)
+	MUL (rp, rp, TABLE(d));
+    }
+#undef TABLE
+#undef MUL
+#undef SQR
+}
+
+void
+_rsa_mont_powm_e (const struct rsa_mont *m,
+		  const struct rsa_public_precomp *pre,
+		  mp_limb_t *rp, const mp_limb_t *ap,
+		  mp_limb_t *scratch)
+{
+  mont_powm_e (m, pre, rp, ap, scratch, 0);
+}
+
+void
+_rsa_mont_powm_e_public (const struct rsa_mont *m,
+			 const struct rsa_public_precomp *pre,
+			 mp_limb_t *rp, const mp_limb_t *ap,
+			 mp_limb_t *scratch)
+{
+  mont_powm_e (m, pre, rp, ap, scratch, 1);
+}
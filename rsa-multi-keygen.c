@@ -0,0 +1,251 @@
+/* rsa-multi-keygen.c
+
+   Generation of multi-prime RSA keys.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "rsa.h"
+#include "rsa-internal.h"
+#include "bignum.h"
+
+/* Smallest prime size accepted, in bits. */
+#define RSA_MULTI_MINIMUM_PRIME_BITS 32
+
+/* Generates a prime r distinct from the first k primes, and such
+   that gcd(r-1, e) = 1 if e is given. */
+static void
+rsa_multi_random_prime(mpz_t r, unsigned bits, int top_bits_set,
+		       mpz_ptr *primes, unsigned k,
+		       const mpz_t e, unsigned e_size,
+		       void *random_ctx, nettle_random_func *random,
+		       void *progress_ctx, nettle_progress_func *progress)
+{
+  mpz_t tmp;
+  mpz_init(tmp);
+
+  for (;;)
+    {
+      unsigned i;
+
+      nettle_random_prime(r, bits, top_bits_set,
+			  random_ctx, random,
+			  progress_ctx, progress);
+
+      for (i = 0; i < k; i++)
+	if (mpz_cmp(r, primes[i]) == 0)
+	  break;
+
+      if (i == k)
+	{
+	  if (e_size)
+	    break;
+
+	  mpz_sub_ui(tmp, r, 1);
+	  mpz_gcd(tmp, e, tmp);
+	  if (mpz_cmp_ui(tmp, 1) == 0)
+	    break;
+	}
+      if (progress) progress(progress_ctx, 'c');
+    }
+
+  if (progress)
+    progress(progress_ctx, '\n');
+
+  mpz_clear(tmp);
+}
+
+int
+rsa_generate_multi_keypair(struct rsa_public_key *pub,
+			   struct rsa_multi_private_key *key,
+			   void *random_ctx, nettle_random_func *random,
+			   void *progress_ctx, nettle_progress_func *progress,
+			   unsigned n_size,
+			   unsigned e_size,
+			   unsigned nprimes)
+{
+  mpz_ptr primes[RSA_MAX_PRIMES];
+  mpz_t phi;
+  mpz_t prod;
+  mpz_t tmp;
+  unsigned bits_left;
+  unsigned i;
+
+  if (nprimes < 2 || nprimes > RSA_MAX_PRIMES)
+    return 0;
+
+  if (e_size)
+    {
+      /* We should choose e randomly. Is the size reasonable? */
+      if ((e_size < 16) || (e_size >= n_size) )
+	return 0;
+    }
+  else
+    {
+      /* We have a fixed e. Check that it makes sense */
+
+      /* It must be odd */
+      if (!mpz_tstbit(pub->e, 0))
+	return 0;
+
+      /* And 3 or larger */
+      if (mpz_cmp_ui(pub->e, 3) < 0)
+	return 0;
+
+      /* And size less than n */
+      if (mpz_sizeinbase(pub->e, 2) >= n_size)
+	return 0;
+    }
+
+  if (n_size < RSA_MINIMUM_N_BITS
+      || n_size / nprimes < RSA_MULTI_MINIMUM_PRIME_BITS)
+    return 0;
+
+  primes[0] = key->p;
+  primes[1] = key->q;
+  for (i = 2; i < nprimes; i++)
+    primes[i] = key->other[i-2].r;
+
+  mpz_init(phi); mpz_init(prod); mpz_init(tmp);
+
+  /* All but the last prime, with the top two bits set, like for
+     two-prime keys. */
+  mpz_set_ui(prod, 1);
+  for (i = 0, bits_left = n_size; i < nprimes - 1; i++)
+    {
+      unsigned bits = (bits_left + nprimes - i - 1) / (nprimes - i);
+      rsa_multi_random_prime(primes[i], bits, 1, primes, i,
+			     pub->e, e_size,
+			     random_ctx, random, progress_ctx, progress);
+      mpz_mul(prod, prod, primes[i]);
+      bits_left -= bits;
+    }
+
+  /* The product so far, prod = f 2^(k-1), with 1 <= f < 2 and k =
+     size of prod, may be too far from a power of two for a last prime
+     with two top bits set to give the right size. So only the top bit
+     is set, r = g 2^(bits-1), with 1 <= g < 2, and the size of the
+     product depends on f g. We choose bits to make the probability
+     of the desired size at least 40%, and retry until we get it. */
+  bits_left = n_size - mpz_sizeinbase(prod, 2);
+  mpz_mul(tmp, prod, prod);
+  if (mpz_sizeinbase(tmp, 2) < 2*mpz_sizeinbase(prod, 2))
+    /* f < sqrt(2), and f g < 2 gives size k + bits - 1. */
+    bits_left++;
+
+  for (;;)
+    {
+      rsa_multi_random_prime(primes[nprimes - 1], bits_left, 0,
+			     primes, nprimes - 1,
+			     pub->e, e_size,
+			     random_ctx, random, progress_ctx, progress);
+      mpz_mul(pub->n, prod, primes[nprimes - 1]);
+      if (mpz_sizeinbase(pub->n, 2) == n_size)
+	break;
+      if (progress) progress(progress_ctx, 's');
+    }
+
+  mpz_set_ui(phi, 1);
+  for (i = 0; i < nprimes; i++)
+    {
+      mpz_sub_ui(tmp, primes[i], 1);
+      mpz_mul(phi, phi, tmp);
+    }
+
+  /* If we didn't have a given e, generate one now. */
+  if (e_size)
+    {
+      int retried = 0;
+      for (;;)
+	{
+	  nettle_mpz_random_size(pub->e,
+				 random_ctx, random,
+				 e_size);
+
+	  /* Make sure it's odd and that the most significant bit is
+	   * set */
+	  mpz_setbit(pub->e, 0);
+	  mpz_setbit(pub->e, e_size - 1);
+
+	  if (mpz_invert(key->d, pub->e, phi))
+	    break;
+
+	  if (progress) progress(progress_ctx, 'e');
+	  retried = 1;
+	}
+      if (retried && progress)
+	progress(progress_ctx, '\n');
+    }
+  else
+    {
+      /* Must always succeed, as we already know that e
+       * doesn't have any common factor with any r_i - 1. */
+      int res = mpz_invert(key->d, pub->e, phi);
+      assert(res);
+    }
+
+  /* a = d % (p-1), b = d % (q-1) */
+  mpz_sub_ui(tmp, key->p, 1);
+  mpz_fdiv_r(key->a, key->d, tmp);
+  mpz_sub_ui(tmp, key->q, 1);
+  mpz_fdiv_r(key->b, key->d, tmp);
+
+  /* The primes are distinct, so the inverses always exist. */
+  {
+    int res = mpz_invert(key->c, key->q, key->p);
+    assert(res);
+  }
+
+  mpz_mul(prod, key->p, key->q);
+  for (i = 0; i < nprimes - 2; i++)
+    {
+      struct rsa_prime_info *info = &key->other[i];
+      int res;
+
+      mpz_sub_ui(tmp, info->r, 1);
+      mpz_fdiv_r(info->d, key->d, tmp);
+
+      res = mpz_invert(info->t, prod, info->r);
+      assert(res);
+
+      mpz_mul(prod, prod, info->r);
+    }
+  key->count = nprimes - 2;
+
+  pub->size = key->size = (n_size + 7) / 8;
+  assert(pub->size >= RSA_MINIMUM_N_OCTETS);
+
+  mpz_clear(phi); mpz_clear(prod); mpz_clear(tmp);
+
+  return 1;
+}
@@ -0,0 +1,193 @@
+/* rsa-multi.c
+
+   Multi-prime RSA private keys.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "rsa.h"
+#include "rsa-internal.h"
+#include "gmp-glue.h"
+
+void
+rsa_multi_private_key_init(struct rsa_multi_private_key *key)
+{
+  unsigned i;
+
+  mpz_init(key->d);
+  mpz_init(key->p);
+  mpz_init(key->q);
+  mpz_init(key->a);
+  mpz_init(key->b);
+  mpz_init(key->c);
+
+  for (i = 0; i < RSA_MAX_PRIMES - 2; i++)
+    {
+      mpz_init(key->other[i].r);
+      mpz_init(key->other[i].d);
+      mpz_init(key->other[i].t);
+    }
+
+  key->count = 0;
+  key->size = 0;
+}
+
+void
+rsa_multi_private_key_clear(struct rsa_multi_private_key *key)
+{
+  unsigned i;
+
+  mpz_clear(key->d);
+  mpz_clear(key->p);
+  mpz_clear(key->q);
+  mpz_clear(key->a);
+  mpz_clear(key->b);
+  mpz_clear(key->c);
+
+  for (i = 0; i < RSA_MAX_PRIMES - 2; i++)
+    {
+      mpz_clear(key->other[i].r);
+      mpz_clear(key->other[i].d);
+      mpz_clear(key->other[i].t);
+    }
+}
+
+int
+rsa_multi_private_key_prepare(struct rsa_multi_private_key *key)
+{
+  mpz_t n;
+  unsigned i;
+
+  if (key->count > RSA_MAX_PRIMES - 2)
+    return 0;
+
+  /* Exponents and coefficients must be reduced modulo the
+   * corresponding prime, we rely on that in calculations. */
+  if (mpz_cmp(key->a, key->p) >= 0 || mpz_cmp(key->b, key->q) >= 0
+      || mpz_cmp(key->c, key->p) >= 0)
+    return 0;
+
+  for (i = 0; i < key->count; i++)
+    if (mpz_cmp(key->other[i].d, key->other[i].r) >= 0
+	|| mpz_cmp(key->other[i].t, key->other[i].r) >= 0)
+      return 0;
+
+  mpz_init(n);
+  mpz_mul(n, key->p, key->q);
+  for (i = 0; i < key->count; i++)
+    mpz_mul(n, n, key->other[i].r);
+
+  key->size = _rsa_check_size(n);
+
+  mpz_clear(n);
+
+  return (key->size > 0);
+}
+
+#if NETTLE_USE_MINI_GMP
+
+/* With x = m^d known modulo R, extends it to modulo R r. */
+static void
+rsa_multi_garner_step(mpz_t x, mpz_t R, const mpz_t m,
+		      const mpz_t r, const mpz_t e, const mpz_t t)
+{
+  mpz_t h;
+  mpz_init(h);
+
+  /* h = (m^e - x) t % r */
+  mpz_fdiv_r(h, m, r);
+  mpz_powm_sec(h, h, e, r);
+  mpz_sub(h, h, x);
+  mpz_mul(h, h, t);
+  mpz_fdiv_r(h, h, r);
+
+  /* x = x + R h */
+  mpz_addmul(x, R, h);
+  mpz_mul(R, R, r);
+
+  mpz_clear(h);
+}
+
+void
+rsa_multi_compute_root(const struct rsa_multi_private_key *key,
+		       mpz_t x, const mpz_t m)
+{
+  mpz_t y;
+  mpz_t R;
+  unsigned i;
+
+  mpz_init(y);
+  mpz_init_set(R, key->q);
+
+  /* y = m^d % q = (m%q)^b % q */
+  mpz_fdiv_r(y, m, key->q);
+  mpz_powm_sec(y, y, key->b, key->q);
+
+  rsa_multi_garner_step(y, R, m, key->p, key->a, key->c);
+  for (i = 0; i < key->count; i++)
+    rsa_multi_garner_step(y, R, m, key->other[i].r,
+			  key->other[i].d, key->other[i].t);
+
+  mpz_swap(x, y);
+
+  mpz_clear(y);
+  mpz_clear(R);
+}
+
+#else /* !NETTLE_USE_MINI_GMP */
+
+void
+rsa_multi_compute_root(const struct rsa_multi_private_key *key,
+		       mpz_t x, const mpz_t m)
+{
+  TMP_GMP_DECL (scratch, mp_limb_t);
+  TMP_GMP_DECL (ml, mp_limb_t);
+  mp_limb_t *xl;
+  size_t key_size;
+
+  key_size = NETTLE_OCTET_SIZE_TO_LIMB_SIZE(key->size);
+  assert(mpz_size (m) <= key_size);
+
+  TMP_GMP_ALLOC (ml, key_size);
+  mpz_limbs_copy(ml, m, key_size);
+
+  TMP_GMP_ALLOC (scratch, _rsa_multi_sec_compute_root_itch(key));
+
+  xl = mpz_limbs_write (x, key_size);
+  _rsa_multi_sec_compute_root (key, xl, ml, scratch);
+  mpz_limbs_finish (x, key_size);
+
+  TMP_GMP_FREE (ml);
+  TMP_GMP_FREE (scratch);
+}
+#endif /* !NETTLE_USE_MINI_GMP */
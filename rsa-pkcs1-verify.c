@@ -38,6 +38,8 @@
 #include "rsa.h"
 #include "rsa-internal.h"
 
+#include "gmp-glue.h"
+#include "hogweed-internal.h"
 #include "pkcs1.h"
 
 int
@@ -57,3 +59,34 @@ rsa_pkcs1_verify(const struct rsa_public_key *key,
 
   return res;
 }
+
+int
+rsa_pkcs1_verify_precomp(const struct rsa_public_key *key,
+			 const struct rsa_public_precomp *pre,
+			 size_t length, const uint8_t *digest_info,
+			 const mpz_t s)
+{
+  int res;
+  mpz_t m;
+
+  mpz_init (m);
+
+  res = (pkcs1_rsa_digest_encode (m, key->size, length, digest_info)
+	 && _rsa_verify_precomp (key, pre, m, s));
+
+  mpz_clear(m);
+
+  return res;
+}
+
+int
+rsa_pkcs1_verify_scratch(const struct rsa_public_key *key,
+			 const struct rsa_public_precomp *pre,
+			 size_t length, const uint8_t *digest_info,
+			 const uint8_t *signature,
+			 mp_limb_t *scratch)
+{
+  return (_pkcs1_signature_prefix (key->size, (uint8_t *) scratch,
+				   length, digest_info, 0)
+	  && _rsa_verify_octets (key, pre, signature, scratch));
+}
@@ -0,0 +1,186 @@
+/* rsa-precomp.c
+
+   Precomputed per-key values for RSA operations.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "rsa.h"
+#include "rsa-internal.h"
+#include "gmp-glue.h"
+
+#define POWM_E_MAX_WINDOW 6
+
+static void
+public_precomp_zero (struct rsa_public_precomp *pre)
+{
+  pre->size = 0;
+  pre->ninv = 0;
+  pre->r2 = NULL;
+  pre->ewindow = 0;
+  pre->edigits = 0;
+  pre->ep = NULL;
+}
+
+static unsigned
+get_digit (const mpz_t e, mp_bitcnt_t pos, unsigned w)
+{
+  unsigned d, i;
+  for (i = d = 0; i < w; i++)
+    d |= mpz_tstbit (e, pos + i) << i;
+  return d;
+}
+
+/* Picks the window size minimizing the number of multiplications,
+   counting the table setup and the non-zero digits. The number of
+   squarings is roughly the bit size of e for all window sizes. */
+static void
+recode_e (struct rsa_public_precomp *pre, const mpz_t e)
+{
+  mp_bitcnt_t ebits = mpz_sizeinbase (e, 2);
+  unsigned best_w = 1;
+  unsigned long best_cost = ~0UL;
+  unsigned w, i;
+
+  for (w = 1; w <= POWM_E_MAX_WINDOW; w++)
+    {
+      unsigned digits = (ebits + w - 1) / w;
+      unsigned long cost = (1UL << w) - 2;
+
+      for (i = 0; i < digits; i++)
+	cost += get_digit (e, (mp_bitcnt_t) i * w, w) != 0;
+
+      if (cost < best_cost)
+	{
+	  best_cost = cost;
+	  best_w = w;
+	}
+    }
+
+  pre->ewindow = best_w;
+  pre->edigits = (ebits + best_w - 1) / best_w;
+  pre->ep = gmp_alloc (pre->edigits);
+
+  for (i = 0; i < pre->edigits; i++)
+    pre->ep[i] = get_digit (e, (mp_bitcnt_t) (pre->edigits - 1 - i) * best_w,
+			    best_w);
+}
+
+int
+rsa_public_precomp_init (struct rsa_public_precomp *pre,
+			 const struct rsa_public_key *key)
+{
+  mp_limb_t *scratch;
+  mp_size_t nn;
+  mp_size_t itch;
+
+  public_precomp_zero (pre);
+
+  if (mpz_sgn (key->n) <= 0 || mpz_even_p (key->n)
+      || mpz_cmp_ui (key->n, 1) == 0 || mpz_sgn (key->e) <= 0)
+    return 0;
+
+  nn = mpz_size (key->n);
+
+  pre->size = nn;
+  pre->ninv = _rsa_mont_minv (mpz_getlimbn (key->n, 0));
+  pre->r2 = gmp_alloc_limbs (nn);
+
+  itch = _rsa_mont_itch (nn);
+  scratch = gmp_alloc_limbs (itch);
+  _rsa_mont_r2 (pre->r2, mpz_limbs_read (key->n), nn, scratch);
+  gmp_free_limbs (scratch, itch);
+
+  recode_e (pre, key->e);
+
+  return 1;
+}
+
+void
+rsa_public_precomp_clear (struct rsa_public_precomp *pre)
+{
+  if (pre->r2)
+    gmp_free_limbs (pre->r2, pre->size);
+  if (pre->ep)
+    gmp_free (pre->ep, pre->edigits);
+
+  public_precomp_zero (pre);
+}
+
+int
+rsa_private_precomp_init (struct rsa_private_precomp *pre,
+			  const struct rsa_public_key *pub,
+			  const struct rsa_private_key *key)
+{
+  mp_limb_t *scratch;
+  mp_size_t pn, qn;
+  mp_size_t itch;
+
+  pre->pn = pre->qn = 0;
+  pre->pinv = pre->qinv = 0;
+  pre->r2 = NULL;
+
+  if (!rsa_public_precomp_init (&pre->pub, pub))
+    return 0;
+
+  if (mpz_sgn (key->p) <= 0 || mpz_even_p (key->p)
+      || mpz_sgn (key->q) <= 0 || mpz_even_p (key->q))
+    return 0;
+
+  pn = mpz_size (key->p);
+  qn = mpz_size (key->q);
+
+  pre->pn = pn;
+  pre->qn = qn;
+  pre->pinv = _rsa_mont_minv (mpz_getlimbn (key->p, 0));
+  pre->qinv = _rsa_mont_minv (mpz_getlimbn (key->q, 0));
+  pre->r2 = gmp_alloc_limbs (pn + qn);
+
+  itch = _rsa_mont_itch (pn > qn ? pn : qn);
+  scratch = gmp_alloc_limbs (itch);
+  _rsa_mont_r2 (pre->r2, mpz_limbs_read (key->p), pn, scratch);
+  _rsa_mont_r2 (pre->r2 + pn, mpz_limbs_read (key->q), qn, scratch);
+  gmp_free_limbs (scratch, itch);
+
+  return 1;
+}
+
+void
+rsa_private_precomp_clear (struct rsa_private_precomp *pre)
+{
+  if (pre->r2)
+    gmp_free_limbs (pre->r2, pre->pn + pre->qn);
+  pre->r2 = NULL;
+  pre->pn = pre->qn = 0;
+  pre->pinv = pre->qinv = 0;
+
+  rsa_public_precomp_clear (&pre->pub);
+}
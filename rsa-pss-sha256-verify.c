@@ -39,6 +39,8 @@
 #include "rsa-internal.h"
 
 #include "bignum.h"
+#include "gmp-glue.h"
+#include "pkcs1-internal.h"
 #include "pss.h"
 
 int
@@ -59,3 +61,61 @@ rsa_pss_sha256_verify_digest(const struct rsa_public_key *key,
   mpz_clear (m);
   return res;
 }
+
+int
+rsa_pss_sha256_verify_digest_scratch(const struct rsa_public_key *key,
+				     const struct rsa_public_precomp *pre,
+				     size_t salt_length,
+				     const uint8_t *digest,
+				     const uint8_t *signature,
+				     mp_limb_t *scratch)
+{
+  uint8_t *em = (uint8_t *) scratch;
+  mp_limb_t *mp = scratch + _RSA_OCTETS_ITCH (key->size);
+  size_t bits = mpz_sizeinbase (key->n, 2) - 1;
+
+  if (!_rsa_verify_recover_octets (key, pre, mp, signature,
+				   mp + pre->size))
+    return 0;
+
+  mpn_get_base256 (em, key->size, mp, pre->size);
+
+  /* The encoded message has (bits + 7) / 8 octets, one less than
+     key->size when bits is a multiple of 8. */
+  if (key->size > (bits + 7) / 8)
+    {
+      if (*em)
+	return 0;
+      em++;
+    }
+  return _pss_verify_mgf1_octets (em, bits, &nettle_sha256, salt_length,
+				  digest, (uint8_t *) scratch + key->size);
+}
+
+int
+rsa_pss_sha256_verify_digest_batch(const struct rsa_public_key *key,
+				   const struct rsa_public_precomp *pre,
+				   size_t salt_length,
+				   size_t count, const uint8_t *digests,
+				   const uint8_t *signatures, int *valid)
+{
+  size_t i;
+  int res;
+  TMP_GMP_DECL(scratch, mp_limb_t);
+
+  TMP_GMP_ALLOC (scratch, rsa_public_itch (key, pre));
+
+  for (i = 0, res = 1; i < count; i++)
+    {
+      int ok = rsa_pss_sha256_verify_digest_scratch (
+	key, pre, salt_length, digests + i * SHA256_DIGEST_SIZE,
+	signatures + i * key->size, scratch);
+      if (valid)
+	valid[i] = ok;
+      res &= ok;
+    }
+
+  TMP_GMP_FREE (scratch);
+
+  return res;
+}
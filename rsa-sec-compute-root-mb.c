@@ -0,0 +1,342 @@
+/* rsa-sec-compute-root-mb.c
+
+   Multi-buffer RSA root computation, using vectorized Montgomery
+   multiplication.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include "rsa.h"
+#include "rsa-internal.h"
+#include "gmp-glue.h"
+
+#if !NETTLE_USE_MINI_GMP
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+#define MB_TABLE_SIZE (1U << RSA_MB_WINDOW)
+
+/* Number of digits, with 4 m < 2^(52 size) for both p and q, or zero
+   if not supported. The scratch space is used for both limbs and
+   digits, which requires 64-bit limbs. */
+static size_t
+mb_size (const struct rsa_private_key *key)
+{
+#if GMP_NUMB_BITS == 64
+  size_t bits = MAX (mpz_sizeinbase (key->p, 2), mpz_sizeinbase (key->q, 2));
+  size_t size = (bits + 2 + MONT52_DIGIT_BITS - 1) / MONT52_DIGIT_BITS;
+
+  if (size > MONT52_MAX_SIZE)
+    return 0;
+  return MAX (size, 2);
+#else
+  (void) key;
+  return 0;
+#endif
+}
+
+/* Extracts bits pos to pos + n - 1 of a, for n <= 52. */
+static uint64_t
+get_bits (const mp_limb_t *ap, mp_size_t an, mp_bitcnt_t pos, unsigned n)
+{
+  mp_size_t i = pos / GMP_NUMB_BITS;
+  unsigned shift = pos % GMP_NUMB_BITS;
+  unsigned done;
+  uint64_t r;
+
+  for (r = 0, done = 0; done < n && i < an;
+       done += GMP_NUMB_BITS - shift, shift = 0, i++)
+    r |= (uint64_t) (ap[i] >> shift) << done;
+
+  return r & ((((uint64_t) 1) << n) - 1);
+}
+
+/* Sets lane l of the digits x to a. */
+static void
+mb_from_limbs (uint64_t *xp, unsigned l, size_t size,
+	       const mp_limb_t *ap, mp_size_t an)
+{
+  size_t j;
+  for (j = 0; j < size; j++)
+    xp[j * MONT52_LANES + l]
+      = get_bits (ap, an, (mp_bitcnt_t) j * MONT52_DIGIT_BITS,
+		  MONT52_DIGIT_BITS);
+}
+
+/* Sets r to the low rn limbs of lane l of the digits x. */
+static void
+mb_to_limbs (mp_limb_t *rp, mp_size_t rn,
+	     const uint64_t *xp, unsigned l, size_t size)
+{
+  size_t j;
+
+  mpn_zero (rp, rn);
+  for (j = 0; j < size; j++)
+    {
+      uint64_t d = xp[j * MONT52_LANES + l];
+      mp_bitcnt_t pos = (mp_bitcnt_t) j * MONT52_DIGIT_BITS;
+      mp_size_t i = pos / GMP_NUMB_BITS;
+      unsigned shift = pos % GMP_NUMB_BITS;
+      unsigned done;
+
+      for (done = 0; done < MONT52_DIGIT_BITS && i < rn;
+	   done += GMP_NUMB_BITS - shift, shift = 0, i++)
+	rp[i] |= (mp_limb_t) ((d >> done) << shift);
+    }
+}
+
+/* Sets all lanes to 1. */
+static void
+mb_one (uint64_t *xp, size_t size)
+{
+  size_t i;
+  for (i = 0; i < MONT52_LANES; i++)
+    xp[i] = 1;
+  for (; i < size * MONT52_LANES; i++)
+    xp[i] = 0;
+}
+
+/* Copies element k[l] of the table to lane l of r, reading the
+   complete table, like sec_tabselect. */
+static void
+mb_tabselect (uint64_t *rp, const uint64_t *table, size_t size,
+	      unsigned tn, const unsigned *k)
+{
+  size_t n = size * MONT52_LANES;
+  uint64_t mask[MONT52_LANES];
+  unsigned idx[MONT52_LANES];
+  unsigned j, l;
+  size_t i;
+
+  for (l = 0; l < MONT52_LANES; l++)
+    idx[l] = k[l];
+  for (i = 0; i < n; i++)
+    rp[i] = 0;
+
+  for (j = 0; j < tn; j++, table += n)
+    {
+      for (l = 0; l < MONT52_LANES; l++)
+	mask[l] = - (uint64_t) (idx[l]-- == 0);
+
+      for (i = 0; i < n; i += MONT52_LANES)
+	for (l = 0; l < MONT52_LANES; l++)
+	  rp[i + l] += mask[l] & table[i + l];
+    }
+}
+
+static void
+mb_r2 (uint64_t *rp, unsigned l, size_t size, const mpz_t m)
+{
+  mp_size_t mn = mpz_size (m);
+  mp_bitcnt_t bits = 2 * (mp_bitcnt_t) MONT52_DIGIT_BITS * size;
+  mp_size_t tn = bits / GMP_NUMB_BITS + 1;
+  TMP_GMP_DECL (tp, mp_limb_t);
+
+  TMP_GMP_ALLOC (tp, tn + mpn_sec_div_r_itch (tn, mn));
+  mpn_zero (tp, tn);
+  tp[tn-1] = (mp_limb_t) 1 << (bits % GMP_NUMB_BITS);
+
+  mpn_sec_div_r (tp, tn, mpz_limbs_read (m), mn, tp + tn);
+  mb_from_limbs (rp, l, size, tp, mn);
+
+  TMP_GMP_FREE (tp);
+}
+
+mp_size_t
+_rsa_mb_sec_compute_root_itch (const struct rsa_private_key *key)
+{
+  size_t size = mb_size (key);
+  mp_size_t pn = mpz_size (key->p);
+  mp_size_t qn = mpz_size (key->q);
+  mp_size_t itch;
+
+  if (!size)
+    return 0;
+
+  itch = MAX (_rsa_mont_to_itch (MAX (pn, qn)),
+	      _rsa_sec_crt_precomp_itch (key));
+
+  return (MB_TABLE_SIZE + 3) * size * MONT52_LANES + pn + qn + itch;
+}
+
+void
+_rsa_mb_key_init (struct rsa_mb_key *mb, const struct rsa_private_key *key)
+{
+  size_t size = mb_size (key);
+  mp_size_t an = mpz_size (key->a);
+  mp_size_t bn = mpz_size (key->b);
+  unsigned l;
+
+  assert (size > 0);
+  assert (an <= RSA_MB_EXP_LIMBS);
+  assert (bn <= RSA_MB_EXP_LIMBS);
+
+  mb->size = size;
+  mb->bits = MAX (mpz_sizeinbase (key->p, 2), mpz_sizeinbase (key->q, 2));
+
+  for (l = 0; l < MONT52_LANES; l++)
+    {
+      const mpz_srcptr m = (l & 1) ? key->q : key->p;
+      uint64_t m0, inv;
+      unsigned i;
+
+      mb_from_limbs (mb->m, l, size, mpz_limbs_read (m), mpz_size (m));
+
+      /* Newton iteration, as in _rsa_mont_minv */
+      m0 = mb->m[l];
+      for (i = 3, inv = m0; i < 64; i *= 2)
+	inv *= 2 - m0 * inv;
+      mb->minv[l] = -inv & MONT52_DIGIT_MASK;
+
+      if (l < 2)
+	mb_r2 (mb->r2, l, size, m);
+      else
+	for (i = 0; i < size; i++)
+	  mb->r2[i * MONT52_LANES + l] = mb->r2[i * MONT52_LANES + (l & 1)];
+    }
+
+  mpn_copyi (mb->e[0], mpz_limbs_read (key->a), an);
+  mpn_zero (mb->e[0] + an, RSA_MB_EXP_LIMBS - an);
+  mpn_copyi (mb->e[1], mpz_limbs_read (key->b), bn);
+  mpn_zero (mb->e[1] + bn, RSA_MB_EXP_LIMBS - bn);
+}
+
+/* Input i is reduced mod p in lane 2i, and mod q in lane 2i + 1, and
+   all lanes are raised to their exponent using the same sequence of
+   multiplications. */
+void
+_rsa_mb_sec_compute_root (const struct rsa_mb_key *mb,
+			  const struct rsa_private_key *key,
+			  const struct rsa_private_precomp *pre,
+			  size_t count, mp_limb_t *rp, const mp_limb_t *mp,
+			  mp_limb_t *scratch)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size);
+  mp_size_t pn = mpz_size (key->p);
+  mp_size_t qn = mpz_size (key->q);
+  size_t size = mb->size;
+  size_t n = size * MONT52_LANES;
+  unsigned w = RSA_MB_WINDOW;
+  unsigned k[MONT52_LANES];
+  struct rsa_mont m[2];
+  uint64_t *xp, *r, *t, *table;
+  mp_limb_t *r_mod_p, *r_mod_q;
+  unsigned i, l;
+  size_t j;
+
+  assert (count <= RSA_MB_COUNT);
+  assert (size == mb_size (key));
+  assert (pn == pre->pn);
+  assert (qn == pre->qn);
+
+  xp = (uint64_t *) scratch;
+  r = xp + n;
+  t = r + n;
+  table = t + n;
+  r_mod_p = scratch + (MB_TABLE_SIZE + 3) * n;
+  r_mod_q = r_mod_p + pn;
+  scratch = r_mod_q + qn;
+
+  m[0].size = pn; m[0].m = mpz_limbs_read (key->p);
+  m[0].minv = pre->pinv; m[0].r2 = pre->r2;
+  m[1].size = qn; m[1].m = mpz_limbs_read (key->q);
+  m[1].minv = pre->qinv; m[1].r2 = pre->r2 + pn;
+
+  for (l = 0; l < MONT52_LANES; l++)
+    {
+      const struct rsa_mont *lm = &m[l & 1];
+      if (l / 2 < count)
+	{
+	  _rsa_mont_to (lm, r_mod_p, mp + (l / 2) * nn, nn, scratch);
+	  _rsa_mont_from (lm, r_mod_p, r_mod_p, scratch);
+	  mb_from_limbs (r, l, size, r_mod_p, lm->size);
+	}
+      else
+	for (j = 0; j < size; j++)
+	  r[j * MONT52_LANES + l] = 0;
+    }
+
+#define TABLE(d) (table + (d) * n)
+  mb_one (t, size);
+  _mont52_mul (TABLE(0), mb->r2, t, mb->m, mb->minv, size);
+  _mont52_mul (TABLE(1), r, mb->r2, mb->m, mb->minv, size);
+  for (i = 2; i < MB_TABLE_SIZE; i++)
+    _mont52_mul (TABLE(i), TABLE(i-1), TABLE(1), mb->m, mb->minv, size);
+
+  /* The number of windows depends only on the sizes of p and q. */
+  i = (mb->bits + w - 1) / w;
+  assert (i > 0);
+  for (l = 0; l < MONT52_LANES; l++)
+    k[l] = get_bits (mb->e[l & 1], RSA_MB_EXP_LIMBS,
+		     (mp_bitcnt_t) (i-1) * w, w);
+  mb_tabselect (r, table, size, MB_TABLE_SIZE, k);
+
+  while (i-- > 1)
+    {
+      uint64_t *tmp;
+      unsigned s;
+
+      for (s = 0; s < w; s++)
+	{
+	  _mont52_mul (t, r, r, mb->m, mb->minv, size);
+	  tmp = r; r = t; t = tmp;
+	}
+      for (l = 0; l < MONT52_LANES; l++)
+	k[l] = get_bits (mb->e[l & 1], RSA_MB_EXP_LIMBS,
+			 (mp_bitcnt_t) (i-1) * w, w);
+      mb_tabselect (xp, table, size, MB_TABLE_SIZE, k);
+      _mont52_mul (t, r, xp, mb->m, mb->minv, size);
+      tmp = r; r = t; t = tmp;
+    }
+#undef TABLE
+
+  /* Convert back, by multiplication by 1. The result is at most m,
+     and a final conditional subtraction reduces it fully. */
+  mb_one (xp, size);
+  _mont52_mul (t, r, xp, mb->m, mb->minv, size);
+
+  for (i = 0; i < count; i++)
+    {
+      mp_limb_t cy;
+
+      mb_to_limbs (r_mod_p, pn, t, 2*i, size);
+      cy = mpn_sub_n (r_mod_p, r_mod_p, m[0].m, pn);
+      cnd_add_n (cy, r_mod_p, m[0].m, pn);
+
+      mb_to_limbs (r_mod_q, qn, t, 2*i + 1, size);
+      cy = mpn_sub_n (r_mod_q, r_mod_q, m[1].m, qn);
+      cnd_add_n (cy, r_mod_q, m[1].m, qn);
+
+      _rsa_sec_crt_precomp (key, pre, rp + i * nn, r_mod_p, r_mod_q, scratch);
+    }
+}
+#endif
@@ -40,6 +40,7 @@
 
 #include "rsa.h"
 #include "rsa-internal.h"
+#include "hogweed-internal.h"
 #include "gmp-glue.h"
 
 #if !NETTLE_USE_MINI_GMP
@@ -192,4 +193,344 @@ _rsa_sec_compute_root (const struct rsa_private_key *key,
   cy = mpn_add_n (rp, scratch_out, r_mod_q, qn);
   mpn_sec_add_1 (rp + qn, scratch_out + qn, nn - qn, cy, scratch_out + pn + qn);
 }
+
+/* Multi-prime keys. The primes are processed in the order q, p, r_3,
+   ..., using Garner's algorithm as in RFC 8017: with x known modulo
+   R = q p r_3 ... r_(i-1), the next prime gives
+
+     x <-- x + R ((x_i - x) t_i mod r_i), where x_i = m^(d_i) mod r_i.
+
+   For the first step, R = q and the coefficient is c. */
+struct rsa_multi_prime
+{
+  const mp_limb_t *rp;
+  mp_size_t rn;
+  const mp_limb_t *ep;
+  mp_size_t en;
+  const mp_limb_t *tp;
+  mp_size_t tn;
+};
+
+static void
+rsa_multi_prime_set (struct rsa_multi_prime *prime,
+		     const mpz_t r, const mpz_t e, const mpz_t t)
+{
+  prime->rp = mpz_limbs_read (r);
+  prime->rn = mpz_size (r);
+  prime->ep = mpz_limbs_read (e);
+  prime->en = mpz_size (e);
+  prime->tp = mpz_limbs_read (t);
+  prime->tn = mpz_size (t);
+}
+
+/* Returns the number of primes. Their total size is stored in
+   *total. */
+static unsigned
+rsa_multi_primes (const struct rsa_multi_private_key *key,
+		  struct rsa_multi_prime *primes, mp_size_t *total)
+{
+  unsigned k, i;
+
+  assert (key->count <= RSA_MAX_PRIMES - 2);
+
+  /* The coefficient is unused for the first prime. */
+  rsa_multi_prime_set (&primes[0], key->q, key->b, key->c);
+  rsa_multi_prime_set (&primes[1], key->p, key->a, key->c);
+  for (i = 0; i < key->count; i++)
+    rsa_multi_prime_set (&primes[i+2], key->other[i].r,
+			 key->other[i].d, key->other[i].t);
+
+  k = key->count + 2;
+  for (i = 0, *total = 0; i < k; i++)
+    *total += primes[i].rn;
+
+  return k;
+}
+
+mp_size_t
+_rsa_multi_sec_compute_root_itch (const struct rsa_multi_private_key *key)
+{
+  struct rsa_multi_prime primes[RSA_MAX_PRIMES];
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size);
+  mp_size_t total;
+  mp_size_t rmax, tmax;
+  mp_size_t Rn;
+  mp_size_t itch;
+  unsigned k, i;
+
+  k = rsa_multi_primes (key, primes, &total);
+
+  rmax = primes[0].rn;
+  tmax = 0;
+  itch = sec_powm_itch (nn, primes[0].en, primes[0].rn);
+
+  for (i = 1, Rn = primes[0].rn; i < k; Rn += primes[i].rn, i++)
+    {
+      const struct rsa_multi_prime *r = &primes[i];
+      rmax = MAX (rmax, r->rn);
+      tmax = MAX (tmax, r->tn);
+
+      itch = MAX (itch, sec_powm_itch (nn, r->en, r->rn));
+      if (Rn >= r->rn)
+	itch = MAX (itch, mpn_sec_div_r_itch (Rn, r->rn));
+      itch = MAX (itch, sec_mod_mul_itch (r->rn, r->tn, r->rn));
+      itch = MAX (itch, sec_mul_itch (Rn, r->rn));
+      itch = MAX (itch, mpn_sec_add_1_itch (r->rn));
+    }
+
+  /* total for each of x, R and their product, rmax for x_i, and
+     total + tmax for reductions and the product by t_i. */
+  return 4*total + rmax + tmax + itch;
+}
+
+void
+_rsa_multi_sec_compute_root (const struct rsa_multi_private_key *key,
+			     mp_limb_t *rp, const mp_limb_t *mp,
+			     mp_limb_t *scratch)
+{
+  struct rsa_multi_prime primes[RSA_MAX_PRIMES];
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size);
+  mp_size_t total;
+  mp_size_t rmax, tmax;
+  mp_size_t Rn;
+  unsigned k, i;
+
+  mp_limb_t *xp;
+  mp_limb_t *Rp;
+  mp_limb_t *pp;
+  mp_limb_t *xip;
+  mp_limb_t *tp;
+
+  k = rsa_multi_primes (key, primes, &total);
+  for (i = 1, rmax = primes[0].rn, tmax = 0; i < k; i++)
+    {
+      rmax = MAX (rmax, primes[i].rn);
+      tmax = MAX (tmax, primes[i].tn);
+    }
+
+  assert (total >= nn);
+
+  xp = scratch;
+  Rp = xp + total;
+  pp = Rp + total;
+  xip = pp + total;
+  tp = xip + rmax;
+  scratch = tp + total + tmax;
+
+  /* x = m^b mod q, R = q */
+  sec_powm (xp, mp, nn, primes[0].ep, primes[0].en,
+	    primes[0].rp, primes[0].rn, scratch);
+  mpn_copyi (Rp, primes[0].rp, primes[0].rn);
+  Rn = primes[0].rn;
+
+  for (i = 1; i < k; i++)
+    {
+      const struct rsa_multi_prime *r = &primes[i];
+      mp_limb_t cy;
+
+      sec_powm (xip, mp, nn, r->ep, r->en, r->rp, r->rn, scratch);
+
+      /* Reduce x mod r_i. If R has fewer limbs than r_i, then x < R <
+	 r_i already. */
+      mpn_copyi (tp, xp, Rn);
+      if (Rn >= r->rn)
+	mpn_sec_div_r (tp, Rn, r->rp, r->rn, scratch);
+      else
+	mpn_zero (tp + Rn, r->rn - Rn);
+
+      /* h = (x_i - x) t_i mod r_i */
+      cy = mpn_sub_n (xip, xip, tp, r->rn);
+      cnd_add_n (cy, xip, r->rp, r->rn);
+      sec_mod_mul (tp, xip, r->rn, r->tp, r->tn, r->rp, r->rn, scratch);
+
+      /* x = x + R h, which is less than R r_i */
+      sec_mul (pp, Rp, Rn, tp, r->rn, scratch);
+      cy = mpn_add_n (xp, pp, xp, Rn);
+      mpn_sec_add_1 (xp + Rn, pp + Rn, r->rn, cy, scratch);
+
+      if (i + 1 < k)
+	{
+	  sec_mul (pp, Rp, Rn, r->rp, r->rn, scratch);
+	  mpn_copyi (Rp, pp, Rn + r->rn);
+	}
+      Rn += r->rn;
+    }
+
+  /* The top limbs are zero, since x < n. */
+  mpn_copyi (rp, xp, nn);
+}
+
+/* Variant using precomputed Montgomery parameters, which replace the
+   divisions for reducing m mod p and mod q, and the modular
+   multiplication in the CRT step. The two exponentiations use
+   separate scratch areas, so that they can be run concurrently. */
+mp_size_t
+_rsa_sec_compute_root_precomp_itch (const struct rsa_private_key *key)
+{
+  mp_size_t pn = mpz_size (key->p);
+  mp_size_t qn = mpz_size (key->q);
+  mp_size_t an = mpz_size (key->a);
+  mp_size_t bn = mpz_size (key->b);
+
+  mp_size_t powm_p_itch
+    = pn + MAX (_rsa_mont_to_itch (pn),
+		mpn_sec_powm_itch (pn, an * GMP_NUMB_BITS, pn));
+  mp_size_t powm_q_itch
+    = qn + MAX (_rsa_mont_to_itch (qn),
+		mpn_sec_powm_itch (qn, bn * GMP_NUMB_BITS, qn));
+
+  return pn + qn + MAX (powm_p_itch + powm_q_itch,
+			_rsa_sec_crt_precomp_itch (key));
+}
+
+mp_size_t
+_rsa_sec_crt_precomp_itch (const struct rsa_private_key *key)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size);
+  mp_size_t pn = mpz_size (key->p);
+  mp_size_t qn = mpz_size (key->q);
+
+  mp_size_t mul_itch = sec_mul_itch (qn, pn);
+  mp_size_t add_1_itch = mpn_sec_add_1_itch (nn - qn);
+  mp_size_t mont_itch = pn + MAX (_rsa_mont_to_itch (pn), _rsa_mont_itch (pn));
+
+  return MAX (mont_itch, pn + qn + MAX (mul_itch, add_1_itch));
+}
+
+/* Reduces m mod p, by converting to Montgomery representation and
+   back. */
+static void
+mont_mod (const struct rsa_mont *m, mp_limb_t *rp,
+	  const mp_limb_t *ap, mp_size_t an, mp_limb_t *scratch)
+{
+  _rsa_mont_to (m, rp, ap, an, scratch);
+  _rsa_mont_from (m, rp, rp, scratch);
+}
+
+/* One of the two exponentiations, r = (m % p)^a % p. This uses
+   mpn_sec_powm, which redoes its own Montgomery setup, rather than
+   _rsa_mont_powm with the precomputed values, since gmp's assembly
+   redc makes it faster in spite of that. */
+struct rsa_root_half
+{
+  const struct rsa_mont *m;
+  const mp_limb_t *ep;
+  mp_size_t en;
+  const mp_limb_t *mp;
+  mp_size_t mn;
+  mp_limb_t *rp;
+  mp_limb_t *scratch;
+};
+
+static void
+rsa_root_half (void *arg, size_t i)
+{
+  const struct rsa_root_half *h = (const struct rsa_root_half *) arg + i;
+  mp_size_t n = h->m->size;
+
+  mont_mod (h->m, h->scratch, h->mp, h->mn, h->scratch + n);
+  mpn_sec_powm (h->rp, h->scratch, n, h->ep, h->en * GMP_NUMB_BITS,
+		h->m->m, n, h->scratch + n);
+}
+
+void
+_rsa_sec_compute_root_precomp (const struct rsa_private_key *key,
+			       const struct rsa_private_precomp *pre,
+			       void *executor_ctx, rsa_executor_func *executor,
+			       mp_limb_t *rp, const mp_limb_t *mp,
+			       mp_limb_t *scratch)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size);
+
+  const mp_limb_t *pp = mpz_limbs_read (key->p);
+  const mp_limb_t *qp = mpz_limbs_read (key->q);
+
+  mp_size_t pn = mpz_size (key->p);
+  mp_size_t qn = mpz_size (key->q);
+  mp_size_t an = mpz_size (key->a);
+  mp_size_t bn = mpz_size (key->b);
+
+  struct rsa_mont pm;
+  struct rsa_mont qm;
+  struct rsa_root_half half[2];
+
+  mp_limb_t *r_mod_p = scratch;
+  mp_limb_t *r_mod_q = scratch + pn;
+  mp_limb_t *scratch_out = r_mod_q + qn;
+
+  assert (pn == pre->pn);
+  assert (qn == pre->qn);
+  assert (pn <= nn);
+  assert (qn <= nn);
+  assert (an <= pn);
+  assert (bn <= qn);
+
+  pm.size = pn; pm.m = pp; pm.minv = pre->pinv; pm.r2 = pre->r2;
+  qm.size = qn; qm.m = qp; qm.minv = pre->qinv; qm.r2 = pre->r2 + pn;
+
+  /* Compute r_mod_p = m^d % p = (m%p)^a % p */
+  half[0].m = &pm;
+  half[0].ep = mpz_limbs_read (key->a); half[0].en = an;
+  half[0].mp = mp; half[0].mn = nn;
+  half[0].rp = r_mod_p;
+  half[0].scratch = scratch_out;
+
+  /* Compute r_mod_q = m^d % q = (m%q)^b % q */
+  half[1].m = &qm;
+  half[1].ep = mpz_limbs_read (key->b); half[1].en = bn;
+  half[1].mp = mp; half[1].mn = nn;
+  half[1].rp = r_mod_q;
+  half[1].scratch = scratch_out + pn
+    + MAX (_rsa_mont_to_itch (pn),
+	   mpn_sec_powm_itch (pn, an * GMP_NUMB_BITS, pn));
+
+  _nettle_run_tasks (executor_ctx, executor, 2, rsa_root_half, half);
+
+  _rsa_sec_crt_precomp (key, pre, rp, r_mod_p, r_mod_q, scratch_out);
+}
+
+/* Combines x_p = x mod p and x_q = x mod q, as x = x_q + q ((x_p -
+   x_q) c mod p). Clobbers r_mod_p. */
+void
+_rsa_sec_crt_precomp (const struct rsa_private_key *key,
+		      const struct rsa_private_precomp *pre,
+		      mp_limb_t *rp, mp_limb_t *r_mod_p, const mp_limb_t *r_mod_q,
+		      mp_limb_t *scratch)
+{
+  mp_size_t nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE (key->size);
+
+  const mp_limb_t *pp = mpz_limbs_read (key->p);
+  const mp_limb_t *qp = mpz_limbs_read (key->q);
+
+  mp_size_t pn = mpz_size (key->p);
+  mp_size_t qn = mpz_size (key->q);
+  mp_size_t cn = mpz_size (key->c);
+
+  struct rsa_mont pm;
+  mp_limb_t cy;
+
+  assert (pn == pre->pn);
+  assert (qn == pre->qn);
+  assert (cn <= pn);
+
+  pm.size = pn; pm.m = pp; pm.minv = pre->pinv; pm.r2 = pre->r2;
+
+  /* Set r_mod_p' = (r_mod_p - r_mod_q) * c % p. The first Montgomery
+     multiplication leaves a factor 1/R, which the multiplication by
+     R^2 mod p removes. */
+  mont_mod (&pm, scratch, r_mod_q, qn, scratch + pn);
+  cy = mpn_sub_n (r_mod_p, r_mod_p, scratch, pn);
+  cnd_add_n (cy, r_mod_p, pp, pn);
+
+  mpn_copyi (scratch, mpz_limbs_read (key->c), cn);
+  mpn_zero (scratch + cn, pn - cn);
+  _rsa_mont_mul (&pm, r_mod_p, r_mod_p, scratch, scratch + pn);
+  _rsa_mont_mul (&pm, r_mod_p, r_mod_p, pm.r2, scratch + pn);
+
+  /* Finally, compute x = r_mod_q + q r_mod_p' */
+  sec_mul (scratch, qp, qn, r_mod_p, pn, scratch + pn + qn);
+
+  cy = mpn_add_n (rp, scratch, r_mod_q, qn);
+  mpn_sec_add_1 (rp + qn, scratch + qn, nn - qn, cy, scratch + pn + qn);
+}
 #endif
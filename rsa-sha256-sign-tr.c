@@ -82,3 +82,93 @@ rsa_sha256_sign_digest_tr(const struct rsa_public_key *pub,
   mpz_clear (m);
   return res;
 }
+
+int
+rsa_sha256_sign_digest_tr_blinding(const struct rsa_public_key *pub,
+				   const struct rsa_private_key *key,
+				   const struct rsa_private_precomp *pre,
+				   struct rsa_blinding *blinding,
+				   void *random_ctx, nettle_random_func *random,
+				   const uint8_t *digest,
+				   mpz_t s)
+{
+  mpz_t m;
+  int res;
+
+  mpz_init (m);
+
+  res = (pkcs1_rsa_sha256_encode_digest(m, key->size, digest)
+	 && rsa_compute_root_tr_blinding (pub, key, pre, blinding,
+					  random_ctx, random,
+					  s, m));
+
+  mpz_clear (m);
+  return res;
+}
+
+int
+rsa_sha256_sign_digest_tr_parallel(const struct rsa_public_key *pub,
+				   const struct rsa_private_key *key,
+				   const struct rsa_private_precomp *pre,
+				   struct rsa_blinding *blinding,
+				   void *executor_ctx, rsa_executor_func *executor,
+				   void *random_ctx, nettle_random_func *random,
+				   const uint8_t *digest,
+				   mpz_t s)
+{
+  mpz_t m;
+  int res;
+
+  mpz_init (m);
+
+  res = (pkcs1_rsa_sha256_encode_digest(m, key->size, digest)
+	 && rsa_compute_root_tr_parallel (pub, key, pre, blinding,
+					  executor_ctx, executor,
+					  random_ctx, random,
+					  s, m));
+
+  mpz_clear (m);
+  return res;
+}
+
+/* The padding is done up front, in the calling thread. */
+int
+rsa_sha256_sign_digest_tr_batch(const struct rsa_public_key *pub,
+				const struct rsa_private_key *key,
+				const struct rsa_private_precomp *pre,
+				size_t workers, struct rsa_worker *worker,
+				void *executor_ctx, rsa_executor_func *executor,
+				size_t count, const uint8_t *digests,
+				mpz_t *s)
+{
+  size_t i;
+
+  for (i = 0; i < count; i++)
+    if (!pkcs1_rsa_sha256_encode_digest(s[i], key->size,
+					digests + i * SHA256_DIGEST_SIZE))
+      return 0;
+
+  return rsa_compute_root_tr_batch (pub, key, pre, workers, worker,
+				    executor_ctx, executor, count, s);
+}
+
+int
+rsa_multi_sha256_sign_digest_tr(const struct rsa_public_key *pub,
+				const struct rsa_multi_private_key *key,
+				void *random_ctx, nettle_random_func *random,
+				const uint8_t *digest,
+				mpz_t s)
+{
+  mpz_t m;
+  int res;
+
+  mpz_init (m);
+
+  res = (pkcs1_rsa_sha256_encode_digest(m, key->size, digest)
+	 && rsa_multi_compute_root_tr (pub, key,
+				       random_ctx, random,
+				       s, m));
+
+  mpz_clear (m);
+  return res;
+}
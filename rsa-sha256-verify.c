@@ -36,11 +36,14 @@
 #endif
 
 #include <assert.h>
+#include <string.h>
 
 #include "rsa.h"
 #include "rsa-internal.h"
 
 #include "bignum.h"
+#include "gmp-glue.h"
+#include "hogweed-internal.h"
 #include "pkcs1.h"
 
 int
@@ -78,3 +81,80 @@ rsa_sha256_verify_digest(const struct rsa_public_key *key,
 
   return res;
 }
+
+int
+rsa_sha256_verify_digest_precomp(const struct rsa_public_key *key,
+				 const struct rsa_public_precomp *pre,
+				 const uint8_t *digest,
+				 const mpz_t s)
+{
+  int res;
+  mpz_t m;
+
+  mpz_init(m);
+
+  res = (pkcs1_rsa_sha256_encode_digest(m, key->size, digest)
+	 && _rsa_verify_precomp(key, pre, m, s));
+
+  mpz_clear(m);
+
+  return res;
+}
+
+int
+rsa_sha256_verify_digest_scratch(const struct rsa_public_key *key,
+				 const struct rsa_public_precomp *pre,
+				 const uint8_t *digest,
+				 const uint8_t *signature,
+				 mp_limb_t *scratch)
+{
+  uint8_t *p = _pkcs1_rsa_sha256_prefix (key->size, (uint8_t *) scratch);
+  if (!p)
+    return 0;
+
+  memcpy (p, digest, SHA256_DIGEST_SIZE);
+  return _rsa_verify_octets (key, pre, signature, scratch);
+}
+
+/* The encoding is the same for all digests, except for the final
+   SHA256_DIGEST_SIZE octets, so the prefix is written only once. */
+int
+rsa_sha256_verify_digest_batch(const struct rsa_public_key *key,
+			       const struct rsa_public_precomp *pre,
+			       size_t count, const uint8_t *digests,
+			       const uint8_t *signatures, int *valid)
+{
+  size_t i;
+  uint8_t *p;
+  int res;
+  TMP_GMP_DECL(scratch, mp_limb_t);
+
+  if (count == 0)
+    return 1;
+
+  TMP_GMP_ALLOC (scratch, rsa_public_itch (key, pre));
+
+  p = _pkcs1_rsa_sha256_prefix (key->size, (uint8_t *) scratch);
+  if (!p)
+    {
+      TMP_GMP_FREE (scratch);
+      if (valid)
+	memset (valid, 0, count * sizeof(*valid));
+      return 0;
+    }
+
+  for (i = 0, res = 1; i < count; i++)
+    {
+      int ok;
+      memcpy (p, digests + i * SHA256_DIGEST_SIZE, SHA256_DIGEST_SIZE);
+      ok = _rsa_verify_octets (key, pre, signatures + i * key->size,
+			       scratch);
+      if (valid)
+	valid[i] = ok;
+      res &= ok;
+    }
+
+  TMP_GMP_FREE (scratch);
+
+  return res;
+}
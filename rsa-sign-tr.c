@@ -45,6 +45,21 @@
 
 #define MAX(a, b) ((a) > (b) ? (a) : (b))
 
+/* Even factors are rejected by rsa_multi_private_key_prepare, but as
+   for two-prime keys, check again before any exponentiation. */
+static int
+rsa_multi_even_p (const struct rsa_multi_private_key *key)
+{
+  unsigned i;
+
+  if (mpz_even_p (key->p) || mpz_even_p (key->q))
+    return 1;
+  for (i = 0; i < key->count; i++)
+    if (mpz_even_p (key->other[i].r))
+      return 1;
+  return 0;
+}
+
 #if NETTLE_USE_MINI_GMP
 /* Blinds m, by computing c = m r^e (mod n), for a random r. Also
    returns the inverse (ri), for use by rsa_unblind. */
@@ -86,12 +101,14 @@ rsa_unblind (const struct rsa_public_key *pub,
 
 /* Checks for any errors done in the RSA computation. That avoids
  * attacks which rely on faults on hardware, or even software MPI
- * implementation. */
-int
-rsa_compute_root_tr(const struct rsa_public_key *pub,
-		    const struct rsa_private_key *key,
-		    void *random_ctx, nettle_random_func *random,
-		    mpz_t x, const mpz_t m)
+ * implementation. Uses the precomputed values, if pre is
+ * non-NULL. */
+static int
+compute_root_tr(const struct rsa_public_key *pub,
+		const struct rsa_private_key *key,
+		const struct rsa_private_precomp *pre,
+		void *random_ctx, nettle_random_func *random,
+		mpz_t x, const mpz_t m)
 {
   int res;
   mpz_t t, mb, xb, ri;
@@ -111,7 +128,56 @@ rsa_compute_root_tr(const struct rsa_public_key *pub,
 
   rsa_blind (pub, random_ctx, random, mb, ri, m);
 
-  rsa_compute_root (key, xb, mb);
+  if (pre)
+    _rsa_compute_root_precomp (key, pre, xb, mb);
+  else
+    rsa_compute_root (key, xb, mb);
+
+  mpz_powm_sec(t, xb, pub->e, pub->n);
+  res = (mpz_cmp(mb, t) == 0);
+
+  if (res)
+    rsa_unblind (pub, x, ri, xb);
+
+  mpz_clear (mb);
+  mpz_clear (xb);
+  mpz_clear (ri);
+  mpz_clear (t);
+
+  return res;
+}
+
+int
+rsa_compute_root_tr(const struct rsa_public_key *pub,
+		    const struct rsa_private_key *key,
+		    void *random_ctx, nettle_random_func *random,
+		    mpz_t x, const mpz_t m)
+{
+  return compute_root_tr (pub, key, NULL, random_ctx, random, x, m);
+}
+
+/* The multi-prime variant is identical, except for the root
+   computation. */
+int
+rsa_multi_compute_root_tr(const struct rsa_public_key *pub,
+			  const struct rsa_multi_private_key *key,
+			  void *random_ctx, nettle_random_func *random,
+			  mpz_t x, const mpz_t m)
+{
+  int res;
+  mpz_t t, mb, xb, ri;
+
+  if (mpz_even_p (pub->n) || rsa_multi_even_p (key))
+    return 0;
+
+  mpz_init (mb);
+  mpz_init (xb);
+  mpz_init (ri);
+  mpz_init (t);
+
+  rsa_blind (pub, random_ctx, random, mb, ri, m);
+
+  rsa_multi_compute_root (key, xb, mb);
 
   mpz_powm_sec(t, xb, pub->e, pub->n);
   res = (mpz_cmp(mb, t) == 0);
@@ -152,6 +218,37 @@ _rsa_sec_compute_root_tr(const struct rsa_public_key *pub,
   mpz_clear(xz);
   return res;
 }
+
+/* The blinding state is not used with mini-gmp, and of the
+   precomputed values, only R^2 mod p and mod q. */
+int
+rsa_compute_root_tr_blinding(const struct rsa_public_key *pub,
+			     const struct rsa_private_key *key,
+			     const struct rsa_private_precomp *pre,
+			     struct rsa_blinding *blinding,
+			     void *random_ctx, nettle_random_func *random,
+			     mpz_t x, const mpz_t m)
+{
+  assert (pre->pub.size == (mp_size_t) mpz_size (pub->n));
+  assert (blinding->size == 0);
+  return compute_root_tr (pub, key, pre, random_ctx, random, x, m);
+}
+
+/* Runs sequentially, since there is no split into independent
+   exponentiations with mini-gmp. */
+int
+rsa_compute_root_tr_parallel(const struct rsa_public_key *pub,
+			     const struct rsa_private_key *key,
+			     const struct rsa_private_precomp *pre,
+			     struct rsa_blinding *blinding,
+			     void *executor_ctx, rsa_executor_func *executor,
+			     void *random_ctx, nettle_random_func *random,
+			     mpz_t x, const mpz_t m)
+{
+  assert (executor || !executor_ctx);
+  return rsa_compute_root_tr_blinding (pub, key, pre, blinding,
+				       random_ctx, random, x, m);
+}
 #else
 /* Blinds m, by computing c = m r^e (mod n), for a random r. Also
    returns the inverse (ri), for use by rsa_unblind. */
@@ -343,6 +440,305 @@ _rsa_sec_compute_root_tr(const struct rsa_public_key *pub,
   return ret;
 }
 
+int
+_rsa_multi_sec_compute_root_tr(const struct rsa_public_key *pub,
+			       const struct rsa_multi_private_key *key,
+			       void *random_ctx, nettle_random_func *random,
+			       mp_limb_t *x, const mp_limb_t *m, size_t mn)
+{
+  TMP_GMP_DECL (c, mp_limb_t);
+  TMP_GMP_DECL (ri, mp_limb_t);
+  TMP_GMP_DECL (scratch, mp_limb_t);
+  size_t key_limb_size;
+  int ret;
+
+  key_limb_size = NETTLE_OCTET_SIZE_TO_LIMB_SIZE(key->size);
+
+  if (mpz_even_p (pub->n) || rsa_multi_even_p (key))
+    {
+      mpn_zero(x, key_limb_size);
+      return 0;
+    }
+
+  assert(mpz_size(pub->n) == key_limb_size);
+  assert(mn <= key_limb_size);
+
+  TMP_GMP_ALLOC (c, key_limb_size);
+  TMP_GMP_ALLOC (ri, key_limb_size);
+  TMP_GMP_ALLOC (scratch, _rsa_multi_sec_compute_root_itch(key));
+
+  rsa_sec_blind (pub, random_ctx, random, x, ri, m, mn);
+
+  _rsa_multi_sec_compute_root(key, c, x, scratch);
+
+  ret = rsa_sec_check_root(pub, c, x);
+
+  rsa_sec_unblind(pub, x, ri, c);
+
+  cnd_mpn_zero(1 - ret, x, key_limb_size);
+
+  TMP_GMP_FREE (scratch);
+  TMP_GMP_FREE (ri);
+  TMP_GMP_FREE (c);
+  return ret;
+}
+
+static mp_size_t
+rsa_sec_blinding_new_itch (const struct rsa_mont *nm,
+			   const struct rsa_public_precomp *pre)
+{
+  mp_size_t nn = nm->size;
+  mp_size_t itch;
+  mp_size_t i2;
+
+  itch = mpn_sec_invert_itch (nn);
+  i2 = _rsa_mont_to_itch (nn);
+  itch = MAX(itch, i2);
+  i2 = _rsa_mont_powm_e_itch (nm, pre);
+  itch = MAX(itch, i2);
+
+  return 3*nn + itch;
+}
+
+/* Sets vi = r^e and vf = 1/r mod n, both in Montgomery
+   representation, for a random r. */
+static void
+rsa_sec_blinding_new (const struct rsa_mont *nm,
+		      const struct rsa_public_precomp *pre,
+		      void *random_ctx, nettle_random_func *random,
+		      mp_limb_t *vi, mp_limb_t *vf, mp_limb_t *scratch)
+{
+  mp_size_t nn = nm->size;
+  mp_limb_t *tp = scratch;
+  mp_limb_t *rp = scratch + nn;
+  uint8_t *r = (uint8_t *) (scratch + 2*nn);
+
+  scratch += 3*nn;
+
+  /* vf = r^(-1) */
+  do
+    {
+      random(random_ctx, nn * sizeof(mp_limb_t), r);
+      mpn_set_base256(rp, nn, r, nn * sizeof(mp_limb_t));
+      mpn_copyi(tp, rp, nn);
+    }
+  while (!mpn_sec_invert (vf, tp, nm->m, nn, 2 * nn * GMP_NUMB_BITS, scratch));
+
+  _rsa_mont_to (nm, vf, vf, nn, scratch);
+
+  /* vi = r^e */
+  _rsa_mont_to (nm, tp, rp, nn, scratch);
+  _rsa_mont_powm_e (nm, pre, vi, tp, scratch);
+}
+
+/* Gets the next blinding pair, either by squaring the previous one, or
+   by generating a fresh one every RSA_BLINDING_REFRESH uses, or when
+   the modulus differs from the one the state was generated for. Uses
+   rsa_sec_blinding_new_itch scratch. */
+static void
+rsa_sec_blinding_update (const struct rsa_mont *nm,
+			 const struct rsa_public_precomp *pre,
+			 struct rsa_blinding *blinding,
+			 void *random_ctx, nettle_random_func *random,
+			 mp_limb_t *scratch)
+{
+  if (blinding->size != nm->size)
+    {
+      rsa_blinding_clear (blinding);
+      blinding->size = nm->size;
+      blinding->vi = gmp_alloc_limbs (3*nm->size);
+      blinding->vf = blinding->vi + nm->size;
+      blinding->n = blinding->vf + nm->size;
+    }
+  /* The modulus is public, so the comparison needn't be side-channel
+     silent. */
+  else if (mpn_cmp (blinding->n, nm->m, nm->size) != 0)
+    blinding->count = 0;
+
+  if (blinding->count == 0)
+    {
+      mpn_copyi (blinding->n, nm->m, nm->size);
+      rsa_sec_blinding_new (nm, pre, random_ctx, random,
+			    blinding->vi, blinding->vf, scratch);
+      blinding->count = RSA_BLINDING_REFRESH;
+    }
+  else
+    {
+      _rsa_mont_sqr (nm, blinding->vi, blinding->vi, scratch);
+      _rsa_mont_sqr (nm, blinding->vf, blinding->vf, scratch);
+    }
+  blinding->count--;
+}
+
+mp_size_t
+_rsa_sec_blind_precomp_itch(const struct rsa_public_key *pub,
+			    const struct rsa_private_precomp *pre)
+{
+  struct rsa_mont nm;
+  mp_size_t itch;
+  mp_size_t i2;
+
+  _rsa_mont_public (&nm, pub, &pre->pub);
+
+  itch = rsa_sec_blinding_new_itch (&nm, &pre->pub);
+  i2 = _rsa_mont_itch (nm.size);
+  itch = MAX(itch, i2);
+
+  return 2*nm.size + itch;
+}
+
+void
+_rsa_sec_blind_precomp(const struct rsa_public_key *pub,
+		       const struct rsa_private_precomp *pre,
+		       struct rsa_blinding *blinding,
+		       void *random_ctx, nettle_random_func *random,
+		       mp_limb_t *c, mp_limb_t *vf,
+		       const mp_limb_t *m, size_t mn,
+		       mp_limb_t *scratch)
+{
+  struct rsa_mont nm;
+  mp_size_t nn;
+  mp_limb_t *tp;
+  mp_limb_t *vi;
+
+  _rsa_mont_public (&nm, pub, &pre->pub);
+  nn = nm.size;
+
+  assert(mn <= (size_t) nn);
+
+  tp = scratch;
+  vi = scratch + nn;
+  scratch += 2*nn;
+
+  if (blinding)
+    {
+      rsa_sec_blinding_update (&nm, &pre->pub, blinding,
+			       random_ctx, random, scratch);
+      mpn_copyi (vi, blinding->vi, nn);
+      mpn_copyi (vf, blinding->vf, nn);
+    }
+  else
+    rsa_sec_blinding_new (&nm, &pre->pub, random_ctx, random,
+			  vi, vf, scratch);
+
+  /* c = m*(r^e) mod n */
+  mpn_copyi (tp, m, mn);
+  mpn_zero (tp + mn, nn - mn);
+  _rsa_mont_mul (&nm, c, vi, tp, scratch);
+}
+
+mp_size_t
+_rsa_sec_unblind_precomp_itch(const struct rsa_public_key *pub,
+			      const struct rsa_private_precomp *pre)
+{
+  struct rsa_mont nm;
+  mp_size_t itch;
+  mp_size_t i2;
+
+  _rsa_mont_public (&nm, pub, &pre->pub);
+
+  itch = _rsa_mont_to_itch (nm.size);
+  i2 = _rsa_mont_powm_e_itch (&nm, &pre->pub);
+  itch = MAX(itch, i2);
+
+  return 2*nm.size + itch;
+}
+
+int
+_rsa_sec_unblind_precomp(const struct rsa_public_key *pub,
+			 const struct rsa_private_precomp *pre,
+			 mp_limb_t *x, const mp_limb_t *c, const mp_limb_t *vf,
+			 mp_limb_t *scratch)
+{
+  struct rsa_mont nm;
+  mp_size_t nn;
+  mp_limb_t *xm;
+  mp_limb_t *tp;
+  int ret;
+
+  _rsa_mont_public (&nm, pub, &pre->pub);
+  nn = nm.size;
+
+  xm = scratch;
+  tp = scratch + nn;
+  scratch += 2*nn;
+
+  /* Check that x^e = c */
+  _rsa_mont_to (&nm, xm, x, nn, scratch);
+  _rsa_mont_powm_e (&nm, &pre->pub, tp, xm, scratch);
+  _rsa_mont_from (&nm, tp, tp, scratch);
+  ret = sec_equal(tp, c, nn);
+
+  /* x = x r^(-1) mod n */
+  _rsa_mont_mul (&nm, x, x, vf, scratch);
+
+  cnd_mpn_zero(1 - ret, x, nn);
+
+  return ret;
+}
+
+mp_size_t
+_rsa_sec_compute_root_tr_precomp_itch(const struct rsa_public_key *pub,
+				      const struct rsa_private_key *key,
+				      const struct rsa_private_precomp *pre)
+{
+  mp_size_t nn;
+  mp_size_t itch;
+  mp_size_t i2;
+
+  nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE(key->size);
+
+  itch = _rsa_sec_compute_root_precomp_itch (key);
+  i2 = _rsa_sec_blind_precomp_itch (pub, pre);
+  itch = MAX(itch, i2);
+  i2 = _rsa_sec_unblind_precomp_itch (pub, pre);
+  itch = MAX(itch, i2);
+
+  return 2*nn + itch;
+}
+
+/* Like _rsa_sec_compute_root_tr, but with all arithmetic mod n done
+   using Montgomery multiplication with the precomputed parameters. If
+   blinding is non-NULL, the blinding pair is taken from it, otherwise
+   a fresh one is generated. The exponentiations mod p and mod q are
+   run as two tasks of the executor. */
+int
+_rsa_sec_compute_root_tr_precomp(const struct rsa_public_key *pub,
+				 const struct rsa_private_key *key,
+				 const struct rsa_private_precomp *pre,
+				 struct rsa_blinding *blinding,
+				 void *executor_ctx, rsa_executor_func *executor,
+				 void *random_ctx, nettle_random_func *random,
+				 mp_limb_t *x, const mp_limb_t *m, size_t mn,
+				 mp_limb_t *scratch)
+{
+  mp_size_t nn;
+  mp_limb_t *c;
+  mp_limb_t *vf;
+
+  nn = NETTLE_OCTET_SIZE_TO_LIMB_SIZE(key->size);
+
+  if (mpz_even_p (pub->n) || mpz_even_p (key->p) || mpz_even_p (key->q))
+    {
+      mpn_zero(x, nn);
+      return 0;
+    }
+
+  assert(mpz_size(pub->n) == (size_t) nn);
+
+  c = scratch;
+  vf = scratch + nn;
+  scratch += 2*nn;
+
+  _rsa_sec_blind_precomp (pub, pre, blinding, random_ctx, random,
+			  c, vf, m, mn, scratch);
+
+  _rsa_sec_compute_root_precomp (key, pre, executor_ctx, executor,
+				 x, c, scratch);
+
+  return _rsa_sec_unblind_precomp (pub, pre, x, c, vf, scratch);
+}
+
 /* Checks for any errors done in the RSA computation. That avoids
  * attacks which rely on faults on hardware, or even software MPI
  * implementation.
@@ -373,4 +769,85 @@ rsa_compute_root_tr(const struct rsa_public_key *pub,
   TMP_GMP_FREE (l);
   return res;
 }
+
+int
+rsa_multi_compute_root_tr(const struct rsa_public_key *pub,
+			  const struct rsa_multi_private_key *key,
+			  void *random_ctx, nettle_random_func *random,
+			  mpz_t x, const mpz_t m)
+{
+  TMP_GMP_DECL (l, mp_limb_t);
+  int res;
+
+  mp_size_t l_size = NETTLE_OCTET_SIZE_TO_LIMB_SIZE(key->size);
+  TMP_GMP_ALLOC (l, l_size);
+
+  res = _rsa_multi_sec_compute_root_tr (pub, key, random_ctx, random, l,
+					mpz_limbs_read(m), mpz_size(m));
+  if (res) {
+    mp_limb_t *xp = mpz_limbs_write (x, l_size);
+    mpn_copyi (xp, l, l_size);
+    mpz_limbs_finish (x, l_size);
+  }
+
+  TMP_GMP_FREE (l);
+  return res;
+}
+
+static int
+rsa_compute_root_tr_mpz(const struct rsa_public_key *pub,
+			const struct rsa_private_key *key,
+			const struct rsa_private_precomp *pre,
+			struct rsa_blinding *blinding,
+			void *executor_ctx, rsa_executor_func *executor,
+			void *random_ctx, nettle_random_func *random,
+			mpz_t x, const mpz_t m)
+{
+  TMP_GMP_DECL (l, mp_limb_t);
+  int res;
+
+  mp_size_t l_size = NETTLE_OCTET_SIZE_TO_LIMB_SIZE(key->size);
+  TMP_GMP_ALLOC (l, l_size
+		 + _rsa_sec_compute_root_tr_precomp_itch (pub, key, pre));
+
+  res = _rsa_sec_compute_root_tr_precomp (pub, key, pre, blinding,
+					  executor_ctx, executor,
+					  random_ctx, random,
+					  l, mpz_limbs_read(m), mpz_size(m),
+					  l + l_size);
+  if (res) {
+    mp_limb_t *xp = mpz_limbs_write (x, l_size);
+    mpn_copyi (xp, l, l_size);
+    mpz_limbs_finish (x, l_size);
+  }
+
+  TMP_GMP_FREE (l);
+  return res;
+}
+
+int
+rsa_compute_root_tr_blinding(const struct rsa_public_key *pub,
+			     const struct rsa_private_key *key,
+			     const struct rsa_private_precomp *pre,
+			     struct rsa_blinding *blinding,
+			     void *random_ctx, nettle_random_func *random,
+			     mpz_t x, const mpz_t m)
+{
+  return rsa_compute_root_tr_mpz (pub, key, pre, blinding, NULL, NULL,
+				  random_ctx, random, x, m);
+}
+
+int
+rsa_compute_root_tr_parallel(const struct rsa_public_key *pub,
+			     const struct rsa_private_key *key,
+			     const struct rsa_private_precomp *pre,
+			     struct rsa_blinding *blinding,
+			     void *executor_ctx, rsa_executor_func *executor,
+			     void *random_ctx, nettle_random_func *random,
+			     mpz_t x, const mpz_t m)
+{
+  return rsa_compute_root_tr_mpz (pub, key, pre, blinding,
+				  executor_ctx, executor,
+				  random_ctx, random, x, m);
+}
 #endif
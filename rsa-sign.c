@@ -94,10 +94,65 @@ rsa_private_key_prepare(struct rsa_private_key *key)
 
 #if NETTLE_USE_MINI_GMP
 
-/* Computing an rsa root. */
-void
-rsa_compute_root(const struct rsa_private_key *key,
-		 mpz_t x, const mpz_t m)
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* Sets r = (m % p)^e % p. mini-gmp's mpz_powm is neither side-channel
+   silent nor fast, so use Montgomery arithmetic and the fixed window
+   _rsa_mont_powm. If r2 is NULL, R^2 mod p is computed here, by
+   _rsa_mont_r2, since mini-gmp has no side-channel silent division. */
+static void
+sec_powm (mpz_t r, const mpz_t m, const mpz_t e, const mpz_t p,
+	  const mp_limb_t *r2)
+{
+  TMP_GMP_DECL (scratch, mp_limb_t);
+  mp_size_t pn = mpz_size (p);
+  mp_size_t en = mpz_size (e);
+  mp_size_t mn = MAX (mpz_size (m), 1);
+  mp_bitcnt_t ebits = (mp_bitcnt_t) en * GMP_NUMB_BITS;
+  unsigned w = _rsa_mont_powm_window (ebits, pn);
+  struct rsa_mont pm;
+  mp_size_t itch;
+  mp_limb_t *r2p;
+  mp_limb_t *tp;
+  mp_limb_t *mp;
+  mp_limb_t *scratch_out;
+
+  assert (mpz_odd_p (p));
+  assert (en > 0);
+
+  itch = MAX (_rsa_mont_to_itch (pn), _rsa_mont_powm_itch (pn, w));
+  TMP_GMP_ALLOC (scratch, 2*pn + mn + itch);
+  r2p = scratch;
+  tp = r2p + pn;
+  mp = tp + pn;
+  scratch_out = mp + mn;
+
+  pm.size = pn;
+  pm.m = mpz_limbs_read (p);
+  pm.minv = _rsa_mont_minv (pm.m[0]);
+  if (r2)
+    pm.r2 = r2;
+  else
+    {
+      _rsa_mont_r2 (r2p, pm.m, pn, scratch_out);
+      pm.r2 = r2p;
+    }
+
+  mpz_limbs_copy (mp, m, mn);
+  _rsa_mont_to (&pm, tp, mp, mn, scratch_out);
+  _rsa_mont_powm (&pm, w, tp, tp, mpz_limbs_read (e), ebits, scratch_out);
+  _rsa_mont_from (&pm, mpz_limbs_write (r, pn), tp, scratch_out);
+  mpz_limbs_finish (r, pn);
+
+  TMP_GMP_FREE (scratch);
+}
+
+/* Computing an rsa root, with R^2 mod p and mod q from pre, if
+   non-NULL. */
+static void
+compute_root(const struct rsa_private_key *key,
+	     const struct rsa_private_precomp *pre,
+	     mpz_t x, const mpz_t m)
 {
   mpz_t xp; /* modulo p */
   mpz_t xq; /* modulo q */
@@ -105,12 +160,10 @@ rsa_compute_root(const struct rsa_private_key *key,
   mpz_init(xp); mpz_init(xq);    
 
   /* Compute xq = m^d % q = (m%q)^b % q */
-  mpz_fdiv_r(xq, m, key->q);
-  mpz_powm_sec(xq, xq, key->b, key->q);
+  sec_powm(xq, m, key->b, key->q, pre ? pre->r2 + pre->pn : NULL);
 
   /* Compute xp = m^d % p = (m%p)^a % p */
-  mpz_fdiv_r(xp, m, key->p);
-  mpz_powm_sec(xp, xp, key->a, key->p);
+  sec_powm(xp, m, key->a, key->p, pre ? pre->r2 : NULL);
 
   /* Set xp' = (xp - xq) c % p. */
   mpz_sub(xp, xp, xq);
@@ -153,6 +206,23 @@ rsa_compute_root(const struct rsa_private_key *key,
   mpz_clear(xp); mpz_clear(xq);
 }
 
+void
+rsa_compute_root(const struct rsa_private_key *key,
+		 mpz_t x, const mpz_t m)
+{
+  compute_root (key, NULL, x, m);
+}
+
+void
+_rsa_compute_root_precomp(const struct rsa_private_key *key,
+			  const struct rsa_private_precomp *pre,
+			  mpz_t x, const mpz_t m)
+{
+  assert (pre->pn == (mp_size_t) mpz_size (key->p));
+  assert (pre->qn == (mp_size_t) mpz_size (key->q));
+  compute_root (key, pre, x, m);
+}
+
 #else /* !NETTLE_USE_MINI_GMP */
 
 /* Computing an rsa root. */
@@ -35,10 +35,15 @@
 # include "config.h"
 #endif
 
+#include <string.h>
+
 #include "rsa.h"
 #include "rsa-internal.h"
 
 #include "bignum.h"
+#include "gmp-glue.h"
+
+#define MAX(a, b) ((a) > (b) ? (a) : (b))
 
 int
 _rsa_verify(const struct rsa_public_key *key,
@@ -64,6 +69,117 @@ _rsa_verify(const struct rsa_public_key *key,
   return res;
 }
 
+/* Like _rsa_verify, but using Montgomery multiplication with the
+   precomputed parameters, and the recoded exponent. */
+int
+_rsa_verify_precomp(const struct rsa_public_key *key,
+		    const struct rsa_public_precomp *pre,
+		    const mpz_t m,
+		    const mpz_t s)
+{
+  struct rsa_mont mont;
+  mp_size_t nn;
+  mp_size_t itch;
+  mpz_t m1;
+  int res;
+  TMP_GMP_DECL(tp, mp_limb_t);
+
+  if ( (mpz_sgn(s) <= 0)
+       || (mpz_cmp(s, key->n) >= 0) )
+    return 0;
+
+  _rsa_mont_public (&mont, key, pre);
+  nn = mont.size;
+
+  itch = MAX (_rsa_mont_to_itch (nn), _rsa_mont_powm_e_itch (&mont, pre));
+  TMP_GMP_ALLOC (tp, 2*nn + itch);
+
+  _rsa_mont_to (&mont, tp, mpz_limbs_read (s), mpz_size (s), tp + 2*nn);
+  _rsa_mont_powm_e_public (&mont, pre, tp + nn, tp, tp + 2*nn);
+  _rsa_mont_from (&mont, tp, tp + nn, tp + 2*nn);
+
+  res = !mpz_cmp (m, mpz_roinit_n (m1, tp, nn));
+
+  TMP_GMP_FREE (tp);
+
+  return res;
+}
+
+mp_size_t
+_rsa_verify_recover_octets_itch(const struct rsa_public_key *key,
+				const struct rsa_public_precomp *pre)
+{
+  struct rsa_mont mont;
+  _rsa_mont_public (&mont, key, pre);
+
+  return 2*mont.size + _rsa_mont_powm_e_itch (&mont, pre);
+}
+
+int
+_rsa_verify_recover_octets(const struct rsa_public_key *key,
+			   const struct rsa_public_precomp *pre,
+			   mp_limb_t *mp, const uint8_t *s,
+			   mp_limb_t *scratch)
+{
+  struct rsa_mont mont;
+  mp_size_t nn;
+
+  _rsa_mont_public (&mont, key, pre);
+  nn = mont.size;
+
+#define sp scratch
+#define tp (scratch + nn)
+#define scratch_out (scratch + 2*nn)
+
+  mpn_set_base256 (sp, nn, s, key->size);
+  if (mpn_zero_p (sp, nn) || mpn_cmp (sp, mont.m, nn) >= 0)
+    return 0;
+
+  /* Convert to Montgomery representation, s R = (s R^2) / R. */
+  _rsa_mont_mul_public (&mont, tp, sp, mont.r2, scratch_out);
+  _rsa_mont_powm_e_public (&mont, pre, sp, tp, scratch_out);
+  _rsa_mont_from (&mont, mp, sp, scratch_out);
+
+  return 1;
+#undef sp
+#undef tp
+#undef scratch_out
+}
+
+mp_size_t
+rsa_public_itch(const struct rsa_public_key *key,
+		const struct rsa_public_precomp *pre)
+{
+  struct rsa_mont mont;
+  mp_size_t nn;
+
+  _rsa_mont_public (&mont, key, pre);
+  nn = mont.size;
+
+  /* Encoded messages, followed by one number and either the scratch
+     for _rsa_verify_recover_octets, or another number and the scratch
+     for side-channel silent exponentiation. */
+  return _RSA_OCTETS_ITCH (key->size) + nn
+    + MAX (_rsa_verify_recover_octets_itch (key, pre),
+	   nn + MAX (_rsa_mont_to_itch (nn),
+		     _rsa_mont_powm_e_itch (&mont, pre)));
+}
+
+int
+_rsa_verify_octets(const struct rsa_public_key *key,
+		   const struct rsa_public_precomp *pre,
+		   const uint8_t *s, mp_limb_t *scratch)
+{
+  uint8_t *em = (uint8_t *) scratch;
+  mp_limb_t *mp = scratch + _RSA_OCTETS_ITCH (key->size);
+
+  if (!_rsa_verify_recover_octets (key, pre, mp, s, mp + pre->size))
+    return 0;
+
+  mpn_get_base256 (em + key->size, key->size, mp, pre->size);
+  return memcmp (em, em + key->size, key->size) == 0;
+}
+
 int
 _rsa_verify_recover(const struct rsa_public_key *key,
 		    mpz_t m,
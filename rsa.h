@@ -92,6 +92,7 @@ extern "C" {
 #define rsa_compute_root nettle_rsa_compute_root
 #define rsa_compute_root_tr nettle_rsa_compute_root_tr
 #define rsa_generate_keypair nettle_rsa_generate_keypair
+#define rsa_generate_keypair_parallel nettle_rsa_generate_keypair_parallel
 #define rsa_keypair_to_sexp nettle_rsa_keypair_to_sexp
 #define rsa_keypair_from_sexp_alist nettle_rsa_keypair_from_sexp_alist
 #define rsa_keypair_from_sexp nettle_rsa_keypair_from_sexp
@@ -99,6 +100,44 @@ extern "C" {
 #define rsa_private_key_from_der_iterator nettle_rsa_private_key_from_der_iterator
 #define rsa_keypair_from_der nettle_rsa_keypair_from_der
 #define rsa_keypair_to_openpgp nettle_rsa_keypair_to_openpgp
+#define rsa_public_precomp_init nettle_rsa_public_precomp_init
+#define rsa_public_precomp_clear nettle_rsa_public_precomp_clear
+#define rsa_private_precomp_init nettle_rsa_private_precomp_init
+#define rsa_private_precomp_clear nettle_rsa_private_precomp_clear
+#define rsa_pkcs1_verify_precomp nettle_rsa_pkcs1_verify_precomp
+#define rsa_sha256_verify_digest_precomp nettle_rsa_sha256_verify_digest_precomp
+#define rsa_sha256_verify_digest_batch nettle_rsa_sha256_verify_digest_batch
+#define rsa_pss_sha256_verify_digest_batch nettle_rsa_pss_sha256_verify_digest_batch
+#define rsa_public_itch nettle_rsa_public_itch
+#define rsa_pkcs1_verify_scratch nettle_rsa_pkcs1_verify_scratch
+#define rsa_sha256_verify_digest_scratch nettle_rsa_sha256_verify_digest_scratch
+#define rsa_pss_sha256_verify_digest_scratch nettle_rsa_pss_sha256_verify_digest_scratch
+#define rsa_encrypt_scratch nettle_rsa_encrypt_scratch
+#define rsa_blinding_init nettle_rsa_blinding_init
+#define rsa_blinding_clear nettle_rsa_blinding_clear
+#define rsa_pkcs1_sign_tr_blinding nettle_rsa_pkcs1_sign_tr_blinding
+#define rsa_sha256_sign_digest_tr_blinding nettle_rsa_sha256_sign_digest_tr_blinding
+#define rsa_compute_root_tr_blinding nettle_rsa_compute_root_tr_blinding
+#define rsa_compute_root_tr_parallel nettle_rsa_compute_root_tr_parallel
+#define rsa_sha256_sign_digest_tr_parallel nettle_rsa_sha256_sign_digest_tr_parallel
+#define rsa_worker_init nettle_rsa_worker_init
+#define rsa_worker_clear nettle_rsa_worker_clear
+#define rsa_compute_root_tr_batch nettle_rsa_compute_root_tr_batch
+#define rsa_sec_decrypt_batch nettle_rsa_sec_decrypt_batch
+#define rsa_sha256_sign_digest_tr_batch nettle_rsa_sha256_sign_digest_tr_batch
+#define rsa_multi_private_key_init nettle_rsa_multi_private_key_init
+#define rsa_multi_private_key_clear nettle_rsa_multi_private_key_clear
+#define rsa_multi_private_key_prepare nettle_rsa_multi_private_key_prepare
+#define rsa_multi_compute_root nettle_rsa_multi_compute_root
+#define rsa_multi_compute_root_tr nettle_rsa_multi_compute_root_tr
+#define rsa_multi_pkcs1_sign_tr nettle_rsa_multi_pkcs1_sign_tr
+#define rsa_multi_sha256_sign_digest_tr nettle_rsa_multi_sha256_sign_digest_tr
+#define rsa_generate_multi_keypair nettle_rsa_generate_multi_keypair
+#define rsa_multi_keypair_to_sexp nettle_rsa_multi_keypair_to_sexp
+#define rsa_multi_keypair_from_sexp_alist nettle_rsa_multi_keypair_from_sexp_alist
+#define rsa_multi_keypair_from_sexp nettle_rsa_multi_keypair_from_sexp
+#define rsa_multi_private_key_from_der_iterator nettle_rsa_multi_private_key_from_der_iterator
+#define rsa_multi_keypair_from_der nettle_rsa_multi_keypair_from_der
 
 /* This limit is somewhat arbitrary. Technically, the smallest modulo
    which makes sense at all is 15 = 3*5, phi(15) = 8, size 4 bits. But
@@ -145,6 +184,128 @@ struct rsa_private_key
   mpz_t c;
 };
 
+/* Multi-prime keys, as specified in RFC 8017, with n = p q r_3 ...
+   r_u. The private operation does one exponentiation per prime, each
+   with a smaller modulo than for a two-prime key of the same size.
+   Note that more primes make the key easier to factor using methods
+   whose running time depends on the size of the smallest factor, so
+   the number of primes must be limited for a given key size. */
+#define RSA_MAX_PRIMES 4
+
+struct rsa_prime_info
+{
+  /* The prime r_i */
+  mpz_t r;
+
+  /* d % (r_i - 1) */
+  mpz_t d;
+
+  /* Inverse of r_1 r_2 ... r_(i-1) mod r_i, where r_1 = p and r_2 = q. */
+  mpz_t t;
+};
+
+struct rsa_multi_private_key
+{
+  /* Size of n, the product of all primes, in octets. */
+  size_t size;
+
+  /* The same as for struct rsa_private_key. */
+  mpz_t d;
+  mpz_t p; mpz_t q;
+  mpz_t a; mpz_t b;
+  mpz_t c;
+
+  /* Number of primes in addition to p and q, at most
+     RSA_MAX_PRIMES - 2. */
+  unsigned count;
+  struct rsa_prime_info other[RSA_MAX_PRIMES - 2];
+};
+
+/* Precomputed per-key values for Montgomery arithmetic, for
+   applications doing many operations with the same key. They are kept
+   separate from the key structs, and must be recomputed whenever the
+   key is modified. */
+struct rsa_public_precomp
+{
+  /* Number of limbs in n. */
+  mp_size_t size;
+
+  /* -1/n mod 2^GMP_NUMB_BITS */
+  mp_limb_t ninv;
+
+  /* 2^(2 size GMP_NUMB_BITS) mod n, size limbs. */
+  mp_limb_t *r2;
+
+  /* Fixed window recoding of the public exponent, most significant
+     digit first. The window size is chosen to minimize the number of
+     multiplications for this particular e. */
+  unsigned ewindow;
+  unsigned edigits;
+  uint8_t *ep;
+};
+
+struct rsa_private_precomp
+{
+  /* Parameters for n, used for blinding and for checking the
+     result. */
+  struct rsa_public_precomp pub;
+
+  /* Number of limbs in p and q. */
+  mp_size_t pn;
+  mp_size_t qn;
+
+  /* -1/p and -1/q mod 2^GMP_NUMB_BITS. */
+  mp_limb_t pinv;
+  mp_limb_t qinv;
+
+  /* 2^(2 pn GMP_NUMB_BITS) mod p, followed by 2^(2 qn GMP_NUMB_BITS)
+     mod q. */
+  mp_limb_t *r2;
+};
+
+/* Number of uses of a blinding pair, updated by squaring, before it
+   is replaced by a fresh random one. */
+#define RSA_BLINDING_REFRESH 32
+
+/* Blinding state for repeated private key operations. Instead of a
+   fresh random r, with an inversion mod n, for each operation, the
+   pair (r^e, 1/r) is updated by squaring. The state remembers the
+   modulus it was generated for, and a fresh pair is generated if it
+   is used with a different key. The state is modified by every
+   operation, so a struct must never be used by more than one thread
+   at a time; use one per thread, while the key and precomp structs
+   can be shared. */
+struct rsa_blinding
+{
+  /* Number of limbs in n, zero until first use. */
+  mp_size_t size;
+  /* Uses left before refresh. */
+  unsigned count;
+  /* r^e and 1/r mod n, in Montgomery representation. */
+  mp_limb_t *vi;
+  mp_limb_t *vf;
+  /* Copy of n. */
+  mp_limb_t *n;
+};
+
+/* Support for running parts of private key operations concurrently,
+   see nettle_executor_func in bignum.h. */
+typedef nettle_task_func rsa_task_func;
+typedef nettle_executor_func rsa_executor_func;
+
+/* Per-worker state for batch signing. Each worker owns its blinding
+   state and scratch space, and is used by at most one thread at a
+   time. */
+struct rsa_worker
+{
+  struct rsa_blinding blinding;
+  void *random_ctx;
+  nettle_random_func *random;
+  /* Scratch space, allocated by rsa_worker_init. */
+  mp_size_t size;
+  mp_limb_t *scratch;
+};
+
 /* Signing a message works as follows:
  *
  * Store the private key in a rsa_private_key struct.
@@ -190,6 +351,61 @@ rsa_private_key_clear(struct rsa_private_key *key);
 int
 rsa_private_key_prepare(struct rsa_private_key *key);
 
+/* Calls mpz_init for all primes, and sets count to zero. */
+void
+rsa_multi_private_key_init(struct rsa_multi_private_key *key);
+
+void
+rsa_multi_private_key_clear(struct rsa_multi_private_key *key);
+
+int
+rsa_multi_private_key_prepare(struct rsa_multi_private_key *key);
+
+/* Computes the precomputed values for a prepared key. Returns 1 on
+   success, and 0 if the key is invalid, in which case the precomp
+   struct is left in a state where only the clear function may be
+   called. */
+int
+rsa_public_precomp_init(struct rsa_public_precomp *pre,
+			const struct rsa_public_key *key);
+
+void
+rsa_public_precomp_clear(struct rsa_public_precomp *pre);
+
+/* Scratch space, in limbs, needed by the *_scratch public key
+   functions, which do no memory allocation of their own. */
+mp_size_t
+rsa_public_itch(const struct rsa_public_key *key,
+		const struct rsa_public_precomp *pre);
+
+int
+rsa_private_precomp_init(struct rsa_private_precomp *pre,
+			 const struct rsa_public_key *pub,
+			 const struct rsa_private_key *key);
+
+void
+rsa_private_precomp_clear(struct rsa_private_precomp *pre);
+
+void
+rsa_blinding_init(struct rsa_blinding *blinding);
+
+void
+rsa_blinding_clear(struct rsa_blinding *blinding);
+
+/* Allocates the scratch space needed for batch operations with the
+   given key. The random function must be safe to use concurrently
+   with those of the other workers, e.g., by giving each worker its
+   own generator state. */
+void
+rsa_worker_init(struct rsa_worker *worker,
+		const struct rsa_public_key *pub,
+		const struct rsa_private_key *key,
+		const struct rsa_private_precomp *pre,
+		void *random_ctx, nettle_random_func *random);
+
+void
+rsa_worker_clear(struct rsa_worker *worker);
+
 
 /* PKCS#1 style signatures */
 int
@@ -208,6 +424,31 @@ rsa_pkcs1_verify(const struct rsa_public_key *key,
 		 size_t length, const uint8_t *digest_info,
 		 const mpz_t signature);
 
+/* Variants using precomputed values, which must correspond to the
+   keys passed. */
+int
+rsa_pkcs1_sign_tr_blinding(const struct rsa_public_key *pub,
+			   const struct rsa_private_key *key,
+			   const struct rsa_private_precomp *pre,
+			   struct rsa_blinding *blinding,
+			   void *random_ctx, nettle_random_func *random,
+			   size_t length, const uint8_t *digest_info,
+			   mpz_t s);
+int
+rsa_pkcs1_verify_precomp(const struct rsa_public_key *key,
+			 const struct rsa_public_precomp *pre,
+			 size_t length, const uint8_t *digest_info,
+			 const mpz_t signature);
+
+/* Like rsa_pkcs1_verify_precomp, for a signature of key->size octets,
+   big-endian, using rsa_public_itch limbs of scratch. */
+int
+rsa_pkcs1_verify_scratch(const struct rsa_public_key *key,
+			 const struct rsa_public_precomp *pre,
+			 size_t length, const uint8_t *digest_info,
+			 const uint8_t *signature,
+			 mp_limb_t *scratch);
+
 int
 rsa_md5_sign(const struct rsa_private_key *key,
              struct md5_ctx *hash,
@@ -327,6 +568,64 @@ rsa_sha256_verify_digest(const struct rsa_public_key *key,
 			 const uint8_t *digest,
 			 const mpz_t signature);
 
+int
+rsa_sha256_sign_digest_tr_blinding(const struct rsa_public_key *pub,
+				   const struct rsa_private_key *key,
+				   const struct rsa_private_precomp *pre,
+				   struct rsa_blinding *blinding,
+				   void *random_ctx, nettle_random_func *random,
+				   const uint8_t *digest,
+				   mpz_t s);
+
+/* Like rsa_sha256_sign_digest_tr_blinding, but with the CRT
+   exponentiations mod p and mod q run as two tasks of the
+   executor. */
+int
+rsa_sha256_sign_digest_tr_parallel(const struct rsa_public_key *pub,
+				   const struct rsa_private_key *key,
+				   const struct rsa_private_precomp *pre,
+				   struct rsa_blinding *blinding,
+				   void *executor_ctx, rsa_executor_func *executor,
+				   void *random_ctx, nettle_random_func *random,
+				   const uint8_t *digest,
+				   mpz_t s);
+
+/* Signs count digests, stored consecutively, distributing the work
+   over the workers, one executor task per worker. Returns 1 if all
+   signatures were created. On failure, 0 is returned, and any failed
+   signature is set to zero. */
+int
+rsa_sha256_sign_digest_tr_batch(const struct rsa_public_key *pub,
+				const struct rsa_private_key *key,
+				const struct rsa_private_precomp *pre,
+				size_t workers, struct rsa_worker *worker,
+				void *executor_ctx, rsa_executor_func *executor,
+				size_t count, const uint8_t *digests,
+				mpz_t *s);
+
+int
+rsa_sha256_verify_digest_precomp(const struct rsa_public_key *key,
+				 const struct rsa_public_precomp *pre,
+				 const uint8_t *digest,
+				 const mpz_t signature);
+
+/* Verifies count signatures made with the same key. Digests and
+   signatures are stored consecutively, each signature as key->size
+   octets, big-endian. Returns 1 if all signatures are valid. If valid
+   is non-NULL, valid[i] is set to 1 or 0 for each signature. */
+int
+rsa_sha256_verify_digest_batch(const struct rsa_public_key *key,
+			       const struct rsa_public_precomp *pre,
+			       size_t count, const uint8_t *digests,
+			       const uint8_t *signatures, int *valid);
+
+int
+rsa_sha256_verify_digest_scratch(const struct rsa_public_key *key,
+				 const struct rsa_public_precomp *pre,
+				 const uint8_t *digest,
+				 const uint8_t *signature,
+				 mp_limb_t *scratch);
+
 int
 rsa_sha512_sign_digest(const struct rsa_private_key *key,
 		       const uint8_t *digest,
@@ -359,6 +658,22 @@ rsa_pss_sha256_verify_digest(const struct rsa_public_key *key,
 			     const uint8_t *digest,
 			     const mpz_t signature);
 
+/* Like rsa_sha256_verify_digest_batch, for PSS signatures. */
+int
+rsa_pss_sha256_verify_digest_batch(const struct rsa_public_key *key,
+				   const struct rsa_public_precomp *pre,
+				   size_t salt_length,
+				   size_t count, const uint8_t *digests,
+				   const uint8_t *signatures, int *valid);
+
+int
+rsa_pss_sha256_verify_digest_scratch(const struct rsa_public_key *key,
+				     const struct rsa_public_precomp *pre,
+				     size_t salt_length,
+				     const uint8_t *digest,
+				     const uint8_t *signature,
+				     mp_limb_t *scratch);
+
 int
 rsa_pss_sha384_sign_digest_tr(const struct rsa_public_key *pub,
 			      const struct rsa_private_key *key,
@@ -401,6 +716,18 @@ rsa_encrypt(const struct rsa_public_key *key,
 	    size_t length, const uint8_t *cleartext,
 	    mpz_t cipher);
 
+/* Like rsa_encrypt, producing key->size octets of ciphertext,
+   big-endian, using rsa_public_itch limbs of scratch. Unlike
+   rsa_encrypt, the exponentiation is side-channel silent. */
+int
+rsa_encrypt_scratch(const struct rsa_public_key *key,
+		    const struct rsa_public_precomp *pre,
+		    /* For padding */
+		    void *random_ctx, nettle_random_func *random,
+		    size_t length, const uint8_t *cleartext,
+		    uint8_t *ciphertext,
+		    mp_limb_t *scratch);
+
 /* Message must point to a buffer of size *LENGTH. KEY->size is enough
  * for all valid messages. On success, *LENGTH is updated to reflect
  * the actual length of the message. Returns 1 on success, 0 on
@@ -441,6 +768,81 @@ rsa_compute_root_tr(const struct rsa_public_key *pub,
 		    void *random_ctx, nettle_random_func *random,
 		    mpz_t x, const mpz_t m);
 
+/* Like rsa_compute_root_tr, but using the precomputed values, which
+   must correspond to the keys passed, and with amortised blinding.
+   The random function is used only when the blinding state is
+   refreshed. */
+int
+rsa_compute_root_tr_blinding(const struct rsa_public_key *pub,
+			     const struct rsa_private_key *key,
+			     const struct rsa_private_precomp *pre,
+			     struct rsa_blinding *blinding,
+			     void *random_ctx, nettle_random_func *random,
+			     mpz_t x, const mpz_t m);
+
+/* Like rsa_compute_root_tr_blinding, but with the CRT
+   exponentiations mod p and mod q run as two tasks of the
+   executor. */
+int
+rsa_compute_root_tr_parallel(const struct rsa_public_key *pub,
+			     const struct rsa_private_key *key,
+			     const struct rsa_private_precomp *pre,
+			     struct rsa_blinding *blinding,
+			     void *executor_ctx, rsa_executor_func *executor,
+			     void *random_ctx, nettle_random_func *random,
+			     mpz_t x, const mpz_t m);
+
+/* Replaces each x[i], i < count, by its e:th root, like
+   rsa_compute_root_tr_blinding, distributing the work over the
+   workers. Returns 1 on success. On failure, 0 is returned, and any
+   failed element is set to zero. */
+int
+rsa_compute_root_tr_batch(const struct rsa_public_key *pub,
+			  const struct rsa_private_key *key,
+			  const struct rsa_private_precomp *pre,
+			  size_t workers, struct rsa_worker *worker,
+			  void *executor_ctx, rsa_executor_func *executor,
+			  size_t count, mpz_t *x);
+
+/* Decrypts count ciphertexts, like rsa_sec_decrypt, distributing the
+   work over the workers. The ciphertexts are stored consecutively,
+   each as key->size octets, big-endian, and so are the messages, each
+   of the given length. Returns 1 if all messages were decrypted. If
+   valid is non-NULL, valid[i] is set to 1 or 0 for each message. */
+int
+rsa_sec_decrypt_batch(const struct rsa_public_key *pub,
+		      const struct rsa_private_key *key,
+		      const struct rsa_private_precomp *pre,
+		      size_t workers, struct rsa_worker *worker,
+		      void *executor_ctx, rsa_executor_func *executor,
+		      size_t count, size_t length, uint8_t *messages,
+		      const uint8_t *ciphertexts, int *valid);
+
+/* Multi-prime variants, for signing only. */
+void
+rsa_multi_compute_root(const struct rsa_multi_private_key *key,
+		       mpz_t x, const mpz_t m);
+
+int
+rsa_multi_compute_root_tr(const struct rsa_public_key *pub,
+			  const struct rsa_multi_private_key *key,
+			  void *random_ctx, nettle_random_func *random,
+			  mpz_t x, const mpz_t m);
+
+int
+rsa_multi_pkcs1_sign_tr(const struct rsa_public_key *pub,
+			const struct rsa_multi_private_key *key,
+			void *random_ctx, nettle_random_func *random,
+			size_t length, const uint8_t *digest_info,
+			mpz_t s);
+
+int
+rsa_multi_sha256_sign_digest_tr(const struct rsa_public_key *pub,
+				const struct rsa_multi_private_key *key,
+				void *random_ctx, nettle_random_func *random,
+				const uint8_t *digest,
+				mpz_t s);
+
 /* Key generation */
 
 /* Note that the key structs must be initialized first. */
@@ -458,6 +860,30 @@ rsa_generate_keypair(struct rsa_public_key *pub,
 		      * zero, the passed in value pub->e is used. */
 		     unsigned e_size);
 
+/* Like rsa_generate_keypair, but tests up to WIDTH prime candidates
+   at a time, as concurrent executor tasks. See
+   nettle_random_prime_parallel. */
+int
+rsa_generate_keypair_parallel(struct rsa_public_key *pub,
+			      struct rsa_private_key *key,
+			      void *random_ctx, nettle_random_func *random,
+			      void *progress_ctx, nettle_progress_func *progress,
+			      void *executor_ctx, rsa_executor_func *executor,
+			      unsigned width,
+			      unsigned n_size,
+			      unsigned e_size);
+
+/* Generates a key with nprimes primes of roughly equal size, 2 <=
+   nprimes <= RSA_MAX_PRIMES. */
+int
+rsa_generate_multi_keypair(struct rsa_public_key *pub,
+			   struct rsa_multi_private_key *key,
+			   void *random_ctx, nettle_random_func *random,
+			   void *progress_ctx, nettle_progress_func *progress,
+			   unsigned n_size,
+			   unsigned e_size,
+			   unsigned nprimes);
+
 
 #define RSA_SIGN(key, algorithm, ctx, length, data, signature) ( \
   algorithm##_update(ctx, length, data), \
@@ -499,6 +925,27 @@ rsa_keypair_from_sexp(struct rsa_public_key *pub,
 		      unsigned limit,
 		      size_t length, const uint8_t *expr);
 
+/* Multi-prime keys. Each additional prime r_i is represented using
+   the names ri, di and ti, for i = 3, 4. With PRIV == NULL, these
+   functions are equivalent to the two-prime functions. */
+int
+rsa_multi_keypair_to_sexp(struct nettle_buffer *buffer,
+			  const char *algorithm_name,
+			  const struct rsa_public_key *pub,
+			  const struct rsa_multi_private_key *priv);
+
+int
+rsa_multi_keypair_from_sexp_alist(struct rsa_public_key *pub,
+				  struct rsa_multi_private_key *priv,
+				  unsigned limit,
+				  struct sexp_iterator *i);
+
+int
+rsa_multi_keypair_from_sexp(struct rsa_public_key *pub,
+			    struct rsa_multi_private_key *priv,
+			    unsigned limit,
+			    size_t length, const uint8_t *expr);
+
 
 /* Keys in PKCS#1 format. */
 struct asn1_der_iterator;
@@ -521,6 +968,20 @@ rsa_keypair_from_der(struct rsa_public_key *pub,
 		     unsigned limit, 
 		     size_t length, const uint8_t *data);
 
+/* Accepts both version 0 keys, and version 1 keys with
+   otherPrimeInfos. */
+int
+rsa_multi_private_key_from_der_iterator(struct rsa_public_key *pub,
+					struct rsa_multi_private_key *priv,
+					unsigned limit,
+					struct asn1_der_iterator *i);
+
+int
+rsa_multi_keypair_from_der(struct rsa_public_key *pub,
+			   struct rsa_multi_private_key *priv,
+			   unsigned limit,
+			   size_t length, const uint8_t *data);
+
 /* OpenPGP format. Experimental interface, subject to change. */
 int
 rsa_keypair_to_openpgp(struct nettle_buffer *buffer,
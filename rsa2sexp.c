@@ -57,3 +57,51 @@ rsa_keypair_to_sexp(struct nettle_buffer *buffer,
     return sexp_format(buffer, "(public-key(%0s(n%b)(e%b)))",
 		       algorithm_name, pub->n, pub->e);
 }
+
+int
+rsa_multi_keypair_to_sexp(struct nettle_buffer *buffer,
+			  const char *algorithm_name,
+			  const struct rsa_public_key *pub,
+			  const struct rsa_multi_private_key *priv)
+{
+  if (!algorithm_name)
+    algorithm_name = "rsa-pkcs1";
+
+  if (!priv)
+    return rsa_keypair_to_sexp(buffer, algorithm_name, pub, NULL);
+
+  switch (priv->count)
+    {
+    case 0:
+      return sexp_format(buffer,
+			 "(private-key(%0s(n%b)(e%b)"
+			 "(d%b)(p%b)(q%b)(a%b)(b%b)(c%b)))",
+			 algorithm_name, pub->n, pub->e,
+			 priv->d, priv->p, priv->q,
+			 priv->a, priv->b, priv->c);
+    case 1:
+      return sexp_format(buffer,
+			 "(private-key(%0s(n%b)(e%b)"
+			 "(d%b)(p%b)(q%b)(a%b)(b%b)(c%b)"
+			 "(r3%b)(d3%b)(t3%b)))",
+			 algorithm_name, pub->n, pub->e,
+			 priv->d, priv->p, priv->q,
+			 priv->a, priv->b, priv->c,
+			 priv->other[0].r, priv->other[0].d,
+			 priv->other[0].t);
+    case 2:
+      return sexp_format(buffer,
+			 "(private-key(%0s(n%b)(e%b)"
+			 "(d%b)(p%b)(q%b)(a%b)(b%b)(c%b)"
+			 "(r3%b)(d3%b)(t3%b)(r4%b)(d4%b)(t4%b)))",
+			 algorithm_name, pub->n, pub->e,
+			 priv->d, priv->p, priv->q,
+			 priv->a, priv->b, priv->c,
+			 priv->other[0].r, priv->other[0].d,
+			 priv->other[0].t,
+			 priv->other[1].r, priv->other[1].d,
+			 priv->other[1].t);
+    default:
+      return 0;
+    }
+}
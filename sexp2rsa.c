@@ -113,3 +113,88 @@ rsa_keypair_from_sexp(struct rsa_public_key *pub,
 
   return rsa_keypair_from_sexp_alist(pub, priv, limit, &i);
 }
+
+/* Tries the largest number of primes first, since sexp_iterator_assoc
+   ignores unknown keys. */
+int
+rsa_multi_keypair_from_sexp_alist(struct rsa_public_key *pub,
+				  struct rsa_multi_private_key *priv,
+				  unsigned limit,
+				  struct sexp_iterator *i)
+{
+  static const char * const names[8 + 3*(RSA_MAX_PRIMES - 2)]
+    = { "n", "e", "d", "p", "q", "a", "b", "c",
+	"r3", "d3", "t3", "r4", "d4", "t4" };
+  struct sexp_iterator values[8 + 3*(RSA_MAX_PRIMES - 2)];
+  struct sexp_iterator j;
+  unsigned count;
+  unsigned k;
+
+  if (!priv)
+    return rsa_keypair_from_sexp_alist(pub, NULL, limit, i);
+
+  for (count = RSA_MAX_PRIMES - 2; ; count--)
+    {
+      j = *i;
+      if (sexp_iterator_assoc(&j, 8 + 3*count, names, values))
+	break;
+      if (!count)
+	return 0;
+    }
+  *i = j;
+
+  GET(priv->d, limit, &values[2]);
+  GET(priv->p, limit, &values[3]);
+  GET(priv->q, limit, &values[4]);
+  GET(priv->a, limit, &values[5]);
+  GET(priv->b, limit, &values[6]);
+  GET(priv->c, limit, &values[7]);
+
+  for (k = 0; k < count; k++)
+    {
+      GET(priv->other[k].r, limit, &values[8 + 3*k]);
+      GET(priv->other[k].d, limit, &values[9 + 3*k]);
+      GET(priv->other[k].t, limit, &values[10 + 3*k]);
+    }
+  priv->count = count;
+
+  if (!rsa_multi_private_key_prepare(priv))
+    return 0;
+
+  if (pub)
+    {
+      GET(pub->n, limit, &values[0]);
+      GET(pub->e, limit, &values[1]);
+
+      if (!rsa_public_key_prepare(pub))
+	return 0;
+
+      /* Catches some incomplete sets of primes. */
+      if (pub->size != priv->size)
+	return 0;
+    }
+
+  return 1;
+}
+
+int
+rsa_multi_keypair_from_sexp(struct rsa_public_key *pub,
+			    struct rsa_multi_private_key *priv,
+			    unsigned limit,
+			    size_t length, const uint8_t *expr)
+{
+  struct sexp_iterator i;
+  static const char * const names[3]
+    = { "rsa", "rsa-pkcs1", "rsa-pkcs1-sha1" };
+
+  if (!sexp_iterator_first(&i, length, expr))
+    return 0;
+
+  if (!sexp_iterator_check_type(&i, priv ? "private-key" : "public-key"))
+    return 0;
+
+  if (!sexp_iterator_check_types(&i, 3, names))
+    return 0;
+
+  return rsa_multi_keypair_from_sexp_alist(pub, priv, limit, &i);
+}
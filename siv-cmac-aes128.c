@@ -74,3 +74,17 @@ siv_cmac_aes128_decrypt_message(const struct siv_cmac_aes128_ctx *ctx,
 				  nlength, nonce, alength, adata,
 				  mlength, dst, src);
 }
+
+void
+siv_cmac_aes128_encrypt_messages(const struct siv_cmac_aes128_ctx *ctx,
+				 size_t count,
+				 const size_t *nlengths, const uint8_t * const *nonces,
+				 const size_t *alengths, const uint8_t * const *adata,
+				 const size_t *clengths,
+				 uint8_t * const *dst, const uint8_t * const *src)
+{
+  siv_cmac_encrypt_messages(&ctx->cmac_key, &ctx->cmac_cipher,
+			    &nettle_aes128, &ctx->ctr_cipher,
+			    count, nlengths, nonces, alengths, adata,
+			    clengths, dst, src);
+}
@@ -49,32 +49,46 @@
 
 /* This is an implementation of S2V for the AEAD case where
  * vectors if zero, are considered as S empty components */
+
+/* The CMAC of the zero block depends only on the key. Returns
+   D = dbl(CMAC(0)). */
 static void
-_siv_s2v (const struct nettle_cipher *nc,
-	  const struct cmac128_key *cmac_key,
-	  const void *cmac_cipher,
-	  size_t alength, const uint8_t * adata,
-	  size_t nlength, const uint8_t * nonce,
-	  size_t plength, const uint8_t * pdata, uint8_t * v)
+_siv_s2v_init (const struct nettle_cipher *nc,
+	       const struct cmac128_key *cmac_key,
+	       const void *cmac_cipher,
+	       union nettle_block16 *D)
 {
-  union nettle_block16 D, S, T;
   static const union nettle_block16 const_zero = {.b = 0 };
-  struct cmac128_ctx cmac_ctx;
-  assert (nlength >= SIV_MIN_NONCE_SIZE);
 
-  cmac128_init(&cmac_ctx);
-  cmac128_update (&cmac_ctx, cmac_cipher, nc->encrypt, 16, const_zero.b);
-  cmac128_digest (&cmac_ctx, cmac_key, cmac_cipher, nc->encrypt, 16, D.b);
+  cmac128_digest_message (cmac_key, cmac_cipher, nc->encrypt,
+			  16, const_zero.b, 16, D->b);
+  block16_mulx_be (D, D);
+}
 
-  block16_mulx_be (&D, &D);
-  cmac128_update (&cmac_ctx, cmac_cipher, nc->encrypt, alength, adata);
-  cmac128_digest (&cmac_ctx, cmac_key, cmac_cipher, nc->encrypt, 16, S.b);
-  block16_xor (&D, &S);
+/* Folds in the CMACs of the associated data and the nonce, S_ad and
+   S_nonce, into D. */
+static void
+_siv_s2v_ad (union nettle_block16 *D,
+	     const union nettle_block16 *S_ad,
+	     const union nettle_block16 *S_nonce)
+{
+  block16_xor (D, S_ad);
+  block16_mulx_be (D, D);
+  block16_xor (D, S_nonce);
+}
 
-  block16_mulx_be (&D, &D);
-  cmac128_update (&cmac_ctx, cmac_cipher, nc->encrypt, nlength, nonce);
-  cmac128_digest (&cmac_ctx, cmac_key, cmac_cipher, nc->encrypt, 16, S.b);
-  block16_xor (&D, &S);
+/* The final CMAC, of the plaintext combined with D. */
+static void
+_siv_s2v_final (const struct nettle_cipher *nc,
+		const struct cmac128_key *cmac_key,
+		const void *cmac_cipher,
+		const union nettle_block16 *D,
+		size_t plength, const uint8_t * pdata, uint8_t * v)
+{
+  union nettle_block16 T;
+  struct cmac128_ctx cmac_ctx;
+
+  cmac128_init(&cmac_ctx);
 
   /* Sn */
   if (plength >= 16)
@@ -83,13 +97,13 @@ _siv_s2v (const struct nettle_cipher *nc,
 
       pdata += plength - 16;
 
-      block16_xor_bytes (&T, &D, pdata);
+      block16_xor_bytes (&T, D, pdata);
     }
   else
     {
       union nettle_block16 pad;
 
-      block16_mulx_be (&T, &D);
+      block16_mulx_be (&T, D);
       memcpy (pad.b, pdata, plength);
       pad.b[plength] = 0x80;
       if (plength + 1 < 16)
@@ -102,6 +116,35 @@ _siv_s2v (const struct nettle_cipher *nc,
   cmac128_digest (&cmac_ctx, cmac_key, cmac_cipher, nc->encrypt, 16, v);
 }
 
+/* The CMACs of the zero block, the associated data and the nonce are
+   independent, and computed together. */
+static void
+_siv_s2v (const struct nettle_cipher *nc,
+	  const struct cmac128_key *cmac_key,
+	  const void *cmac_cipher,
+	  size_t alength, const uint8_t * adata,
+	  size_t nlength, const uint8_t * nonce,
+	  size_t plength, const uint8_t * pdata, uint8_t * v)
+{
+  static const union nettle_block16 const_zero = {.b = 0 };
+  union nettle_block16 S[3];
+  const size_t lengths[3] = { 16, alength, nlength };
+  const uint8_t *msgs[3];
+  uint8_t *digests[3];
+
+  assert (nlength >= SIV_MIN_NONCE_SIZE);
+
+  msgs[0] = const_zero.b; msgs[1] = adata; msgs[2] = nonce;
+  digests[0] = S[0].b; digests[1] = S[1].b; digests[2] = S[2].b;
+
+  cmac128_digest_messages (cmac_key, cmac_cipher, nc->encrypt,
+			   3, lengths, msgs, 16, digests);
+
+  block16_mulx_be (&S[0], &S[0]);
+  _siv_s2v_ad (&S[0], &S[1], &S[2]);
+  _siv_s2v_final (nc, cmac_key, cmac_cipher, &S[0], plength, pdata, v);
+}
+
 void
 siv_cmac_set_key (struct cmac128_key *cmac_key, void *cmac_cipher, void *siv_cipher,
 		  const struct nettle_cipher *nc, const uint8_t * key)
@@ -163,3 +206,74 @@ siv_cmac_decrypt_message (const struct cmac128_key *cmac_key,
 
   return memeql_sec (siv.b, src, SIV_DIGEST_SIZE);
 }
+
+/* Maximum number of messages for which the associated data and nonce
+   CMACs are computed together, two for each message. */
+#define SIV_MAX_MESSAGES 8
+
+void
+siv_cmac_encrypt_messages (const struct cmac128_key *cmac_key,
+			   const void *cmac_cipher,
+			   const struct nettle_cipher *nc,
+			   const void *ctr_cipher,
+			   size_t count,
+			   const size_t *nlengths, const uint8_t * const *nonces,
+			   const size_t *alengths, const uint8_t * const *adata,
+			   const size_t *clengths,
+			   uint8_t * const *dst, const uint8_t * const *src)
+{
+  union nettle_block16 D0;
+  union nettle_block16 S[2*SIV_MAX_MESSAGES];
+  size_t lengths[2*SIV_MAX_MESSAGES];
+  const uint8_t *msgs[2*SIV_MAX_MESSAGES];
+  uint8_t *digests[2*SIV_MAX_MESSAGES];
+
+  if (!count)
+    return;
+
+  _siv_s2v_init (nc, cmac_key, cmac_cipher, &D0);
+
+  while (count > 0)
+    {
+      size_t n = count < SIV_MAX_MESSAGES ? count : SIV_MAX_MESSAGES;
+      size_t i;
+
+      for (i = 0; i < n; i++)
+	{
+	  assert (nlengths[i] >= SIV_MIN_NONCE_SIZE);
+	  assert (clengths[i] >= SIV_DIGEST_SIZE);
+
+	  lengths[2*i] = alengths[i];
+	  msgs[2*i] = adata[i];
+	  digests[2*i] = S[2*i].b;
+	  lengths[2*i+1] = nlengths[i];
+	  msgs[2*i+1] = nonces[i];
+	  digests[2*i+1] = S[2*i+1].b;
+	}
+      cmac128_digest_messages (cmac_key, cmac_cipher, nc->encrypt,
+			       2*n, lengths, msgs, 16, digests);
+
+      for (i = 0; i < n; i++)
+	{
+	  union nettle_block16 D = D0;
+	  union nettle_block16 siv;
+	  size_t slength = clengths[i] - SIV_DIGEST_SIZE;
+
+	  _siv_s2v_ad (&D, &S[2*i], &S[2*i+1]);
+	  _siv_s2v_final (nc, cmac_key, cmac_cipher, &D,
+			  slength, src[i], siv.b);
+
+	  memcpy (dst[i], siv.b, SIV_DIGEST_SIZE);
+	  siv.b[8] &= ~0x80;
+	  siv.b[12] &= ~0x80;
+
+	  ctr_crypt (ctr_cipher, nc->encrypt, AES_BLOCK_SIZE, siv.b, slength,
+		     dst[i] + SIV_DIGEST_SIZE, src[i]);
+	}
+
+      count -= n;
+      nlengths += n; nonces += n;
+      alengths += n; adata += n;
+      clengths += n; dst += n; src += n;
+    }
+}
@@ -47,12 +47,15 @@ extern "C" {
 #define siv_cmac_set_key nettle_siv_cmac_set_key
 #define siv_cmac_encrypt_message nettle_siv_cmac_encrypt_message
 #define siv_cmac_decrypt_message nettle_siv_cmac_decrypt_message
+#define siv_cmac_encrypt_messages nettle_siv_cmac_encrypt_messages
 #define siv_cmac_aes128_set_key nettle_siv_cmac_aes128_set_key
 #define siv_cmac_aes128_encrypt_message nettle_siv_cmac_aes128_encrypt_message
 #define siv_cmac_aes128_decrypt_message nettle_siv_cmac_aes128_decrypt_message
+#define siv_cmac_aes128_encrypt_messages nettle_siv_cmac_aes128_encrypt_messages
 #define siv_cmac_aes256_set_key nettle_siv_cmac_aes256_set_key
 #define siv_cmac_aes256_encrypt_message nettle_siv_cmac_aes256_encrypt_message
 #define siv_cmac_aes256_decrypt_message nettle_siv_cmac_aes256_decrypt_message
+#define siv_cmac_aes256_encrypt_messages nettle_siv_cmac_aes256_encrypt_messages
 
 /* For SIV, the block size of the underlying cipher shall be 128 bits. */
 #define SIV_BLOCK_SIZE  16
@@ -80,6 +83,19 @@ siv_cmac_decrypt_message(const struct cmac128_key *cmac_key, const void *cmac_ci
 			 size_t alength, const uint8_t *adata,
 			 size_t mlength, uint8_t *dst, const uint8_t *src);
 
+/* Encrypts count messages with the same key, as
+ * siv_cmac_encrypt_message, with the CMACs of the associated data and
+ * nonces of several messages computed together. */
+void
+siv_cmac_encrypt_messages(const struct cmac128_key *cmac_key, const void *cmac_cipher,
+			  const struct nettle_cipher *nc,
+			  const void *ctr_cipher,
+			  size_t count,
+			  const size_t *nlengths, const uint8_t * const *nonces,
+			  const size_t *alengths, const uint8_t * const *adata,
+			  const size_t *clengths,
+			  uint8_t * const *dst, const uint8_t * const *src);
+
 /*
  * SIV mode requires the aad and plaintext when building the IV, which
  * prevents streaming processing and it incompatible with the AEAD API.
@@ -107,6 +123,14 @@ siv_cmac_aes128_decrypt_message(const struct siv_cmac_aes128_ctx *ctx,
 				size_t alength, const uint8_t *adata,
 				size_t mlength, uint8_t *dst, const uint8_t *src);
 
+void
+siv_cmac_aes128_encrypt_messages(const struct siv_cmac_aes128_ctx *ctx,
+				 size_t count,
+				 const size_t *nlengths, const uint8_t * const *nonces,
+				 const size_t *alengths, const uint8_t * const *adata,
+				 const size_t *clengths,
+				 uint8_t * const *dst, const uint8_t * const *src);
+
 /* SIV_CMAC_AES256 */
 #define SIV_CMAC_AES256_KEY_SIZE 64
 
@@ -127,6 +151,14 @@ siv_cmac_aes256_decrypt_message(const struct siv_cmac_aes256_ctx *ctx,
 				size_t alength, const uint8_t *adata,
 				size_t mlength, uint8_t *dst, const uint8_t *src);
 
+void
+siv_cmac_aes256_encrypt_messages(const struct siv_cmac_aes256_ctx *ctx,
+				 size_t count,
+				 const size_t *nlengths, const uint8_t * const *nonces,
+				 const size_t *alengths, const uint8_t * const *adata,
+				 const size_t *clengths,
+				 uint8_t * const *dst, const uint8_t * const *src);
+
 #ifdef __cplusplus
 }
 #endif
@@ -64,6 +64,77 @@ test_cbc_bulk(void)
   ASSERT (MEMEQ(CBC_BULK_DATA, clear, cipher));
 }
 
+#define CBC_STREAMS 40
+#define CBC_STREAM_BLOCKS 5
+
+/* Check that cbc_encrypt_streams gives the same result as separate
+ * cbc_encrypt calls, also for more streams than fit in one group,
+ * and in place. */
+static void
+test_cbc_streams(void)
+{
+  struct knuth_lfib_ctx random;
+  struct aes128_ctx aes;
+  uint8_t key[AES128_KEY_SIZE];
+  uint8_t clear[CBC_STREAMS][CBC_STREAM_BLOCKS * AES_BLOCK_SIZE];
+  uint8_t cipher[CBC_STREAMS][CBC_STREAM_BLOCKS * AES_BLOCK_SIZE];
+  uint8_t ref[CBC_STREAMS][CBC_STREAM_BLOCKS * AES_BLOCK_SIZE];
+  uint8_t start_iv[CBC_STREAMS][AES_BLOCK_SIZE];
+  uint8_t iv[CBC_STREAMS][AES_BLOCK_SIZE];
+  uint8_t ref_iv[CBC_STREAMS][AES_BLOCK_SIZE];
+  uint8_t *ivs[CBC_STREAMS];
+  uint8_t *dst[CBC_STREAMS];
+  const uint8_t *src[CBC_STREAMS];
+  size_t streams, blocks, i;
+
+  knuth_lfib_init(&random, 17);
+  knuth_lfib_random(&random, sizeof(key), key);
+  knuth_lfib_random(&random, sizeof(clear), clear[0]);
+  knuth_lfib_random(&random, sizeof(start_iv), start_iv[0]);
+
+  aes128_set_encrypt_key(&aes, key);
+
+  for (i = 0; i < CBC_STREAMS; i++)
+    ivs[i] = iv[i];
+
+  for (streams = 1; streams <= CBC_STREAMS; streams += 13)
+    for (blocks = 0; blocks <= CBC_STREAM_BLOCKS; blocks++)
+      {
+	size_t length = blocks * AES_BLOCK_SIZE;
+
+	for (i = 0; i < streams; i++)
+	  {
+	    memcpy(ref_iv[i], start_iv[i], AES_BLOCK_SIZE);
+	    cbc_encrypt(&aes, (nettle_cipher_func *) aes128_encrypt,
+			AES_BLOCK_SIZE, ref_iv[i], length, ref[i], clear[i]);
+
+	    memcpy(iv[i], start_iv[i], AES_BLOCK_SIZE);
+	    dst[i] = cipher[i];
+	    src[i] = clear[i];
+	  }
+	cbc_encrypt_streams(&aes, (nettle_cipher_func *) aes128_encrypt,
+			    AES_BLOCK_SIZE, streams, ivs, length, dst, src);
+
+	for (i = 0; i < streams; i++)
+	  ASSERT(MEMEQ(length, cipher[i], ref[i]));
+	ASSERT(MEMEQ(streams * AES_BLOCK_SIZE, iv, ref_iv));
+
+	/* In place */
+	memcpy(cipher, clear, streams * sizeof(cipher[0]));
+	for (i = 0; i < streams; i++)
+	  {
+	    memcpy(iv[i], start_iv[i], AES_BLOCK_SIZE);
+	    src[i] = cipher[i];
+	  }
+	cbc_encrypt_streams(&aes, (nettle_cipher_func *) aes128_encrypt,
+			    AES_BLOCK_SIZE, streams, ivs, length, dst, src);
+
+	for (i = 0; i < streams; i++)
+	  ASSERT(MEMEQ(length, cipher[i], ref[i]));
+	ASSERT(MEMEQ(streams * AES_BLOCK_SIZE, iv, ref_iv));
+      }
+}
+
 void
 test_main(void)
 {
@@ -162,6 +233,7 @@ test_main(void)
 		  SHEX("000102030405060708090a0b0c0d0e0f"));
 
   test_cbc_bulk();
+  test_cbc_streams();
 }
 
 /*
@@ -43,7 +43,10 @@
 #include "testutils.h"
 #include "aes.h"
 #include "ccm.h"
+#include "cbc.h"
+#include "ctr.h"
 #include "knuth-lfib.h"
+#include "memxor.h"
 
 static void
 test_compare_results(const char *name,
@@ -248,6 +251,133 @@ test_cipher_ccm(const struct nettle_cipher *cipher,
   free(de_data);
 }
 
+/* Straightforward CCM, using cbc_encrypt for the CBC-MAC and
+ * ctr_crypt for the encryption, for adata shorter than 0xff00 bytes. */
+static void
+ccm_reference_encrypt(const struct aes128_ctx *aes,
+		      size_t nlength, const uint8_t *nonce,
+		      size_t alength, const uint8_t *adata,
+		      size_t tlength, size_t mlength,
+		      uint8_t *dst, const uint8_t *src)
+{
+  uint8_t *mac_input = xalloc(3 * CCM_BLOCK_SIZE + alength + mlength);
+  uint8_t iv[CCM_BLOCK_SIZE];
+  uint8_t ctr[CCM_BLOCK_SIZE];
+  uint8_t s0[CCM_BLOCK_SIZE];
+  size_t L = CCM_BLOCK_SIZE - 1 - nlength;
+  size_t length, i;
+
+  ASSERT(alength < 0xff00);
+
+  /* B0 */
+  mac_input[0] = (alength ? 0x40 : 0) | (((tlength - 2) / 2) << 3) | (L - 1);
+  memcpy(mac_input + 1, nonce, nlength);
+  for (i = 0; i < L; i++)
+    mac_input[CCM_BLOCK_SIZE - 1 - i] = (mlength >> (8*i)) & 0xff;
+  length = CCM_BLOCK_SIZE;
+  if (alength)
+    {
+      mac_input[length++] = alength >> 8;
+      mac_input[length++] = alength & 0xff;
+      memcpy(mac_input + length, adata, alength);
+      length += alength;
+      for (; length % CCM_BLOCK_SIZE; length++)
+	mac_input[length] = 0;
+    }
+  memcpy(mac_input + length, src, mlength);
+  length += mlength;
+  for (; length % CCM_BLOCK_SIZE; length++)
+    mac_input[length] = 0;
+
+  memset(iv, 0, sizeof(iv));
+  cbc_encrypt(aes, (nettle_cipher_func *) aes128_encrypt, CCM_BLOCK_SIZE,
+	      iv, length, mac_input, mac_input);
+
+  /* A0 */
+  memset(ctr, 0, sizeof(ctr));
+  ctr[0] = L - 1;
+  memcpy(ctr + 1, nonce, nlength);
+  aes128_encrypt(aes, CCM_BLOCK_SIZE, s0, ctr);
+  ctr[CCM_BLOCK_SIZE - 1] = 1;
+  ctr_crypt(aes, (nettle_cipher_func *) aes128_encrypt, CCM_BLOCK_SIZE,
+	    ctr, mlength, dst, src);
+  memxor3(dst + mlength, iv, s0, tlength);
+
+  free(mac_input);
+}
+
+/* Compare to the reference, for messages of many blocks, also in
+ * place, and split into several calls. */
+static void
+test_ccm_long(void)
+{
+  struct knuth_lfib_ctx random;
+  struct aes128_ctx aes;
+  struct ccm_ctx ccm;
+  uint8_t key[AES128_KEY_SIZE];
+  uint8_t nonce[CCM_MAX_NONCE_SIZE];
+  uint8_t adata[40];
+  uint8_t clear[200];
+  uint8_t ref[200 + CCM_BLOCK_SIZE];
+  uint8_t data[200 + CCM_BLOCK_SIZE];
+  size_t mlength, alength, split;
+
+  knuth_lfib_init(&random, 4711);
+  knuth_lfib_random(&random, sizeof(key), key);
+  knuth_lfib_random(&random, sizeof(nonce), nonce);
+  knuth_lfib_random(&random, sizeof(adata), adata);
+  knuth_lfib_random(&random, sizeof(clear), clear);
+
+  aes128_set_encrypt_key(&aes, key);
+
+  for (mlength = 0; mlength <= sizeof(clear); mlength += 7)
+    for (alength = 0; alength <= sizeof(adata); alength += 13)
+      {
+	size_t clength = mlength + CCM_BLOCK_SIZE;
+
+	ccm_reference_encrypt(&aes, 12, nonce, alength, adata,
+			      CCM_BLOCK_SIZE, mlength, ref, clear);
+
+	memcpy(data, clear, mlength);
+	ccm_encrypt_message(&aes, (nettle_cipher_func *) aes128_encrypt,
+			    12, nonce, alength, adata, CCM_BLOCK_SIZE,
+			    clength, data, data);
+	ASSERT(MEMEQ(clength, data, ref));
+
+	ASSERT(ccm_decrypt_message(&aes, (nettle_cipher_func *) aes128_encrypt,
+				   12, nonce, alength, adata, CCM_BLOCK_SIZE,
+				   mlength, data, data));
+	ASSERT(MEMEQ(mlength, data, clear));
+
+	/* Several calls, all but the last a multiple of the block size. */
+	split = mlength / 2 - (mlength / 2) % CCM_BLOCK_SIZE;
+	ccm_set_nonce(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		      12, nonce, alength, mlength, CCM_BLOCK_SIZE);
+	ccm_update(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		   alength, adata);
+	ccm_encrypt(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		    split, data, clear);
+	ccm_encrypt(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		    mlength - split, data + split, clear + split);
+	ccm_digest(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		   CCM_BLOCK_SIZE, data + mlength);
+	ASSERT(MEMEQ(clength, data, ref));
+
+	ccm_set_nonce(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		      12, nonce, alength, mlength, CCM_BLOCK_SIZE);
+	ccm_update(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		   alength, adata);
+	ccm_decrypt(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		    split, data, ref);
+	ccm_decrypt(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		    mlength - split, data + split, ref + split);
+	ccm_digest(&ccm, &aes, (nettle_cipher_func *) aes128_encrypt,
+		   CCM_BLOCK_SIZE, data + mlength);
+	ASSERT(MEMEQ(mlength, data, clear));
+	ASSERT(MEMEQ(CCM_BLOCK_SIZE, data + mlength, ref + mlength));
+      }
+}
+
 void
 test_main(void)
 {
@@ -725,4 +855,6 @@ test_main(void)
 		  SHEX("90ae61cf7baebd4cade494c54a29ae70269aec71"),
 		  SHEX("6c05313e45dc8ec10bea6c670bd94f31569386a6"
 		       "8f3829e8e76ee23c04f566189e63c686"));
+
+  test_ccm_long();
 }
@@ -36,6 +36,7 @@
 
 #include "chacha.h"
 #include "chacha-internal.h"
+#include "knuth-lfib.h"
 
 static void
 test_chacha(const struct tstring *key, const struct tstring *nonce,
@@ -117,6 +118,57 @@ test_chacha(const struct tstring *key, const struct tstring *nonce,
     }
 }
 
+/* Compares chacha_crypt on long messages, which may use several
+   blocks at a time, to processing one block per call. */
+static void
+test_chacha_long(uint32_t counter)
+{
+  struct chacha_ctx ctx, ref;
+  struct knuth_lfib_ctx rand;
+  uint8_t *src, *dst, *expected;
+  size_t length, max_length = 20 * CHACHA_BLOCK_SIZE;
+  size_t i;
+
+  knuth_lfib_init (&rand, counter);
+  src = xalloc (max_length);
+  dst = xalloc (max_length + 1);
+  expected = xalloc (max_length);
+
+  knuth_lfib_random (&rand, CHACHA_KEY_SIZE, src);
+  chacha_set_key (&ctx, src);
+  knuth_lfib_random (&rand, max_length, src);
+
+  for (length = 0; length <= max_length; length += 5)
+    {
+      chacha_set_nonce (&ctx, src);
+      ctx.state[12] = counter;
+      ref = ctx;
+
+      for (i = 0; i < length; i += CHACHA_BLOCK_SIZE)
+	chacha_crypt (&ref, length - i < CHACHA_BLOCK_SIZE
+		      ? length - i : CHACHA_BLOCK_SIZE,
+		      expected + i, src + i);
+
+      dst[length] = 17;
+      chacha_crypt (&ctx, length, dst, src);
+      ASSERT (dst[length] == 17);
+      if (!MEMEQ (length, dst, expected))
+	{
+	  printf ("Error, counter %lx, length %u, expected:\n",
+		  (unsigned long) counter, (unsigned) length);
+	  print_hex (length, expected);
+	  printf ("Got:\n");
+	  print_hex (length, dst);
+	  FAIL ();
+	}
+      ASSERT (ctx.state[12] == ref.state[12]);
+      ASSERT (ctx.state[13] == ref.state[13]);
+    }
+  free (src);
+  free (dst);
+  free (expected);
+}
+
 void
 test_main(void)
 {
@@ -644,4 +696,8 @@ test_main(void)
 		   "d2826446079faa09 14c2d705d98b02a2"
 		   "b5129cd1de164eb9 cbd083e8a2503c4e"),
 	      20);
+
+  test_chacha_long (0);
+  /* Counter carry in the middle of a multi-block call. */
+  test_chacha_long (0xfffffffa);
 }
@@ -1,6 +1,7 @@
 #include "testutils.h"
 #include "nettle-internal.h"
 #include "cmac.h"
+#include "knuth-lfib.h"
 
 const struct nettle_mac nettle_cmac_aes128 =
 {
@@ -95,6 +96,87 @@ const struct nettle_mac nettle_cmac_kuznyechik_64 =
 #define test_cmac_des3(key, msg, ref)					\
   test_mac(&nettle_cmac_des3, key, msg, ref)
 
+/* One-shot interface, with the RFC 4493 example 2 */
+static void
+test_cmac_digest_message(void)
+{
+  struct aes128_ctx aes;
+  struct cmac128_key key;
+  uint8_t digest[CMAC128_DIGEST_SIZE];
+
+  aes128_set_encrypt_key(&aes, H("2b7e151628aed2a6abf7158809cf4f3c"));
+  cmac128_set_key(&key, &aes, (nettle_cipher_func *) aes128_encrypt);
+  cmac128_digest_message(&key, &aes, (nettle_cipher_func *) aes128_encrypt,
+			 16, H("6bc1bee22e409f96e93d7e117393172a"),
+			 sizeof(digest), digest);
+  ASSERT(MEMEQ(sizeof(digest), digest,
+	       H("070a16b46b4d4144f79bdd9dd04a287c")));
+}
+
+typedef void
+digest_messages_func(const void *ctx, size_t count,
+		     const size_t *msg_lengths, const uint8_t * const *msgs,
+		     size_t length, uint8_t * const *digests);
+
+#define MAX_MESSAGES 40
+#define MAX_MESSAGE_LENGTH 100
+
+/* Compare the multi-message function to one message at a time, with
+   messages of different lengths, including empty and block aligned
+   ones. */
+static void
+test_cmac_messages(const struct nettle_mac *mac,
+		   digest_messages_func *digest_messages)
+{
+  struct knuth_lfib_ctx random;
+  void *ctx = xalloc(mac->context_size);
+  uint8_t *key = xalloc(mac->key_size);
+  uint8_t data[MAX_MESSAGES][MAX_MESSAGE_LENGTH];
+  uint8_t digest[MAX_MESSAGES][CMAC128_DIGEST_SIZE];
+  uint8_t ref[CMAC128_DIGEST_SIZE];
+  const uint8_t *msgs[MAX_MESSAGES];
+  uint8_t *digests[MAX_MESSAGES];
+  size_t lengths[MAX_MESSAGES];
+  size_t count, i;
+
+  knuth_lfib_init(&random, 11);
+  knuth_lfib_random(&random, mac->key_size, key);
+  knuth_lfib_random(&random, sizeof(data), data[0]);
+
+  for (i = 0; i < MAX_MESSAGES; i++)
+    {
+      lengths[i] = (i * 8) % MAX_MESSAGE_LENGTH + (i % 3 == 2);
+      msgs[i] = data[i];
+      digests[i] = digest[i];
+    }
+
+  mac->set_key(ctx, key);
+
+  for (count = 0; count <= MAX_MESSAGES; count += 7)
+    {
+      memset(digest, 0, sizeof(digest));
+      digest_messages(ctx, count, lengths, msgs, mac->digest_size, digests);
+
+      for (i = 0; i < count; i++)
+	{
+	  mac->update(ctx, lengths[i], msgs[i]);
+	  mac->digest(ctx, mac->digest_size, ref);
+	  if (!MEMEQ(mac->digest_size, digest[i], ref))
+	    {
+	      fprintf(stderr, "%s digest_messages failed, message %u of %u\n",
+		      mac->name, (unsigned) i, (unsigned) count);
+	      fprintf(stderr, "got: ");
+	      print_hex(mac->digest_size, digest[i]);
+	      fprintf(stderr, "exp: ");
+	      print_hex(mac->digest_size, ref);
+	      FAIL();
+	    }
+	}
+    }
+  free(ctx);
+  free(key);
+}
+
 void
 test_main(void)
 {
@@ -201,4 +283,20 @@ test_main(void)
 	   "112233445566778899aabbcceeff0a00"
 	   "2233445566778899aabbcceeff0a0011"),
       SHEX("336f4d296059fbe3"));
+
+  test_cmac_digest_message();
+  test_cmac_messages(&nettle_cmac_aes128,
+		     (digest_messages_func *) cmac_aes128_digest_messages);
+  test_cmac_messages(&nettle_cmac_aes256,
+		     (digest_messages_func *) cmac_aes256_digest_messages);
+  test_cmac_messages(&nettle_cmac_kuznyechik,
+		     (digest_messages_func *) cmac_kuznyechik_digest_messages);
+  test_cmac_messages(&nettle_cmac_kuznyechik_64,
+		     (digest_messages_func *) cmac_kuznyechik_digest_messages);
+  test_cmac_messages(&nettle_cmac_des3,
+		     (digest_messages_func *) cmac_des3_digest_messages);
+  test_cmac_messages(&nettle_cmac_magma,
+		     (digest_messages_func *) cmac_magma_digest_messages);
+  test_cmac_messages(&nettle_cmac_magma_32,
+		     (digest_messages_func *) cmac_magma_digest_messages);
 }
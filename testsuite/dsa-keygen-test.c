@@ -8,6 +8,101 @@ progress(void *ctx UNUSED, int c)
   fputc(c, stderr);
 }
 
+static void
+count_progress (void *ctx, int c)
+{
+  if (c == '.')
+    ++*(unsigned *) ctx;
+}
+
+static void
+reverse_executor (void *ctx UNUSED, size_t count,
+		  nettle_task_func *task, void *arg)
+{
+  while (count-- > 0)
+    task (arg, count);
+}
+
+static void
+test_parallel (unsigned p_bits, unsigned q_bits, unsigned width)
+{
+  struct dsa_params params, params2;
+  struct knuth_lfib_ctx lfib;
+  mpz_t pub, key;
+  unsigned tested = 0;
+
+  dsa_params_init (&params);
+  dsa_params_init (&params2);
+  mpz_init (pub);
+  mpz_init (key);
+
+  knuth_lfib_init (&lfib, 17);
+  ASSERT (dsa_generate_params_parallel (&params, &lfib,
+					(nettle_random_func *) knuth_lfib_random,
+					&tested, count_progress,
+					NULL, NULL, width, p_bits, q_bits));
+  ASSERT (tested > 0);
+
+  /* Same result when the candidates are tested by an executor. */
+  knuth_lfib_init (&lfib, 17);
+  ASSERT (dsa_generate_params_parallel (&params2, &lfib,
+					(nettle_random_func *) knuth_lfib_random,
+					NULL, NULL,
+					NULL, reverse_executor, width,
+					p_bits, q_bits));
+  ASSERT (mpz_cmp (params.p, params2.p) == 0);
+  ASSERT (mpz_cmp (params.q, params2.q) == 0);
+  ASSERT (mpz_cmp (params.g, params2.g) == 0);
+
+  dsa_generate_keypair (&params, pub, key,
+			&lfib, (nettle_random_func *) knuth_lfib_random);
+  test_dsa_key (&params, pub, key, q_bits);
+
+  dsa_params_clear (&params);
+  dsa_params_clear (&params2);
+  mpz_clear (pub);
+  mpz_clear (key);
+}
+
+static void
+test_seed (unsigned p_bits, unsigned q_bits)
+{
+  static const uint8_t seed[] = "dsa-keygen-test seed";
+  struct dsa_params params, params2;
+  struct knuth_lfib_ctx lfib;
+  mpz_t pub, key;
+
+  dsa_params_init (&params);
+  dsa_params_init (&params2);
+  mpz_init (pub);
+  mpz_init (key);
+
+  ASSERT (dsa_generate_params_seed (&params, sizeof (seed) - 1, seed,
+				    NULL, NULL, NULL, NULL, 4,
+				    p_bits, q_bits));
+  ASSERT (dsa_generate_params_seed (&params2, sizeof (seed) - 1, seed,
+				    NULL, NULL, NULL, reverse_executor, 4,
+				    p_bits, q_bits));
+  ASSERT (mpz_cmp (params.p, params2.p) == 0);
+  ASSERT (mpz_cmp (params.q, params2.q) == 0);
+  ASSERT (mpz_cmp (params.g, params2.g) == 0);
+
+  ASSERT (dsa_generate_params_seed (&params2, sizeof (seed) - 2, seed,
+				    NULL, NULL, NULL, NULL, 4,
+				    p_bits, q_bits));
+  ASSERT (mpz_cmp (params.q, params2.q) != 0);
+
+  knuth_lfib_init (&lfib, 19);
+  dsa_generate_keypair (&params, pub, key,
+			&lfib, (nettle_random_func *) knuth_lfib_random);
+  test_dsa_key (&params, pub, key, q_bits);
+
+  dsa_params_clear (&params);
+  dsa_params_clear (&params2);
+  mpz_clear (pub);
+  mpz_clear (key);
+}
+
 void
 test_main(void)
 {
@@ -63,6 +158,11 @@ test_main(void)
 			(nettle_random_func *) knuth_lfib_random);
   test_dsa_key(params, pub.y, key.x, 768);
   test_dsa256(&pub, &key, NULL);
+
+  test_parallel (1024, 160, 1);
+  test_parallel (1024, 160, 8);
+  test_parallel (1024, 768, 8);
+  test_seed (1024, 160);
   
   dsa_public_key_clear(&pub);
   dsa_private_key_clear(&key);
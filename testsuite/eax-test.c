@@ -1,5 +1,116 @@
 #include "testutils.h"
 #include "nettle-internal.h"
+#include "cmac.h"
+#include "ctr.h"
+#include "eax.h"
+#include "knuth-lfib.h"
+#include "memxor.h"
+
+/* OMAC^t(M) = CMAC(t || M), with t as a full block */
+static void
+omac_reference(const struct aes128_ctx *aes, const struct cmac128_key *key,
+	       unsigned t, size_t length, const uint8_t *data,
+	       uint8_t *digest)
+{
+  struct cmac128_ctx ctx;
+  uint8_t block[EAX_BLOCK_SIZE];
+
+  memset(block, 0, sizeof(block));
+  block[EAX_BLOCK_SIZE - 1] = t;
+
+  cmac128_init(&ctx);
+  cmac128_update(&ctx, aes, (nettle_cipher_func *) aes128_encrypt,
+		 EAX_BLOCK_SIZE, block);
+  cmac128_update(&ctx, aes, (nettle_cipher_func *) aes128_encrypt,
+		 length, data);
+  cmac128_digest(&ctx, key, aes, (nettle_cipher_func *) aes128_encrypt,
+		 EAX_BLOCK_SIZE, digest);
+}
+
+static void
+eax_reference_encrypt(const struct aes128_ctx *aes,
+		      size_t nlength, const uint8_t *nonce,
+		      size_t alength, const uint8_t *adata,
+		      size_t mlength, uint8_t *dst, const uint8_t *src)
+{
+  struct cmac128_key key;
+  uint8_t n[EAX_BLOCK_SIZE];
+  uint8_t h[EAX_BLOCK_SIZE];
+  uint8_t c[EAX_BLOCK_SIZE];
+
+  cmac128_set_key(&key, aes, (nettle_cipher_func *) aes128_encrypt);
+  omac_reference(aes, &key, 0, nlength, nonce, n);
+  omac_reference(aes, &key, 1, alength, adata, h);
+  memcpy(c, n, EAX_BLOCK_SIZE);
+  ctr_crypt(aes, (nettle_cipher_func *) aes128_encrypt, EAX_BLOCK_SIZE,
+	    c, mlength, dst, src);
+  omac_reference(aes, &key, 2, mlength, dst, c);
+
+  memxor3(dst + mlength, n, h, EAX_BLOCK_SIZE);
+  memxor(dst + mlength, c, EAX_BLOCK_SIZE);
+}
+
+/* Compare the one-shot functions to the reference, for messages of
+   many blocks, and nonces and associated data of different lengths. */
+static void
+test_eax_long(void)
+{
+  struct knuth_lfib_ctx random;
+  struct eax_aes128_ctx ctx;
+  uint8_t key[AES128_KEY_SIZE];
+  uint8_t nonce[40];
+  uint8_t adata[40];
+  uint8_t clear[200];
+  uint8_t ref[200 + EAX_DIGEST_SIZE];
+  uint8_t data[200 + EAX_DIGEST_SIZE];
+  size_t mlength, alength;
+
+  knuth_lfib_init(&random, 4711);
+  knuth_lfib_random(&random, sizeof(key), key);
+  knuth_lfib_random(&random, sizeof(nonce), nonce);
+  knuth_lfib_random(&random, sizeof(adata), adata);
+  knuth_lfib_random(&random, sizeof(clear), clear);
+
+  eax_aes128_set_key(&ctx, key);
+
+  for (mlength = 0; mlength <= sizeof(clear); mlength += 7)
+    for (alength = 0; alength <= sizeof(adata); alength += 8)
+      {
+	size_t nlength = sizeof(nonce) - alength;
+	size_t clength = mlength + EAX_DIGEST_SIZE;
+
+	eax_reference_encrypt(&ctx.cipher, nlength, nonce, alength, adata,
+			      mlength, ref, clear);
+
+	memcpy(data, clear, mlength);
+	eax_aes128_encrypt_message(&ctx, nlength, nonce, alength, adata,
+				   EAX_DIGEST_SIZE, clength, data, data);
+	ASSERT(MEMEQ(clength, data, ref));
+
+	ASSERT(eax_aes128_decrypt_message(&ctx, nlength, nonce,
+					  alength, adata, EAX_DIGEST_SIZE,
+					  mlength, data, data));
+	ASSERT(MEMEQ(mlength, data, clear));
+
+	eax_aes128_set_nonce(&ctx, nlength, nonce);
+	eax_aes128_update(&ctx, alength, adata);
+	eax_aes128_encrypt(&ctx, mlength, data, clear);
+	eax_aes128_digest(&ctx, EAX_DIGEST_SIZE, data + mlength);
+	ASSERT(MEMEQ(clength, data, ref));
+
+	eax_aes128_set_nonce(&ctx, nlength, nonce);
+	eax_aes128_update(&ctx, alength, adata);
+	eax_aes128_decrypt(&ctx, mlength, data, ref);
+	eax_aes128_digest(&ctx, EAX_DIGEST_SIZE, data + mlength);
+	ASSERT(MEMEQ(mlength, data, clear));
+	ASSERT(MEMEQ(EAX_DIGEST_SIZE, data + mlength, ref + mlength));
+
+	ref[0] ^= 1;
+	ASSERT(!eax_aes128_decrypt_message(&ctx, nlength, nonce,
+					   alength, adata, EAX_DIGEST_SIZE,
+					   mlength, data, ref));
+      }
+}
 
 void
 test_main(void)
@@ -85,4 +196,6 @@ test_main(void)
 	    SHEX("CB8920F87A6C75CFF39627B56E3ED197C552D295A7"),
 	    SHEX("22E7ADD93CFC6393C57EC0B3C17D6B44"),
 	    SHEX("CFC46AFC253B4652B1AF3795B124AB6E"));
+
+  test_eax_long();
 }
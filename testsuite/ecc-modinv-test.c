@@ -42,7 +42,7 @@ zero_p (const struct ecc_modulo *m, const mp_limb_t *xp)
 
 static void
 test_modulo (gmp_randstate_t rands, const char *name,
-	     const struct ecc_modulo *m)
+	     const struct ecc_modulo *m, ecc_mod_inv_func *invert)
 {
   mp_limb_t *a;
   mp_limb_t *ai;
@@ -61,10 +61,10 @@ test_modulo (gmp_randstate_t rands, const char *name,
   /* Check behaviour for zero input */
   mpn_zero (a, m->size);
   memset (ai, 17, m->size * sizeof(*ai));
-  m->invert (m, ai, a, scratch);
+  invert (m, ai, a, scratch);
   if (!zero_p (m, ai))
     {
-      fprintf (stderr, "%s->invert failed for zero input (bit size %u):\n",
+      fprintf (stderr, "%s failed for zero input (bit size %u):\n",
 	       name, m->bit_size);
       fprintf (stderr, "p = ");
       mpn_out_str (stderr, 16, m->m, m->size);
@@ -76,10 +76,10 @@ test_modulo (gmp_randstate_t rands, const char *name,
 	  
   /* Check behaviour for a = m */
   memset (ai, 17, m->size * sizeof(*ai));
-  m->invert (m, ai, m->m, scratch);
+  invert (m, ai, m->m, scratch);
   if (!zero_p (m, ai))
     {
-      fprintf (stderr, "%s->invert failed for a = p input (bit size %u):\n",
+      fprintf (stderr, "%s failed for a = p input (bit size %u):\n",
 	       name, m->bit_size);
       
       fprintf (stderr, "p = ");
@@ -106,10 +106,10 @@ test_modulo (gmp_randstate_t rands, const char *name,
 		     j, m->bit_size, name);
 	  continue;
 	}
-      m->invert (m, ai, a, scratch);
+      invert (m, ai, a, scratch);
       if (mpn_cmp (ref, ai, m->size))
 	{
-	  fprintf (stderr, "%s->invert failed (test %u, bit size %u):\n",
+	  fprintf (stderr, "%s failed (test %u, bit size %u):\n",
 		   name, j, m->bit_size);
 	  fprintf (stderr, "a = ");
 	  mpz_out_str (stderr, 16, r);
@@ -141,8 +141,14 @@ test_main (void)
 
   for (i = 0; ecc_curves[i]; i++)
     {
-      test_modulo (rands, "p", &ecc_curves[i]->p);
-      test_modulo (rands, "q", &ecc_curves[i]->q);
+      test_modulo (rands, "p->invert", &ecc_curves[i]->p,
+		   ecc_curves[i]->p.invert);
+      test_modulo (rands, "p->invert_vartime", &ecc_curves[i]->p,
+		   ecc_curves[i]->p.invert_vartime);
+      test_modulo (rands, "q->invert", &ecc_curves[i]->q,
+		   ecc_curves[i]->q.invert);
+      test_modulo (rands, "q->invert_vartime", &ecc_curves[i]->q,
+		   ecc_curves[i]->q.invert_vartime);
     }
   gmp_randclear (rands);
 }
@@ -0,0 +1,185 @@
+#include "testutils.h"
+
+static void
+random_scalar (mp_limb_t *np, mpz_t r, const struct ecc_curve *ecc,
+	       gmp_randstate_t rands)
+{
+  mp_size_t size = ecc_size (ecc);
+  mpz_t q;
+
+  mpz_urandomb (r, rands, size * GMP_NUMB_BITS);
+  mpz_mod (r, r, mpz_roinit_n (q, ecc->q.m, size));
+  mpz_limbs_copy (np, r, size);
+}
+
+/* Computes the expected result, (sum_i k_i a_i) g. */
+static void
+mul_reference (const struct ecc_curve *ecc, mp_limb_t *r, mpz_t s,
+	       mp_limb_t *scratch)
+{
+  mp_size_t size = ecc_size (ecc);
+  mp_limb_t *np = xalloc_limbs (size);
+  mp_limb_t *tp = xalloc_limbs (ecc_size_j (ecc));
+  mpz_t q;
+
+  mpz_mod (s, s, mpz_roinit_n (q, ecc->q.m, size));
+  if (mpz_sgn (s) == 0)
+    {
+      mpn_zero (r, 2*size);
+      if (ecc->p.bit_size == 255)
+	r[size] = 1;
+    }
+  else
+    {
+      mpz_limbs_copy (np, s, size);
+      ecc->mul_g (ecc, tp, np, scratch);
+      ecc->h_to_a (ecc, 0, r, tp, scratch);
+    }
+  free (np);
+  free (tp);
+}
+
+static void
+test_mul_multi (const struct ecc_curve *ecc, size_t count,
+		const mp_limb_t *np, const mp_limb_t *p,
+		const mp_limb_t *ref)
+{
+  mp_size_t size = ecc_size (ecc);
+  mp_limb_t *rp = xalloc_limbs (ecc_size_j (ecc));
+  mp_limb_t *scratch;
+  mp_size_t itch = ecc_mul_multi_itch (ecc, count);
+
+  if (itch < ecc->h_to_a_itch)
+    itch = ecc->h_to_a_itch;
+  scratch = xalloc_limbs (itch);
+
+  ecc_mul_multi (ecc, rp, count, np, p, scratch);
+  ecc->h_to_a (ecc, 0, rp, rp, scratch);
+
+  if (mpn_cmp (rp, ref, 2*size))
+    {
+      fprintf (stderr, "ecc_mul_multi failed, bits = %u, count = %u\n",
+	       ecc->p.bit_size, (unsigned) count);
+      fprintf (stderr, "r = ");
+      write_mpn (stderr, 16, rp, size);
+      fprintf (stderr, ",\n    ");
+      write_mpn (stderr, 16, rp + size, size);
+      fprintf (stderr, "\nref = ");
+      write_mpn (stderr, 16, ref, size);
+      fprintf (stderr, ",\n    ");
+      write_mpn (stderr, 16, ref + size, size);
+      fprintf (stderr, "\n");
+      abort ();
+    }
+  free (rp);
+  free (scratch);
+}
+
+static void
+test_curve (const struct ecc_curve *ecc, gmp_randstate_t rands)
+{
+  static const size_t counts[] = { 0, 1, 2, 3, 10, 50, 200 };
+  mp_size_t size = ecc_size (ecc);
+  size_t max_count = counts[sizeof(counts)/sizeof(counts[0]) - 1];
+  mp_limb_t *np = xalloc_limbs (max_count * size);
+  mp_limb_t *p = xalloc_limbs (max_count * 2*size);
+  mp_limb_t *ap = xalloc_limbs (size);
+  mp_limb_t *tp = xalloc_limbs (ecc_size_j (ecc));
+  mp_limb_t *ref = xalloc_limbs (2*size);
+  mp_limb_t *scratch = xalloc_limbs (ecc->mul_itch + ecc->mul_g_itch);
+  struct ecc_point r, pub[2];
+  struct ecc_scalar key[2];
+  mpz_t a, k, s;
+  size_t i, j;
+
+  mpz_init (a);
+  mpz_init (k);
+  mpz_init (s);
+
+  /* Points p_i = a_i g, with random a_i */
+  for (i = 0; i < max_count; i++)
+    {
+      do
+	random_scalar (ap, a, ecc, rands);
+      while (mpz_sgn (a) == 0);
+      ecc->mul_g (ecc, tp, ap, scratch);
+      ecc->h_to_a (ecc, 0, p + 2*i*size, tp, scratch);
+      random_scalar (np + i*size, k, ecc, rands);
+      mpz_addmul (s, a, k);
+
+      for (j = 0; j < sizeof(counts)/sizeof(counts[0]); j++)
+	if (counts[j] == i + 1)
+	  {
+	    mpz_set (k, s);
+	    mul_reference (ecc, ref, k, scratch);
+	    test_mul_multi (ecc, i + 1, np, p, ref);
+	  }
+    }
+
+  /* Zero points */
+  mpn_zero (ref, 2*size);
+  if (ecc->p.bit_size == 255)
+    ref[size] = 1;
+  test_mul_multi (ecc, 0, np, p, ref);
+
+  /* Equal points, with equal scalars, then with k_1 = -k_0. */
+  mpn_copyi (p + 2*size, p, 2*size);
+  mpn_copyi (np + size, np, size);
+  ecc->mul (ecc, tp, np, p, scratch);
+  ecc->h_to_a (ecc, 0, ref, tp, scratch);
+  mpn_zero (ap, size);
+  ap[0] = 2;
+  ecc->mul (ecc, tp, ap, ref, scratch);
+  ecc->h_to_a (ecc, 0, ref, tp, scratch);
+  test_mul_multi (ecc, 2, np, p, ref);
+
+  mpn_sub_n (np + size, ecc->q.m, np, size);
+  mpn_zero (ref, 2*size);
+  if (ecc->p.bit_size == 255)
+    ref[size] = 1;
+  test_mul_multi (ecc, 2, np, p, ref);
+
+  /* High-level interface, compared to ecc_mul_multi */
+  ecc_point_init (&r, ecc);
+  for (i = 0; i < 2; i++)
+    {
+      ecc_point_init (&pub[i], ecc);
+      ecc_scalar_init (&key[i], ecc);
+      mpn_copyi (pub[i].p, p + 2*(i+2)*size, 2*size);
+      mpn_copyi (key[i].p, np + (i+2)*size, size);
+    }
+  ecc_point_mul_multi (&r, 2, key, pub);
+
+  test_mul_multi (ecc, 2, np + 2*size, p + 4*size, r.p);
+
+  for (i = 0; i < 2; i++)
+    {
+      ecc_point_clear (&pub[i]);
+      ecc_scalar_clear (&key[i]);
+    }
+  ecc_point_clear (&r);
+
+  mpz_clear (a);
+  mpz_clear (k);
+  mpz_clear (s);
+  free (np);
+  free (p);
+  free (ap);
+  free (tp);
+  free (ref);
+  free (scratch);
+}
+
+void
+test_main (void)
+{
+  gmp_randstate_t rands;
+  unsigned i;
+
+  gmp_randinit_default (rands);
+
+  for (i = 0; ecc_curves[i]; i++)
+    test_curve (ecc_curves[i], rands);
+
+  gmp_randclear (rands);
+}
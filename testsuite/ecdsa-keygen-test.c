@@ -56,6 +56,45 @@ ecc_valid_p (struct ecc_point *pub)
   return res;
 }
 
+static void
+test_keypairs (const struct ecc_curve *ecc, size_t count,
+	       struct knuth_lfib_ctx *rctx)
+{
+  struct ecc_point *pub = xalloc (count * sizeof(*pub));
+  struct ecc_scalar *key = xalloc (count * sizeof(*key));
+  struct ecc_point ref;
+  size_t i;
+
+  for (i = 0; i < count; i++)
+    {
+      ecc_point_init (&pub[i], ecc);
+      ecc_scalar_init (&key[i], ecc);
+    }
+  ecc_point_init (&ref, ecc);
+
+  ecdsa_generate_keypairs (count, pub, key,
+			   rctx, (nettle_random_func *) knuth_lfib_random);
+
+  for (i = 0; i < count; i++)
+    {
+      if (!ecc_valid_p (&pub[i]))
+	die ("ecdsa_generate_keypairs produced an invalid point.\n");
+
+      ecc_point_mul_g (&ref, &key[i]);
+      if (mpn_cmp (ref.p, pub[i].p, 2*ecc->p.size) != 0)
+	die ("ecdsa_generate_keypairs produced an inconsistent key.\n");
+    }
+
+  for (i = 0; i < count; i++)
+    {
+      ecc_point_clear (&pub[i]);
+      ecc_scalar_clear (&key[i]);
+    }
+  ecc_point_clear (&ref);
+  free (pub);
+  free (key);
+}
+
 void
 test_main (void)
 {
@@ -129,6 +168,9 @@ test_main (void)
 
       ecc_point_clear (&pub);
       ecc_scalar_clear (&key);
+
+      test_keypairs (ecc, 1, &rctx);
+      test_keypairs (ecc, 7, &rctx);
     }
   dsa_signature_clear (&signature);
 }
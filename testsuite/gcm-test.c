@@ -4,6 +4,9 @@
 #include "testutils.h"
 #include "nettle-internal.h"
 #include "gcm.h"
+#include "knuth-lfib.h"
+#include "macros.h"
+#include "memxor.h"
 
 static void
 test_gcm_hash (const struct tstring *msg, const struct tstring *ref)
@@ -28,6 +31,137 @@ test_gcm_hash (const struct tstring *msg, const struct tstring *ref)
     }
 }
 
+/* Multiplication in GF(2^128), using the plain bitwise algorithm
+   from the specification. */
+static void
+ref_gf_mul (uint8_t *x, const uint8_t *h)
+{
+  uint8_t z[GCM_BLOCK_SIZE];
+  uint8_t v[GCM_BLOCK_SIZE];
+  unsigned i, j;
+
+  memset (z, 0, sizeof(z));
+  memcpy (v, h, sizeof(v));
+  for (i = 0; i < 128; i++)
+    {
+      uint8_t carry;
+      if (x[i/8] & (0x80 >> (i%8)))
+	memxor (z, v, sizeof(z));
+      carry = v[GCM_BLOCK_SIZE-1] & 1;
+      for (j = GCM_BLOCK_SIZE-1; j > 0; j--)
+	v[j] = (v[j] >> 1) | (v[j-1] << 7);
+      v[0] = (v[0] >> 1) ^ (carry ? 0xe1 : 0);
+    }
+  memcpy (x, z, sizeof(z));
+}
+
+static void
+ref_ghash (uint8_t *x, const uint8_t *h, size_t length, const uint8_t *data)
+{
+  for (; length > GCM_BLOCK_SIZE;
+       length -= GCM_BLOCK_SIZE, data += GCM_BLOCK_SIZE)
+    {
+      memxor (x, data, GCM_BLOCK_SIZE);
+      ref_gf_mul (x, h);
+    }
+  if (length > 0)
+    {
+      memxor (x, data, length);
+      ref_gf_mul (x, h);
+    }
+}
+
+/* Compares the tag to a reference computation, for messages long
+   enough to exercise the aggregated reduction in native gcm_hash
+   implementations, and the stitched aes-gcm functions. */
+static void
+test_gcm_long (const struct nettle_aead *aead,
+	       const struct nettle_cipher *cipher)
+{
+  struct knuth_lfib_ctx rand;
+  void *ctx = xalloc (aead->context_size);
+  void *cipher_ctx = xalloc (cipher->context_size);
+  uint8_t key[AES256_KEY_SIZE];
+  uint8_t iv[GCM_IV_SIZE];
+  uint8_t h[GCM_BLOCK_SIZE];
+  uint8_t x[GCM_BLOCK_SIZE];
+  uint8_t block[GCM_BLOCK_SIZE];
+  uint8_t digest[GCM_DIGEST_SIZE];
+  uint8_t data[400];
+  uint8_t ct[sizeof(data)];
+  uint8_t pt[sizeof(data)];
+  size_t length;
+
+  ASSERT (cipher->key_size <= sizeof(key));
+  knuth_lfib_init (&rand, 4711);
+  for (length = 0; length <= sizeof(data); length++)
+    {
+      size_t split = length / 32 * GCM_BLOCK_SIZE;
+      int encrypt = length & 1;
+
+      knuth_lfib_random (&rand, cipher->key_size, key);
+      knuth_lfib_random (&rand, sizeof(iv), iv);
+      knuth_lfib_random (&rand, length, data);
+
+      aead->set_encrypt_key (ctx, key);
+      aead->set_nonce (ctx, iv);
+      if (encrypt)
+	{
+	  aead->encrypt (ctx, split, ct, data);
+	  aead->encrypt (ctx, length - split, ct + split, data + split);
+	}
+      else
+	{
+	  aead->update (ctx, split, data);
+	  aead->update (ctx, length - split, data + split);
+	}
+      aead->digest (ctx, sizeof(digest), digest);
+
+      cipher->set_encrypt_key (cipher_ctx, key);
+      memset (h, 0, sizeof(h));
+      cipher->encrypt (cipher_ctx, sizeof(h), h, h);
+
+      memset (x, 0, sizeof(x));
+      ref_ghash (x, h, length, encrypt ? ct : data);
+      memset (block, 0, sizeof(block));
+      WRITE_UINT64 (block + (encrypt ? 8 : 0), (uint64_t) length * 8);
+      ref_ghash (x, h, sizeof(block), block);
+
+      memcpy (block, iv, GCM_IV_SIZE);
+      WRITE_UINT32 (block + GCM_IV_SIZE, 1);
+      cipher->encrypt (cipher_ctx, sizeof(block), block, block);
+      memxor (x, block, sizeof(x));
+
+      if (!MEMEQ (sizeof(digest), digest, x))
+	{
+	  fprintf (stderr, "%s failed, length %u, %s\nOutput: ",
+		   aead->name, (unsigned) length,
+		   encrypt ? "encrypt" : "update");
+	  print_hex (sizeof(digest), digest);
+	  fprintf (stderr, "Expected:");
+	  print_hex (sizeof(x), x);
+	  fprintf (stderr, "\n");
+	  FAIL ();
+	}
+      if (encrypt)
+	{
+	  split = length / 3 & -GCM_BLOCK_SIZE;
+	  aead->set_nonce (ctx, iv);
+	  aead->decrypt (ctx, split, pt, ct);
+	  aead->decrypt (ctx, length - split, pt + split, ct + split);
+	  aead->digest (ctx, sizeof(digest), digest);
+	  if (!MEMEQ (length, pt, data) || !MEMEQ (sizeof(digest), digest, x))
+	    {
+	      fprintf (stderr, "%s decrypt failed, length %u\n",
+		       aead->name, (unsigned) length);
+	      FAIL ();
+	    }
+	}
+    }
+  free (ctx);
+  free (cipher_ctx);
+}
+
 static nettle_set_key_func gcm_unified_aes128_set_key;
 static nettle_set_key_func gcm_unified_aes128_set_iv;
 static void
@@ -555,5 +689,8 @@ test_main(void)
 		 SHEX("65f8245330febf15 6fd95e324304c258"));
   test_gcm_hash (SDATA("abcdefghijklmnopqr"),
 		 SHEX("d07259e85d4fc998 5a662eed41c8ed1d"));
+
+  test_gcm_long (&nettle_gcm_aes128, &nettle_aes128);
+  test_gcm_long (&nettle_gcm_aes256, &nettle_aes256);
 }
 
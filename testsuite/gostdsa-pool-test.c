@@ -0,0 +1,106 @@
+#include "testutils.h"
+#include "knuth-lfib.h"
+
+#define POOL_SIZE 5
+
+static int
+pool_entry_zero_p (const struct gostdsa_nonce_pool *pool, size_t i)
+{
+  mp_size_t size = 2 * pool->ecc->p.size;
+  return mpn_zero_p (pool->entries + i * size, size);
+}
+
+void
+test_main (void)
+{
+  unsigned i;
+  struct knuth_lfib_ctx rctx;
+  struct dsa_signature signature;
+
+  struct tstring *digest;
+
+  knuth_lfib_init (&rctx, 4711);
+  dsa_signature_init (&signature);
+
+  digest = SHEX (/* sha256("abc") */
+		 "BA7816BF 8F01CFEA 414140DE 5DAE2223"
+		 "B00361A3 96177A9C B410FF61 F20015AD");
+
+  for (i = 0; ecc_curves[i]; i++)
+    {
+      const struct ecc_curve *ecc = ecc_curves[i];
+      struct gostdsa_nonce_pool pool;
+      struct gostdsa_nonce_pool background;
+      struct ecc_point pub;
+      struct ecc_scalar key;
+      size_t j;
+
+      if (verbose)
+	fprintf (stderr, "Curve %d\n", ecc->p.bit_size);
+
+      ecc_point_init (&pub, ecc);
+      ecc_scalar_init (&key, ecc);
+
+      gostdsa_generate_keypair (&pub, &key,
+				&rctx,
+				(nettle_random_func *) knuth_lfib_random);
+
+      gostdsa_nonce_pool_init (&pool, ecc, POOL_SIZE);
+      gostdsa_nonce_pool_init (&background, ecc, POOL_SIZE);
+
+      if (gostdsa_sign_online (&key, &pool,
+			       digest->length, digest->data,
+			       &signature))
+	die ("gostdsa_sign_online succeeded with empty pool.\n");
+
+      ASSERT (gostdsa_nonce_pool_fill (&pool, &rctx,
+				       (nettle_random_func *) knuth_lfib_random,
+				       3) == 3);
+      ASSERT (pool.count == 3);
+      ASSERT (gostdsa_nonce_pool_fill (&background, &rctx,
+				       (nettle_random_func *) knuth_lfib_random,
+				       POOL_SIZE + 1) == POOL_SIZE);
+      ASSERT (background.count == POOL_SIZE);
+
+      /* Only two entries fit. */
+      ASSERT (gostdsa_nonce_pool_move (&pool, &background) == 2);
+      ASSERT (pool.count == POOL_SIZE);
+      ASSERT (background.count == POOL_SIZE - 2);
+      ASSERT (pool_entry_zero_p (&background, POOL_SIZE - 1));
+      ASSERT (pool_entry_zero_p (&background, POOL_SIZE - 2));
+      ASSERT (!pool_entry_zero_p (&background, POOL_SIZE - 3));
+
+      for (j = 0; j < POOL_SIZE; j++)
+	{
+	  if (!gostdsa_sign_online (&key, &pool,
+				    digest->length, digest->data,
+				    &signature))
+	    die ("gostdsa_sign_online failed.\n");
+
+	  if (!pool_entry_zero_p (&pool, pool.count))
+	    die ("gostdsa_sign_online didn't clear the used entry.\n");
+
+	  if (!gostdsa_verify (&pub, digest->length, digest->data,
+			       &signature))
+	    die ("gostdsa_verify failed.\n");
+
+	  digest->data[3] ^= 17;
+	  if (gostdsa_verify (&pub, digest->length, digest->data,
+			      &signature))
+	    die ("gostdsa_verify returned success with invalid digest.\n");
+	  digest->data[3] ^= 17;
+	}
+      ASSERT (pool.count == 0);
+
+      if (gostdsa_sign_online (&key, &pool,
+			       digest->length, digest->data,
+			       &signature))
+	die ("gostdsa_sign_online succeeded with empty pool.\n");
+
+      gostdsa_nonce_pool_clear (&pool);
+      gostdsa_nonce_pool_clear (&background);
+      ecc_point_clear (&pub);
+      ecc_scalar_clear (&key);
+    }
+  dsa_signature_clear (&signature);
+}
@@ -46,6 +46,32 @@ test_gostdsa (const struct ecc_curve *ecc,
       abort();
     }
 
+  /* Same signature, computed in two halves. */
+  mpn_zero (rp, ecc->p.size);
+  mpn_zero (sp, ecc->p.size);
+  ecc_gostdsa_sign_offline (ecc, mpz_limbs_read_n (k, ecc->p.size),
+			    rp, scratch);
+  ecc_gostdsa_sign_online (ecc, mpz_limbs_read_n (z, ecc->p.size),
+			   mpz_limbs_read_n (k, ecc->p.size), rp,
+			   h->length, h->data, sp, scratch);
+
+  if (mpz_limbs_cmp (ref.r, rp, ecc->p.size) != 0
+      || mpz_limbs_cmp (ref.s, sp, ecc->p.size) != 0)
+    {
+      fprintf (stderr, "_gostdsa_sign_offline/online failed, bit_size = %u\n",
+	       ecc->p.bit_size);
+      fprintf (stderr, "r     = ");
+      write_mpn (stderr, 16, rp, ecc->p.size);
+      fprintf (stderr, "\ns     = ");
+      write_mpn (stderr, 16, sp, ecc->p.size);
+      fprintf (stderr, "\nref.r = ");
+      mpz_out_str (stderr, 16, ref.r);
+      fprintf (stderr, "\nref.s = ");
+      mpz_out_str (stderr, 16, ref.s);
+      fprintf (stderr, "\n");
+      abort();
+    }
+
   free (rp);
   free (sp);
   free (scratch);
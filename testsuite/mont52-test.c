@@ -0,0 +1,170 @@
+#include "testutils.h"
+
+#include "mont52-internal.h"
+
+#define COUNT 200
+
+/* Gets the low 52 bits, also if unsigned long is only 32 bits. */
+static uint64_t
+get_digit (const mpz_t x)
+{
+  mpz_t t;
+  uint64_t d;
+
+  mpz_init (t);
+  mpz_tdiv_q_2exp (t, x, 26);
+  d = mpz_get_ui (t) & 0x3ffffff;
+  d = (d << 26) | (mpz_get_ui (x) & 0x3ffffff);
+  mpz_clear (t);
+
+  return d;
+}
+
+static void
+set_digits (uint64_t *xp, unsigned l, size_t size, const mpz_t x)
+{
+  mpz_t t;
+  size_t j;
+
+  mpz_init_set (t, x);
+  for (j = 0; j < size; j++)
+    {
+      xp[j * MONT52_LANES + l] = get_digit (t);
+      mpz_tdiv_q_2exp (t, t, MONT52_DIGIT_BITS);
+    }
+  ASSERT (mpz_sgn (t) == 0);
+  mpz_clear (t);
+}
+
+static void
+get_digits (mpz_t x, const uint64_t *xp, unsigned l, size_t size)
+{
+  size_t j;
+
+  mpz_set_ui (x, 0);
+  for (j = size; j-- > 0; )
+    {
+      uint64_t d = xp[j * MONT52_LANES + l];
+      ASSERT (d <= MONT52_DIGIT_MASK);
+      mpz_mul_2exp (x, x, 26);
+      mpz_add_ui (x, x, d >> 26);
+      mpz_mul_2exp (x, x, 26);
+      mpz_add_ui (x, x, d & 0x3ffffff);
+    }
+}
+
+static void
+test_size (gmp_randstate_t rands, size_t size)
+{
+  uint64_t a[MONT52_MAX_SIZE * MONT52_LANES];
+  uint64_t b[MONT52_MAX_SIZE * MONT52_LANES];
+  uint64_t m[MONT52_MAX_SIZE * MONT52_LANES];
+  uint64_t r[MONT52_MAX_SIZE * MONT52_LANES];
+  uint64_t minv[MONT52_LANES];
+  mpz_t ma[MONT52_LANES], mb[MONT52_LANES], mm[MONT52_LANES];
+  mpz_t t, w, ref;
+  unsigned i, l;
+
+  mpz_init (t);
+  mpz_init (w);
+  mpz_init (ref);
+  for (l = 0; l < MONT52_LANES; l++)
+    {
+      mpz_init (ma[l]);
+      mpz_init (mb[l]);
+      mpz_init (mm[l]);
+    }
+
+  for (i = 0; i < COUNT; i++)
+    {
+      for (l = 0; l < MONT52_LANES; l++)
+	{
+	  /* Random odd modulus, with 4 m < 2^(52 size), and a, b < 2m,
+	     occasionally the largest allowed values. */
+	  if (i & 1)
+	    mpz_rrandomb (mm[l], rands, size * MONT52_DIGIT_BITS - 2);
+	  else
+	    mpz_urandomb (mm[l], rands, size * MONT52_DIGIT_BITS - 2);
+	  mpz_setbit (mm[l], 0);
+
+	  mpz_mul_2exp (t, mm[l], 1);
+	  mpz_urandomb (ma[l], rands, size * MONT52_DIGIT_BITS);
+	  mpz_fdiv_r (ma[l], ma[l], t);
+	  if (i == 1)
+	    mpz_sub_ui (mb[l], t, 1);
+	  else
+	    {
+	      mpz_urandomb (mb[l], rands, size * MONT52_DIGIT_BITS);
+	      mpz_fdiv_r (mb[l], mb[l], t);
+	    }
+
+	  set_digits (a, l, size, ma[l]);
+	  set_digits (b, l, size, mb[l]);
+	  set_digits (m, l, size, mm[l]);
+
+	  mpz_set_ui (t, 0);
+	  mpz_setbit (t, MONT52_DIGIT_BITS);
+	  mpz_invert (w, mm[l], t);
+	  mpz_sub (w, t, w);
+	  minv[l] = get_digit (w);
+	}
+
+      _mont52_mul (r, a, b, m, minv, size);
+
+      for (l = 0; l < MONT52_LANES; l++)
+	{
+	  get_digits (t, r, l, size);
+
+	  mpz_set_ui (w, 0);
+	  mpz_setbit (w, size * MONT52_DIGIT_BITS);
+	  mpz_invert (w, w, mm[l]);
+	  mpz_mul (ref, ma[l], mb[l]);
+	  mpz_mul (ref, ref, w);
+	  mpz_sub (w, ref, t);
+
+	  mpz_mul_2exp (ref, mm[l], 1);
+	  if (mpz_cmp (t, ref) >= 0 || !mpz_divisible_p (w, mm[l]))
+	    {
+	      fprintf (stderr, "_mont52_mul failed: size = %u, lane = %u\n",
+		       (unsigned) size, l);
+	      fprintf (stderr, "a = ");
+	      mpz_out_str (stderr, 16, ma[l]);
+	      fprintf (stderr, "\nb = ");
+	      mpz_out_str (stderr, 16, mb[l]);
+	      fprintf (stderr, "\nm = ");
+	      mpz_out_str (stderr, 16, mm[l]);
+	      fprintf (stderr, "\nr = ");
+	      mpz_out_str (stderr, 16, t);
+	      fprintf (stderr, " (bad)\n");
+	      abort ();
+	    }
+	}
+    }
+
+  mpz_clear (t);
+  mpz_clear (w);
+  mpz_clear (ref);
+  for (l = 0; l < MONT52_LANES; l++)
+    {
+      mpz_clear (ma[l]);
+      mpz_clear (mb[l]);
+      mpz_clear (mm[l]);
+    }
+}
+
+void
+test_main (void)
+{
+  gmp_randstate_t rands;
+  size_t size;
+
+  gmp_randinit_default (rands);
+
+  for (size = 2; size <= 4; size++)
+    test_size (rands, size);
+  test_size (rands, 20);
+  test_size (rands, 30);
+  test_size (rands, MONT52_MAX_SIZE);
+
+  gmp_randclear (rands);
+}
@@ -1,5 +1,6 @@
 #include "testutils.h"
 #include "poly1305.h"
+#include "knuth-lfib.h"
 
 static void
 update (void *ctx, nettle_hash_update_func *f,
@@ -51,6 +52,67 @@ test_poly1305 (const struct tstring *key,
 		msg, length, 16, ref->data);
 }
 
+/* Checks that _poly1305_blocks, which may use a different algorithm
+   for long inputs, agrees with processing one block at a time. */
+static void
+test_poly1305_blocks (void)
+{
+  struct knuth_lfib_ctx rand;
+  struct poly1305_ctx ctx, ref;
+  uint8_t key[POLY1305_KEY_SIZE];
+  uint8_t *data;
+  size_t max_blocks = 100;
+  size_t blocks, i;
+  unsigned j;
+
+  knuth_lfib_init (&rand, 1305);
+  data = xalloc (max_blocks * POLY1305_BLOCK_SIZE);
+
+  for (j = 0; j < 4; j++)
+    {
+      knuth_lfib_random (&rand, sizeof(key), key);
+      if (j & 1)
+	/* Largest possible r, and large message blocks, to exercise
+	   carry propagation. */
+	memset (key, 0xff, sizeof(key));
+      poly1305_set_key (&ctx, key);
+
+      for (blocks = 0; blocks <= max_blocks; blocks++)
+	{
+	  union nettle_block16 digest, ref_digest;
+	  const uint8_t *end;
+
+	  if (j & 1)
+	    memset (data, 0xff, blocks * POLY1305_BLOCK_SIZE);
+	  else
+	    knuth_lfib_random (&rand, blocks * POLY1305_BLOCK_SIZE, data);
+
+	  /* Start with a non-zero state. */
+	  _poly1305_block (&ctx, key, 1);
+	  ref = ctx;
+
+	  end = _poly1305_blocks (&ctx, blocks, data);
+	  ASSERT (end == data + blocks * POLY1305_BLOCK_SIZE);
+	  for (i = 0; i < blocks; i++)
+	    _poly1305_block (&ref, data + i * POLY1305_BLOCK_SIZE, 1);
+
+	  memset (digest.b, 0, sizeof(digest.b));
+	  memset (ref_digest.b, 0, sizeof(ref_digest.b));
+	  poly1305_digest (&ctx, &digest);
+	  poly1305_digest (&ref, &ref_digest);
+	  if (!MEMEQ (POLY1305_DIGEST_SIZE, digest.b, ref_digest.b))
+	    {
+	      printf ("_poly1305_blocks failed, blocks = %u\n",
+		      (unsigned) blocks);
+	      printf ("got: "); print_hex (POLY1305_DIGEST_SIZE, digest.b);
+	      printf ("ref: "); print_hex (POLY1305_DIGEST_SIZE, ref_digest.b);
+	      FAIL ();
+	    }
+	}
+    }
+  free (data);
+}
+
 void
 test_main(void)
 {
@@ -83,4 +145,5 @@ test_main(void)
          "5c1bf9"), 63,
     SHEX("5154ad0d2cb26e01274fc51148491f1b"));
 
+  test_poly1305_blocks ();
 }
@@ -2,6 +2,47 @@
 
 #include "knuth-lfib.h"
 
+/* Runs the tasks in reverse order, to check that the result doesn't
+   depend on the order of evaluation. */
+static void
+reverse_executor (void *ctx, size_t count, nettle_task_func *task, void *arg)
+{
+  size_t *calls = ctx;
+  while (count-- > 0)
+    task (arg, count);
+  (*calls)++;
+}
+
+static void
+test_parallel (unsigned bits, int top_bits_set, unsigned width)
+{
+  struct knuth_lfib_ctx lfib;
+  mpz_t p, q;
+  size_t calls = 0;
+
+  mpz_init (p);
+  mpz_init (q);
+
+  knuth_lfib_init (&lfib, bits);
+  nettle_random_prime_parallel (p, bits, top_bits_set,
+				&lfib, (nettle_random_func *) knuth_lfib_random,
+				NULL, NULL, NULL, NULL, width);
+  ASSERT (mpz_sizeinbase (p, 2) == bits);
+  if (top_bits_set)
+    ASSERT (mpz_tstbit (p, bits - 2));
+  ASSERT (mpz_probab_prime_p (p, 25));
+
+  knuth_lfib_init (&lfib, bits);
+  nettle_random_prime_parallel (q, bits, top_bits_set,
+				&lfib, (nettle_random_func *) knuth_lfib_random,
+				NULL, NULL, &calls, reverse_executor, width);
+  ASSERT (mpz_cmp (p, q) == 0);
+  ASSERT (calls > 0);
+
+  mpz_clear (p);
+  mpz_clear (q);
+}
+
 void
 test_main(void)
 {
@@ -25,4 +66,9 @@ test_main(void)
     }
 
   mpz_clear(p);
+
+  test_parallel (100, 0, 1);
+  test_parallel (512, 1, 4);
+  test_parallel (1024, 1, 7);
+  test_parallel (1025, 0, 16);
 }
@@ -8,6 +8,50 @@ progress(void *ctx UNUSED, int c)
   fputc(c, stderr);
 }
 
+static void
+reverse_executor (void *ctx UNUSED, size_t count,
+		  nettle_task_func *task, void *arg)
+{
+  while (count-- > 0)
+    task (arg, count);
+}
+
+static void
+test_parallel (unsigned n_size, unsigned width)
+{
+  struct rsa_public_key pub, pub2;
+  struct rsa_private_key key, key2;
+  struct knuth_lfib_ctx lfib;
+
+  rsa_public_key_init (&pub);
+  rsa_private_key_init (&key);
+  rsa_public_key_init (&pub2);
+  rsa_private_key_init (&key2);
+
+  mpz_set_ui (pub.e, 65537);
+  mpz_set_ui (pub2.e, 65537);
+
+  knuth_lfib_init (&lfib, n_size);
+  ASSERT (rsa_generate_keypair_parallel (&pub, &key, &lfib,
+					 (nettle_random_func *) knuth_lfib_random,
+					 NULL, NULL, NULL, NULL, width,
+					 n_size, 0));
+  test_rsa_key (&pub, &key);
+
+  knuth_lfib_init (&lfib, n_size);
+  ASSERT (rsa_generate_keypair_parallel (&pub2, &key2, &lfib,
+					 (nettle_random_func *) knuth_lfib_random,
+					 NULL, NULL, NULL, reverse_executor, width,
+					 n_size, 0));
+  ASSERT (mpz_cmp (pub.n, pub2.n) == 0);
+  ASSERT (mpz_cmp (key.d, key2.d) == 0);
+
+  rsa_public_key_clear (&pub);
+  rsa_private_key_clear (&key);
+  rsa_public_key_clear (&pub2);
+  rsa_private_key_clear (&key2);
+}
+
 void
 test_main(void)
 {
@@ -35,12 +79,12 @@ test_main(void)
   test_rsa_key(&pub, &key);
 
   mpz_set_str(expected,
-	      "31ee088024b66f28" "e182fa07e60f7864" "636eea21cf74c804"
-	      "02a9c29ebd00933d" "8fae3ddf029d18e0" "1b5498c70a4b68fd"
-	      "d3135748424e8caf" "43ee86068f250c92" "8da001d09f68c433"
-	      "96f2c2a42eaed7e5" "8934a052faa38b2c" "f2ac04cc91bd0d15"
-	      "4f60b16dc9045b08" "2ea1372717fd7f9c" "1e9cc383b7d5b909"
-	      "72e3126df060ef79" , 16);
+	      "88b5ad9f7285c979" "63ccea08e1e6b003" "027b63873ebb7df7"
+	      "c155174ec51135ce" "d9f0042d65fc34f3" "c304ae433839b227"
+	      "0361128206cb66bb" "9d4d23c7dc30167b" "123f3f17e08847fb"
+	      "a8d36f8bd86afb15" "d8ec3d3a5689fcfd" "7dd034964e17db75"
+	      "ecb6803b0cc35b1b" "c3e7fd389ca8ac57" "2e40414709b27743"
+	      "3c3c4301198842ff" , 16);
 
   test_rsa_md5(&pub, &key, expected);
 
@@ -57,19 +101,22 @@ test_main(void)
   test_rsa_key(&pub, &key);
 
   mpz_set_str(expected,
-	      "892ef7cda3b0b501" "85de20b93340316e" "b35ac9c193f1f5a3"
-	      "9e6c1c327b9c36b8" "d4f1d41653b48fbd" "0c49e48bbdc46ced"
-	      "13b3f6426e8a1780" "55b9077ba59ce748" "a325563c3b4bdf78"
-	      "acdcdd556f5de3cf" "70257c3b334ba360" "5625ebda869c8058"
-	      "b95b40c1e75eb91b" "776e83c0224757c6" "b61266cb1739df1a"
-	      "c7fcc09194c575b5" "af4f3eb8e3aa3900" "22b72fb6e950c355"
-	      "88743bab32c3a214" "ea5865e2f5c41d67" "12e745496890fc9d"
-	      "7944a759f39d7b57" "e365d8d3f6ac2dd4" "052b6a2e58a6af82"
-	      "b0d67e7fe09045d9" "bc965e260cf3c9a9" "3bfaa09bdd076dc2"
-	      "c0ab48ce5b67105c" "cad90dcfc11cd713" "e64478d2d7ea42dd"
-	      "fd040793c487588d" "6218" , 16);
+	      "c7d1e537376eef5c" "a4f7e2237c70ce9d" "a609b5c74189c3aa"
+	      "f28809bae716f671" "7514c9397abfad5e" "a15627ef51e31294"
+	      "097d79036e36fdd6" "2bbc7274cbccf437" "dc9a2faa8d21a7ad"
+	      "9f547f5b49b4d7ac" "36759bd081b1e9c1" "7fb032f934de759c"
+	      "daa3f7e6c4399175" "4559ead6ff4ba783" "3fed9c3f76c2acea"
+	      "4855b044766f0ed5" "1991c2dc185d35ef" "df03b6a35fc4f3a8"
+	      "ffc703d4e4442257" "42ae859fa8857cd3" "f9a6448aa0b223cf"
+	      "883ad04842239d67" "404c98a2f2b47f51" "864a73c1b810f1ba"
+	      "acefc6e753988c58" "766d8b3aa85542dd" "a782a674e6e67058"
+	      "b5c849a487ea437a" "570ce9a72cd35aa6" "fadce75e34b12d4e"
+	      "f2b84d28bd982f3c" "7bb4" , 16);
 
   test_rsa_sha1(&pub, &key, expected);
+
+  test_parallel (1024, 4);
+  test_parallel (1537, 3);
   
   rsa_private_key_clear(&key);
   rsa_public_key_clear(&pub);
@@ -0,0 +1,337 @@
+#include "testutils.h"
+
+#include "buffer.h"
+#include "sexp.h"
+
+#define COUNT 10
+
+static void
+random_fn (void *ctx, size_t n, uint8_t *dst)
+{
+  gmp_randstate_t *rands = (gmp_randstate_t *)ctx;
+  mpz_t r;
+
+  mpz_init (r);
+  mpz_urandomb (r, *rands, n*8);
+  nettle_mpz_get_str_256 (n, dst, r);
+  mpz_clear (r);
+}
+
+/* Checks that all values of the key are consistent. */
+static void
+check_multi_key (const struct rsa_public_key *pub,
+		 const struct rsa_multi_private_key *key)
+{
+  mpz_t prod, r1, t;
+  unsigned i;
+
+  mpz_init (prod);
+  mpz_init (r1);
+  mpz_init (t);
+
+  mpz_mul (prod, key->p, key->q);
+  mpz_sub_ui (r1, key->p, 1);
+  mpz_fdiv_r (t, key->d, r1);
+  ASSERT (mpz_cmp (t, key->a) == 0);
+  mpz_sub_ui (r1, key->q, 1);
+  mpz_fdiv_r (t, key->d, r1);
+  ASSERT (mpz_cmp (t, key->b) == 0);
+  mpz_mul (t, key->c, key->q);
+  mpz_fdiv_r (t, t, key->p);
+  ASSERT (mpz_cmp_ui (t, 1) == 0);
+
+  for (i = 0; i < key->count; i++)
+    {
+      const struct rsa_prime_info *info = &key->other[i];
+      mpz_sub_ui (r1, info->r, 1);
+      mpz_fdiv_r (t, key->d, r1);
+      ASSERT (mpz_cmp (t, info->d) == 0);
+      mpz_mul (t, info->t, prod);
+      mpz_fdiv_r (t, t, info->r);
+      ASSERT (mpz_cmp_ui (t, 1) == 0);
+
+      mpz_mul (prod, prod, info->r);
+    }
+  ASSERT (mpz_cmp (prod, pub->n) == 0);
+  ASSERT (key->size == pub->size);
+
+  mpz_clear (prod);
+  mpz_clear (r1);
+  mpz_clear (t);
+}
+
+static void
+test_multi_key (gmp_randstate_t *rands,
+		const struct rsa_public_key *pub,
+		const struct rsa_multi_private_key *key)
+{
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  mpz_t m, x, ref;
+  unsigned i;
+
+  mpz_init (m);
+  mpz_init (x);
+  mpz_init (ref);
+
+  check_multi_key (pub, key);
+
+  for (i = 0; i < COUNT; i++)
+    {
+      if (i & 1)
+	mpz_urandomb (m, *rands, mpz_sizeinbase (pub->n, 2) - 1);
+      else
+	mpz_rrandomb (m, *rands, mpz_sizeinbase (pub->n, 2) - 1);
+
+      mpz_powm (ref, m, key->d, pub->n);
+
+      rsa_multi_compute_root (key, x, m);
+      ASSERT (mpz_cmp (x, ref) == 0);
+
+      ASSERT (rsa_multi_compute_root_tr (pub, key, rands, random_fn, x, m));
+      ASSERT (mpz_cmp (x, ref) == 0);
+
+      random_fn (rands, sizeof (digest), digest);
+      ASSERT (rsa_multi_sha256_sign_digest_tr (pub, key, rands, random_fn,
+					       digest, x));
+      ASSERT (rsa_sha256_verify_digest (pub, digest, x));
+
+      ASSERT (rsa_multi_pkcs1_sign_tr (pub, key, rands, random_fn,
+				       sizeof (digest), digest, x));
+      ASSERT (rsa_pkcs1_verify (pub, sizeof (digest), digest, x));
+    }
+
+  mpz_clear (m);
+  mpz_clear (x);
+  mpz_clear (ref);
+}
+
+static void
+test_sexp_roundtrip (const struct rsa_public_key *pub,
+		     const struct rsa_multi_private_key *key)
+{
+  struct nettle_buffer buffer;
+  struct rsa_public_key pub2;
+  struct rsa_multi_private_key key2;
+  unsigned i;
+
+  nettle_buffer_init (&buffer);
+  rsa_public_key_init (&pub2);
+  rsa_multi_private_key_init (&key2);
+
+  ASSERT (rsa_multi_keypair_to_sexp (&buffer, NULL, pub, key));
+  ASSERT (rsa_multi_keypair_from_sexp (&pub2, &key2, 0,
+				       buffer.size, buffer.contents));
+
+  ASSERT (mpz_cmp (pub->n, pub2.n) == 0);
+  ASSERT (mpz_cmp (pub->e, pub2.e) == 0);
+  ASSERT (key2.count == key->count);
+  ASSERT (key2.size == key->size);
+  ASSERT (mpz_cmp (key->d, key2.d) == 0);
+  ASSERT (mpz_cmp (key->p, key2.p) == 0);
+  ASSERT (mpz_cmp (key->q, key2.q) == 0);
+  ASSERT (mpz_cmp (key->a, key2.a) == 0);
+  ASSERT (mpz_cmp (key->b, key2.b) == 0);
+  ASSERT (mpz_cmp (key->c, key2.c) == 0);
+  for (i = 0; i < key->count; i++)
+    {
+      ASSERT (mpz_cmp (key->other[i].r, key2.other[i].r) == 0);
+      ASSERT (mpz_cmp (key->other[i].d, key2.other[i].d) == 0);
+      ASSERT (mpz_cmp (key->other[i].t, key2.other[i].t) == 0);
+    }
+
+  if (key->count > 0)
+    {
+      /* Incomplete set of primes. */
+      nettle_buffer_reset (&buffer);
+      ASSERT (sexp_format (&buffer,
+			   "(private-key(rsa-pkcs1(n%b)(e%b)"
+			   "(d%b)(p%b)(q%b)(a%b)(b%b)(c%b)(r3%b)(d3%b)))",
+			   pub->n, pub->e, key->d, key->p, key->q,
+			   key->a, key->b, key->c,
+			   key->other[0].r, key->other[0].d));
+      ASSERT (!rsa_multi_keypair_from_sexp (&pub2, &key2, 0,
+					    buffer.size, buffer.contents));
+    }
+
+  nettle_buffer_clear (&buffer);
+  rsa_public_key_clear (&pub2);
+  rsa_multi_private_key_clear (&key2);
+}
+
+#if !NETTLE_USE_MINI_GMP
+/* Creates a key from primes of the given sizes, which need not be in
+   any particular order. */
+static void
+generate_unbalanced (gmp_randstate_t rands,
+		     struct rsa_public_key *pub,
+		     struct rsa_multi_private_key *key,
+		     unsigned nprimes, const unsigned *sizes)
+{
+  mpz_ptr primes[RSA_MAX_PRIMES];
+  mpz_t phi, r1, prod;
+  unsigned i;
+
+  mpz_init (phi);
+  mpz_init (r1);
+  mpz_init (prod);
+
+  primes[0] = key->p;
+  primes[1] = key->q;
+  for (i = 2; i < nprimes; i++)
+    primes[i] = key->other[i-2].r;
+
+  mpz_set_ui (pub->e, 65537);
+  mpz_set_ui (phi, 1);
+  for (i = 0; i < nprimes; i++)
+    {
+      do
+	{
+	  mpz_rrandomb (primes[i], rands, sizes[i]);
+	  mpz_nextprime (primes[i], primes[i]);
+	  mpz_sub_ui (r1, primes[i], 1);
+	  mpz_gcd (prod, pub->e, r1);
+	}
+      while (mpz_cmp_ui (prod, 1) != 0);
+      mpz_mul (phi, phi, r1);
+    }
+
+  ASSERT (mpz_invert (key->d, pub->e, phi));
+  mpz_sub_ui (r1, key->p, 1);
+  mpz_fdiv_r (key->a, key->d, r1);
+  mpz_sub_ui (r1, key->q, 1);
+  mpz_fdiv_r (key->b, key->d, r1);
+  ASSERT (mpz_invert (key->c, key->q, key->p));
+
+  mpz_mul (prod, key->p, key->q);
+  for (i = 0; i < nprimes - 2; i++)
+    {
+      mpz_sub_ui (r1, key->other[i].r, 1);
+      mpz_fdiv_r (key->other[i].d, key->d, r1);
+      ASSERT (mpz_invert (key->other[i].t, prod, key->other[i].r));
+      mpz_mul (prod, prod, key->other[i].r);
+    }
+  key->count = nprimes - 2;
+  mpz_set (pub->n, prod);
+
+  ASSERT (rsa_public_key_prepare (pub));
+  ASSERT (rsa_multi_private_key_prepare (key));
+
+  mpz_clear (phi);
+  mpz_clear (r1);
+  mpz_clear (prod);
+}
+#endif
+
+void
+test_main (void)
+{
+  static const struct {
+    unsigned n_size;
+    unsigned e_size;
+    unsigned long e;
+    unsigned nprimes;
+  } keys[] = {
+    { 512, 0, 65537, 2 },
+    { 777, 0, 3, 3 },
+    { 1024, 0, 65537, 3 },
+    { 1100, 30, 0, 4 },
+    { 1536, 0, 65537, 4 },
+  };
+  /* Version 1 RSAPrivateKey, with three 256-bit primes. */
+  const struct tstring *der =
+    SHEX(
+	      "308201e6020101026100c9ca73d638ec"
+	      "8c4c68f684765c56e0e736947889e5fd"
+	      "6d81ccc158e0f9ac6164b8c19e2384f9"
+	      "661e7d44ea20e7c234c1492077eb5917"
+	      "66dad0a253c0a610ef689c9c3cc7b2fa"
+	      "32e730923d0aa3e8f70675eab60ffa9b"
+	      "554da39e62f6c79ca2cf020301000102"
+	      "604c91c9caabe6f685b7fe72dd06c4e0"
+	      "aa5b879305a083bd9dd73836a58797e5"
+	      "8bfd944d789e20e4317ceff09fb00dfe"
+	      "4af8d242929206d0054d366a59af9065"
+	      "f5052233e1be8d474786db2543153ec1"
+	      "d461182d1b2540ed1b33564bf859e3cc"
+	      "81022100db61143954cd9391c3d372d1"
+	      "9ac9f21b6b28fdc48b4a64587b618ebc"
+	      "e8bb673f022100f235bfb76a1a771eac"
+	      "b22aebdd4da4c95145553eb0c7921059"
+	      "36e709393ced5d022100b5f3aaa67263"
+	      "9f4582b9d9bd67389f89863395667270"
+	      "dd115623f01356a438590220040a1b71"
+	      "6ea69458019f5311edf5ee8aa0fd5c07"
+	      "98a12b71745b730cf75469cd02204152"
+	      "240d35dba9795073699d69789ab80bfd"
+	      "9674d69fc9822dcb32b084909450306a"
+	      "3068022100f8e1d9c26175f2cf697550"
+	      "501c9c5129625003ea948ed312496015"
+	      "1e68a40a25022041eb1fcffa1c51595a"
+	      "27364461af8d5796b076b914ebd73fca"
+	      "ab662c8dae94f9022100c14fb82041c3"
+	      "1e3d57c220e89df8b78be15e37b732f9"
+	      "70328b75a53b4421d1e4");
+  gmp_randstate_t rands;
+  struct rsa_public_key pub;
+  struct rsa_multi_private_key key;
+  unsigned i;
+
+  rsa_multi_private_key_init (&key);
+  rsa_public_key_init (&pub);
+
+  gmp_randinit_default (rands);
+
+  for (i = 0; i < sizeof (keys) / sizeof (keys[0]); i++)
+    {
+      if (keys[i].e)
+	mpz_set_ui (pub.e, keys[i].e);
+      ASSERT (rsa_generate_multi_keypair (&pub, &key, &rands, random_fn,
+					  NULL, NULL,
+					  keys[i].n_size, keys[i].e_size,
+					  keys[i].nprimes));
+      ASSERT (mpz_sizeinbase (pub.n, 2) == keys[i].n_size);
+      ASSERT (key.count == keys[i].nprimes - 2);
+      test_multi_key (&rands, &pub, &key);
+      test_sexp_roundtrip (&pub, &key);
+    }
+
+  /* Invalid parameters */
+  mpz_set_ui (pub.e, 65537);
+  ASSERT (!rsa_generate_multi_keypair (&pub, &key, &rands, random_fn,
+				       NULL, NULL, 1024, 0, 1));
+  ASSERT (!rsa_generate_multi_keypair (&pub, &key, &rands, random_fn,
+				       NULL, NULL, 1024, 0,
+				       RSA_MAX_PRIMES + 1));
+  ASSERT (!rsa_generate_multi_keypair (&pub, &key, &rands, random_fn,
+				       NULL, NULL, 100, 0, 4));
+
+#if !NETTLE_USE_MINI_GMP
+  {
+    static const unsigned sizes[][RSA_MAX_PRIMES] = {
+      { 500, 130, 200, 0 },
+      { 130, 500, 300, 70 },
+      { 200, 200, 64, 600 },
+    };
+    for (i = 0; i < sizeof (sizes) / sizeof (sizes[0]); i++)
+      {
+	generate_unbalanced (rands, &pub, &key, sizes[i][3] ? 4 : 3,
+			     sizes[i]);
+	test_multi_key (&rands, &pub, &key);
+      }
+  }
+#endif
+
+  ASSERT (rsa_multi_keypair_from_der (&pub, &key, 0, der->length, der->data));
+  ASSERT (key.count == 1);
+  ASSERT (mpz_sizeinbase (pub.n, 2) == 768);
+  test_multi_key (&rands, &pub, &key);
+
+  /* Truncated */
+  ASSERT (!rsa_multi_keypair_from_der (&pub, &key, 0,
+				       der->length - 1, der->data));
+
+  rsa_public_key_clear (&pub);
+  rsa_multi_private_key_clear (&key);
+
+  gmp_randclear (rands);
+}
@@ -0,0 +1,784 @@
+#include "testutils.h"
+
+#include "rsa-internal.h"
+
+#define COUNT 20
+
+static void
+random_fn (void *ctx, size_t n, uint8_t *dst)
+{
+  gmp_randstate_t *rands = (gmp_randstate_t *)ctx;
+  mpz_t r;
+
+  mpz_init (r);
+  mpz_urandomb (r, *rands, n*8);
+  nettle_mpz_get_str_256 (n, dst, r);
+  mpz_clear (r);
+}
+
+/* Runs the tasks sequentially, in reverse order, to check that
+   callers don't depend on the order. */
+static unsigned executor_calls;
+
+static void
+reverse_executor (void *ctx, size_t count, rsa_task_func *task, void *arg)
+{
+  ASSERT (ctx == &executor_calls);
+  executor_calls++;
+  while (count-- > 0)
+    task (arg, count);
+}
+
+#define BATCH_WORKERS 3
+#define BATCH_COUNT 8
+
+static void
+test_batch (gmp_randstate_t *rands,
+	    const struct rsa_public_key *pub,
+	    const struct rsa_private_key *key,
+	    const struct rsa_private_precomp *pre)
+{
+  struct rsa_worker worker[BATCH_WORKERS];
+  uint8_t digests[BATCH_COUNT * SHA256_DIGEST_SIZE];
+  mpz_t s[BATCH_COUNT];
+  mpz_t ref;
+  unsigned i;
+
+  mpz_init (ref);
+  for (i = 0; i < BATCH_COUNT; i++)
+    mpz_init (s[i]);
+  for (i = 0; i < BATCH_WORKERS; i++)
+    rsa_worker_init (&worker[i], pub, key, pre, rands, random_fn);
+
+  /* Repeat, to use updated blinding pairs. */
+  for (i = 0; i < 3; i++)
+    {
+      unsigned j;
+      random_fn (rands, sizeof (digests), digests);
+      ASSERT (rsa_sha256_sign_digest_tr_batch (pub, key, pre,
+					       BATCH_WORKERS, worker,
+					       &executor_calls,
+					       reverse_executor,
+					       BATCH_COUNT, digests, s));
+      for (j = 0; j < BATCH_COUNT; j++)
+	{
+	  ASSERT (rsa_sha256_sign_digest (key,
+					  digests + j * SHA256_DIGEST_SIZE,
+					  ref));
+	  ASSERT (mpz_cmp (s[j], ref) == 0);
+	}
+    }
+
+  /* Fewer elements than workers, no executor. */
+  for (i = 0; i < 2; i++)
+    mpz_rrandomb (s[i], *rands, mpz_sizeinbase (pub->n, 2) - 1);
+  rsa_compute_root (key, ref, s[1]);
+  ASSERT (rsa_compute_root_tr_batch (pub, key, pre,
+				     BATCH_WORKERS, worker,
+				     NULL, NULL, 2, s));
+  ASSERT (mpz_cmp (s[1], ref) == 0);
+  ASSERT (rsa_compute_root_tr_batch (pub, key, pre,
+				     BATCH_WORKERS, worker,
+				     NULL, NULL, 0, s));
+
+  for (i = 0; i < BATCH_WORKERS; i++)
+    rsa_worker_clear (&worker[i]);
+  for (i = 0; i < BATCH_COUNT; i++)
+    mpz_clear (s[i]);
+  mpz_clear (ref);
+}
+
+#define DECRYPT_LENGTH 8
+
+static void
+test_decrypt_batch (gmp_randstate_t *rands,
+		    const struct rsa_public_key *pub,
+		    const struct rsa_private_key *key,
+		    const struct rsa_private_precomp *pre)
+{
+  struct rsa_worker worker[BATCH_WORKERS];
+  uint8_t messages[BATCH_COUNT * DECRYPT_LENGTH];
+  uint8_t decrypted[BATCH_COUNT * DECRYPT_LENGTH];
+  uint8_t *ciphertexts;
+  int valid[BATCH_COUNT];
+  mpz_t c;
+  unsigned i;
+
+  mpz_init (c);
+  ciphertexts = xalloc (BATCH_COUNT * key->size);
+  for (i = 0; i < BATCH_WORKERS; i++)
+    rsa_worker_init (&worker[i], pub, key, pre, rands, random_fn);
+
+  random_fn (rands, sizeof (messages), messages);
+  for (i = 0; i < BATCH_COUNT; i++)
+    {
+      ASSERT (rsa_encrypt (pub, rands, random_fn, DECRYPT_LENGTH,
+			   messages + i * DECRYPT_LENGTH, c));
+      nettle_mpz_get_str_256 (key->size, ciphertexts + i * key->size, c);
+    }
+
+  memset (decrypted, 0, sizeof (decrypted));
+  ASSERT (rsa_sec_decrypt_batch (pub, key, pre, BATCH_WORKERS, worker,
+				 &executor_calls, reverse_executor,
+				 BATCH_COUNT, DECRYPT_LENGTH, decrypted,
+				 ciphertexts, valid));
+  ASSERT (MEMEQ (sizeof (messages), messages, decrypted));
+  for (i = 0; i < BATCH_COUNT; i++)
+    ASSERT (valid[i] == 1);
+
+  /* Invalid padding, for one of the messages. */
+  mpz_set_ui (c, 17);
+  nettle_mpz_get_str_256 (key->size, ciphertexts + 2 * key->size, c);
+  memset (decrypted, 0, sizeof (decrypted));
+  ASSERT (!rsa_sec_decrypt_batch (pub, key, pre, BATCH_WORKERS, worker,
+				  NULL, NULL, BATCH_COUNT, DECRYPT_LENGTH,
+				  decrypted, ciphertexts, valid));
+  for (i = 0; i < BATCH_COUNT; i++)
+    {
+      ASSERT (valid[i] == (i != 2));
+      if (i != 2)
+	ASSERT (MEMEQ (DECRYPT_LENGTH, messages + i * DECRYPT_LENGTH,
+		       decrypted + i * DECRYPT_LENGTH));
+    }
+
+  for (i = 0; i < BATCH_WORKERS; i++)
+    rsa_worker_clear (&worker[i]);
+  free (ciphertexts);
+  mpz_clear (c);
+}
+
+#if !NETTLE_USE_MINI_GMP
+/* Checks the multi-buffer root computation directly, also when the
+   batch functions don't use it. */
+static void
+test_mb (gmp_randstate_t *rands,
+	 const struct rsa_public_key *pub,
+	 const struct rsa_private_key *key,
+	 const struct rsa_private_precomp *pre)
+{
+  mp_size_t nn = mpz_size (pub->n);
+  mp_size_t itch = _rsa_mb_sec_compute_root_itch (key);
+  struct rsa_mb_key *mb;
+  mp_limb_t *mp, *rp, *scratch;
+  mpz_t m, ref;
+  unsigned count;
+
+  if (!itch)
+    return;
+
+  mpz_init (m);
+  mpz_init (ref);
+  mb = xalloc (sizeof (*mb));
+  mp = xalloc (RSA_MB_COUNT * nn * sizeof (*mp));
+  rp = xalloc (RSA_MB_COUNT * nn * sizeof (*rp));
+  scratch = xalloc (itch * sizeof (*scratch));
+
+  _rsa_mb_key_init (mb, key);
+
+  for (count = 1; count <= RSA_MB_COUNT; count++)
+    {
+      unsigned i;
+      for (i = 0; i < count; i++)
+	{
+	  if (i == 1)
+	    mpz_set_ui (m, 0);
+	  else if (i == 2)
+	    mpz_sub_ui (m, pub->n, 1);
+	  else
+	    mpz_urandomb (m, *rands, mpz_sizeinbase (pub->n, 2) - 1);
+	  mpz_limbs_copy (mp + i * nn, m, nn);
+	}
+
+      _rsa_mb_sec_compute_root (mb, key, pre, count, rp, mp, scratch);
+
+      for (i = 0; i < count; i++)
+	{
+	  mpz_t x;
+	  mpz_set_n (m, mp + i * nn, nn);
+	  rsa_compute_root (key, ref, m);
+	  if (mpz_cmp (mpz_roinit_n (x, rp + i * nn, nn), ref))
+	    {
+	      fprintf (stderr, "_rsa_mb_sec_compute_root failed, i = %u\n", i);
+	      fprintf (stderr, "n = ");
+	      mpz_out_str (stderr, 16, pub->n);
+	      fprintf (stderr, "\nm = ");
+	      mpz_out_str (stderr, 16, m);
+	      fprintf (stderr, "\ngot = ");
+	      mpz_out_str (stderr, 16, x);
+	      fprintf (stderr, "\nref = ");
+	      mpz_out_str (stderr, 16, ref);
+	      fprintf (stderr, "\n");
+	      abort ();
+	    }
+	}
+    }
+
+  free (mb);
+  free (mp);
+  free (rp);
+  free (scratch);
+  mpz_clear (m);
+  mpz_clear (ref);
+}
+#endif
+
+#define PSS_SALT_SIZE 16
+
+static void
+test_verify_batch (gmp_randstate_t *rands,
+		   const struct rsa_public_key *pub,
+		   const struct rsa_private_key *key,
+		   const struct rsa_public_precomp *pre)
+{
+  uint8_t digests[BATCH_COUNT * SHA256_DIGEST_SIZE];
+  uint8_t salt[PSS_SALT_SIZE];
+  uint8_t *pkcs1 = xalloc (BATCH_COUNT * pub->size);
+  uint8_t *pss = xalloc (BATCH_COUNT * pub->size);
+  int valid[BATCH_COUNT];
+  mpz_t s;
+  unsigned i;
+
+  mpz_init (s);
+
+  random_fn (rands, sizeof (digests), digests);
+  for (i = 0; i < BATCH_COUNT; i++)
+    {
+      const uint8_t *digest = digests + i * SHA256_DIGEST_SIZE;
+      ASSERT (rsa_sha256_sign_digest (key, digest, s));
+      nettle_mpz_get_str_256 (pub->size, pkcs1 + i * pub->size, s);
+
+      random_fn (rands, sizeof (salt), salt);
+      ASSERT (rsa_pss_sha256_sign_digest_tr (pub, key, rands, random_fn,
+					     sizeof (salt), salt, digest, s));
+      nettle_mpz_get_str_256 (pub->size, pss + i * pub->size, s);
+    }
+
+  ASSERT (rsa_sha256_verify_digest_batch (pub, pre, BATCH_COUNT,
+					  digests, pkcs1, NULL));
+  ASSERT (rsa_pss_sha256_verify_digest_batch (pub, pre, PSS_SALT_SIZE,
+					      BATCH_COUNT, digests, pss,
+					      valid));
+  for (i = 0; i < BATCH_COUNT; i++)
+    ASSERT (valid[i] == 1);
+
+  ASSERT (rsa_sha256_verify_digest_batch (pub, pre, 0, digests, pkcs1, NULL));
+
+  /* Mixing up the signature types. */
+  ASSERT (!rsa_sha256_verify_digest_batch (pub, pre, BATCH_COUNT,
+					   digests, pss, NULL));
+  ASSERT (!rsa_pss_sha256_verify_digest_batch (pub, pre, PSS_SALT_SIZE,
+					       BATCH_COUNT, digests, pkcs1,
+					       NULL));
+
+  /* Bad digest, bad signature, and signatures of zero and n. */
+  digests[1 * SHA256_DIGEST_SIZE + 5] ^= 0x10;
+  pkcs1[3 * pub->size + pub->size / 2] ^= 1;
+  pss[3 * pub->size + pub->size / 2] ^= 1;
+  memset (pkcs1 + 5 * pub->size, 0, pub->size);
+  memset (pss + 5 * pub->size, 0, pub->size);
+  nettle_mpz_get_str_256 (pub->size, pkcs1 + 6 * pub->size, pub->n);
+  nettle_mpz_get_str_256 (pub->size, pss + 6 * pub->size, pub->n);
+
+  ASSERT (!rsa_sha256_verify_digest_batch (pub, pre, BATCH_COUNT,
+					   digests, pkcs1, valid));
+  for (i = 0; i < BATCH_COUNT; i++)
+    ASSERT (valid[i] == (i != 1 && i != 3 && i != 5 && i != 6));
+
+  ASSERT (!rsa_pss_sha256_verify_digest_batch (pub, pre, PSS_SALT_SIZE,
+					       BATCH_COUNT, digests, pss,
+					       valid));
+  for (i = 0; i < BATCH_COUNT; i++)
+    ASSERT (valid[i] == (i != 1 && i != 3 && i != 5 && i != 6));
+
+  mpz_clear (s);
+  free (pkcs1);
+  free (pss);
+}
+
+static void
+test_scratch (gmp_randstate_t *rands,
+	      const struct rsa_public_key *pub,
+	      const struct rsa_private_key *key,
+	      const struct rsa_public_precomp *pre)
+{
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  uint8_t salt[PSS_SALT_SIZE];
+  uint8_t *msg = xalloc (pub->size);
+  uint8_t *decrypted = xalloc (pub->size);
+  uint8_t *signature = xalloc (pub->size);
+  mp_limb_t *scratch = xalloc (rsa_public_itch (pub, pre)
+			       * sizeof (mp_limb_t));
+  size_t length;
+  mpz_t s;
+  unsigned i;
+
+  mpz_init (s);
+
+  for (i = 0; i < COUNT; i++)
+    {
+      random_fn (rands, sizeof (digest), digest);
+
+      ASSERT (rsa_sha256_sign_digest (key, digest, s));
+      nettle_mpz_get_str_256 (pub->size, signature, s);
+      ASSERT (rsa_sha256_verify_digest_scratch (pub, pre, digest,
+						signature, scratch));
+      ASSERT (!rsa_pkcs1_verify_scratch (pub, pre, sizeof (digest), digest,
+					 signature, scratch));
+
+      ASSERT (rsa_pkcs1_sign (key, sizeof (digest), digest, s));
+      nettle_mpz_get_str_256 (pub->size, signature, s);
+      ASSERT (rsa_pkcs1_verify_scratch (pub, pre, sizeof (digest), digest,
+					signature, scratch));
+      signature[i % pub->size] ^= 0x40;
+      ASSERT (!rsa_pkcs1_verify_scratch (pub, pre, sizeof (digest), digest,
+					 signature, scratch));
+
+      random_fn (rands, sizeof (salt), salt);
+      ASSERT (rsa_pss_sha256_sign_digest_tr (pub, key, rands, random_fn,
+					     sizeof (salt), salt, digest, s));
+      nettle_mpz_get_str_256 (pub->size, signature, s);
+      ASSERT (rsa_pss_sha256_verify_digest_scratch (pub, pre, PSS_SALT_SIZE,
+						    digest, signature,
+						    scratch));
+      ASSERT (!rsa_pss_sha256_verify_digest_scratch (pub, pre,
+						     PSS_SALT_SIZE - 1,
+						     digest, signature,
+						     scratch));
+      digest[i % sizeof (digest)] ^= 1;
+      ASSERT (!rsa_pss_sha256_verify_digest_scratch (pub, pre, PSS_SALT_SIZE,
+						     digest, signature,
+						     scratch));
+
+      length = i % (pub->size - 10);
+      random_fn (rands, length, msg);
+      ASSERT (rsa_encrypt_scratch (pub, pre, rands, random_fn,
+				   length, msg, signature, scratch));
+      nettle_mpz_set_str_256_u (s, pub->size, signature);
+      ASSERT (mpz_cmp (s, pub->n) < 0);
+      length = pub->size;
+      ASSERT (rsa_decrypt (key, &length, decrypted, s));
+      ASSERT (length == i % (pub->size - 10));
+      ASSERT (MEMEQ (length, msg, decrypted));
+    }
+
+  ASSERT (!rsa_encrypt_scratch (pub, pre, rands, random_fn,
+				pub->size - 10, msg, signature, scratch));
+
+  /* Signatures of zero and n. */
+  memset (signature, 0, pub->size);
+  ASSERT (!rsa_pkcs1_verify_scratch (pub, pre, sizeof (digest), digest,
+				     signature, scratch));
+  nettle_mpz_get_str_256 (pub->size, signature, pub->n);
+  ASSERT (!rsa_sha256_verify_digest_scratch (pub, pre, digest,
+					     signature, scratch));
+  ASSERT (!rsa_pss_sha256_verify_digest_scratch (pub, pre, PSS_SALT_SIZE,
+						 digest, signature, scratch));
+
+  mpz_clear (s);
+  free (msg);
+  free (decrypted);
+  free (signature);
+  free (scratch);
+}
+
+#if !NETTLE_USE_MINI_GMP
+/* Generates a key where p and q have different limb sizes. */
+static void
+generate_unbalanced (gmp_randstate_t rands,
+		     struct rsa_public_key *pub, struct rsa_private_key *key,
+		     unsigned psize, unsigned qsize)
+{
+  mpz_t p1, q1, phi;
+
+  mpz_init (p1);
+  mpz_init (q1);
+  mpz_init (phi);
+
+  mpz_set_ui (pub->e, 65537);
+  do
+    {
+      do
+	{
+	  mpz_rrandomb (key->p, rands, psize);
+	  mpz_nextprime (key->p, key->p);
+	  mpz_sub_ui (p1, key->p, 1);
+	  mpz_gcd (phi, pub->e, p1);
+	}
+      while (mpz_cmp_ui (phi, 1) != 0);
+      do
+	{
+	  mpz_rrandomb (key->q, rands, qsize);
+	  mpz_nextprime (key->q, key->q);
+	  mpz_sub_ui (q1, key->q, 1);
+	  mpz_gcd (phi, pub->e, q1);
+	}
+      while (mpz_cmp_ui (phi, 1) != 0);
+    }
+  while (!mpz_invert (key->c, key->q, key->p));
+
+  mpz_mul (phi, p1, q1);
+  ASSERT (mpz_invert (key->d, pub->e, phi));
+  mpz_fdiv_r (key->a, key->d, p1);
+  mpz_fdiv_r (key->b, key->d, q1);
+  mpz_mul (pub->n, key->p, key->q);
+
+  ASSERT (rsa_public_key_prepare (pub));
+  ASSERT (rsa_private_key_prepare (key));
+
+  mpz_clear (p1);
+  mpz_clear (q1);
+  mpz_clear (phi);
+}
+#endif
+
+static void
+test_precomp (gmp_randstate_t *rands,
+	      const struct rsa_public_key *pub,
+	      const struct rsa_private_key *key)
+{
+  struct rsa_private_precomp pre;
+  struct rsa_public_precomp pub_pre;
+  struct rsa_blinding blinding;
+  struct rsa_blinding parallel_blinding;
+  uint8_t digest[SHA256_DIGEST_SIZE];
+  mpz_t m, x, ref;
+  unsigned i;
+
+  mpz_init (m);
+  mpz_init (x);
+  mpz_init (ref);
+
+  ASSERT (rsa_private_precomp_init (&pre, pub, key));
+  ASSERT (rsa_public_precomp_init (&pub_pre, pub));
+
+  rsa_blinding_init (&blinding);
+  rsa_blinding_init (&parallel_blinding);
+
+  for (i = 0; i < COUNT; i++)
+    {
+      if (i & 1)
+	mpz_urandomb (m, *rands, mpz_sizeinbase (pub->n, 2) - 1);
+      else
+	mpz_rrandomb (m, *rands, mpz_sizeinbase (pub->n, 2) - 1);
+
+      rsa_compute_root (key, ref, m);
+      ASSERT (rsa_compute_root_tr_blinding (pub, key, &pre, &blinding,
+					    rands, random_fn, x, m));
+      if (mpz_cmp (x, ref))
+	{
+	  fprintf (stderr, "rsa_compute_root_tr_blinding failed, i = %u\n", i);
+	  fprintf (stderr, "n = ");
+	  mpz_out_str (stderr, 16, pub->n);
+	  fprintf (stderr, "\nm = ");
+	  mpz_out_str (stderr, 16, m);
+	  fprintf (stderr, "\ngot = ");
+	  mpz_out_str (stderr, 16, x);
+	  fprintf (stderr, "\nref = ");
+	  mpz_out_str (stderr, 16, ref);
+	  fprintf (stderr, "\n");
+	  abort ();
+	}
+
+      random_fn (rands, sizeof (digest), digest);
+      ASSERT (rsa_sha256_sign_digest (key, digest, ref));
+      ASSERT (rsa_sha256_sign_digest_tr_blinding (pub, key, &pre, &blinding,
+						  rands, random_fn,
+						  digest, x));
+      ASSERT (mpz_cmp (x, ref) == 0);
+
+      ASSERT (rsa_sha256_verify_digest_precomp (pub, &pub_pre, digest, x));
+      ASSERT (rsa_sha256_verify_digest_precomp (pub, &pre.pub, digest, x));
+      ASSERT (!rsa_pkcs1_verify_precomp (pub, &pub_pre,
+					 sizeof (digest), digest, x));
+
+      ASSERT (rsa_pkcs1_sign_tr_blinding (pub, key, &pre, &blinding,
+					  rands, random_fn,
+					  sizeof (digest), digest, x));
+      ASSERT (rsa_pkcs1_verify (pub, sizeof (digest), digest, x));
+      ASSERT (rsa_pkcs1_verify_precomp (pub, &pub_pre,
+					sizeof (digest), digest, x));
+
+      mpz_combit (x, i);
+      ASSERT (!rsa_pkcs1_verify_precomp (pub, &pub_pre,
+					 sizeof (digest), digest, x));
+    }
+
+  /* Long enough to use updated and refreshed blinding pairs. */
+  for (i = 0; i < 2*RSA_BLINDING_REFRESH + 3; i++)
+    {
+      mpz_rrandomb (m, *rands, mpz_sizeinbase (pub->n, 2) - 1);
+
+      rsa_compute_root (key, ref, m);
+      ASSERT (rsa_compute_root_tr_blinding (pub, key, &pre, &blinding,
+					    rands, random_fn, x, m));
+      ASSERT (mpz_cmp (x, ref) == 0);
+
+      ASSERT (rsa_compute_root_tr_parallel (pub, key, &pre,
+					    &parallel_blinding,
+					    &executor_calls, reverse_executor,
+					    rands, random_fn, x, m));
+      ASSERT (mpz_cmp (x, ref) == 0);
+
+      random_fn (rands, sizeof (digest), digest);
+      ASSERT (rsa_sha256_sign_digest (key, digest, ref));
+      ASSERT (rsa_sha256_sign_digest_tr_blinding (pub, key, &pre, &blinding,
+						  rands, random_fn,
+						  digest, x));
+      ASSERT (mpz_cmp (x, ref) == 0);
+
+      ASSERT (rsa_sha256_sign_digest_tr_parallel (pub, key, &pre,
+						  &parallel_blinding,
+						  NULL, NULL,
+						  rands, random_fn,
+						  digest, x));
+      ASSERT (mpz_cmp (x, ref) == 0);
+
+      ASSERT (rsa_pkcs1_sign_tr_blinding (pub, key, &pre, &blinding,
+					  rands, random_fn,
+					  sizeof (digest), digest, x));
+      ASSERT (rsa_pkcs1_verify_precomp (pub, &pub_pre,
+					sizeof (digest), digest, x));
+    }
+  rsa_blinding_clear (&blinding);
+  rsa_blinding_clear (&parallel_blinding);
+
+  test_batch (rands, pub, key, &pre);
+  test_decrypt_batch (rands, pub, key, &pre);
+#if !NETTLE_USE_MINI_GMP
+  test_mb (rands, pub, key, &pre);
+#endif
+  test_verify_batch (rands, pub, key, &pub_pre);
+  test_scratch (rands, pub, key, &pub_pre);
+
+  /* Out of range signatures */
+  ASSERT (!rsa_pkcs1_verify_precomp (pub, &pub_pre,
+				     sizeof (digest), digest, pub->n));
+  mpz_set_ui (x, 0);
+  ASSERT (!rsa_pkcs1_verify_precomp (pub, &pub_pre,
+				     sizeof (digest), digest, x));
+
+  rsa_private_precomp_clear (&pre);
+  rsa_public_precomp_clear (&pub_pre);
+
+  mpz_clear (m);
+  mpz_clear (x);
+  mpz_clear (ref);
+}
+
+static void
+test_mont_powm (gmp_randstate_t *rands)
+{
+  mpz_t m, a, e, r, ref;
+  mp_limb_t *r2, *ap, *rp, *scratch;
+  unsigned i;
+
+  mpz_init (m);
+  mpz_init (a);
+  mpz_init (e);
+  mpz_init (r);
+  mpz_init (ref);
+
+  for (i = 0; i < 10 * COUNT; i++)
+    {
+      struct rsa_mont mont;
+      mpz_t t;
+      mp_size_t n;
+      mp_size_t itch;
+      mp_bitcnt_t ebits;
+      unsigned w = 1 + i % RSA_POWM_MAX_WINDOW;
+
+      mpz_urandomb (r, *rands, 10);
+      mpz_rrandomb (m, *rands, 1 + mpz_get_ui (r));
+      mpz_setbit (m, 0);
+      if (mpz_cmp_ui (m, 1) == 0)
+	mpz_set_ui (m, 3);
+      n = mpz_size (m);
+
+      mpz_urandomb (a, *rands, n * GMP_NUMB_BITS);
+      mpz_fdiv_r (a, a, m);
+
+      mpz_urandomb (r, *rands, 10);
+      if (i & 1)
+	mpz_rrandomb (e, *rands, 1 + mpz_get_ui (r));
+      else
+	mpz_urandomb (e, *rands, 1 + mpz_get_ui (r));
+      if (mpz_sgn (e) == 0)
+	mpz_set_ui (e, 1);
+      /* Exact bit size, or a multiple of the limb size. */
+      ebits = (i & 2) ? mpz_sizeinbase (e, 2)
+	: mpz_size (e) * GMP_NUMB_BITS;
+
+      r2 = xalloc (n * sizeof (mp_limb_t));
+      ap = xalloc (n * sizeof (mp_limb_t));
+      rp = xalloc (n * sizeof (mp_limb_t));
+      itch = _rsa_mont_powm_itch (n, w);
+      if (itch < _rsa_mont_to_itch (n))
+	itch = _rsa_mont_to_itch (n);
+      scratch = xalloc (itch * sizeof (mp_limb_t));
+
+      _rsa_mont_r2 (r2, mpz_limbs_read (m), n, scratch);
+      mpz_set_ui (ref, 0);
+      mpz_setbit (ref, 2 * n * GMP_NUMB_BITS);
+      mpz_fdiv_r (ref, ref, m);
+      ASSERT (mpz_cmp (mpz_roinit_n (t, r2, n), ref) == 0);
+
+      mont.size = n;
+      mont.m = mpz_limbs_read (m);
+      mont.minv = _rsa_mont_minv (mont.m[0]);
+      mont.r2 = r2;
+
+      mpz_limbs_copy (ap, a, n);
+      _rsa_mont_to (&mont, rp, ap, n, scratch);
+      _rsa_mont_powm (&mont, w, rp, rp, mpz_limbs_read (e), ebits, scratch);
+      _rsa_mont_from (&mont, rp, rp, scratch);
+
+      mpz_powm (ref, a, e, m);
+      if (mpz_cmp (mpz_roinit_n (t, rp, n), ref) != 0)
+	{
+	  fprintf (stderr, "_rsa_mont_powm failed, w = %u:\nm = ", w);
+	  mpz_out_str (stderr, 16, m);
+	  fprintf (stderr, "\na = ");
+	  mpz_out_str (stderr, 16, a);
+	  fprintf (stderr, "\ne = ");
+	  mpz_out_str (stderr, 16, e);
+	  fprintf (stderr, "\nr = ");
+	  mpz_out_str (stderr, 16, t);
+	  fprintf (stderr, " (bad)\nref = ");
+	  mpz_out_str (stderr, 16, ref);
+	  fprintf (stderr, "\n");
+	  abort ();
+	}
+      free (r2);
+      free (ap);
+      free (rp);
+      free (scratch);
+    }
+
+  mpz_clear (m);
+  mpz_clear (a);
+  mpz_clear (e);
+  mpz_clear (r);
+  mpz_clear (ref);
+}
+
+/* Alternates between two keys of the same size, with one blinding
+   state, which must not use a blinding pair for the wrong modulus. */
+static void
+test_blinding_switch (gmp_randstate_t *rands)
+{
+  struct rsa_public_key pub[2];
+  struct rsa_private_key key[2];
+  struct rsa_private_precomp pre[2];
+  struct rsa_blinding blinding;
+  mpz_t m, x, ref;
+  unsigned i;
+
+  mpz_init (m);
+  mpz_init (x);
+  mpz_init (ref);
+
+  for (i = 0; i < 2; i++)
+    {
+      rsa_public_key_init (&pub[i]);
+      rsa_private_key_init (&key[i]);
+      mpz_set_ui (pub[i].e, 65537);
+      ASSERT (rsa_generate_keypair (&pub[i], &key[i], rands, random_fn,
+				    NULL, NULL, 512, 0));
+      ASSERT (rsa_private_precomp_init (&pre[i], &pub[i], &key[i]));
+    }
+  ASSERT (mpz_size (pub[0].n) == mpz_size (pub[1].n));
+  ASSERT (mpz_cmp (pub[0].n, pub[1].n) != 0);
+
+  rsa_blinding_init (&blinding);
+  for (i = 0; i < 2*RSA_BLINDING_REFRESH; i++)
+    {
+      /* Switch keys at varying positions in the refresh cycle. */
+      unsigned j = (i / 3) & 1;
+
+      mpz_urandomb (m, *rands, mpz_sizeinbase (pub[j].n, 2) - 1);
+      rsa_compute_root (&key[j], ref, m);
+      ASSERT (rsa_compute_root_tr_blinding (&pub[j], &key[j], &pre[j],
+					    &blinding, rands, random_fn,
+					    x, m));
+      ASSERT (mpz_cmp (x, ref) == 0);
+    }
+  rsa_blinding_clear (&blinding);
+
+  for (i = 0; i < 2; i++)
+    {
+      rsa_private_precomp_clear (&pre[i]);
+      rsa_public_key_clear (&pub[i]);
+      rsa_private_key_clear (&key[i]);
+    }
+  mpz_clear (m);
+  mpz_clear (x);
+  mpz_clear (ref);
+}
+
+void
+test_main (void)
+{
+  static const struct {
+    unsigned n_size;
+    unsigned e_size;
+    unsigned long e;
+  } keys[] = {
+    { 512, 0, 65537 },
+    { 777, 0, 3 },
+    { 1024, 0, 65537 },
+    { 600, 17, 0 },
+    { 700, 300, 0 },
+  };
+  gmp_randstate_t rands;
+  struct rsa_public_key pub;
+  struct rsa_private_key key;
+  struct rsa_public_precomp pub_pre;
+  unsigned i;
+
+  rsa_private_key_init (&key);
+  rsa_public_key_init (&pub);
+
+  gmp_randinit_default (rands);
+
+  test_mont_powm (&rands);
+  test_blinding_switch (&rands);
+
+  for (i = 0; i < sizeof (keys) / sizeof (keys[0]); i++)
+    {
+      if (keys[i].e)
+	mpz_set_ui (pub.e, keys[i].e);
+      ASSERT (rsa_generate_keypair (&pub, &key, &rands, random_fn,
+				    NULL, NULL,
+				    keys[i].n_size, keys[i].e_size));
+      test_precomp (&rands, &pub, &key);
+    }
+
+#if !NETTLE_USE_MINI_GMP
+  generate_unbalanced (rands, &pub, &key, 200, 450);
+  test_precomp (&rands, &pub, &key);
+  generate_unbalanced (rands, &pub, &key, 500, 130);
+  test_precomp (&rands, &pub, &key);
+
+  /* The main target of the multi-buffer root computation. */
+  mpz_set_ui (pub.e, 65537);
+  ASSERT (rsa_generate_keypair (&pub, &key, &rands, random_fn,
+				NULL, NULL, 2048, 0));
+  {
+    struct rsa_private_precomp pre;
+    ASSERT (rsa_private_precomp_init (&pre, &pub, &key));
+    test_mb (&rands, &pub, &key, &pre);
+    test_decrypt_batch (&rands, &pub, &key, &pre);
+    rsa_private_precomp_clear (&pre);
+  }
+#endif
+
+  /* Invalid key */
+  mpz_set_ui (pub.n, 1000);
+  ASSERT (!rsa_public_precomp_init (&pub_pre, &pub));
+  rsa_public_precomp_clear (&pub_pre);
+
+  rsa_public_key_clear (&pub);
+  rsa_private_key_clear (&key);
+
+  gmp_randclear (rands);
+}
@@ -180,6 +180,65 @@ test_cipher_siv(const char *name,
 		  sizeof(struct siv_cmac_aes256_ctx), SIV_CMAC_AES256_KEY_SIZE, \
 		  key, nonce, authdata, cleartext, ciphertext)
 
+#define SIV_MESSAGES 20
+
+/* Check that siv_cmac_aes128_encrypt_messages gives the same result
+   as one message at a time. */
+static void
+test_siv_messages(void)
+{
+  struct knuth_lfib_ctx random;
+  struct siv_cmac_aes128_ctx ctx;
+  uint8_t key[SIV_CMAC_AES128_KEY_SIZE];
+  uint8_t data[SIV_MESSAGES][100];
+  uint8_t out[SIV_MESSAGES][100 + SIV_DIGEST_SIZE];
+  uint8_t ref[100 + SIV_DIGEST_SIZE];
+  size_t nlengths[SIV_MESSAGES], alengths[SIV_MESSAGES];
+  size_t clengths[SIV_MESSAGES];
+  const uint8_t *nonces[SIV_MESSAGES], *adata[SIV_MESSAGES];
+  const uint8_t *src[SIV_MESSAGES];
+  uint8_t *dst[SIV_MESSAGES];
+  size_t i;
+
+  knuth_lfib_init(&random, 17);
+  knuth_lfib_random(&random, sizeof(key), key);
+  knuth_lfib_random(&random, sizeof(data), data[0]);
+
+  siv_cmac_aes128_set_key(&ctx, key);
+
+  for (i = 0; i < SIV_MESSAGES; i++)
+    {
+      /* Nonce, adata and cleartext are overlapping parts of data[i]. */
+      nlengths[i] = 1 + (i * 7) % 40;
+      alengths[i] = (i * 11) % 50;
+      clengths[i] = (i * 5) % 60 + SIV_DIGEST_SIZE;
+      nonces[i] = data[i];
+      adata[i] = data[i] + 10;
+      src[i] = data[i] + 30;
+      dst[i] = out[i];
+    }
+
+  siv_cmac_aes128_encrypt_messages(&ctx, SIV_MESSAGES, nlengths, nonces,
+				   alengths, adata, clengths, dst, src);
+
+  for (i = 0; i < SIV_MESSAGES; i++)
+    {
+      siv_cmac_aes128_encrypt_message(&ctx, nlengths[i], nonces[i],
+				      alengths[i], adata[i],
+				      clengths[i], ref, src[i]);
+      if (!MEMEQ(clengths[i], out[i], ref))
+	{
+	  fprintf(stderr, "siv_cmac_aes128_encrypt_messages failed, message %u\n",
+		  (unsigned) i);
+	  fprintf(stderr, "got: ");
+	  print_hex(clengths[i], out[i]);
+	  fprintf(stderr, "exp: ");
+	  print_hex(clengths[i], ref);
+	  FAIL();
+	}
+    }
+}
+
 void
 test_main(void)
 {
@@ -372,4 +431,6 @@ test_main(void)
 		       "0dcdaca0 cebf9dc6 cb90583f 5bf1506e"
 		       "02cd4883 2b00e4e5 98b2b22a 53e6199d"
 		       "4df0c166 6a35a043 3b250dc1 34d776"));
+
+  test_siv_messages();
 }
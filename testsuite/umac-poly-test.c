@@ -0,0 +1,227 @@
+#include "testutils.h"
+
+#include "knuth-lfib.h"
+#include "macros.h"
+#include "umac.h"
+#include "umac-internal.h"
+
+#define COUNT 10000
+
+/* Also works if unsigned long is only 32 bits. */
+static void
+set_u64 (mpz_t r, uint64_t x)
+{
+  mpz_set_ui (r, (unsigned long) (x >> 32));
+  mpz_mul_2exp (r, r, 32);
+  mpz_add_ui (r, r, (unsigned long) (x & 0xffffffff));
+}
+
+static void
+set_u128 (mpz_t r, uint64_t hi, uint64_t lo)
+{
+  mpz_t t;
+  mpz_init (t);
+  set_u64 (r, hi);
+  mpz_mul_2exp (r, r, 64);
+  set_u64 (t, lo);
+  mpz_add (r, r, t);
+  mpz_clear (t);
+}
+
+/* Reference for one polynomial step, y <- y k + m (mod p), where a
+   "marker" message is processed as the two words p - 1 and m - offset. */
+static void
+ref_poly (mpz_t y, const mpz_t k, const mpz_t m, int marker,
+	  unsigned offset, const mpz_t p)
+{
+  mpz_t t;
+  mpz_init_set (t, m);
+  if (marker)
+    {
+      mpz_mul (y, y, k);
+      mpz_sub_ui (y, y, 1);
+      mpz_fdiv_r (y, y, p);
+      mpz_sub_ui (t, t, offset);
+    }
+  mpz_mul (y, y, k);
+  mpz_add (y, y, t);
+  mpz_fdiv_r (y, y, p);
+  mpz_clear (t);
+}
+
+static void
+check_poly64 (uint32_t kh, uint32_t kl, uint64_t y, uint64_t m,
+	      const mpz_t p)
+{
+  mpz_t k, ry, rm, r;
+  uint64_t res;
+
+  mpz_init (k);
+  mpz_init (ry);
+  mpz_init (rm);
+  mpz_init (r);
+
+  set_u128 (k, 0, ((uint64_t) kh << 32) | kl);
+  set_u64 (ry, y);
+  set_u64 (rm, m);
+  ref_poly (ry, k, rm, (m >> 32) == 0xffffffff, UMAC_P64_OFFSET, p);
+
+  res = _umac_poly64 (kh, kl, y, m);
+  set_u64 (r, res);
+  mpz_fdiv_r (r, r, p);
+  if (mpz_cmp (r, ry) != 0)
+    {
+      fprintf (stderr, "_umac_poly64 failed:\n"
+	       "k = %08lx%08lx, y = %016llx, m = %016llx\n"
+	       "res = %016llx, ref = ",
+	       (unsigned long) kh, (unsigned long) kl,
+	       (unsigned long long) y, (unsigned long long) m,
+	       (unsigned long long) res);
+      mpz_out_str (stderr, 16, ry);
+      fprintf (stderr, "\n");
+      abort ();
+    }
+  mpz_clear (k);
+  mpz_clear (ry);
+  mpz_clear (rm);
+  mpz_clear (r);
+}
+
+static void
+check_poly128 (const uint32_t *key, uint64_t yh, uint64_t yl,
+	       uint64_t mh, uint64_t ml, const mpz_t p)
+{
+  mpz_t k, ry, rm, r;
+  uint64_t y[2];
+
+  mpz_init (k);
+  mpz_init (ry);
+  mpz_init (rm);
+  mpz_init (r);
+
+  set_u128 (k, ((uint64_t) key[0] << 32) | key[1],
+	    ((uint64_t) key[2] << 32) | key[3]);
+  set_u128 (ry, yh, yl);
+  set_u128 (rm, mh, ml);
+  ref_poly (ry, k, rm, (mh >> 32) == 0xffffffff, UMAC_P128_OFFSET, p);
+
+  y[0] = yh;
+  y[1] = yl;
+  _umac_poly128 (key, y, mh, ml);
+  set_u128 (r, y[0], y[1]);
+  mpz_fdiv_r (r, r, p);
+  if (mpz_cmp (r, ry) != 0)
+    {
+      fprintf (stderr, "_umac_poly128 failed:\n"
+	       "k = %08lx%08lx%08lx%08lx\n"
+	       "y = %016llx%016llx, m = %016llx%016llx\n"
+	       "res = %016llx%016llx, ref = ",
+	       (unsigned long) key[0], (unsigned long) key[1],
+	       (unsigned long) key[2], (unsigned long) key[3],
+	       (unsigned long long) yh, (unsigned long long) yl,
+	       (unsigned long long) mh, (unsigned long long) ml,
+	       (unsigned long long) y[0], (unsigned long long) y[1]);
+      mpz_out_str (stderr, 16, ry);
+      fprintf (stderr, "\n");
+      abort ();
+    }
+  mpz_clear (k);
+  mpz_clear (ry);
+  mpz_clear (rm);
+  mpz_clear (r);
+}
+
+/* Interesting values for state and message words: zero, values
+   around p, and maximum values, both with and without the marker
+   prefix 0xffffffff. */
+static const uint64_t special[] =
+  {
+    0, 1, 2, 0x7fffffffffffffffULL,
+    0xfffffffeffffffffULL, 0xffffffff00000000ULL,
+    0xffffffff00000001ULL,
+    0xffffffffffffffc3ULL, /* p64 - 2 */
+    0xffffffffffffffc4ULL, /* p64 - 1 */
+    0xffffffffffffffc5ULL, /* p64 */
+    0xffffffffffffffc6ULL, /* p64 + 1 */
+    0xffffffffffffff60ULL, /* p128_lo - 1 */
+    0xffffffffffffff61ULL, /* p128_lo */
+    0xfffffffffffffffeULL,
+    0xffffffffffffffffULL,
+  };
+#define SPECIAL_COUNT (sizeof (special) / sizeof (special[0]))
+
+static uint64_t
+get_u64 (struct knuth_lfib_ctx *lfib)
+{
+  uint8_t b[8];
+  knuth_lfib_random (lfib, sizeof (b), b);
+  return READ_UINT64 (b);
+}
+
+static uint64_t
+get_word (struct knuth_lfib_ctx *lfib)
+{
+  uint32_t i = knuth_lfib_get (lfib);
+  if (i & 1)
+    return special[(i >> 1) % SPECIAL_COUNT];
+  return get_u64 (lfib);
+}
+
+/* Random 25-bit key word, the format after _umac_l2_init, with the
+   largest value favoured. */
+static uint32_t
+get_key (struct knuth_lfib_ctx *lfib)
+{
+  uint32_t k = knuth_lfib_get (lfib);
+  return (k & 3) ? (k >> 2) & 0x01ffffff : 0x01ffffff;
+}
+
+void
+test_main (void)
+{
+  struct knuth_lfib_ctx lfib;
+  mpz_t p64, p128;
+  uint32_t key[4];
+  unsigned i, j, l;
+
+  mpz_init (p64);
+  mpz_init (p128);
+  mpz_setbit (p64, 64);
+  mpz_sub_ui (p64, p64, UMAC_P64_OFFSET);
+  mpz_setbit (p128, 128);
+  mpz_sub_ui (p128, p128, UMAC_P128_OFFSET);
+
+  knuth_lfib_init (&lfib, 17);
+
+  /* All pairs of special values, including y = 0 with a marker
+     message, which borrows into p - 1. */
+  for (l = 0; l < 3; l++)
+    {
+      for (i = 0; i < 4; i++)
+	key[i] = l == 0 ? 0x01ffffff : l == 1 ? 1 : get_key (&lfib);
+
+      for (i = 0; i < SPECIAL_COUNT; i++)
+	for (j = 0; j < SPECIAL_COUNT; j++)
+	  {
+	    check_poly64 (key[0], key[1], special[i], special[j], p64);
+	    check_poly128 (key, special[i], special[j],
+			   special[j], special[i], p128);
+	    check_poly128 (key, 0, special[i], special[j], 0, p128);
+	    check_poly128 (key, special[i], 0, 0xffffffffffffffffULL,
+			   special[j], p128);
+	  }
+    }
+
+  for (i = 0; i < COUNT; i++)
+    {
+      for (j = 0; j < 4; j++)
+	key[j] = get_key (&lfib);
+
+      check_poly64 (key[0], key[1], get_word (&lfib), get_word (&lfib), p64);
+      check_poly128 (key, get_word (&lfib), get_word (&lfib),
+		     get_word (&lfib), get_word (&lfib), p128);
+    }
+
+  mpz_clear (p64);
+  mpz_clear (p128);
+}
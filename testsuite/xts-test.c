@@ -2,6 +2,9 @@
 #include "aes.h"
 #include "xts.h"
 #include "nettle-internal.h"
+#include "knuth-lfib.h"
+#include "macros.h"
+#include "memxor.h"
 
 static void
 test_check_data(const char *operation,
@@ -107,6 +110,204 @@ test_cipher_xts(const struct nettle_cipher *cipher,
   free(data2);
 }
 
+/* Straightforward one block at a time reference, for messages of
+   complete blocks only. */
+static void
+xts_reference_encrypt(const struct nettle_cipher *cipher,
+		      const void *ctx, const void *twk_ctx,
+		      const uint8_t *tweak, size_t length,
+		      uint8_t *dst, const uint8_t *src)
+{
+  uint8_t T[XTS_BLOCK_SIZE];
+  uint8_t P[XTS_BLOCK_SIZE];
+
+  ASSERT (length % XTS_BLOCK_SIZE == 0);
+
+  cipher->encrypt(twk_ctx, XTS_BLOCK_SIZE, T, tweak);
+  for (; length > 0;
+       length -= XTS_BLOCK_SIZE, src += XTS_BLOCK_SIZE, dst += XTS_BLOCK_SIZE)
+    {
+      unsigned carry, i;
+
+      memxor3(P, src, T, XTS_BLOCK_SIZE);
+      cipher->encrypt(ctx, XTS_BLOCK_SIZE, dst, P);
+      memxor(dst, T, XTS_BLOCK_SIZE);
+
+      /* Multiply T by x, little-endian */
+      for (i = 0, carry = 0; i < XTS_BLOCK_SIZE; i++)
+	{
+	  unsigned b = T[i];
+	  T[i] = (b << 1) | carry;
+	  carry = b >> 7;
+	}
+      if (carry)
+	T[0] ^= 0x87;
+    }
+}
+
+#define MAX_SECTORS 9
+#define MAX_SECTOR_SIZE 4096
+
+/* Checks the sector functions against per-sector calls to
+   xts_encrypt_message, with lengths spanning several batches of
+   blocks, and with non-consecutive sector numbers and buffers. */
+static void
+test_xts_sectors(const struct nettle_cipher *cipher)
+{
+  static const size_t sector_sizes[] = { 16, 17, 512, 520, 4096 };
+  void *twk_ctx = xalloc(cipher->context_size);
+  void *ctx = xalloc(cipher->context_size);
+  uint8_t *key = xalloc(2 * cipher->key_size);
+  uint8_t *clear = xalloc(MAX_SECTORS * MAX_SECTOR_SIZE);
+  uint8_t *in = xalloc(MAX_SECTORS * MAX_SECTOR_SIZE);
+  uint8_t *data = xalloc(MAX_SECTORS * MAX_SECTOR_SIZE);
+  uint8_t *ref = xalloc(MAX_SECTORS * MAX_SECTOR_SIZE);
+  uint64_t sectors[MAX_SECTORS];
+  const uint8_t *src[MAX_SECTORS];
+  uint8_t *dst[MAX_SECTORS];
+  uint8_t *ref_dst[MAX_SECTORS];
+  struct knuth_lfib_ctx lfib;
+  uint64_t start = 0xfffffffffffffff0ULL;
+  unsigned i;
+
+  knuth_lfib_init(&lfib, 4711);
+  knuth_lfib_random(&lfib, 2 * cipher->key_size, key);
+  knuth_lfib_random(&lfib, MAX_SECTORS * MAX_SECTOR_SIZE, clear);
+
+  cipher->set_encrypt_key(twk_ctx, key + cipher->key_size);
+
+  for (i = 0; i < sizeof(sector_sizes) / sizeof(sector_sizes[0]); i++)
+    {
+      size_t sector_size = sector_sizes[i];
+      size_t count;
+
+      for (count = 1; count <= MAX_SECTORS; count++)
+	{
+	  size_t length = count * sector_size;
+	  size_t j;
+
+	  cipher->set_encrypt_key(ctx, key);
+	  for (j = 0; j < count; j++)
+	    {
+	      /* Sector j is stored in reverse order, and the sector
+		 numbers wrap around. */
+	      size_t offset = (count - 1 - j) * sector_size;
+	      uint8_t tweak[XTS_BLOCK_SIZE];
+
+	      sectors[j] = start + 5 * j;
+	      src[j] = in + offset;
+	      dst[j] = data + offset;
+	      memcpy(in + offset, clear + j * sector_size, sector_size);
+
+	      memset(tweak, 0, sizeof(tweak));
+	      LE_WRITE_UINT64(tweak, sectors[j]);
+	      xts_encrypt_message(ctx, twk_ctx, cipher->encrypt, tweak,
+				  sector_size, ref + offset,
+				  clear + j * sector_size);
+
+	      if (sector_size % XTS_BLOCK_SIZE == 0)
+		{
+		  xts_reference_encrypt(cipher, ctx, twk_ctx, tweak,
+					sector_size, data, clear + j * sector_size);
+		  test_check_data("reference", clear + j * sector_size,
+				  ref + offset, data, sector_size);
+		}
+	    }
+
+	  xts_encrypt_sectors(ctx, twk_ctx, cipher->encrypt,
+			      count, sectors, sector_size, dst, src);
+	  test_check_data("sector encrypt", in, data, ref, length);
+
+	  cipher->set_decrypt_key(ctx, key);
+	  xts_decrypt_sectors(ctx, twk_ctx, cipher->decrypt, cipher->encrypt,
+			      count, sectors, sector_size,
+			      dst, (const uint8_t * const *) dst);
+	  test_check_data("sector decrypt", ref, data, in, length);
+	}
+    }
+
+  for (i = 0; i < MAX_SECTORS; i++)
+    {
+      sectors[i] = start + i;
+      src[i] = clear + i * 512;
+      dst[i] = data + i * 512;
+      ref_dst[i] = ref + i * 512;
+    }
+
+  /* make sure the cipher specific functions work the same */
+  if (cipher == &nettle_aes128)
+    {
+      struct xts_aes128_key xts_key;
+
+      xts_aes128_set_encrypt_key(&xts_key, key);
+      xts_aes128_encrypt_sectors(&xts_key, MAX_SECTORS, sectors, 512,
+				 dst, src);
+      cipher->set_encrypt_key(ctx, key);
+      xts_encrypt_sectors(ctx, twk_ctx, cipher->encrypt,
+			  MAX_SECTORS, sectors, 512, ref_dst, src);
+      test_check_data("sector encrypt", clear, data, ref, MAX_SECTORS * 512);
+
+      xts_aes128_set_decrypt_key(&xts_key, key);
+      xts_aes128_decrypt_sectors(&xts_key, MAX_SECTORS, sectors, 512,
+				 dst, (const uint8_t * const *) ref_dst);
+      test_check_data("sector decrypt", ref, data, clear, MAX_SECTORS * 512);
+    }
+  if (cipher == &nettle_aes256)
+    {
+      struct xts_aes256_key xts_key;
+
+      xts_aes256_set_encrypt_key(&xts_key, key);
+      xts_aes256_encrypt_sectors(&xts_key, MAX_SECTORS, sectors, 512,
+				 dst, src);
+      cipher->set_encrypt_key(ctx, key);
+      xts_encrypt_sectors(ctx, twk_ctx, cipher->encrypt,
+			  MAX_SECTORS, sectors, 512, ref_dst, src);
+      test_check_data("sector encrypt", clear, data, ref, MAX_SECTORS * 512);
+
+      xts_aes256_set_decrypt_key(&xts_key, key);
+      xts_aes256_decrypt_sectors(&xts_key, MAX_SECTORS, sectors, 512,
+				 dst, (const uint8_t * const *) ref_dst);
+      test_check_data("sector decrypt", ref, data, clear, MAX_SECTORS * 512);
+    }
+  if (cipher == &nettle_kuznyechik)
+    {
+      struct xts_kuznyechik_key xts_key;
+      uint8_t tweak[XTS_BLOCK_SIZE];
+
+      memset(tweak, 0, sizeof(tweak));
+      LE_WRITE_UINT64(tweak, start);
+
+      xts_kuznyechik_set_encrypt_key(&xts_key, key);
+      xts_kuznyechik_encrypt_message(&xts_key, tweak, 520, data, clear);
+      cipher->set_encrypt_key(ctx, key);
+      xts_encrypt_message(ctx, twk_ctx, cipher->encrypt, tweak,
+			  520, ref, clear);
+      test_check_data("encrypt", clear, data, ref, 520);
+
+      xts_kuznyechik_set_decrypt_key(&xts_key, key);
+      xts_kuznyechik_decrypt_message(&xts_key, tweak, 520, data, ref);
+      test_check_data("decrypt", ref, data, clear, 520);
+
+      xts_kuznyechik_encrypt_sectors(&xts_key, MAX_SECTORS, sectors, 512,
+				     dst, src);
+      xts_encrypt_sectors(ctx, twk_ctx, cipher->encrypt,
+			  MAX_SECTORS, sectors, 512, ref_dst, src);
+      test_check_data("sector encrypt", clear, data, ref, MAX_SECTORS * 512);
+
+      xts_kuznyechik_decrypt_sectors(&xts_key, MAX_SECTORS, sectors, 512,
+				     dst, (const uint8_t * const *) ref_dst);
+      test_check_data("sector decrypt", ref, data, clear, MAX_SECTORS * 512);
+    }
+
+  free(twk_ctx);
+  free(ctx);
+  free(key);
+  free(clear);
+  free(in);
+  free(data);
+  free(ref);
+}
+
 void
 test_main(void)
 {
@@ -170,4 +371,8 @@ test_main(void)
 		  SHEX("c73256870cc2f4dd57acc74b5456dbd7"
                        "76912a128bc1f77d72cdebbf270044b7"
                        "a43ceed29025e1e8be211fa3c3ed002d"));
+
+  test_xts_sectors(&nettle_aes128);
+  test_xts_sectors(&nettle_aes256);
+  test_xts_sectors(&nettle_kuznyechik);
 }
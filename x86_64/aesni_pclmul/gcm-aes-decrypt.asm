@@ -0,0 +1,134 @@
+C x86_64/aesni_pclmul/gcm-aes-decrypt.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+C Stitched AES-CTR and GHASH. Each iteration encrypts eight counter
+C blocks, with the GHASH of the corresponding eight ciphertext blocks
+C interleaved with the AES rounds, so that the aesenc and pclmulqdq
+C latencies overlap, and the data is read only once.
+
+C Register usage:
+
+define(<CTX>, <%rdi>)
+define(<ROUNDS>, <%esi>)
+define(<LENGTH>, <%rdx>)
+define(<DST>, <%rcx>)
+define(<SRC>, <%r8>)
+define(<CNT>, <%r9d>)
+define(<CNT64>, <%r9>)
+define(<KEYS>, <%r10>)
+define(<LAST>, <%r11>)
+define(<TMP>, <%rbx>)
+
+define(<B0>, <%xmm0>)
+define(<B1>, <%xmm1>)
+define(<B2>, <%xmm2>)
+define(<B3>, <%xmm3>)
+define(<B4>, <%xmm4>)
+define(<B5>, <%xmm5>)
+define(<B6>, <%xmm6>)
+define(<B7>, <%xmm7>)
+define(<K>, <%xmm8>)
+define(<X>, <%xmm9>)
+define(<LO>, <%xmm10>)
+define(<HI>, <%xmm11>)
+define(<MID>, <%xmm12>)
+define(<D>, <%xmm13>)
+define(<T>, <%xmm14>)
+define(<H>, <%xmm15>)
+define(<BSWAP>, <.Lbswap(%rip)>)
+
+include_src(<x86_64/pclmul/ghash.m4>)
+include_src(<x86_64/aesni_pclmul/gcm-aes.m4>)
+
+	.file "gcm-aes-decrypt.asm"
+
+	C size_t _gcm_aes_decrypt (struct gcm_key *key, unsigned rounds,
+	C                          size_t length, uint8_t *dst,
+	C                          const uint8_t *src)
+
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_gcm_aes_decrypt)
+	W64_ENTRY(5, 16)
+	and	$-128, LENGTH
+	mov	LENGTH, %rax
+	jz	.Lend
+
+	push	TMP
+	lea	AES_OFFSET<>(CTX), KEYS
+	mov	ROUNDS, XREG(LAST)
+	shl	$4, LAST
+	add	KEYS, LAST
+	mov	CTR_OFFSET+12<>(CTX), CNT
+	bswap	CNT
+	LOAD_BLOCK(X, X_OFFSET<>(CTX))
+
+	ALIGN(16)
+.Loop:
+	CTR_BLOCKS
+	AES_FIRST((KEYS))
+	GHASH_ZERO
+	AES_ROUND(16(KEYS))
+	GHASH_BLOCK(0, (SRC))
+	AES_ROUND(32(KEYS))
+	GHASH_BLOCK(1, 16(SRC))
+	AES_ROUND(48(KEYS))
+	GHASH_BLOCK(2, 32(SRC))
+	AES_ROUND(64(KEYS))
+	GHASH_BLOCK(3, 48(SRC))
+	AES_ROUND(80(KEYS))
+	GHASH_BLOCK(4, 64(SRC))
+	AES_ROUND(96(KEYS))
+	GHASH_BLOCK(5, 80(SRC))
+	AES_ROUND(112(KEYS))
+	GHASH_BLOCK(6, 96(SRC))
+	AES_ROUND(128(KEYS))
+	GHASH_BLOCK(7, 112(SRC))
+	AES_ROUND(144(KEYS))
+	GHASH_REDUCE
+	AES_TAIL(loop)
+	XOR_STORE
+	sub	$128, LENGTH
+	jnz	.Loop
+
+	pshufb	BSWAP, X
+	movups	X, X_OFFSET<>(CTX)
+	bswap	CNT
+	mov	CNT, CTR_OFFSET+12<>(CTX)
+	pop	TMP
+.Lend:
+	W64_EXIT(5, 16)
+	ret
+EPILOGUE(_nettle_gcm_aes_decrypt)
+
+	RODATA
+	ALIGN(16)
+.Lbswap:
+	.byte	15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0
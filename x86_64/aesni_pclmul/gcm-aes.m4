@@ -0,0 +1,142 @@
+C x86_64/aesni_pclmul/gcm-aes.m4
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+C Offsets in struct gcm_aes128_ctx, struct gcm_aes192_ctx and struct
+C gcm_aes256_ctx, all laid out by GCM_CTX. The key starts with H^1,
+C ..., H^8, as set up by the pclmul _gcm_init_key.
+define(<CTR_OFFSET>, <4112>)
+define(<X_OFFSET>, <4128>)
+define(<AES_OFFSET>, <4160>)
+
+C CTR_BLOCKS, loads eight counter blocks into B0, ..., B7, using
+C and advancing the 32-bit counter CNT.
+define(<CTR_BLOCK>, <
+	lea	$2(CNT64), XREG(TMP)
+	bswap	XREG(TMP)
+	movups	CTR_OFFSET<>(CTX), $1
+	pinsrd	<$>3, XREG(TMP), $1
+>)
+define(<CTR_BLOCKS>, <
+	CTR_BLOCK(B0, 0)
+	CTR_BLOCK(B1, 1)
+	CTR_BLOCK(B2, 2)
+	CTR_BLOCK(B3, 3)
+	CTR_BLOCK(B4, 4)
+	CTR_BLOCK(B5, 5)
+	CTR_BLOCK(B6, 6)
+	CTR_BLOCK(B7, 7)
+	add	<$>8, CNT
+>)
+
+C AES_FIRST(subkey), AES_ROUND(subkey) and AES_LAST(subkey) apply
+C the first, middle and last AES rounds to B0, ..., B7.
+define(<AES_FIRST>, <
+	movups	$1, K
+	pxor	K, B0
+	pxor	K, B1
+	pxor	K, B2
+	pxor	K, B3
+	pxor	K, B4
+	pxor	K, B5
+	pxor	K, B6
+	pxor	K, B7
+>)
+define(<AES_ROUND>, <
+	movups	$1, K
+	aesenc	K, B0
+	aesenc	K, B1
+	aesenc	K, B2
+	aesenc	K, B3
+	aesenc	K, B4
+	aesenc	K, B5
+	aesenc	K, B6
+	aesenc	K, B7
+>)
+define(<AES_LAST>, <
+	movups	$1, K
+	aesenclast	K, B0
+	aesenclast	K, B1
+	aesenclast	K, B2
+	aesenclast	K, B3
+	aesenclast	K, B4
+	aesenclast	K, B5
+	aesenclast	K, B6
+	aesenclast	K, B7
+>)
+
+C AES_TAIL(label), the rounds from 10 on, for 10, 12 or 14 rounds.
+define(<AES_TAIL>, <
+	cmp	<$>10, ROUNDS
+	je	.Laes_last$1
+	AES_ROUND(160(KEYS))
+	AES_ROUND(176(KEYS))
+	cmp	<$>12, ROUNDS
+	je	.Laes_last$1
+	AES_ROUND(192(KEYS))
+	AES_ROUND(208(KEYS))
+.Laes_last$1:
+	AES_LAST((LAST))
+>)
+
+C GHASH_BLOCK(i, block), adds block i of the eight blocks hashed
+C together, multiplied by H^(8-i). For i = 0, the hash state X is
+C added to the block first.
+define(<GHASH_BLOCK>, <
+	LOAD_BLOCK(D, $2)
+	ifelse($1, 0, <pxor	X, D>)
+	movups	eval(112 - 16*$1)(CTX), H
+	GHASH_ACC(D, H)
+>)
+
+define(<GHASH_ZERO>, <
+	pxor	LO, LO
+	pxor	HI, HI
+	pxor	MID, MID
+>)
+
+C XOR_STORE, xors the key stream in B0, ..., B7 with 128 bytes at
+C SRC, stores the result at DST, and advances both pointers.
+define(<XOR_STORE_BLOCK>, <
+	movups	$2(SRC), T
+	pxor	T, $1
+	movups	$1, $2(DST)
+>)
+define(<XOR_STORE>, <
+	XOR_STORE_BLOCK(B0, 0)
+	XOR_STORE_BLOCK(B1, 16)
+	XOR_STORE_BLOCK(B2, 32)
+	XOR_STORE_BLOCK(B3, 48)
+	XOR_STORE_BLOCK(B4, 64)
+	XOR_STORE_BLOCK(B5, 80)
+	XOR_STORE_BLOCK(B6, 96)
+	XOR_STORE_BLOCK(B7, 112)
+	add	<$>128, SRC
+	add	<$>128, DST
+>)
@@ -0,0 +1,246 @@
+C x86_64/chacha-4core.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+C Four blocks are processed in parallel, with each xmm register
+C holding the same state word for all four blocks. That needs 16
+C registers for the state, so two of the four words in the third row
+C are kept on the stack, and swapped in and out between pairs of
+C quarter rounds.
+
+define(<DST>, <%rdi>)
+define(<SRC>, <%rsi>)
+define(<COUNT>, <%rdx>)
+
+define(<A0>, <%xmm0>)
+define(<A1>, <%xmm1>)
+define(<A2>, <%xmm2>)
+define(<A3>, <%xmm3>)
+define(<B0>, <%xmm4>)
+define(<B1>, <%xmm5>)
+define(<B2>, <%xmm6>)
+define(<B3>, <%xmm7>)
+define(<D0>, <%xmm8>)
+define(<D1>, <%xmm9>)
+define(<D2>, <%xmm10>)
+define(<D3>, <%xmm11>)
+define(<CA>, <%xmm12>)
+define(<CB>, <%xmm13>)
+define(<T0>, <%xmm14>)
+define(<T1>, <%xmm15>)
+
+C ROTL(n, x, tmp)
+define(<ROTL>, <
+	movdqa	$2, $3
+	pslld	<$>$1, $2
+	psrld	<$>eval(32 - $1), $3
+	por	$3, $2
+>)
+
+C ROTL_BY_16(x)
+define(<ROTL_BY_16>, <
+	pshufhw	<$>0xb1, $1, $1
+	pshuflw	<$>0xb1, $1, $1
+>)
+
+C QROUND2(a, b, c, d, a', b', c', d'), two independent quarter rounds
+define(<QROUND2>, <
+	paddd	$2, $1
+	paddd	$6, $5
+	pxor	$1, $4
+	pxor	$5, $8
+	ROTL_BY_16($4)
+	ROTL_BY_16($8)
+
+	paddd	$4, $3
+	paddd	$8, $7
+	pxor	$3, $2
+	pxor	$7, $6
+	ROTL(12, $2, T0)
+	ROTL(12, $6, T1)
+
+	paddd	$2, $1
+	paddd	$6, $5
+	pxor	$1, $4
+	pxor	$5, $8
+	ROTL(8, $4, T0)
+	ROTL(8, $8, T1)
+
+	paddd	$4, $3
+	paddd	$8, $7
+	pxor	$3, $2
+	pxor	$7, $6
+	ROTL(7, $2, T0)
+	ROTL(7, $6, T1)
+>)
+
+C TRANSPOSE(r0, r1, r2, r3), leaves the rows in r1, T0, r3, r0
+define(<TRANSPOSE>, <
+	movdqa	$1, T0
+	punpckldq	$2, T0
+	punpckhdq	$2, $1
+	movdqa	$3, T1
+	punpckldq	$4, T1
+	punpckhdq	$4, $3
+	movdqa	T0, $2
+	punpcklqdq	T1, $2
+	punpckhqdq	T1, T0
+	movdqa	$1, $4
+	punpcklqdq	$3, $4
+	punpckhqdq	$3, $1
+>)
+
+C OUTPUT(r0, r1, r2, r3, offset), adds in the input words at offset,
+C and stores the corresponding 16 bytes of each of the four blocks.
+define(<OUTPUT>, <
+	movups	$5(SRC), T0
+	pshufd	<$>0x00, T0, T1
+	paddd	T1, $1
+	pshufd	<$>0x55, T0, T1
+	paddd	T1, $2
+	pshufd	<$>0xaa, T0, T1
+	paddd	T1, $3
+	pshufd	<$>0xff, T0, T1
+	paddd	T1, $4
+	STORE($1, $2, $3, $4, $5)
+>)
+
+define(<STORE>, <
+	TRANSPOSE($1, $2, $3, $4)
+	movups	$2, $5(DST)
+	movups	T0, eval($5 + 64)(DST)
+	movups	$4, eval($5 + 128)(DST)
+	movups	$1, eval($5 + 192)(DST)
+>)
+
+	.file "chacha-4core.asm"
+
+	C _chacha_4core(uint32_t *dst, const uint32_t *src, unsigned rounds)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_chacha_4core)
+	W64_ENTRY(3, 16)
+	sub	$64, %rsp
+
+	movups	(SRC), T0
+	pshufd	$0x00, T0, A0
+	pshufd	$0x55, T0, A1
+	pshufd	$0xaa, T0, A2
+	pshufd	$0xff, T0, A3
+	movups	16(SRC), T0
+	pshufd	$0x00, T0, B0
+	pshufd	$0x55, T0, B1
+	pshufd	$0xaa, T0, B2
+	pshufd	$0xff, T0, B3
+	movups	32(SRC), T0
+	pshufd	$0x00, T0, CA
+	pshufd	$0x55, T0, CB
+	pshufd	$0xaa, T0, T1
+	movups	T1, 32(%rsp)
+	pshufd	$0xff, T0, T1
+	movups	T1, 48(%rsp)
+	movups	48(SRC), T0
+	pshufd	$0x00, T0, D0
+	pshufd	$0x55, T0, D1
+	pshufd	$0xaa, T0, D2
+	pshufd	$0xff, T0, D3
+
+	C Block i uses counter + i, with carry into the high word.
+	movdqa	D0, T1
+	paddd	.Lcount(%rip), D0
+	pxor	.Lsign(%rip), T1
+	movdqa	D0, T0
+	pxor	.Lsign(%rip), T0
+	pcmpgtd	T0, T1
+	psubd	T1, D1
+
+	shrl	$1, XREG(COUNT)
+
+	ALIGN(16)
+.Loop:
+	C Column round, with c0, c1 in registers
+	QROUND2(A0, B0, CA, D0, A1, B1, CB, D1)
+	movups	CA, (%rsp)
+	movups	CB, 16(%rsp)
+	movups	32(%rsp), CA
+	movups	48(%rsp), CB
+	QROUND2(A2, B2, CA, D2, A3, B3, CB, D3)
+
+	C Diagonal round, starting with c2, c3 in registers
+	QROUND2(A0, B1, CA, D3, A1, B2, CB, D0)
+	movups	CA, 32(%rsp)
+	movups	CB, 48(%rsp)
+	movups	(%rsp), CA
+	movups	16(%rsp), CB
+	QROUND2(A2, B3, CA, D1, A3, B0, CB, D2)
+
+	decl	XREG(COUNT)
+	jnz	.Loop
+
+	movups	CA, (%rsp)
+	movups	CB, 16(%rsp)
+
+	OUTPUT(A0, A1, A2, A3, 0)
+	OUTPUT(B0, B1, B2, B3, 16)
+
+	movups	(%rsp), A0
+	movups	16(%rsp), A1
+	movups	32(%rsp), A2
+	movups	48(%rsp), A3
+	OUTPUT(A0, A1, A2, A3, 32)
+
+	C Recompute the counters, using the free B registers.
+	movups	48(SRC), T0
+	pshufd	$0x00, T0, B0
+	movdqa	B0, B1
+	paddd	.Lcount(%rip), B0
+	paddd	B0, D0
+	pxor	.Lsign(%rip), B1
+	pxor	.Lsign(%rip), B0
+	pcmpgtd	B0, B1
+	pshufd	$0x55, T0, B2
+	psubd	B1, B2
+	paddd	B2, D1
+	pshufd	$0xaa, T0, T1
+	paddd	T1, D2
+	pshufd	$0xff, T0, T1
+	paddd	T1, D3
+	STORE(D0, D1, D2, D3, 48)
+
+	add	$64, %rsp
+	W64_EXIT(3, 16)
+	ret
+EPILOGUE(_nettle_chacha_4core)
+
+	RODATA
+	ALIGN(16)
+.Lcount:
+	.long	0, 1, 2, 3
+.Lsign:
+	.long	0x80000000, 0x80000000, 0x80000000, 0x80000000
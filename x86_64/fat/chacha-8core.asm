@@ -0,0 +1,238 @@
+C x86_64/fat/chacha-8core.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+define(<fat_transform>, <$1_avx2>)
+
+C Same structure as x86_64/chacha-4core.asm, with the eight 32-bit
+C lanes of each ymm register holding one state word of eight blocks.
+
+define(<DST>, <%rdi>)
+define(<SRC>, <%rsi>)
+define(<COUNT>, <%rdx>)
+
+define(<A0>, <%ymm0>)
+define(<A1>, <%ymm1>)
+define(<A2>, <%ymm2>)
+define(<A3>, <%ymm3>)
+define(<B0>, <%ymm4>)
+define(<B1>, <%ymm5>)
+define(<B2>, <%ymm6>)
+define(<B3>, <%ymm7>)
+define(<D0>, <%ymm8>)
+define(<D1>, <%ymm9>)
+define(<D2>, <%ymm10>)
+define(<D3>, <%ymm11>)
+define(<CA>, <%ymm12>)
+define(<CB>, <%ymm13>)
+define(<T0>, <%ymm14>)
+define(<T1>, <%ymm15>)
+
+C ROTL(n, x, tmp)
+define(<ROTL>, <
+	vpslld	<$>$1, $2, $3
+	vpsrld	<$>eval(32 - $1), $2, $2
+	vpor	$3, $2, $2
+>)
+
+C QROUND2(a, b, c, d, a', b', c', d'), two independent quarter rounds
+define(<QROUND2>, <
+	vpaddd	$2, $1, $1
+	vpaddd	$6, $5, $5
+	vpxor	$1, $4, $4
+	vpxor	$5, $8, $8
+	vpshufb	.Lrot16(%rip), $4, $4
+	vpshufb	.Lrot16(%rip), $8, $8
+
+	vpaddd	$4, $3, $3
+	vpaddd	$8, $7, $7
+	vpxor	$3, $2, $2
+	vpxor	$7, $6, $6
+	ROTL(12, $2, T0)
+	ROTL(12, $6, T1)
+
+	vpaddd	$2, $1, $1
+	vpaddd	$6, $5, $5
+	vpxor	$1, $4, $4
+	vpxor	$5, $8, $8
+	vpshufb	.Lrot8(%rip), $4, $4
+	vpshufb	.Lrot8(%rip), $8, $8
+
+	vpaddd	$4, $3, $3
+	vpaddd	$8, $7, $7
+	vpxor	$3, $2, $2
+	vpxor	$7, $6, $6
+	ROTL(7, $2, T0)
+	ROTL(7, $6, T1)
+>)
+
+C TRANSPOSE(r0, r1, r2, r3), transposes each 128-bit half, leaving
+C the rows in r1, T0, r3, r0
+define(<TRANSPOSE>, <
+	vpunpckldq	$2, $1, T0
+	vpunpckhdq	$2, $1, $1
+	vpunpckldq	$4, $3, T1
+	vpunpckhdq	$4, $3, $3
+	vpunpcklqdq	T1, T0, $2
+	vpunpckhqdq	T1, T0, T0
+	vpunpcklqdq	$3, $1, $4
+	vpunpckhqdq	$3, $1, $1
+>)
+
+C OUTPUT(r0, r1, r2, r3, offset), adds in the input words at offset,
+C and stores the corresponding 16 bytes of each of the eight blocks.
+define(<OUTPUT>, <
+	vpbroadcastd	$5(SRC), T0
+	vpaddd	T0, $1, $1
+	vpbroadcastd	eval($5 + 4)(SRC), T0
+	vpaddd	T0, $2, $2
+	vpbroadcastd	eval($5 + 8)(SRC), T0
+	vpaddd	T0, $3, $3
+	vpbroadcastd	eval($5 + 12)(SRC), T0
+	vpaddd	T0, $4, $4
+	STORE($1, $2, $3, $4, $5)
+>)
+
+define(<STORE>, <
+	TRANSPOSE($1, $2, $3, $4)
+	vextracti128	<$>0, $2, $5(DST)
+	vextracti128	<$>0, T0, eval($5 + 64)(DST)
+	vextracti128	<$>0, $4, eval($5 + 128)(DST)
+	vextracti128	<$>0, $1, eval($5 + 192)(DST)
+	vextracti128	<$>1, $2, eval($5 + 256)(DST)
+	vextracti128	<$>1, T0, eval($5 + 320)(DST)
+	vextracti128	<$>1, $4, eval($5 + 384)(DST)
+	vextracti128	<$>1, $1, eval($5 + 448)(DST)
+>)
+
+	.file "chacha-8core.asm"
+
+	C _chacha_8core(uint32_t *dst, const uint32_t *src, unsigned rounds)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_chacha_8core)
+	W64_ENTRY(3, 16)
+	sub	$128, %rsp
+
+	vpbroadcastd	(SRC), A0
+	vpbroadcastd	4(SRC), A1
+	vpbroadcastd	8(SRC), A2
+	vpbroadcastd	12(SRC), A3
+	vpbroadcastd	16(SRC), B0
+	vpbroadcastd	20(SRC), B1
+	vpbroadcastd	24(SRC), B2
+	vpbroadcastd	28(SRC), B3
+	vpbroadcastd	32(SRC), CA
+	vpbroadcastd	36(SRC), CB
+	vpbroadcastd	40(SRC), T0
+	vmovdqu	T0, 64(%rsp)
+	vpbroadcastd	44(SRC), T0
+	vmovdqu	T0, 96(%rsp)
+	vpbroadcastd	48(SRC), T1
+	vpbroadcastd	52(SRC), D1
+	vpbroadcastd	56(SRC), D2
+	vpbroadcastd	60(SRC), D3
+
+	C Block i uses counter + i, with carry into the high word.
+	vpaddd	.Lcount(%rip), T1, D0
+	vpxor	.Lsign(%rip), T1, T1
+	vpxor	.Lsign(%rip), D0, T0
+	vpcmpgtd	T0, T1, T1
+	vpsubd	T1, D1, D1
+
+	shrl	$1, XREG(COUNT)
+
+	ALIGN(16)
+.Loop:
+	C Column round, with c0, c1 in registers
+	QROUND2(A0, B0, CA, D0, A1, B1, CB, D1)
+	vmovdqu	CA, (%rsp)
+	vmovdqu	CB, 32(%rsp)
+	vmovdqu	64(%rsp), CA
+	vmovdqu	96(%rsp), CB
+	QROUND2(A2, B2, CA, D2, A3, B3, CB, D3)
+
+	C Diagonal round, starting with c2, c3 in registers
+	QROUND2(A0, B1, CA, D3, A1, B2, CB, D0)
+	vmovdqu	CA, 64(%rsp)
+	vmovdqu	CB, 96(%rsp)
+	vmovdqu	(%rsp), CA
+	vmovdqu	32(%rsp), CB
+	QROUND2(A2, B3, CA, D1, A3, B0, CB, D2)
+
+	decl	XREG(COUNT)
+	jnz	.Loop
+
+	vmovdqu	CA, (%rsp)
+	vmovdqu	CB, 32(%rsp)
+
+	OUTPUT(A0, A1, A2, A3, 0)
+	OUTPUT(B0, B1, B2, B3, 16)
+
+	vmovdqu	(%rsp), A0
+	vmovdqu	32(%rsp), A1
+	vmovdqu	64(%rsp), A2
+	vmovdqu	96(%rsp), A3
+	OUTPUT(A0, A1, A2, A3, 32)
+
+	C Recompute the counters, using the free B registers.
+	vpbroadcastd	48(SRC), B1
+	vpaddd	.Lcount(%rip), B1, B0
+	vpaddd	B0, D0, D0
+	vpxor	.Lsign(%rip), B1, B1
+	vpxor	.Lsign(%rip), B0, B0
+	vpcmpgtd	B0, B1, B1
+	vpbroadcastd	52(SRC), B2
+	vpsubd	B1, B2, B2
+	vpaddd	B2, D1, D1
+	vpbroadcastd	56(SRC), T1
+	vpaddd	T1, D2, D2
+	vpbroadcastd	60(SRC), T1
+	vpaddd	T1, D3, D3
+	STORE(D0, D1, D2, D3, 48)
+
+	add	$128, %rsp
+	vzeroupper
+	W64_EXIT(3, 16)
+	ret
+EPILOGUE(_nettle_chacha_8core)
+
+	RODATA
+	ALIGN(32)
+.Lcount:
+	.long	0, 1, 2, 3, 4, 5, 6, 7
+.Lsign:
+	.long	0x80000000, 0x80000000, 0x80000000, 0x80000000
+	.long	0x80000000, 0x80000000, 0x80000000, 0x80000000
+.Lrot16:
+	.byte	2,3,0,1, 6,7,4,5, 10,11,8,9, 14,15,12,13
+	.byte	2,3,0,1, 6,7,4,5, 10,11,8,9, 14,15,12,13
+.Lrot8:
+	.byte	3,0,1,2, 7,4,5,6, 11,8,9,10, 15,12,13,14
+	.byte	3,0,1,2, 7,4,5,6, 11,8,9,10, 15,12,13,14
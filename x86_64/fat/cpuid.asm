@@ -57,3 +57,16 @@ PROLOGUE(_nettle_cpuid)
 	ret
 EPILOGUE(_nettle_cpuid)
 
+
+	C uint32_t _nettle_xgetbv(uint32_t index)
+	C Low 32 bits of the extended control register, e.g., XCR0,
+	C telling which register state the OS saves.
+
+	ALIGN(16)
+PROLOGUE(_nettle_xgetbv)
+	W64_ENTRY(1)
+	movl	%edi, %ecx
+	xgetbv
+	W64_EXIT(1)
+	ret
+EPILOGUE(_nettle_xgetbv)
@@ -0,0 +1,139 @@
+C x86_64/fat/mont52-mul-2.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+define(<fat_transform>, <$1_ifma>)
+
+C Uses AVX-512F and AVX-512 IFMA, with the eight lanes of a zmm
+C register holding one digit of each of the eight numbers. The
+C accumulator is kept in the output area. Only %zmm16-%zmm31 are
+C used, since they need no saving under the W64 ABI.
+
+define(<RP>, <%rdi>)
+define(<AP>, <%rsi>)
+define(<BP>, <%rdx>)
+define(<MP>, <%rcx>)
+define(<MINV>, <%r8>)
+define(<SIZE>, <%r9>)
+
+define(<I>, <%r10>)
+define(<J>, <%r11>)
+define(<END>, <%rax>)
+
+define(<B>, <%zmm16>)
+define(<Q>, <%zmm17>)
+define(<T>, <%zmm18>)
+define(<CY>, <%zmm19>)
+define(<VMINV>, <%zmm20>)
+define(<MASK>, <%zmm21>)
+
+	.file "mont52-mul-2.asm"
+
+	C _mont52_mul(uint64_t *rp, const uint64_t *ap, const uint64_t *bp,
+	C             const uint64_t *mp, const uint64_t *minv, size_t size)
+
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_mont52_mul)
+	W64_ENTRY(6, 0)
+	vmovdqu64	(MINV), VMINV
+	mov	SIZE, END
+	shl	$6, END
+
+	vpxorq	T, T, T
+	xor	J, J
+.Lzero:
+	vmovdqu64	T, (RP, J)
+	add	$64, J
+	cmp	END, J
+	jb	.Lzero
+
+	mov	SIZE, I
+.Louter:
+	C t_0 += lo(a_0 b_i), q = lo(t_0 minv), t_0 += lo(m_0 q)
+	vmovdqu64	(BP), B
+	vmovdqu64	(RP), T
+	vpmadd52luq	(AP), B, T
+	vpxorq	Q, Q, Q
+	vpmadd52luq	VMINV, T, Q
+	vpmadd52luq	(MP), Q, T
+	vpsrlq	$52, T, CY
+
+	C j = 1, adding in the carry
+	vmovdqu64	64(RP), T
+	vpaddq	CY, T, T
+	vpmadd52luq	64(AP), B, T
+	vpmadd52luq	64(MP), Q, T
+	vpmadd52huq	(AP), B, T
+	vpmadd52huq	(MP), Q, T
+	vmovdqu64	T, (RP)
+
+	mov	$128, J
+	cmp	END, J
+	jae	.Ltop
+.Linner:
+	vmovdqu64	(RP, J), T
+	vpmadd52luq	(AP, J), B, T
+	vpmadd52luq	(MP, J), Q, T
+	vpmadd52huq	-64(AP, J), B, T
+	vpmadd52huq	-64(MP, J), Q, T
+	vmovdqu64	T, -64(RP, J)
+	add	$64, J
+	cmp	END, J
+	jb	.Linner
+
+.Ltop:
+	vpxorq	T, T, T
+	vpmadd52huq	-64(AP, J), B, T
+	vpmadd52huq	-64(MP, J), Q, T
+	vmovdqu64	T, -64(RP, J)
+
+	add	$64, BP
+	dec	I
+	jnz	.Louter
+
+	C Propagate carries
+	mov	$0xfffffffffffff, I
+	vpbroadcastq	I, MASK
+	vpxorq	CY, CY, CY
+	xor	J, J
+.Lnorm:
+	vmovdqu64	(RP, J), T
+	vpaddq	CY, T, T
+	vpsrlq	$52, T, CY
+	vpandq	MASK, T, T
+	vmovdqu64	T, (RP, J)
+	add	$64, J
+	cmp	END, J
+	jb	.Lnorm
+
+	vzeroupper
+	W64_EXIT(6, 0)
+	ret
+EPILOGUE(_nettle_mont52_mul)
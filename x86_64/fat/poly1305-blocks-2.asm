@@ -0,0 +1,397 @@
+C x86_64/fat/poly1305-blocks-2.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+define(<fat_transform>, <$1_avx2>)
+
+C Processes four blocks per iteration, with the state represented as
+C five 26-bit limbs in each of four 64-bit lanes. Lanes are updated
+C as h = (h + m) r^4, and for the final four blocks, each lane is
+C multiplied by r^4, r^3, r^2 or r depending on position, and the
+C lanes are summed. The powers of r are computed on entry, since
+C there's no space for them in struct poly1305_ctx. Short inputs,
+C and any remaining blocks, are handled by the scalar code.
+
+define(<CTX>, <%rdi>)
+define(<BLOCKS>, <%rsi>)
+define(<M>, <%r12>)
+define(<T0>, <%rcx>)
+define(<T1>, <%rbx>)
+define(<T2>, <%r8>)
+define(<H0>, <%r9>)
+define(<H1>, <%r10>)
+define(<H2>, <%r11>)
+define(<CNT>, <%r13>)
+
+define(<Y0>, <%ymm0>)
+define(<Y1>, <%ymm1>)
+define(<Y2>, <%ymm2>)
+define(<Y3>, <%ymm3>)
+define(<Y4>, <%ymm4>)
+define(<A0>, <%ymm5>)
+define(<A1>, <%ymm6>)
+define(<A2>, <%ymm7>)
+define(<A3>, <%ymm8>)
+define(<A4>, <%ymm9>)
+define(<M0>, <%ymm10>)
+define(<M1>, <%ymm11>)
+define(<TMP>, <%ymm12>)
+define(<MASK>, <%ymm13>)
+define(<HIBIT>, <%ymm14>)
+
+define(<XMM>, <patsubst(<$1>, <ymm>, <xmm>)>)
+
+C Use at least this many blocks for the vectorized loop.
+define(<VECTOR_THRESHOLD>, <16>)
+
+C Stack frame, with one 32-byte slot per limb of r and 5 r, the
+C latter only for limbs 1-4. The final multipliers, with different
+C powers in each lane, are first, followed by r^4 in all lanes.
+define(<FRAME_SIZE>, <576>)
+define(<FINAL>, <0>)
+define(<LOOP>, <288>)
+define(<RLIMB>, <eval($1 + 32*$2)(%rsp)>)
+define(<SLIMB>, <eval($1 + 32*(4 + $2))(%rsp)>)
+
+include_src(<x86_64/poly1305.m4>)
+
+C STORE_LIMBS(x0, x1, x2, offset), splits x0 + 2^64 x1 + 2^128 x2
+C into 26-bit limbs, stored 32 bytes apart, followed by 5 times limbs
+C 1-4. Clobbers %rax and %rdx.
+define(<STORE_LIMBS>, <
+	mov	$1, %rax
+	and	<$>0x3ffffff, XREG(%rax)
+	mov	%rax, eval($4)(%rsp)
+	mov	$1, %rax
+	shr	<$>26, %rax
+	and	<$>0x3ffffff, XREG(%rax)
+	mov	%rax, eval($4 + 32)(%rsp)
+	lea	(%rax, %rax, 4), %rdx
+	mov	%rdx, eval($4 + 160)(%rsp)
+	mov	$1, %rax
+	shr	<$>52, %rax
+	mov	$2, %rdx
+	shl	<$>12, %rdx
+	or	%rdx, %rax
+	and	<$>0x3ffffff, XREG(%rax)
+	mov	%rax, eval($4 + 64)(%rsp)
+	lea	(%rax, %rax, 4), %rdx
+	mov	%rdx, eval($4 + 192)(%rsp)
+	mov	$2, %rax
+	shr	<$>14, %rax
+	and	<$>0x3ffffff, XREG(%rax)
+	mov	%rax, eval($4 + 96)(%rsp)
+	lea	(%rax, %rax, 4), %rdx
+	mov	%rdx, eval($4 + 224)(%rsp)
+	mov	$2, %rax
+	shr	<$>40, %rax
+	mov	$3, %rdx
+	shl	<$>24, %rdx
+	or	%rdx, %rax
+	mov	%rax, eval($4 + 128)(%rsp)
+	lea	(%rax, %rax, 4), %rdx
+	mov	%rdx, eval($4 + 256)(%rsp)
+>)
+
+C Loads four blocks, and adds them to the accumulators. The lanes
+C hold blocks 0, 2, 1, 3.
+define(<VLOAD>, <
+	vmovdqu	(M), TMP
+	vmovdqu	32(M), M1
+	vpunpcklqdq	M1, TMP, M0
+	vpunpckhqdq	M1, TMP, M1
+	vpand	MASK, M0, TMP
+	vpaddq	TMP, Y0, Y0
+	vpsrlq	<$>26, M0, TMP
+	vpand	MASK, TMP, TMP
+	vpaddq	TMP, Y1, Y1
+	vpsrlq	<$>52, M0, M0
+	vpsllq	<$>12, M1, TMP
+	vpor	TMP, M0, M0
+	vpand	MASK, M0, M0
+	vpaddq	M0, Y2, Y2
+	vpsrlq	<$>14, M1, TMP
+	vpand	MASK, TMP, TMP
+	vpaddq	TMP, Y3, Y3
+	vpsrlq	<$>40, M1, M1
+	vpor	HIBIT, M1, M1
+	vpaddq	M1, Y4, Y4
+>)
+
+C VMUL(base), multiplies Y0-Y4 by the powers at the given frame
+C offset, producing unreduced products in A0-A4.
+define(<VMUL>, <
+	vpmuludq	RLIMB($1, 0), Y0, A0
+	vpmuludq	RLIMB($1, 1), Y0, A1
+	vpmuludq	RLIMB($1, 2), Y0, A2
+	vpmuludq	RLIMB($1, 3), Y0, A3
+	vpmuludq	RLIMB($1, 4), Y0, A4
+
+	vpmuludq	SLIMB($1, 4), Y1, TMP
+	vpaddq	TMP, A0, A0
+	vpmuludq	RLIMB($1, 0), Y1, TMP
+	vpaddq	TMP, A1, A1
+	vpmuludq	RLIMB($1, 1), Y1, TMP
+	vpaddq	TMP, A2, A2
+	vpmuludq	RLIMB($1, 2), Y1, TMP
+	vpaddq	TMP, A3, A3
+	vpmuludq	RLIMB($1, 3), Y1, TMP
+	vpaddq	TMP, A4, A4
+
+	vpmuludq	SLIMB($1, 3), Y2, TMP
+	vpaddq	TMP, A0, A0
+	vpmuludq	SLIMB($1, 4), Y2, TMP
+	vpaddq	TMP, A1, A1
+	vpmuludq	RLIMB($1, 0), Y2, TMP
+	vpaddq	TMP, A2, A2
+	vpmuludq	RLIMB($1, 1), Y2, TMP
+	vpaddq	TMP, A3, A3
+	vpmuludq	RLIMB($1, 2), Y2, TMP
+	vpaddq	TMP, A4, A4
+
+	vpmuludq	SLIMB($1, 2), Y3, TMP
+	vpaddq	TMP, A0, A0
+	vpmuludq	SLIMB($1, 3), Y3, TMP
+	vpaddq	TMP, A1, A1
+	vpmuludq	SLIMB($1, 4), Y3, TMP
+	vpaddq	TMP, A2, A2
+	vpmuludq	RLIMB($1, 0), Y3, TMP
+	vpaddq	TMP, A3, A3
+	vpmuludq	RLIMB($1, 1), Y3, TMP
+	vpaddq	TMP, A4, A4
+
+	vpmuludq	SLIMB($1, 1), Y4, TMP
+	vpaddq	TMP, A0, A0
+	vpmuludq	SLIMB($1, 2), Y4, TMP
+	vpaddq	TMP, A1, A1
+	vpmuludq	SLIMB($1, 3), Y4, TMP
+	vpaddq	TMP, A2, A2
+	vpmuludq	SLIMB($1, 4), Y4, TMP
+	vpaddq	TMP, A3, A3
+	vpmuludq	RLIMB($1, 0), Y4, TMP
+	vpaddq	TMP, A4, A4
+>)
+
+C Partial carry propagation from A0-A4 into Y0-Y4, leaving limbs
+C only slightly larger than 26 bits.
+define(<VREDUCE>, <
+	vpsrlq	<$>26, A0, TMP
+	vpand	MASK, A0, A0
+	vpaddq	TMP, A1, A1
+	vpsrlq	<$>26, A3, TMP
+	vpand	MASK, A3, A3
+	vpaddq	TMP, A4, A4
+
+	vpsrlq	<$>26, A1, TMP
+	vpand	MASK, A1, Y1
+	vpaddq	TMP, A2, A2
+	vpsrlq	<$>26, A4, TMP
+	vpand	MASK, A4, Y4
+	vpaddq	TMP, A0, A0
+	vpsllq	<$>2, TMP, TMP
+	vpaddq	TMP, A0, A0
+
+	vpsrlq	<$>26, A2, TMP
+	vpand	MASK, A2, Y2
+	vpaddq	TMP, A3, A3
+	vpsrlq	<$>26, A0, TMP
+	vpand	MASK, A0, Y0
+	vpaddq	TMP, Y1, Y1
+
+	vpsrlq	<$>26, A3, TMP
+	vpand	MASK, A3, Y3
+	vpaddq	TMP, Y4, Y4
+>)
+
+C HSUM(y), adds the four lanes, leaving the sum in the low lane.
+define(<HSUM>, <
+	vextracti128	<$>1, $1, XMM(TMP)
+	vpaddq	XMM(TMP), XMM($1), XMM($1)
+	vpshufd	<$>0x4e, XMM($1), XMM(TMP)
+	vpaddq	XMM(TMP), XMM($1), XMM($1)
+>)
+
+	.file "poly1305-blocks-2.asm"
+
+	C const uint8_t *
+	C _poly1305_blocks (struct poly1305_ctx *ctx, size_t blocks,
+	C                   const uint8_t *m)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_poly1305_blocks)
+	W64_ENTRY(3, 15)
+	push	%rbx
+	push	%r12
+	push	%r13
+	mov	%rdx, M
+	test	BLOCKS, BLOCKS
+	jz	.Lend
+
+	mov	P1305_H0 (CTX), H0
+	mov	P1305_H1 (CTX), H1
+	mov	P1305_H2 (CTX), XREG(T2)
+
+	cmp	$VECTOR_THRESHOLD, BLOCKS
+	jc	.Lscalar
+
+	sub	$FRAME_SIZE, %rsp
+
+	C Initial state, in lane 0.
+	STORE_LIMBS(H0, H1, T2, LOOP)
+	vmovq	RLIMB(LOOP, 0), XMM(Y0)
+	vmovq	RLIMB(LOOP, 1), XMM(Y1)
+	vmovq	RLIMB(LOOP, 2), XMM(Y2)
+	vmovq	RLIMB(LOOP, 3), XMM(Y3)
+	vmovq	RLIMB(LOOP, 4), XMM(Y4)
+
+	C Powers of r, lanes ordered as the blocks in VLOAD.
+	mov	P1305_R0 (CTX), T0
+	mov	P1305_R1 (CTX), T1
+	xor	XREG(T2), XREG(T2)
+	STORE_LIMBS(T0, T1, T2, FINAL + 24)
+	POLY1305_MUL
+	STORE_LIMBS(H0, H1, T2, FINAL + 8)
+	mov	H0, T0
+	mov	H1, T1
+	POLY1305_MUL
+	STORE_LIMBS(H0, H1, T2, FINAL + 16)
+	mov	H0, T0
+	mov	H1, T1
+	POLY1305_MUL
+	STORE_LIMBS(H0, H1, T2, FINAL)
+
+	vpbroadcastq	RLIMB(FINAL, 0), TMP
+	vmovdqu	TMP, RLIMB(LOOP, 0)
+	vpbroadcastq	RLIMB(FINAL, 1), TMP
+	vmovdqu	TMP, RLIMB(LOOP, 1)
+	vpbroadcastq	RLIMB(FINAL, 2), TMP
+	vmovdqu	TMP, RLIMB(LOOP, 2)
+	vpbroadcastq	RLIMB(FINAL, 3), TMP
+	vmovdqu	TMP, RLIMB(LOOP, 3)
+	vpbroadcastq	RLIMB(FINAL, 4), TMP
+	vmovdqu	TMP, RLIMB(LOOP, 4)
+	vpbroadcastq	SLIMB(FINAL, 1), TMP
+	vmovdqu	TMP, SLIMB(LOOP, 1)
+	vpbroadcastq	SLIMB(FINAL, 2), TMP
+	vmovdqu	TMP, SLIMB(LOOP, 2)
+	vpbroadcastq	SLIMB(FINAL, 3), TMP
+	vmovdqu	TMP, SLIMB(LOOP, 3)
+	vpbroadcastq	SLIMB(FINAL, 4), TMP
+	vmovdqu	TMP, SLIMB(LOOP, 4)
+
+	vpcmpeqd	MASK, MASK, MASK
+	vpsrlq	$63, MASK, HIBIT
+	vpsllq	$24, HIBIT, HIBIT
+	vpsrlq	$38, MASK, MASK
+
+	mov	BLOCKS, CNT
+	shr	$2, CNT
+	dec	CNT
+	and	$3, BLOCKS
+
+	ALIGN(16)
+.Loop4:
+	VLOAD
+	VMUL(LOOP)
+	VREDUCE
+	add	$64, M
+	dec	CNT
+	jnz	.Loop4
+
+	VLOAD
+	VMUL(FINAL)
+	VREDUCE
+	add	$64, M
+
+	HSUM(Y0)
+	HSUM(Y1)
+	HSUM(Y2)
+	HSUM(Y3)
+	HSUM(Y4)
+
+	C Convert to 64-bit limbs, all limbs are below 2^29.
+	vmovq	XMM(Y0), H0
+	vmovq	XMM(Y1), %rax
+	shl	$26, %rax
+	add	%rax, H0
+	vmovq	XMM(Y2), %rax
+	mov	%rax, H1
+	shl	$52, %rax
+	shr	$12, H1
+	add	%rax, H0
+	adc	$0, H1
+	vmovq	XMM(Y3), %rax
+	shl	$14, %rax
+	add	%rax, H1
+	vmovq	XMM(Y4), %rax
+	mov	%rax, T2
+	shl	$40, %rax
+	shr	$24, T2
+	add	%rax, H1
+	adc	$0, T2
+
+	C Reduce the high part, for the scalar code.
+	mov	T2, %rax
+	shr	$2, %rax
+	lea	(%rax, %rax, 4), %rax
+	and	$3, XREG(T2)
+	add	%rax, H0
+	adc	$0, H1
+	adc	$0, XREG(T2)
+
+	vzeroupper
+	add	$FRAME_SIZE, %rsp
+
+	test	BLOCKS, BLOCKS
+	jz	.Lstore
+
+.Lscalar:
+	mov	(M), T0
+	mov	8(M), T1
+	add	H0, T0
+	adc	H1, T1
+	adc	$1, XREG(T2)
+	POLY1305_MUL
+	add	$16, M
+	dec	BLOCKS
+	jnz	.Lscalar
+
+.Lstore:
+	mov	H0, P1305_H0 (CTX)
+	mov	H1, P1305_H1 (CTX)
+	mov	XREG(T2), P1305_H2 (CTX)
+
+.Lend:
+	mov	M, %rax
+	pop	%r13
+	pop	%r12
+	pop	%rbx
+	W64_EXIT(3, 15)
+	ret
+EPILOGUE(_nettle_poly1305_blocks)
@@ -0,0 +1,101 @@
+C x86_64/fat/umac-nh-2.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+dnl PROLOGUE(_nettle_umac_nh) picked up by configure
+
+define(<fat_transform>, <$1_avx2>)
+
+C Same method as x86_64/fat/umac-nh-n-2.asm, two 32-byte chunks per
+C iteration.
+
+define(<KEY>, <%rdi>)
+define(<LENGTH>, <%rsi>)
+define(<MSG>, <%rdx>)
+
+define(<MX>, <%ymm0>)
+define(<MY>, <%ymm1>)
+define(<K0>, <%ymm2>)
+define(<K1>, <%ymm3>)
+define(<Y>, <%ymm4>)
+define(<T0>, <%ymm5>)
+define(<T1>, <%ymm6>)
+define(<T2>, <%ymm7>)
+define(<T3>, <%ymm8>)
+
+define(<XMX>, <%xmm0>)
+define(<XMY>, <%xmm1>)
+define(<XK0>, <%xmm2>)
+define(<XK1>, <%xmm3>)
+define(<XY>, <%xmm4>)
+define(<XT0>, <%xmm5>)
+
+	.file "umac-nh-2.asm"
+
+	C umac_nh(const uint32_t *key, unsigned length, const uint8_t *msg)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_umac_nh)
+	W64_ENTRY(3, 9)
+	vpxor	Y, Y, Y
+.Loop:
+	vmovdqu	(MSG), XMX
+	vmovdqu	16(MSG), XMY
+	vmovdqu	(KEY), XK0
+	vmovdqu	16(KEY), XK1
+	C Length is only 32 bits
+	cmpl	$32, XREG(LENGTH)
+	je	.Lhalf
+	vinserti128	$1, 32(MSG), MX, MX
+	vinserti128	$1, 48(MSG), MY, MY
+	vinserti128	$1, 32(KEY), K0, K0
+	vinserti128	$1, 48(KEY), K1, K1
+.Lhalf:
+	vpaddd	K0, MX, T0
+	vpaddd	K1, MY, T1
+	vpsrlq	$32, T0, T2
+	vpsrlq	$32, T1, T3
+	vpmuludq	T0, T1, T0
+	vpmuludq	T2, T3, T2
+	vpaddq	T0, Y, Y
+	vpaddq	T2, Y, Y
+	lea	64(MSG), MSG
+	lea	64(KEY), KEY
+	subl	$64, XREG(LENGTH)
+	ja	.Loop
+
+	vextracti128	$1, Y, XT0
+	vpaddq	XT0, XY, XY
+	vpshufd	$0xe, XY, XT0
+	vpaddq	XT0, XY, XY
+	vmovq	XY, %rax
+	vzeroupper
+	W64_EXIT(3, 9)
+	ret
+EPILOGUE(_nettle_umac_nh)
@@ -0,0 +1,221 @@
+C x86_64/fat/umac-nh-n-2.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+dnl PROLOGUE(_nettle_umac_nh_n) picked up by configure
+
+define(<fat_transform>, <$1_avx2>)
+
+C Each ymm register holds two 32-byte chunks of the message, the
+C first in the low 128 bits. With both chunks added to the key, the
+C even 32-bit words are multiplied with vpmuludq, and the odd words
+C after a shift, so that one pass over the message computes all n
+C iterations. An odd number of chunks is handled by leaving the high
+C halves zero.
+
+define(<OUT>, <%rdi>)
+define(<ITERS>, <%rsi>)
+define(<KEY>, <%rdx>)
+define(<LENGTH>, <%rcx>)
+define(<MSG>, <%r8>)
+
+define(<MX>, <%ymm0>)
+define(<MY>, <%ymm1>)
+define(<K0>, <%ymm2>)
+define(<K1>, <%ymm3>)
+define(<K2>, <%ymm4>)
+define(<K3>, <%ymm5>)
+define(<K4>, <%ymm6>)
+define(<Y0>, <%ymm7>)
+define(<Y1>, <%ymm8>)
+define(<Y2>, <%ymm9>)
+define(<Y3>, <%ymm10>)
+define(<T0>, <%ymm11>)
+define(<T1>, <%ymm12>)
+define(<T2>, <%ymm13>)
+define(<T3>, <%ymm14>)
+
+C XREG of the above
+define(<XMX>, <%xmm0>)
+define(<XMY>, <%xmm1>)
+define(<XK0>, <%xmm2>)
+define(<XK1>, <%xmm3>)
+define(<XK2>, <%xmm4>)
+define(<XK3>, <%xmm5>)
+define(<XK4>, <%xmm6>)
+define(<XY0>, <%xmm7>)
+define(<XT0>, <%xmm11>)
+define(<XT1>, <%xmm12>)
+
+C LOAD_LOW(offset, xreg, ptr) loads 16 bytes from the first chunk,
+C clearing the high half. LOAD_HIGH(offset, reg, ptr) loads the
+C corresponding 16 bytes of the second chunk into the high half.
+define(<LOAD_LOW>, <
+	vmovdqu	$1($3), $2
+>)
+define(<LOAD_HIGH>, <
+	vinserti128	<$>1, eval($1 + 32)($3), $2, $2
+>)
+
+C NH_ITER(ka, kb, y)
+define(<NH_ITER>, <
+	vpaddd	$1, MX, T0
+	vpaddd	$2, MY, T1
+	vpsrlq	<$>32, T0, T2
+	vpsrlq	<$>32, T1, T3
+	vpmuludq	T0, T1, T0
+	vpmuludq	T2, T3, T2
+	vpaddq	T0, $3, $3
+	vpaddq	T2, $3, $3
+>)
+
+C SUM2(a, b, dst), sets dst to [a0+a1, b0+b1, a2+a3, b2+b3]
+define(<SUM2>, <
+	vpunpcklqdq	$2, $1, $3
+	vpunpckhqdq	$2, $1, $1
+	vpaddq	$1, $3, $3
+>)
+
+	.file "umac-nh-n-2.asm"
+
+	C umac_nh_n(uint64_t *out, unsigned n, const uint32_t *key,
+	C	    unsigned length, const uint8_t *msg)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_umac_nh_n)
+	W64_ENTRY(5, 15)
+	vpxor	Y0, Y0, Y0
+	vpxor	Y1, Y1, Y1
+	vpxor	Y2, Y2, Y2
+	vpxor	Y3, Y3, Y3
+	cmp	$3, XREG(ITERS)
+	jc	.Lnh2
+	je	.Lnh3
+
+.Lnh4:
+	LOAD_LOW(0, XMX, MSG)
+	LOAD_LOW(16, XMY, MSG)
+	LOAD_LOW(0, XK0, KEY)
+	LOAD_LOW(16, XK1, KEY)
+	LOAD_LOW(32, XK2, KEY)
+	LOAD_LOW(48, XK3, KEY)
+	LOAD_LOW(64, XK4, KEY)
+	cmpl	$32, XREG(LENGTH)
+	je	.Lnh4_half
+	LOAD_HIGH(0, MX, MSG)
+	LOAD_HIGH(16, MY, MSG)
+	LOAD_HIGH(0, K0, KEY)
+	LOAD_HIGH(16, K1, KEY)
+	LOAD_HIGH(32, K2, KEY)
+	LOAD_HIGH(48, K3, KEY)
+	LOAD_HIGH(64, K4, KEY)
+.Lnh4_half:
+	NH_ITER(K0, K1, Y0)
+	NH_ITER(K1, K2, Y1)
+	NH_ITER(K2, K3, Y2)
+	NH_ITER(K3, K4, Y3)
+	lea	64(MSG), MSG
+	lea	64(KEY), KEY
+	C Length is only 32 bits
+	subl	$64, XREG(LENGTH)
+	ja	.Lnh4
+
+	SUM2(Y0, Y1, T0)
+	SUM2(Y2, Y3, T1)
+	vperm2i128	$0x20, T1, T0, Y0
+	vperm2i128	$0x31, T1, T0, Y1
+	vpaddq	Y1, Y0, Y0
+	vmovdqu	Y0, (OUT)
+	jmp	.Lend
+
+.Lnh3:
+	LOAD_LOW(0, XMX, MSG)
+	LOAD_LOW(16, XMY, MSG)
+	LOAD_LOW(0, XK0, KEY)
+	LOAD_LOW(16, XK1, KEY)
+	LOAD_LOW(32, XK2, KEY)
+	LOAD_LOW(48, XK3, KEY)
+	cmpl	$32, XREG(LENGTH)
+	je	.Lnh3_half
+	LOAD_HIGH(0, MX, MSG)
+	LOAD_HIGH(16, MY, MSG)
+	LOAD_HIGH(0, K0, KEY)
+	LOAD_HIGH(16, K1, KEY)
+	LOAD_HIGH(32, K2, KEY)
+	LOAD_HIGH(48, K3, KEY)
+.Lnh3_half:
+	NH_ITER(K0, K1, Y0)
+	NH_ITER(K1, K2, Y1)
+	NH_ITER(K2, K3, Y2)
+	lea	64(MSG), MSG
+	lea	64(KEY), KEY
+	subl	$64, XREG(LENGTH)
+	ja	.Lnh3
+
+	SUM2(Y0, Y1, T0)
+	SUM2(Y2, Y3, T1)
+	vperm2i128	$0x20, T1, T0, Y0
+	vperm2i128	$0x31, T1, T0, Y1
+	vpaddq	Y1, Y0, Y0
+	vmovdqu	XY0, (OUT)
+	vextracti128	$1, Y0, XT0
+	vmovq	XT0, 16(OUT)
+	jmp	.Lend
+
+.Lnh2:
+	LOAD_LOW(0, XMX, MSG)
+	LOAD_LOW(16, XMY, MSG)
+	LOAD_LOW(0, XK0, KEY)
+	LOAD_LOW(16, XK1, KEY)
+	LOAD_LOW(32, XK2, KEY)
+	cmpl	$32, XREG(LENGTH)
+	je	.Lnh2_half
+	LOAD_HIGH(0, MX, MSG)
+	LOAD_HIGH(16, MY, MSG)
+	LOAD_HIGH(0, K0, KEY)
+	LOAD_HIGH(16, K1, KEY)
+	LOAD_HIGH(32, K2, KEY)
+.Lnh2_half:
+	NH_ITER(K0, K1, Y0)
+	NH_ITER(K1, K2, Y1)
+	lea	64(MSG), MSG
+	lea	64(KEY), KEY
+	subl	$64, XREG(LENGTH)
+	ja	.Lnh2
+
+	SUM2(Y0, Y1, T0)
+	vextracti128	$1, T0, XT1
+	vpaddq	XT1, XT0, XT0
+	vmovdqu	XT0, (OUT)
+
+.Lend:
+	vzeroupper
+	W64_EXIT(5, 15)
+	ret
+EPILOGUE(_nettle_umac_nh_n)
@@ -0,0 +1,226 @@
+C x86_64/pclmul/gcm-hash.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+C Blocks are byte reversed when loaded, so that the coefficient of
+C x^i is bit 127 - i of the xmm register. The key holds H^1, ...,
+C H^8 in this representation, using only the first 128 bytes of
+C struct gcm_key. Eight blocks are multiplied by H^8, ..., H^1 and
+C summed, with a single reduction, using the shift-based reduction
+C from Gueron and Kounavis, "Intel Carry-Less Multiplication
+C Instruction and its Usage for Computing the GCM Mode".
+
+C Register usage:
+
+define(<KEY>, <%rdi>)
+define(<XP>, <%rsi>)
+define(<HP>, <%rsi>)
+define(<LENGTH>, <%rdx>)
+define(<SRC>, <%rcx>)
+define(<KP>, <%rax>)
+define(<CNT>, <%eax>)
+define(<T0>, <%r8>)
+define(<T1>, <%r9>)
+define(<TB>, <%r10>)
+
+define(<X>, <%xmm0>)
+define(<BSWAP>, <%xmm1>)
+define(<LO>, <%xmm2>)
+define(<HI>, <%xmm3>)
+define(<MID>, <%xmm4>)
+define(<D>, <%xmm5>)
+define(<T>, <%xmm6>)
+define(<K>, <%xmm7>)
+define(<H1>, <%xmm8>)
+define(<H2>, <%xmm9>)
+define(<H3>, <%xmm10>)
+define(<H4>, <%xmm11>)
+define(<H5>, <%xmm12>)
+define(<H6>, <%xmm13>)
+define(<H7>, <%xmm14>)
+define(<H8>, <%xmm15>)
+
+include_src(<x86_64/pclmul/ghash.m4>)
+
+	.file "gcm-hash.asm"
+
+	C void gcm_init_key (struct gcm_key *key,
+	C                    const union nettle_block16 *h)
+
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_gcm_init_key)
+	W64_ENTRY(2, 9)
+	movdqa	.Lbswap(%rip), BSWAP
+	LOAD_BLOCK(H1, (HP))
+	movups	H1, (KEY)
+	movdqa	H1, X
+	mov	$7, CNT
+.Linit_loop:
+	pxor	LO, LO
+	pxor	HI, HI
+	pxor	MID, MID
+	GHASH_ACC(X, H1)
+	GHASH_REDUCE
+	add	$16, KEY
+	movups	X, (KEY)
+	decl	CNT
+	jnz	.Linit_loop
+
+	W64_EXIT(2, 9)
+	ret
+EPILOGUE(_nettle_gcm_init_key)
+
+	C void gcm_hash (const struct gcm_key *key, union nettle_block16 *x,
+	C                size_t length, const uint8_t *data)
+
+	ALIGN(16)
+PROLOGUE(_nettle_gcm_hash)
+	W64_ENTRY(4, 16)
+	movdqa	.Lbswap(%rip), BSWAP
+	LOAD_BLOCK(X, (XP))
+	movups	(KEY), H1
+	sub	$128, LENGTH
+	jc	.Ltail
+
+	movups	16(KEY), H2
+	movups	32(KEY), H3
+	movups	48(KEY), H4
+	movups	64(KEY), H5
+	movups	80(KEY), H6
+	movups	96(KEY), H7
+	movups	112(KEY), H8
+
+	ALIGN(16)
+.Loop8:
+	pxor	LO, LO
+	pxor	HI, HI
+	pxor	MID, MID
+	LOAD_BLOCK(D, (SRC))
+	pxor	X, D
+	GHASH_ACC(D, H8)
+	LOAD_BLOCK(D, 16(SRC))
+	GHASH_ACC(D, H7)
+	LOAD_BLOCK(D, 32(SRC))
+	GHASH_ACC(D, H6)
+	LOAD_BLOCK(D, 48(SRC))
+	GHASH_ACC(D, H5)
+	LOAD_BLOCK(D, 64(SRC))
+	GHASH_ACC(D, H4)
+	LOAD_BLOCK(D, 80(SRC))
+	GHASH_ACC(D, H3)
+	LOAD_BLOCK(D, 96(SRC))
+	GHASH_ACC(D, H2)
+	LOAD_BLOCK(D, 112(SRC))
+	GHASH_ACC(D, H1)
+	GHASH_REDUCE
+
+	add	$128, SRC
+	sub	$128, LENGTH
+	jnc	.Loop8
+
+.Ltail:
+	add	$128, LENGTH
+	C Remaining full blocks, i of them, are multiplied by H^i, ...,
+	C H^1, again with a single reduction.
+	mov	LENGTH, KP
+	and	$-16, KP
+	jz	.Lfinal
+	lea	-16(KEY, KP), KP
+	pxor	LO, LO
+	pxor	HI, HI
+	pxor	MID, MID
+	LOAD_BLOCK(D, (SRC))
+	pxor	X, D
+.Ltail_loop:
+	movups	(KP), K
+	GHASH_ACC(D, K)
+	add	$16, SRC
+	sub	$16, KP
+	sub	$16, LENGTH
+	cmp	$16, LENGTH
+	jc	.Ltail_done
+	LOAD_BLOCK(D, (SRC))
+	jmp	.Ltail_loop
+
+.Ltail_done:
+	GHASH_REDUCE
+
+.Lfinal:
+	test	LENGTH, LENGTH
+	jnz	.Lpartial
+
+.Ldone:
+	pshufb	BSWAP, X
+	movups	X, (XP)
+	W64_EXIT(4, 16)
+	ret
+
+.Lpartial:
+	C Read the final 0 < LENGTH < 16 bytes, zero padded, into T1:T0
+	xor	T0, T0
+	xor	T1, T1
+	cmp	$8, LENGTH
+	jc	.Lread_lo
+	mov	(SRC), T0
+	sub	$8, LENGTH
+	jz	.Lpartial_block
+.Lread_hi:
+	shl	$8, T1
+	movzbl	7(SRC, LENGTH), XREG(TB)
+	or	TB, T1
+	sub	$1, LENGTH
+	jnz	.Lread_hi
+	jmp	.Lpartial_block
+
+.Lread_lo:
+	shl	$8, T0
+	movzbl	-1(SRC, LENGTH), XREG(TB)
+	or	TB, T0
+	sub	$1, LENGTH
+	jnz	.Lread_lo
+
+.Lpartial_block:
+	movq	T0, D
+	movq	T1, T
+	punpcklqdq	T, D
+	pshufb	BSWAP, D
+	pxor	D, X
+	pxor	LO, LO
+	pxor	HI, HI
+	pxor	MID, MID
+	GHASH_ACC(X, H1)
+	GHASH_REDUCE
+	jmp	.Ldone
+EPILOGUE(_nettle_gcm_hash)
+
+	RODATA
+	ALIGN(16)
+.Lbswap:
+	.byte	15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0
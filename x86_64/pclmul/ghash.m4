@@ -0,0 +1,115 @@
+C x86_64/pclmul/ghash.m4
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+C GHASH macros shared by the pclmul code. They use the registers X,
+C LO, HI, MID, D, T and BSWAP, which must be defined by the including
+C file. BSWAP may also be a 16-byte aligned memory operand.
+
+C GHASH_ACC(block, key), adds the unreduced product block * key
+C to LO, MID, HI. Clobbers block and T.
+define(<GHASH_ACC>, <
+	movdqa	$1, T
+	pclmulqdq	<$>0x00, $2, T
+	pxor	T, LO
+	movdqa	$1, T
+	pclmulqdq	<$>0x11, $2, T
+	pxor	T, HI
+	movdqa	$1, T
+	pclmulqdq	<$>0x01, $2, T
+	pxor	T, MID
+	pclmulqdq	<$>0x10, $2, $1
+	pxor	$1, MID
+>)
+
+C GHASH_REDUCE, sets X to the reduction of HI x^128 + MID x^64 + LO.
+C Clobbers LO, HI, MID, D and T.
+define(<GHASH_REDUCE>, <
+	movdqa	MID, T
+	pslldq	<$>8, T
+	psrldq	<$>8, MID
+	pxor	T, LO
+	pxor	MID, HI
+
+	C Shift the 255-bit product left one bit, to get the
+	C coefficient of x^i into bit 255 - i.
+	movdqa	LO, T
+	movdqa	HI, D
+	psrlq	<$>63, T
+	psrlq	<$>63, D
+	psllq	<$>1, LO
+	psllq	<$>1, HI
+	movdqa	T, MID
+	pslldq	<$>8, MID
+	psrldq	<$>8, T
+	pslldq	<$>8, D
+	por	MID, LO
+	por	T, HI
+	por	D, HI
+
+	C Fold in the bits of the low word shifted out of the
+	C 128-bit right shifts below.
+	movdqa	LO, T
+	movdqa	LO, D
+	movdqa	LO, MID
+	psllq	<$>63, T
+	psllq	<$>62, D
+	psllq	<$>57, MID
+	pxor	D, T
+	pxor	MID, T
+	pslldq	<$>8, T
+	pxor	T, LO
+
+	C X = HI + LO + LO/2 + LO/4 + LO/128, with 128-bit shifts.
+	movdqa	LO, T
+	movdqa	LO, D
+	movdqa	LO, MID
+	psrlq	<$>1, T
+	psrlq	<$>2, D
+	psrlq	<$>7, MID
+	pxor	D, T
+	pxor	MID, T
+	pxor	LO, T
+	pxor	HI, T
+	movdqa	LO, D
+	movdqa	LO, MID
+	psllq	<$>63, LO
+	psllq	<$>62, D
+	psllq	<$>57, MID
+	pxor	D, LO
+	pxor	MID, LO
+	psrldq	<$>8, LO
+	pxor	LO, T
+	movdqa	T, X
+>)
+
+define(<LOAD_BLOCK>, <
+	movups	$2, $1
+	pshufb	BSWAP, $1
+>)
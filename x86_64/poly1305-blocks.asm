@@ -0,0 +1,84 @@
+C x86_64/poly1305-blocks.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+	.file "poly1305-blocks.asm"
+
+define(<CTX>, <%rdi>)
+define(<BLOCKS>, <%rsi>)
+define(<M>, <%r12>)
+define(<T0>, <%rcx>)
+define(<T1>, <%rbx>)
+define(<T2>, <%r8>)
+define(<H0>, <%r9>)
+define(<H1>, <%r10>)
+define(<H2>, <%r11>)
+
+include_src(<x86_64/poly1305.m4>)
+
+	C const uint8_t *
+	C _poly1305_blocks (struct poly1305_ctx *ctx, size_t blocks,
+	C                   const uint8_t *m)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_poly1305_blocks)
+	W64_ENTRY(3, 0)
+	push	%rbx
+	push	%r12
+	mov	%rdx, M
+	test	BLOCKS, BLOCKS
+	jz	.Lend
+
+	mov	P1305_H0 (CTX), H0
+	mov	P1305_H1 (CTX), H1
+	mov	P1305_H2 (CTX), XREG(T2)
+
+	ALIGN(16)
+.Loop:
+	mov	(M), T0
+	mov	8(M), T1
+	add	H0, T0
+	adc	H1, T1
+	adc	$1, XREG(T2)
+	POLY1305_MUL
+	add	$16, M
+	dec	BLOCKS
+	jnz	.Loop
+
+	mov	H0, P1305_H0 (CTX)
+	mov	H1, P1305_H1 (CTX)
+	mov	XREG(T2), P1305_H2 (CTX)
+
+.Lend:
+	mov	M, %rax
+	pop	%r12
+	pop	%rbx
+	W64_EXIT(3, 0)
+	ret
+EPILOGUE(_nettle_poly1305_blocks)
@@ -40,6 +40,8 @@ define(<T2>, <%r8>)
 define(<H0>, <%r9>)
 define(<H1>, <%r10>)
 define(<H2>, <%r11>)
+
+include_src(<x86_64/poly1305.m4>)
 	
 	C poly1305_set_key(struct poly1305_ctx *ctx, const uint8_t key[16])
 	.text
@@ -71,29 +73,6 @@ PROLOGUE(nettle_poly1305_set_key)
 
 EPILOGUE(nettle_poly1305_set_key)
 
-C 64-bit multiplication mod 2^130 - 5
-C
-C (x_0 + B x_1 + B^2 x_2) * (r_0 + B r_1) =
-C     1   B B^2 B^3 
-C   x_0 r_0
-C       x_0 r_1
-C	x_1 r_0
-C	    x_1 r_1
-C	    x_2 r_0
-C               x_2 r_1
-C Then r_1 B^2 = r_1/4 (2^130) = 5/4 r_1.
-C and  r_1 B^3 = 5/4 B r_1
-C So we get
-C
-C  x_0 r_0 + x_1 (5/4 r_1) + B (x_0 r_1 + x_1 r_0 + x_2 5/4 r_1 + B x_2 r_0)
-C     1   B B^2 B^3 
-C   x_0 r_0
-C   x_1 r'_1
-C       x_0 r_1
-C	x_1 r_0
-C       x_2 r'_1
-C           x_2 r_0
-
 	C _poly1305_block (struct poly1305_ctx *ctx, const uint8_t m[16], unsigned hi)
 	
 PROLOGUE(_nettle_poly1305_block)
@@ -109,32 +88,7 @@ PROLOGUE(_nettle_poly1305_block)
 	add	P1305_H0 (CTX), T0
 	adc	P1305_H1 (CTX), T1
 	adc	P1305_H2 (CTX), XREG(T2)
-	mov	P1305_R0 (CTX), %rax
-	mul	T0			C x0*r0
-	mov	%rax, H0
-	mov	%rdx, H1
-	mov	P1305_S1 (CTX), %rax	C 5/4 r1
-	mov	%rax, H2
-	mul	T1			C x1*r1'
-	imul	T2, H2			C x2*r1'
-	imul	P1305_R0 (CTX), T2	C x2*r0
-	add	%rax, H0
-	adc	%rdx, H1
-	mov	P1305_R0 (CTX), %rax
-	mul	T1			C x1*r0
-	add	%rax, H2
-	adc	%rdx, T2
-	mov	P1305_R1 (CTX), %rax
-	mul	T0			C x0*r1
-	add	%rax, H2
-	adc	%rdx, T2
-	mov	T2, %rax
-	shr	$2, %rax
-	imul	$5, %rax
-	and	$3, XREG(T2)
-	add	%rax, H0
-	adc	H2, H1
-	adc	$0, XREG(T2)
+	POLY1305_MUL
 	mov	H0, P1305_H0 (CTX)
 	mov	H1, P1305_H1 (CTX)
 	mov	XREG(T2), P1305_H2 (CTX)
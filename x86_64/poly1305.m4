@@ -0,0 +1,86 @@
+C x86_64/poly1305.m4
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+C Multiplication mod 2^130 - 5, using 64-bit limbs. Expects the
+C register names CTX, T0, T1, T2, H0, H1 and H2 to be defined.
+C
+C (x_0 + B x_1 + B^2 x_2) * (r_0 + B r_1) =
+C     1   B B^2 B^3 
+C   x_0 r_0
+C       x_0 r_1
+C	x_1 r_0
+C	    x_1 r_1
+C	    x_2 r_0
+C               x_2 r_1
+C Then r_1 B^2 = r_1/4 (2^130) = 5/4 r_1.
+C and  r_1 B^3 = 5/4 B r_1
+C So we get
+C
+C  x_0 r_0 + x_1 (5/4 r_1) + B (x_0 r_1 + x_1 r_0 + x_2 5/4 r_1 + B x_2 r_0)
+C     1   B B^2 B^3 
+C   x_0 r_0
+C   x_1 r'_1
+C       x_0 r_1
+C	x_1 r_0
+C       x_2 r'_1
+C           x_2 r_0
+
+C POLY1305_MUL
+C Inputs:  T0, T1, T2, the value to multiply by r. T2 must be small.
+C Outputs: H0, H1, T2, partially reduced, with T2 at most 4.
+C Clobbers H2, %rax and %rdx.
+define(<POLY1305_MUL>, <
+	mov	P1305_R0 (CTX), %rax
+	mul	T0			C x0*r0
+	mov	%rax, H0
+	mov	%rdx, H1
+	mov	P1305_S1 (CTX), %rax	C 5/4 r1
+	mov	%rax, H2
+	mul	T1			C x1*r1'
+	imul	T2, H2			C x2*r1'
+	imul	P1305_R0 (CTX), T2	C x2*r0
+	add	%rax, H0
+	adc	%rdx, H1
+	mov	P1305_R0 (CTX), %rax
+	mul	T1			C x1*r0
+	add	%rax, H2
+	adc	%rdx, T2
+	mov	P1305_R1 (CTX), %rax
+	mul	T0			C x0*r1
+	add	%rax, H2
+	adc	%rdx, T2
+	mov	T2, %rax
+	shr	<$>2, %rax
+	imul	<$>5, %rax
+	and	<$>3, XREG(T2)
+	add	%rax, H0
+	adc	H2, H1
+	adc	<$>0, XREG(T2)
+>)
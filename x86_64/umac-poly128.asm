@@ -0,0 +1,145 @@
+C x86_64/umac-poly128.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+define(<KP>, <%rdi>)
+define(<YP>, <%rsi>)
+define(<MH>, <%r8>)
+define(<ML>, <%rcx>)
+define(<KH>, <%r9>)
+define(<KL>, <%r10>)
+define(<YH>, <%r11>)
+define(<YL>, <%rdi>)	C Overlaps KP
+define(<S0>, <%rbx>)
+define(<S1>, <%rbp>)
+define(<S2>, <%r12>)
+define(<S3>, <%r13>)
+
+C POLY128_MUL, sets YH:YL = YH:YL * KH:KL (mod p), less than 2^128
+C but not necessarily fully reduced. The full product is at most
+C 249 bits, and it's folded twice using 2^128 = UMAC_P128_OFFSET
+C (mod p).
+define(<POLY128_MUL>, <
+	mov	YL, %rax
+	mul	KL
+	mov	%rax, S0
+	mov	%rdx, S1
+	mov	YL, %rax
+	mul	KH
+	xor	S2, S2
+	add	%rax, S1
+	adc	%rdx, S2
+	mov	YH, %rax
+	mul	KL
+	xor	S3, S3
+	add	%rax, S1
+	adc	%rdx, S2
+	adc	<$>0, S3
+	mov	YH, %rax
+	mul	KH
+	add	%rax, S2
+	adc	%rdx, S3
+
+	mov	<$>159, %eax
+	mul	S2
+	add	%rax, S0
+	adc	%rdx, S1
+	mov	<$>0, S2
+	adc	<$>0, S2
+	mov	<$>159, %eax
+	mul	S3
+	add	%rax, S1
+	adc	%rdx, S2
+
+	imul	<$>159, S2, S2
+	add	S2, S0
+	adc	<$>0, S1
+	sbb	S2, S2
+	and	<$>159, S2
+	add	S2, S0
+	adc	<$>0, S1
+	mov	S0, YL
+	mov	S1, YH
+>)
+
+	.file "umac-poly128.asm"
+
+	C void _umac_poly128 (const uint32_t *k, uint64_t *y,
+	C                     uint64_t mh, uint64_t ml)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_umac_poly128)
+	W64_ENTRY(4, 0)
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+
+	mov	%rdx, MH
+	C The key is stored as four 32-bit words, most significant first
+	mov	(KP), KH
+	rol	$32, KH
+	mov	8(KP), KL
+	rol	$32, KL
+	mov	(YP), YH
+	mov	8(YP), YL
+
+	mov	MH, %rax
+	shr	$32, %rax
+	cmp	$0xffffffff, %eax
+	jne	.Lmul
+
+	C Marker processing, y = y k - 1, m -= UMAC_P128_OFFSET
+	POLY128_MUL
+	sub	$1, YL
+	sbb	$0, YH
+	sbb	%rax, %rax
+	and	$159, %rax
+	sub	%rax, YL
+	sub	$159, ML
+	sbb	$0, MH
+.Lmul:
+	POLY128_MUL
+	add	ML, YL
+	adc	MH, YH
+	sbb	%rax, %rax
+	and	$159, %rax
+	add	%rax, YL
+	adc	$0, YH
+
+	mov	YH, (YP)
+	mov	YL, 8(YP)
+
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	W64_EXIT(4, 0)
+	ret
+EPILOGUE(_nettle_umac_poly128)
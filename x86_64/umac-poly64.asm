@@ -0,0 +1,84 @@
+C x86_64/umac-poly64.asm
+
+ifelse(<
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+>)
+
+define(<KH>, <%rdi>)
+define(<KL>, <%rsi>)
+define(<Y>, <%rdx>)
+define(<M>, <%rcx>)
+define(<K>, <%r8>)
+define(<T>, <%r9>)
+
+C POLY64_MUL, sets %rax = %rax * K (mod p), not necessarily fully
+C reduced. Uses 2^64 = UMAC_P64_OFFSET (mod p), with the special
+C form of the key implying that the high half of the product is
+C less than 2^57.
+define(<POLY64_MUL>, <
+	mul	K
+	imul	<$>59, %rdx, %rdx
+	add	%rdx, %rax
+	sbb	T, T
+	and	<$>59, T
+	add	T, %rax
+>)
+
+	.file "umac-poly64.asm"
+
+	C uint64_t _umac_poly64 (uint32_t kh, uint32_t kl, uint64_t y, uint64_t m)
+	.text
+	ALIGN(16)
+PROLOGUE(_nettle_umac_poly64)
+	W64_ENTRY(4, 0)
+	shl	$32, KH
+	mov	XREG(KL), XREG(K)
+	or	KH, K
+	mov	Y, %rax
+
+	mov	M, T
+	shr	$32, T
+	cmp	$0xffffffff, XREG(T)
+	jne	.Lmul
+
+	C Marker processing, y = y k - 1, m -= UMAC_P64_OFFSET
+	POLY64_MUL
+	sub	$1, %rax
+	sbb	T, T
+	and	$59, T
+	sub	T, %rax
+	sub	$59, M
+.Lmul:
+	POLY64_MUL
+	add	M, %rax
+	sbb	T, T
+	and	$59, T
+	add	T, %rax
+
+	W64_EXIT(4, 0)
+	ret
+EPILOGUE(_nettle_umac_poly64)
@@ -75,3 +75,26 @@ xts_aes256_decrypt_message(struct xts_aes256_key *xts_key,
                         (nettle_cipher_func *) aes256_encrypt,
                         tweak, length, dst, src);
 }
+
+void
+xts_aes256_encrypt_sectors(struct xts_aes256_key *xts_key,
+                           size_t count, const uint64_t *sectors,
+                           size_t sector_size,
+                           uint8_t * const *dst, const uint8_t * const *src)
+{
+    xts_encrypt_sectors(&xts_key->cipher, &xts_key->tweak_cipher,
+                        (nettle_cipher_func *) aes256_encrypt,
+                        count, sectors, sector_size, dst, src);
+}
+
+void
+xts_aes256_decrypt_sectors(struct xts_aes256_key *xts_key,
+                           size_t count, const uint64_t *sectors,
+                           size_t sector_size,
+                           uint8_t * const *dst, const uint8_t * const *src)
+{
+    xts_decrypt_sectors(&xts_key->cipher, &xts_key->tweak_cipher,
+                        (nettle_cipher_func *) aes256_decrypt,
+                        (nettle_cipher_func *) aes256_encrypt,
+                        count, sectors, sector_size, dst, src);
+}
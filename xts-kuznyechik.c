@@ -0,0 +1,100 @@
+/* xts-kuznyechik.c
+
+   XTS Mode using Kuznyechik as the underlying cipher.
+
+   This file is part of GNU Nettle.
+
+   GNU Nettle is free software: you can redistribute it and/or
+   modify it under the terms of either:
+
+     * the GNU Lesser General Public License as published by the Free
+       Software Foundation; either version 3 of the License, or (at your
+       option) any later version.
+
+   or
+
+     * the GNU General Public License as published by the Free
+       Software Foundation; either version 2 of the License, or (at your
+       option) any later version.
+
+   or both in parallel, as here.
+
+   GNU Nettle is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+   General Public License for more details.
+
+   You should have received copies of the GNU General Public License and
+   the GNU Lesser General Public License along with this program.  If
+   not, see http://www.gnu.org/licenses/.
+*/
+
+#if HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "kuznyechik.h"
+#include "xts.h"
+
+
+/* The Kuznyechik key schedule provides both directions, so the
+   encrypt and decrypt key setup functions are identical. */
+void
+xts_kuznyechik_set_encrypt_key(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *key)
+{
+    kuznyechik_set_key(&xts_key->cipher, key);
+    kuznyechik_set_key(&xts_key->tweak_cipher, &key[KUZNYECHIK_KEY_SIZE]);
+}
+
+void
+xts_kuznyechik_set_decrypt_key(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *key)
+{
+    kuznyechik_set_key(&xts_key->cipher, key);
+    kuznyechik_set_key(&xts_key->tweak_cipher, &key[KUZNYECHIK_KEY_SIZE]);
+}
+
+void
+xts_kuznyechik_encrypt_message(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *tweak, size_t length,
+                               uint8_t *dst, const uint8_t *src)
+{
+    xts_encrypt_message(&xts_key->cipher, &xts_key->tweak_cipher,
+                        (nettle_cipher_func *) kuznyechik_encrypt,
+                        tweak, length, dst, src);
+}
+
+void
+xts_kuznyechik_decrypt_message(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *tweak, size_t length,
+                               uint8_t *dst, const uint8_t *src)
+{
+    xts_decrypt_message(&xts_key->cipher, &xts_key->tweak_cipher,
+                        (nettle_cipher_func *) kuznyechik_decrypt,
+                        (nettle_cipher_func *) kuznyechik_encrypt,
+                        tweak, length, dst, src);
+}
+
+void
+xts_kuznyechik_encrypt_sectors(struct xts_kuznyechik_key *xts_key,
+                               size_t count, const uint64_t *sectors,
+                               size_t sector_size,
+                               uint8_t * const *dst, const uint8_t * const *src)
+{
+    xts_encrypt_sectors(&xts_key->cipher, &xts_key->tweak_cipher,
+                        (nettle_cipher_func *) kuznyechik_encrypt,
+                        count, sectors, sector_size, dst, src);
+}
+
+void
+xts_kuznyechik_decrypt_sectors(struct xts_kuznyechik_key *xts_key,
+                               size_t count, const uint64_t *sectors,
+                               size_t sector_size,
+                               uint8_t * const *dst, const uint8_t * const *src)
+{
+    xts_decrypt_sectors(&xts_key->cipher, &xts_key->tweak_cipher,
+                        (nettle_cipher_func *) kuznyechik_decrypt,
+                        (nettle_cipher_func *) kuznyechik_encrypt,
+                        count, sectors, sector_size, dst, src);
+}
@@ -57,58 +57,81 @@ check_length(size_t length, uint8_t *dst)
     memset(dst, '\0', length);
 }
 
-/* works also for inplace encryption/decryption */
+/* Maximum number of blocks passed to the cipher function at once. */
+#define XTS_MAX_BLOCKS 8
 
-void
-xts_encrypt_message(const void *enc_ctx, const void *twk_ctx,
-	            nettle_cipher_func *encf,
-	            const uint8_t *tweak, size_t length,
-	            uint8_t *dst, const uint8_t *src)
+/* Processes complete blocks, at most XTS_MAX_BLOCKS at a time, with
+   all the tweaks for a batch computed up front. Uses T[0] as the
+   initial tweak, and leaves the tweak for the following block in
+   T[0]. */
+static void
+xts_blocks(const void *ctx, nettle_cipher_func *f,
+	   union nettle_block16 *T, size_t blocks,
+	   uint8_t *dst, const uint8_t *src)
 {
-  union nettle_block16 T;
-  union nettle_block16 P;
+  union nettle_block16 P[XTS_MAX_BLOCKS];
 
-  check_length(length, dst);
+  while (blocks > 0)
+    {
+      size_t n = blocks < XTS_MAX_BLOCKS ? blocks : XTS_MAX_BLOCKS;
+      size_t size = n * XTS_BLOCK_SIZE;
+      size_t i;
 
-  encf(twk_ctx, XTS_BLOCK_SIZE, T.b, tweak);
+      for (i = 1; i < n; i++)
+	block16_mulx_le(&T[i], &T[i-1]);
 
-  /* the zeroth power of alpha is the initial ciphertext value itself, so we
-   * skip shifting and do it at the end of each block operation instead */
-  for (;length >= 2 * XTS_BLOCK_SIZE || length == XTS_BLOCK_SIZE;
-       length -= XTS_BLOCK_SIZE, src += XTS_BLOCK_SIZE, dst += XTS_BLOCK_SIZE)
-    {
-      memxor3(P.b, src, T.b, XTS_BLOCK_SIZE);	/* P -> PP */
-      encf(enc_ctx, XTS_BLOCK_SIZE, dst, P.b);  /* CC */
-      memxor(dst, T.b, XTS_BLOCK_SIZE);	        /* CC -> C */
+      memxor3(P[0].b, src, T[0].b, size);	/* P -> PP */
+      f(ctx, size, dst, P[0].b);		/* CC */
+      memxor(dst, T[0].b, size);		/* CC -> C */
+
+      block16_mulx_le(&T[0], &T[n-1]);
 
-      /* shift T for next block if any */
-      if (length > XTS_BLOCK_SIZE)
-          block16_mulx_le(&T, &T);
+      blocks -= n;
+      src += size;
+      dst += size;
     }
+}
+
+/* works also for inplace encryption/decryption */
+
+static void
+xts_encrypt(const void *enc_ctx, nettle_cipher_func *encf,
+	    union nettle_block16 *T, size_t length,
+	    uint8_t *dst, const uint8_t *src)
+{
+  /* If the last block is partial, keep the last complete block for
+     stealing. */
+  size_t blocks = length / XTS_BLOCK_SIZE - (length % XTS_BLOCK_SIZE != 0);
+
+  xts_blocks(enc_ctx, encf, T, blocks, dst, src);
+  length -= blocks * XTS_BLOCK_SIZE;
+  src += blocks * XTS_BLOCK_SIZE;
+  dst += blocks * XTS_BLOCK_SIZE;
 
   /* if the last block is partial, handle via stealing */
-  if (length)
+  if (length > XTS_BLOCK_SIZE)
     {
       /* S Holds the real C(n-1) (Whole last block to steal from) */
       union nettle_block16 S;
+      union nettle_block16 P;
 
-      memxor3(P.b, src, T.b, XTS_BLOCK_SIZE);	/* P -> PP */
+      memxor3(P.b, src, T[0].b, XTS_BLOCK_SIZE);	/* P -> PP */
       encf(enc_ctx, XTS_BLOCK_SIZE, S.b, P.b);  /* CC */
-      memxor(S.b, T.b, XTS_BLOCK_SIZE);	        /* CC -> S */
+      memxor(S.b, T[0].b, XTS_BLOCK_SIZE);	/* CC -> S */
 
       /* shift T for next block */
-      block16_mulx_le(&T, &T);
+      block16_mulx_le(&T[0], &T[0]);
 
       length -= XTS_BLOCK_SIZE;
       src += XTS_BLOCK_SIZE;
 
-      memxor3(P.b, src, T.b, length);           /* P |.. */
+      memxor3(P.b, src, T[0].b, length);        /* P |.. */
       /* steal ciphertext to complete block */
-      memxor3(P.b + length, S.b + length, T.b + length,
+      memxor3(P.b + length, S.b + length, T[0].b + length,
               XTS_BLOCK_SIZE - length);         /* ..| S_2 -> PP */
 
       encf(enc_ctx, XTS_BLOCK_SIZE, dst, P.b);  /* CC */
-      memxor(dst, T.b, XTS_BLOCK_SIZE);         /* CC -> C(n-1) */
+      memxor(dst, T[0].b, XTS_BLOCK_SIZE);      /* CC -> C(n-1) */
 
       /* Do this after we read src so inplace operations do not break */
       dst += XTS_BLOCK_SIZE;
@@ -116,40 +139,28 @@ xts_encrypt_message(const void *enc_ctx, const void *twk_ctx,
     }
 }
 
-void
-xts_decrypt_message(const void *dec_ctx, const void *twk_ctx,
-	            nettle_cipher_func *decf, nettle_cipher_func *encf,
-	            const uint8_t *tweak, size_t length,
-	            uint8_t *dst, const uint8_t *src)
+static void
+xts_decrypt(const void *dec_ctx, nettle_cipher_func *decf,
+	    union nettle_block16 *T, size_t length,
+	    uint8_t *dst, const uint8_t *src)
 {
-  union nettle_block16 T;
-  union nettle_block16 C;
-
-  check_length(length, dst);
-
-  encf(twk_ctx, XTS_BLOCK_SIZE, T.b, tweak);
+  size_t blocks = length / XTS_BLOCK_SIZE - (length % XTS_BLOCK_SIZE != 0);
 
-  for (;length >= 2 * XTS_BLOCK_SIZE || length == XTS_BLOCK_SIZE;
-       length -= XTS_BLOCK_SIZE, src += XTS_BLOCK_SIZE, dst += XTS_BLOCK_SIZE)
-    {
-      memxor3(C.b, src, T.b, XTS_BLOCK_SIZE);	/* c -> CC */
-      decf(dec_ctx, XTS_BLOCK_SIZE, dst, C.b);  /* PP */
-      memxor(dst, T.b, XTS_BLOCK_SIZE);	        /* PP -> P */
-
-      /* shift T for next block if any */
-      if (length > XTS_BLOCK_SIZE)
-          block16_mulx_le(&T, &T);
-    }
+  xts_blocks(dec_ctx, decf, T, blocks, dst, src);
+  length -= blocks * XTS_BLOCK_SIZE;
+  src += blocks * XTS_BLOCK_SIZE;
+  dst += blocks * XTS_BLOCK_SIZE;
 
   /* if the last block is partial, handle via stealing */
-  if (length)
+  if (length > XTS_BLOCK_SIZE)
     {
       union nettle_block16 T1;
       /* S Holds the real P(n) (with part of stolen ciphertext) */
       union nettle_block16 S;
+      union nettle_block16 C;
 
       /* we need the last T(n) and save the T(n-1) for later */
-      block16_mulx_le(&T1, &T);
+      block16_mulx_le(&T1, &T[0]);
 
       memxor3(C.b, src, T1.b, XTS_BLOCK_SIZE);	/* C -> CC */
       decf(dec_ctx, XTS_BLOCK_SIZE, S.b, C.b);  /* PP */
@@ -160,14 +171,115 @@ xts_decrypt_message(const void *dec_ctx, const void *twk_ctx,
       src += XTS_BLOCK_SIZE;
 
       /* Prepare C, P holds the real P(n) */
-      memxor3(C.b, src, T.b, length);	        /* C_1 |.. */
-      memxor3(C.b + length, S.b + length, T.b + length,
+      memxor3(C.b, src, T[0].b, length);	/* C_1 |.. */
+      memxor3(C.b + length, S.b + length, T[0].b + length,
               XTS_BLOCK_SIZE - length);         /* ..| S_2 -> CC */
       decf(dec_ctx, XTS_BLOCK_SIZE, dst, C.b);  /* PP */
-      memxor(dst, T.b, XTS_BLOCK_SIZE);	        /* PP -> P(n-1) */
+      memxor(dst, T[0].b, XTS_BLOCK_SIZE);	/* PP -> P(n-1) */
 
       /* Do this after we read src so inplace operations do not break */
       dst += XTS_BLOCK_SIZE;
       memcpy(dst, S.b, length);                 /* S_1 -> P(n) */
     }
 }
+
+void
+xts_encrypt_message(const void *enc_ctx, const void *twk_ctx,
+	            nettle_cipher_func *encf,
+	            const uint8_t *tweak, size_t length,
+	            uint8_t *dst, const uint8_t *src)
+{
+  union nettle_block16 T[XTS_MAX_BLOCKS];
+
+  check_length(length, dst);
+
+  encf(twk_ctx, XTS_BLOCK_SIZE, T[0].b, tweak);
+  xts_encrypt(enc_ctx, encf, T, length, dst, src);
+}
+
+void
+xts_decrypt_message(const void *dec_ctx, const void *twk_ctx,
+	            nettle_cipher_func *decf, nettle_cipher_func *encf,
+	            const uint8_t *tweak, size_t length,
+	            uint8_t *dst, const uint8_t *src)
+{
+  union nettle_block16 T[XTS_MAX_BLOCKS];
+
+  check_length(length, dst);
+
+  encf(twk_ctx, XTS_BLOCK_SIZE, T[0].b, tweak);
+  xts_decrypt(dec_ctx, decf, T, length, dst, src);
+}
+
+/* Encrypts the tweaks for up to XTS_MAX_BLOCKS sectors with a single
+   call to the cipher. The tweak for a sector is its number, as a
+   128-bit little-endian value. */
+static size_t
+xts_sector_tweaks(const void *twk_ctx, nettle_cipher_func *encf,
+		  union nettle_block16 *N, size_t count, const uint64_t *sectors)
+{
+  size_t n = count < XTS_MAX_BLOCKS ? count : XTS_MAX_BLOCKS;
+  size_t i;
+
+  for (i = 0; i < n; i++)
+    {
+      LE_WRITE_UINT64(N[i].b, sectors[i]);
+      memset(N[i].b + 8, 0, 8);
+    }
+  encf(twk_ctx, n * XTS_BLOCK_SIZE, N[0].b, N[0].b);
+  return n;
+}
+
+void
+xts_encrypt_sectors(const void *enc_ctx, const void *twk_ctx,
+		    nettle_cipher_func *encf,
+		    size_t count, const uint64_t *sectors, size_t sector_size,
+		    uint8_t * const *dst, const uint8_t * const *src)
+{
+  union nettle_block16 N[XTS_MAX_BLOCKS];
+  union nettle_block16 T[XTS_MAX_BLOCKS];
+
+  while (count > 0)
+    {
+      size_t n = xts_sector_tweaks(twk_ctx, encf, N, count, sectors);
+      size_t i;
+
+      for (i = 0; i < n; i++)
+	{
+	  check_length(sector_size, dst[i]);
+	  T[0] = N[i];
+	  xts_encrypt(enc_ctx, encf, T, sector_size, dst[i], src[i]);
+	}
+      sectors += n;
+      dst += n;
+      src += n;
+      count -= n;
+    }
+}
+
+void
+xts_decrypt_sectors(const void *dec_ctx, const void *twk_ctx,
+		    nettle_cipher_func *decf, nettle_cipher_func *encf,
+		    size_t count, const uint64_t *sectors, size_t sector_size,
+		    uint8_t * const *dst, const uint8_t * const *src)
+{
+  union nettle_block16 N[XTS_MAX_BLOCKS];
+  union nettle_block16 T[XTS_MAX_BLOCKS];
+
+  while (count > 0)
+    {
+      size_t n = xts_sector_tweaks(twk_ctx, encf, N, count, sectors);
+      size_t i;
+
+      for (i = 0; i < n; i++)
+	{
+	  check_length(sector_size, dst[i]);
+	  T[0] = N[i];
+	  xts_decrypt(dec_ctx, decf, T, sector_size, dst[i], src[i]);
+	}
+      sectors += n;
+      dst += n;
+      src += n;
+      count -= n;
+    }
+}
@@ -38,6 +38,7 @@
 
 #include "nettle-types.h"
 #include "aes.h"
+#include "kuznyechik.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -46,14 +47,26 @@ extern "C" {
 /* Name mangling */
 #define xts_encrypt_message nettle_xts_encrypt_message
 #define xts_decrypt_message nettle_xts_decrypt_message
+#define xts_encrypt_sectors nettle_xts_encrypt_sectors
+#define xts_decrypt_sectors nettle_xts_decrypt_sectors
 #define xts_aes128_set_encrypt_key nettle_xts_aes128_set_encrypt_key
 #define xts_aes128_set_decrypt_key nettle_xts_aes128_set_decrypt_key
 #define xts_aes128_encrypt_message nettle_xts_aes128_encrypt_message
 #define xts_aes128_decrypt_message nettle_xts_aes128_decrypt_message
+#define xts_aes128_encrypt_sectors nettle_xts_aes128_encrypt_sectors
+#define xts_aes128_decrypt_sectors nettle_xts_aes128_decrypt_sectors
 #define xts_aes256_set_encrypt_key nettle_xts_aes256_set_encrypt_key
 #define xts_aes256_set_decrypt_key nettle_xts_aes256_set_decrypt_key
 #define xts_aes256_encrypt_message nettle_xts_aes256_encrypt_message
 #define xts_aes256_decrypt_message nettle_xts_aes256_decrypt_message
+#define xts_aes256_encrypt_sectors nettle_xts_aes256_encrypt_sectors
+#define xts_aes256_decrypt_sectors nettle_xts_aes256_decrypt_sectors
+#define xts_kuznyechik_set_encrypt_key nettle_xts_kuznyechik_set_encrypt_key
+#define xts_kuznyechik_set_decrypt_key nettle_xts_kuznyechik_set_decrypt_key
+#define xts_kuznyechik_encrypt_message nettle_xts_kuznyechik_encrypt_message
+#define xts_kuznyechik_decrypt_message nettle_xts_kuznyechik_decrypt_message
+#define xts_kuznyechik_encrypt_sectors nettle_xts_kuznyechik_encrypt_sectors
+#define xts_kuznyechik_decrypt_sectors nettle_xts_kuznyechik_decrypt_sectors
 
 #define XTS_BLOCK_SIZE 16
 
@@ -68,6 +81,23 @@ xts_decrypt_message(const void *dec_ctx, const void *twk_ctx,
                     const uint8_t *tweak, size_t length,
                     uint8_t *dst, const uint8_t *src);
 
+/* Processes count sectors of sector_size bytes each, where sector i
+   has number sectors[i] and is read from src[i] and written to
+   dst[i]. The tweak for each sector is its number, encoded as a
+   16-byte little-endian value, as used for disk encryption. */
+void
+xts_encrypt_sectors(const void *enc_ctx, const void *twk_ctx,
+                    nettle_cipher_func *encf,
+                    size_t count, const uint64_t *sectors,
+                    size_t sector_size,
+                    uint8_t * const *dst, const uint8_t * const *src);
+void
+xts_decrypt_sectors(const void *dec_ctx, const void *twk_ctx,
+                    nettle_cipher_func *decf, nettle_cipher_func *encf,
+                    size_t count, const uint64_t *sectors,
+                    size_t sector_size,
+                    uint8_t * const *dst, const uint8_t * const *src);
+
 /* XTS Mode with AES-128 */
 struct xts_aes128_key {
     struct aes128_ctx cipher;
@@ -92,6 +122,18 @@ xts_aes128_decrypt_message(struct xts_aes128_key *xts_key,
                            const uint8_t *tweak, size_t length,
                            uint8_t *dst, const uint8_t *src);
 
+void
+xts_aes128_encrypt_sectors(struct xts_aes128_key *xts_key,
+                           size_t count, const uint64_t *sectors,
+                           size_t sector_size,
+                           uint8_t * const *dst, const uint8_t * const *src);
+
+void
+xts_aes128_decrypt_sectors(struct xts_aes128_key *xts_key,
+                           size_t count, const uint64_t *sectors,
+                           size_t sector_size,
+                           uint8_t * const *dst, const uint8_t * const *src);
+
 /* XTS Mode with AES-256 */
 struct xts_aes256_key {
     struct aes256_ctx cipher;
@@ -116,6 +158,54 @@ xts_aes256_decrypt_message(struct xts_aes256_key *xts_key,
                            const uint8_t *tweak, size_t length,
                            uint8_t *dst, const uint8_t *src);
 
+void
+xts_aes256_encrypt_sectors(struct xts_aes256_key *xts_key,
+                           size_t count, const uint64_t *sectors,
+                           size_t sector_size,
+                           uint8_t * const *dst, const uint8_t * const *src);
+
+void
+xts_aes256_decrypt_sectors(struct xts_aes256_key *xts_key,
+                           size_t count, const uint64_t *sectors,
+                           size_t sector_size,
+                           uint8_t * const *dst, const uint8_t * const *src);
+
+/* XTS Mode with Kuznyechik */
+struct xts_kuznyechik_key {
+    struct kuznyechik_ctx cipher;
+    struct kuznyechik_ctx tweak_cipher;
+};
+
+void
+xts_kuznyechik_set_encrypt_key(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *key);
+
+void
+xts_kuznyechik_set_decrypt_key(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *key);
+
+void
+xts_kuznyechik_encrypt_message(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *tweak, size_t length,
+                               uint8_t *dst, const uint8_t *src);
+
+void
+xts_kuznyechik_decrypt_message(struct xts_kuznyechik_key *xts_key,
+                               const uint8_t *tweak, size_t length,
+                               uint8_t *dst, const uint8_t *src);
+
+void
+xts_kuznyechik_encrypt_sectors(struct xts_kuznyechik_key *xts_key,
+                               size_t count, const uint64_t *sectors,
+                               size_t sector_size,
+                               uint8_t * const *dst, const uint8_t * const *src);
+
+void
+xts_kuznyechik_decrypt_sectors(struct xts_kuznyechik_key *xts_key,
+                               size_t count, const uint64_t *sectors,
+                               size_t sector_size,
+                               uint8_t * const *dst, const uint8_t * const *src);
+
 #ifdef __cplusplus
 }
 #endif